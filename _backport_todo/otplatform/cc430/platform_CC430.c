@@ -366,6 +366,7 @@ void platform_isr_rtca(void) {
     for (i=(RTC_ALARMS-1); i>=0; i--) {
         if (platform_ext.alarm[i].disabled == 0) {
             if ((RTC->TIM0 & platform_ext.alarm[i].mask) == platform_ext.alarm[i].value) {
+                platform_ext.alarm[i].disabled = 1;
                 sys_synchronize( platform_ext.alarm[i].taskid );
             }
         }
@@ -978,12 +979,12 @@ void platform_set_rtc_alarm(ot_u8 alarm_id, ot_u8 task_id, ot_u16 offset) {
     if (alarm_id < RTC_ALARMS)
 #   endif
     {
-        vlFILE* fp                              = ISF_open_su( ISF_ID(real_time_scheduler) );
+        /// The alarm is one-shot, "offset" seconds from now.  Offsets are less
+        /// than 65536, so matching the lower 16 bits of the RTC is exact.
         platform_ext.alarm[alarm_id].disabled   = 0;
         platform_ext.alarm[alarm_id].taskid     = task_id;
-        platform_ext.alarm[alarm_id].mask       = PLATFORM_ENDIAN16(ISF_read(fp, offset));
-        platform_ext.alarm[alarm_id].value      = PLATFORM_ENDIAN16(ISF_read(fp, offset+2));
-        vl_close(fp);
+        platform_ext.alarm[alarm_id].mask       = 0xFFFF;
+        platform_ext.alarm[alarm_id].value      = (ot_u16)platform_get_time() + offset;
 
         platform_enable_rtc();
     }
@@ -0,0 +1,303 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_crc/crc16_bench.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      CRC16 drivers of /otlib/crc16.c against a byte-wise reference
+  *
+  * /otlib/crc16.c is built from the tree (with the headers in shim/), once
+  * for each driver:
+  * <LI> tbcrcbench_s1: OT_PARAM_CRC16_SLICES = 1, the one-table loop </LI>
+  * <LI> tbcrcbench_s4, tbcrcbench_s8: slicing by 4 and by 8 </LI>
+  * <LI> tbcrcbench_fold: slicing by 8, plus crc16drv_fold() from
+  *      /platform/stdc/crc16_stdc.c, as on a POSIX gateway </LI>
+  *
+  * The reference is a byte-wise loop, with its own table worked out bit by
+  * bit from the polynomial in crc16_table.h.  Checked against it:
+  * <LI> crc16drv_block_manual() and crc16drv_block(), for random blocks,
+  *      alignments, lengths and start values </LI>
+  * <LI> crc16drv_block_xor(), with the CRC over the source (crc_dst = False)
+  *      and over the output (True), into a separate buffer, in place, and
+  *      over the key </LI>
+  * <LI> crc_calc_nstream_xor() on a stream cut in random pieces, with the
+  *      CRC written out at the end, as the PN9 codec in /m2/encode.c uses it
+  *      </LI>
+  *
+  * Then it reports throughput for block sizes from a 7 byte background frame
+  * up to a 4 KB MPipe packet.  "2 pass" is crc16drv_block_manual() and then
+  * a separate XOR, as the PN9 codec did it before crc16drv_block_xor().
+  *
+  * Usage: tbcrcbench_XX [megabytes per size]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <otlib/crc16.h>
+#include <otlib/crc16_table.h>
+
+#ifndef KERNEL_NAME
+#   define KERNEL_NAME  "slices=1"
+#endif
+
+#define MAX_BLOCK       4096
+#define CHECKS          200000
+
+
+
+
+/** Reference
+  * ============================================================================
+  */
+static ot_u16 ref_table[256];
+
+static void ref_init(void) {
+    int i, b;
+
+    for (i=0; i<256; i++) {
+        ot_u16 crc = (ot_u16)(i << 8);
+        for (b=0; b<8; b++) {
+            crc = (crc & 0x8000) ? (ot_u16)((crc << 1) ^ CRCx01) : (ot_u16)(crc << 1);
+        }
+        ref_table[i] = crc;
+    }
+}
+
+static ot_u16 ref_crc(const ot_u8* data, int size, ot_u16 init) {
+    while (--size >= 0) {
+        init = (ot_u16)(init << 8) ^ ref_table[(init >> 8) ^ *data++];
+    }
+    return init;
+}
+
+
+
+
+/** Cases
+  * ============================================================================
+  */
+static ot_u8 buf[MAX_BLOCK + 16];
+static ot_u8 key[MAX_BLOCK + 16];
+static ot_u8 dst[MAX_BLOCK + 16];
+static ot_u8 src[MAX_BLOCK + 16];
+
+static int sub_size(int max) {
+/// Mostly frame-sized blocks, sometimes long ones
+    return (rand() & 3) ? (rand() % 300) : (rand() % (max + 1));
+}
+
+
+static int test_block(void) {
+    long n;
+
+    for (n=0; n<CHECKS; n++) {
+        int     offset  = rand() & 15;
+        int     size    = sub_size(MAX_BLOCK);
+        ot_u16  init    = (ot_u16)rand();
+        ot_u16  ref     = ref_crc(&buf[offset], size, init);
+        ot_u16  crc;
+
+        crc = crc16drv_block_manual(&buf[offset], (ot_int)size, init);
+        if (crc != ref) {
+            printf("crc16drv_block_manual: size=%d offset=%d init=%04X: %04X, expected %04X\n",
+                    size, offset, init, crc, ref);
+            return -1;
+        }
+        crc = crc16drv_block(&buf[offset], (ot_int)size);
+        if (crc != ref_crc(&buf[offset], size, 0xFFFF)) {
+            printf("crc16drv_block: size=%d offset=%d: wrong\n", size, offset);
+            return -1;
+        }
+    }
+    printf("crc16drv_block_manual, crc16drv_block: %d checks: OK\n", CHECKS);
+    return 0;
+}
+
+
+static int test_block_xor(void) {
+/// mode 0: separate dst, 1: dst is src, 2: dst is key
+    static const char* mode_name[] = { "separate", "in place", "over key" };
+    ot_u8   expect[MAX_BLOCK];
+    long    n;
+
+    for (n=0; n<CHECKS; n++) {
+        int     offset  = rand() & 15;
+        int     doff    = rand() & 15;
+        int     size    = sub_size(MAX_BLOCK - 16);
+        int     mode    = (int)(n % 3);
+        ot_bool crc_dst = (ot_bool)((n / 3) & 1);
+        ot_u16  init    = (ot_u16)rand();
+        ot_u8*  s       = &src[offset];
+        ot_u8*  k       = &key[(mode == 2) ? doff : (rand() & 15)];
+        ot_u8*  d       = (mode == 0) ? &dst[doff] : ((mode == 1) ? s : k);
+        ot_u16  ref, crc;
+        int     i;
+
+        memcpy(src, buf, sizeof(src));
+        for (i=0; i<size; i++) {
+            expect[i] = s[i] ^ k[i];
+        }
+        ref = ref_crc(crc_dst ? expect : s, size, init);
+        crc = crc16drv_block_xor(d, s, k, (ot_int)size, init, crc_dst);
+
+        if ((crc != ref) || (memcmp(d, expect, size) != 0)) {
+            printf("crc16drv_block_xor: %s, crc_dst=%d, size=%d: %s\n",
+                    mode_name[mode], crc_dst, size, (crc != ref) ? "CRC wrong" : "output wrong");
+            return -1;
+        }
+        if (mode == 2) {
+            for (i=0; i<(int)sizeof(key); i++) key[i] = (ot_u8)rand();
+        }
+    }
+    printf("crc16drv_block_xor: %d checks: OK\n", CHECKS);
+    return 0;
+}
+
+
+static int test_stream_xor(void) {
+/// Encoder side: the CRC over the source, written after it and whitened too.
+/// Decoder side: in place, the CRC over the output, and 0 at the end.
+    long n;
+
+    for (n=0; n<(CHECKS/10); n++) {
+        int         size    = sub_size(MAX_BLOCK - 2);
+        int         done, chunk;
+        crcstream_t stream;
+        ot_u16      ref;
+
+        memcpy(src, buf, sizeof(src));
+        ref = ref_crc(src, size, 0xFFFF);
+
+        /// Encode src into dst
+        crc_init_stream(&stream, True, (ot_int)size, src);
+        for (done=0; done<size+2; done+=chunk) {
+            chunk = 1 + rand() % 80;
+            chunk = (chunk < (size + 2 - done)) ? chunk : (size + 2 - done);
+            crc_calc_nstream_xor(&stream, &dst[done], &key[done], (ot_u16)chunk, False);
+        }
+        if ((src[size] != (ot_u8)(ref >> 8)) || (src[size+1] != (ot_u8)ref)) {
+            printf("crc_calc_nstream_xor: size=%d: CRC not written out\n", size);
+            return -1;
+        }
+        for (done=0; (done<size+2) && (dst[done] == (src[done] ^ key[done])); done++);
+        if (done < size+2) {
+            printf("crc_calc_nstream_xor: size=%d: output wrong at %d\n", size, done);
+            return -1;
+        }
+
+        /// Decode dst in place, CRC included
+        crc_init_stream(&stream, False, (ot_int)(size + 2), dst);
+        for (done=0; done<size+2; done+=chunk) {
+            chunk = 1 + rand() % 80;
+            chunk = (chunk < (size + 2 - done)) ? chunk : (size + 2 - done);
+            crc_calc_nstream_xor(&stream, &dst[done], &key[done], (ot_u16)chunk, True);
+        }
+        if ((crc_get(&stream) != 0) || (memcmp(dst, src, size+2) != 0)) {
+            printf("crc_calc_nstream_xor: size=%d: not decoded\n", size);
+            return -1;
+        }
+    }
+    printf("crc_calc_nstream_xor: %d streams: OK\n", CHECKS/10);
+    return 0;
+}
+
+
+
+
+/** Benchmark
+  * ============================================================================
+  */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (1e-9 * ts.tv_nsec);
+}
+
+static ot_u16 run(int driver, int size) {
+    int i;
+
+    switch (driver) {
+    case 0:     return ref_crc(buf, size, 0xFFFF);
+    case 1:     return crc16drv_block_manual(buf, (ot_int)size, 0xFFFF);
+    case 2:     return crc16drv_block_xor(dst, buf, key, (ot_int)size, 0xFFFF, False);
+    default:    for (i=0; i<size; i++) {
+                    dst[i] = buf[i] ^ key[i];
+                }
+                return crc16drv_block_manual(buf, (ot_int)size, 0xFFFF);
+    }
+}
+
+static void bench(long mbytes) {
+    static const int    sizes[] = { 7, 16, 32, 64, 128, 256, 1024, 4096 };
+    static const char*  name[]  = { "reference", "block", "block_xor", "2 pass" };
+    int d, s;
+
+    printf("\n" KERNEL_NAME "\nbytes ");
+    for (d=0; d<4; d++) printf("  %10s", name[d]);
+    printf("   (MB/s)\n");
+
+    for (s=0; s<(int)(sizeof(sizes)/sizeof(int)); s++) {
+        long loops = (mbytes << 20) / sizes[s];
+        printf("%5d ", sizes[s]);
+        for (d=0; d<4; d++) {
+            volatile ot_u16 sink = 0;
+            double  start;
+            long    n;
+
+            start = now();
+            for (n=0; n<loops; n++) {
+                sink ^= run(d, sizes[s]);
+            }
+            printf("  %10.1f", (double)(loops * sizes[s]) / ((now() - start) * 1e6));
+        }
+        printf("\n");
+    }
+}
+
+
+
+
+int main(int argc, char** argv) {
+    long    mbytes = (argc > 1) ? atol(argv[1]) : 64;
+    ot_u16  fold_crc = 0xFFFF;
+    int     i, rc;
+
+    ref_init();
+    srand(1);
+    for (i=0; i<(int)sizeof(buf); i++) {
+        buf[i]  = (ot_u8)rand();
+        key[i]  = (ot_u8)rand();
+    }
+
+    printf("%s: CRC(\"123456789\") = %04X, crc16drv_fold() takes %d of 128 bytes\n",
+            KERNEL_NAME, ref_crc((const ot_u8*)"123456789", 9, 0xFFFF),
+            crc16drv_fold(buf, 128, &fold_crc));
+    rc  = test_block();
+    rc |= test_block_xor();
+    rc |= test_stream_xor();
+    if (rc != 0) {
+        printf("\nFAILED\n");
+        return 1;
+    }
+    bench(mbytes);
+    return 0;
+}
@@ -0,0 +1,2 @@
+/* Host stand-in: nothing from it is used by the CRC16 driver */
+#include <otstd.h>
@@ -0,0 +1,39 @@
+/* Host stand-in for the OpenTag otstd.h, for the CRC16 benchmark: the SW
+ * CRC16 driver, with OT_PARAM_CRC16_SLICES from the command line. */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef int8_t      ot_s8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_int;
+typedef int16_t     ot_s16;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint32_t    ot_ulong;
+typedef int32_t     ot_s32;
+typedef uint8_t     ot_bool;
+
+#define UPPER       1
+#define LOWER       0
+#define True        1
+#define False       0
+#define ENABLED     1
+#define DISABLED    0
+#define OT_INLINE
+#define OT_WEAK     __attribute__((weak))
+
+#define OT_PARAM(VAL)                   OT_PARAM_##VAL
+#ifndef OT_PARAM_CRC16_SLICES
+#   define OT_PARAM_CRC16_SLICES        1
+#endif
+
+#define MCU_FEATURE(VAL)                MCU_FEATURE_##VAL
+#define MCU_FEATURE_CRC16               DISABLED
+
+#endif
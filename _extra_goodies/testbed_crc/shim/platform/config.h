@@ -0,0 +1,2 @@
+/* Host stand-in for platform/config.h */
+#include <otstd.h>
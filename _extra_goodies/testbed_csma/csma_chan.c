@@ -0,0 +1,300 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_csma/csma_chan.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Multi-channel CSMA-CA benchmark for the DLL occupancy stats
+  *
+  * Simulates M devices that send RAIND requests on a list of C channels,
+  * with a foreign interferer on channel 0.  It compares the stock CSMA-CA
+  * (random channel scramble, fixed RAIND step) with the occupancy-driven one
+  * (channel sort and extra backoff from CCA history).  The CSMA-CA routines
+  * are sub_fcinit(), sub_fcloop() and sub_ccalog(), which the Makefile copies
+  * out of /m2/dll_task.c into dll_tree.h.  Each device swaps its dll.comm,
+  * channel list and dll_cca in to call them.  The stock CSMA-CA is the same
+  * code without the sub_ccalog() calls: with no occupancy stats, the sort
+  * keeps the scrambled order and there is no extra backoff.
+  *
+  * Channel model:
+  * <LI> A TX can only be sensed by CCA after a blind time (RX-TX turnaround
+  *      + CCA), so TX starts closer together than that collide. </LI>
+  * <LI> Any two overlapping TXs on a channel are both lost.  The interferer
+  *      also destroys any TX it overlaps, and it is sensed by CCA. </LI>
+  * <LI> A request that has not started TX within its contention period (Tc)
+  *      is dropped, like the kernel timeout of the radio task. </LI>
+  *
+  * Outcomes are in % of the requests that were completed (delivered, lost to
+  * collision or interference, or dropped at Tc).  Latency is from the time
+  * a request is queued to the end of its TX, so it includes queueing.
+  *
+  * Usage: csma_chan [channels] [load %] [seconds]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define OT_GPTIM_SHIFT  3                   // clocks per tick = 8
+#include "dll_env.h"
+#include "dll_tree.h"
+
+#define CLK2TI_F(X)     ((double)(X) / (1 << OT_GPTIM_SHIFT))
+#define BLIND_CLK       TI2CLK(1)
+#define PKT_CLK         TI2CLK(4)
+#define TC_CLK          TI2CLK(32)
+#define MAX_DEVICES     64
+#define MAX_CHANNELS    8
+
+typedef struct {
+    long        arrival;        // time the present request was queued
+    long        deadline;       // start + Tc
+    long        next;           // next CCA, or -1 if idle
+    long        txend;          // end of present TX, or -1
+    int         channel;
+    int         queued;
+    int         lost;
+    m2comm_struct   comm;                       // dll.comm
+    ot_u8           chanlist[MAX_CHANNELS];     // dll.comm.tx_chanlist
+    __typeof__(dll_cca) cca;                    // dll_cca
+} device_t;
+
+typedef struct {
+    double  offered;
+    double  delivered;
+    double  collided;
+    double  dropped;
+    double  latency;
+} result_t;
+
+static device_t dev[MAX_DEVICES];
+static int      nchan;
+static long     ifr_until;      // interferer on channel 0 is busy until
+static long     ifr_next;       // next interferer burst
+static int      sim_rssi;       // RSSI of the present CCA
+
+
+
+/** Environment of the routines from /m2/dll_task.c
+  * ============================================================================
+  */
+
+ot_u16 rand_prn16(void) {
+    return (ot_u16)(rand() & 0xFFFF);
+}
+
+ot_int radio_rssi(void) {
+    return (ot_int)sim_rssi;
+}
+
+m2session* session_top(void) {
+    static m2session request = { M2_NETSTATE_REQ };
+    return &request;
+}
+
+static void dev_load(device_t* d) {
+    dll.comm            = d->comm;
+    dll_cca             = d->cca;
+    phymac[0].channel   = (ot_u8)d->channel;
+}
+
+static void dev_save(device_t* d) {
+    d->comm = dll.comm;
+    d->cca  = dll_cca;
+}
+
+
+
+
+/** Simulation
+  * ============================================================================
+  */
+
+static int sim_chan_id(int i) {
+/// Channel IDs like a normal-rate channel list: 0x10, 0x12, 0x14 ...
+    return 0x10 + (i << 1);
+}
+
+static int sim_busy(int channel, long t, int* rssi) {
+/// CCA on the channel at time t.  RSSI is -60 for the interferer, else -80.
+    int i;
+    if ((channel == sim_chan_id(0)) && (t < ifr_until)) {
+        *rssi = -60;
+        return 1;
+    }
+    for (i=0; i<MAX_DEVICES; i++) {
+        if ((dev[i].txend > t) && (dev[i].channel == channel) \
+        &&  (dev[i].txend - PKT_CLK + BLIND_CLK <= t)) {
+            *rssi = -80;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void sim_start(device_t* d, long now) {
+/// New request: sub_fcinit() scrambles and sorts the channel list and picks
+/// a RAIND slot in Tc.  TX is on the first channel of the list.
+    CLK_UNIT offset;
+    int i;
+
+    for (i=0; i<nchan; i++) d->chanlist[i] = (ot_u8)sim_chan_id(i);
+    d->comm.tc              = TC_CLK;
+    d->comm.csmaca_params   = M2_CSMACA_RAIND;
+    d->comm.tx_channels     = (ot_u8)nchan;
+    d->comm.tx_chanlist     = d->chanlist;
+
+    dev_load(d);
+    offset = sub_fcinit();
+    dev_save(d);
+
+    d->channel  = d->chanlist[0];
+    d->deadline = now + TC_CLK;
+    d->next     = now + offset;
+}
+
+
+static void sim_run(result_t* res, int m, int load, long duration, int adaptive) {
+/// load is the offered load in % of all channels
+    long    t, arrivals_per;
+    int     i, j;
+
+    memset(dev, 0, sizeof(dev));
+    for (i=0; i<MAX_DEVICES; i++) {
+        dev[i].next     = -1;
+        dev[i].txend    = -1;
+    }
+    ifr_until   = 0;
+    ifr_next    = 0;
+    txq.airtime = (ot_u32)PKT_CLK << (10 - OT_GPTIM_SHIFT);
+
+    /// Per device, a request arrives each clock with probability 1/arrivals_per
+    arrivals_per = (PKT_CLK * m * 100) / ((long)nchan * load);
+
+    for (t=0; t<duration; t++) {
+        /// Interferer: bursts of 4-20 ticks on channel 0, about half the time
+        if (t >= ifr_next) {
+            ifr_until   = t + TI2CLK((4 + (rand() % 17)));
+            ifr_next    = ifr_until + TI2CLK((4 + (rand() % 17)));
+        }
+
+        for (i=0; i<m; i++) {
+            device_t* d = &dev[i];
+
+            if ((rand() % arrivals_per) == 0) {
+                d->queued++;
+                res->offered += 1;
+                if (d->queued == 1) d->arrival = t;
+            }
+
+            /// TX end: score the TX
+            if (d->txend == t) {
+                if (d->lost)    res->collided += 1;
+                else {
+                    res->delivered += 1;
+                    res->latency   += CLK2TI_F(t - d->arrival);
+                }
+                d->txend = -1;
+                if (--d->queued != 0) d->arrival = t;
+            }
+
+            if ((d->queued != 0) && (d->next < 0) && (d->txend < 0)) {
+                sim_start(d, t);
+            }
+
+            /// CCA
+            if (d->next == t) {
+                if (sim_busy(d->channel, t, &sim_rssi)) {
+                    CLK_UNIT wait;
+                    dev_load(d);
+                    if (adaptive) sub_ccalog(True);
+                    wait = sub_fcloop();
+                    dev_save(d);
+                    d->next = t + wait;
+                    if (d->next + PKT_CLK > d->deadline) {
+                        res->dropped += 1;
+                        d->next = -1;
+                        if (--d->queued != 0) d->arrival = t;
+                    }
+                }
+                else {
+                    if (adaptive) {
+                        dev_load(d);
+                        sub_ccalog(False);
+                        dev_save(d);
+                    }
+                    d->next     = -1;
+                    d->txend    = t + PKT_CLK;
+                    d->lost     = 0;
+                    for (j=0; j<m; j++) {
+                        if ((j != i) && (dev[j].txend > t) && (dev[j].channel == d->channel)) {
+                            dev[j].lost = 1;
+                            d->lost     = 1;
+                        }
+                    }
+                }
+            }
+
+            /// Interferer hits any TX on channel 0
+            if ((d->txend > t) && (d->channel == sim_chan_id(0)) && (t < ifr_until)) {
+                d->lost = 1;
+            }
+        }
+    }
+}
+
+
+
+
+int main(int argc, char** argv) {
+    static const int devices[] = { 4, 8, 16, 32, 64 };
+    int     load    = 30;
+    long    seconds = 200;
+    int     d, a;
+
+    nchan = 3;
+    if (argc > 1)   nchan   = atoi(argv[1]);
+    if (argc > 2)   load    = atoi(argv[2]);
+    if (argc > 3)   seconds = atoi(argv[3]);
+    nchan = (nchan < 1) ? 1 : ((nchan > MAX_CHANNELS) ? MAX_CHANNELS : nchan);
+
+    printf("RAIND, %d channels (ch 0 has ~50%% interference), load %d%%, %ld s\n",
+            nchan, load, seconds);
+    printf("CSMA-CA     M   deliv%%  coll%%  drop%%  thruput(pkt/s)  latency(ti)\n");
+
+    for (a=0; a<2; a++) {
+        for (d=0; d<(int)(sizeof(devices)/sizeof(int)); d++) {
+            result_t res;
+            double   done;
+            memset(&res, 0, sizeof(res));
+            srand(1);
+            sim_run(&res, devices[d], load, TI2CLK(seconds*1024), a);
+            done = res.delivered + res.collided + res.dropped;
+
+            printf("%-8s  %3d   %5.1f   %5.1f  %5.1f  %14.1f  %11.1f\n",
+                    a ? "adaptive" : "stock", devices[d],
+                    100.0 * res.delivered / done,
+                    100.0 * res.collided / done,
+                    100.0 * res.dropped / done,
+                    res.delivered / seconds,
+                    (res.delivered == 0) ? 0.0 : res.latency / res.delivered);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,273 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_csma/csma_sim.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Response contention simulator for the DLL slotting
+  *
+  * Simulates N devices that all respond to the same anycast query, and
+  * reports collection completion time and collision rate, with and without
+  * query-score banding.  The slot selection is sub_fceval(), sub_fcinit()
+  * and sub_fcloop(), which the Makefile copies out of /m2/dll_task.c into
+  * dll_tree.h.  Each device swaps its dll.comm and dll_fcrank in to call them.
+  * Without banding, every device has rank 0, which is the whole contention
+  * period, as with M2_PARAM_SCOREBANDS = 1.
+  *
+  * Channel model:
+  * <LI> A device that starts a TX can only be sensed by CCA after a blind time
+  *      (RX-TX turnaround + CCA), so starts closer together than that collide. </LI>
+  * <LI> Any two overlapping TXs are both lost.  Responders do not know that,
+  *      so a collided response is not retried. </LI>
+  * <LI> A device that finds the channel busy backs-off per the CSMA-CA loop,
+  *      and it gives up when the contention period is over. </LI>
+  *
+  * Usage: csma_sim [raind|rigd] [tc ticks] [pkt ticks] [trials]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define OT_GPTIM_SHIFT  5                   // clocks per tick = 32
+#include "dll_env.h"
+#include "dll_tree.h"
+
+#define CLK2TI_F(X)     ((double)(X) / (1 << OT_GPTIM_SHIFT))
+#define BLIND_CLK       TI2CLK(1)
+#define MAX_DEVICES     256
+
+typedef enum {
+    MODE_raind = 0,
+    MODE_rigd
+} mode_t_;
+
+typedef struct {
+    int     score;
+    ot_u8   rank;       // dll_fcrank
+    m2comm_struct comm; // dll.comm: tc is the RIGD subslot, tca the offset
+    long    next;       // absolute time of next CCA
+    int     state;      // 0 = contending, 1 = sent, 2 = gave up
+    long    tx;         // absolute time of TX start
+    int     lost;       // TX overlapped another TX
+} device_t;
+
+typedef struct {
+    double  sent;
+    double  lost;
+    double  timeout;
+    double  done_ti;
+    double  best_ok;
+    double  best_ti;
+    double  inversions;
+} result_t;
+
+static device_t dev[MAX_DEVICES];
+
+
+
+/** Environment of the routines from /m2/dll_task.c
+  * ============================================================================
+  */
+
+ot_u16 rand_prn16(void) {
+    return (ot_u16)(rand() & 0xFFFF);
+}
+
+ot_int radio_rssi(void) {
+    return -80;
+}
+
+m2session* session_top(void) {
+    static m2session response = { M2_NETSTATE_RESP };
+    return &response;
+}
+
+static void dev_load(device_t* d) {
+    dll.comm    = d->comm;
+    dll_fcrank  = d->rank;
+}
+
+static void dev_save(device_t* d) {
+    d->comm     = dll.comm;
+    d->rank     = dll_fcrank;
+}
+
+
+
+
+/** Simulation
+  * ============================================================================
+  */
+
+static void sim_run(result_t* res, int n, mode_t_ mode, long tc, long pkt, int bands) {
+    static ot_u8 chanlist[1] = { 0x10 };
+    int     i, j, best;
+    long    busy_from, busy_to;
+    long    done;
+
+    phymac[0].channel   = chanlist[0];
+    txq.airtime         = (ot_u32)pkt << (10 - OT_GPTIM_SHIFT);
+
+    /// Scores are like correlation hits: each doubling of the score is half
+    /// as likely, and there is a single best device.
+    best = 0;
+    for (i=0; i<n; i++) {
+        int g = 0;
+        while ((g < 6) && (rand() & 1)) g++;
+        dev[i].score    = (1 << g) + (rand() % (1 << g));
+        dev[i].state    = 0;
+        if (dev[i].score >= dev[best].score) best = i;
+    }
+    dev[best].score = 128;
+
+    for (i=0; i<n; i++) {
+        sub_fceval((bands > 1) ? dev[i].score : 0);
+        dev[i].rank                 = dll_fcrank;
+        dev[i].comm.tc              = tc;
+        dev[i].comm.csmaca_params   = (mode == MODE_rigd) ? M2_CSMACA_RIGD : M2_CSMACA_RAIND;
+        dev[i].comm.tx_channels     = 1;
+        dev[i].comm.tx_chanlist     = chanlist;
+        dev_load(&dev[i]);
+        dll.comm.tca                = sub_fcinit();
+        dev_save(&dev[i]);
+        dev[i].next = dev[i].comm.tca;
+    }
+
+    /// Run the CCA events in time order.  The channel is busy (to CCA) from
+    /// the blind time after a TX start until the end of that TX.
+    busy_from   = -1;
+    busy_to     = -1;
+    while (1) {
+        j = -1;
+        for (i=0; i<n; i++) {
+            if ((dev[i].state == 0) && ((j < 0) || (dev[i].next < dev[j].next))) {
+                j = i;
+            }
+        }
+        if (j < 0) break;
+
+        if (dev[j].next + pkt > tc) {
+            dev[j].state = 2;
+        }
+        else if ((dev[j].next >= busy_from) && (dev[j].next < busy_to)) {
+            long wait;
+            dev_load(&dev[j]);
+            wait         = sub_fcloop();
+            dev_save(&dev[j]);
+            dev[j].next += (wait == 0) ? 1 : wait;
+        }
+        else {
+            dev[j].state    = 1;
+            dev[j].tx       = dev[j].next;
+            if (busy_to < dev[j].tx + pkt) {
+                busy_from   = dev[j].tx + BLIND_CLK;
+                busy_to     = dev[j].tx + pkt;
+            }
+        }
+    }
+
+    /// Score the outcome: overlapping TXs are lost
+    done = 0;
+    for (i=0; i<n; i++) {
+        int lost = 0;
+        if (dev[i].state == 2) {
+            res->timeout += 1;
+            continue;
+        }
+        res->sent += 1;
+        for (j=0; j<n; j++) {
+            if ((j != i) && (dev[j].state == 1) \
+            && (dev[j].tx < dev[i].tx + pkt) && (dev[i].tx < dev[j].tx + pkt)) {
+                lost = 1;
+                break;
+            }
+        }
+        if (lost) {
+            res->lost += 1;
+        }
+        else if (done < dev[i].tx + pkt) {
+            done = dev[i].tx + pkt;
+        }
+        dev[i].lost = lost;
+    }
+    res->done_ti += CLK2TI_F(done);
+
+    if ((dev[best].state == 1) && (dev[best].lost == 0)) {
+        res->best_ok += 1;
+        res->best_ti += CLK2TI_F(dev[best].tx + pkt);
+    }
+
+    /// Inversions: received pairs where the lower score arrived first
+    for (i=0; i<n; i++) {
+        for (j=0; j<n; j++) {
+            if ((dev[i].state == 1) && (dev[j].state == 1) \
+            && (dev[i].lost == 0) && (dev[j].lost == 0) \
+            && (dev[i].score < dev[j].score) && (dev[i].tx < dev[j].tx)) {
+                res->inversions += 1;
+            }
+        }
+    }
+}
+
+
+
+
+int main(int argc, char** argv) {
+    static const int devices[] = { 2, 4, 8, 16, 32, 64 };
+    static const int bandset[] = { 1, M2_PARAM(SCOREBANDS) };
+    mode_t_ mode    = MODE_raind;
+    long    tc      = TI2CLK(256);
+    long    pkt     = TI2CLK(4);
+    int     trials  = 2000;
+    int     d, b, t;
+
+    if (argc > 1)   mode    = (strcmp(argv[1], "rigd") == 0) ? MODE_rigd : MODE_raind;
+    if (argc > 2)   tc      = TI2CLK(atoi(argv[2]));
+    if (argc > 3)   pkt     = TI2CLK(atoi(argv[3]));
+    if (argc > 4)   trials  = atoi(argv[4]);
+
+    printf("%s, Tc=%.0f ticks, packet=%.0f ticks, %d trials\n",
+            (mode == MODE_rigd) ? "RIGD" : "RAIND", CLK2TI_F(tc), CLK2TI_F(pkt), trials);
+    printf("bands  N   sent%%  coll%%  tmout%%  done(ti)  best%%  best(ti)  inv/trial\n");
+
+    for (b=0; b<(int)(sizeof(bandset)/sizeof(int)); b++) {
+        for (d=0; d<(int)(sizeof(devices)/sizeof(int)); d++) {
+            result_t res;
+            double   n = devices[d];
+            memset(&res, 0, sizeof(res));
+            srand(1);
+
+            for (t=0; t<trials; t++) {
+                sim_run(&res, devices[d], mode, tc, pkt, bandset[b]);
+            }
+
+            printf("%5d %3d  %5.1f  %5.1f  %6.1f  %8.1f  %5.1f  %8.1f  %9.2f\n",
+                    bandset[b], devices[d],
+                    100.0 * res.sent / (n*trials),
+                    (res.sent == 0) ? 0.0 : 100.0 * res.lost / res.sent,
+                    100.0 * res.timeout / (n*trials),
+                    res.done_ti / trials,
+                    100.0 * res.best_ok / trials,
+                    (res.best_ok == 0) ? 0.0 : res.best_ti / res.best_ok,
+                    res.inversions / trials);
+        }
+    }
+
+    return 0;
+}
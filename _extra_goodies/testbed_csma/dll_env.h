@@ -0,0 +1,79 @@
+/* Environment of the CSMA-CA routines that the Makefile copies out of
+ * /m2/dll_task.c into dll_tree.h.  The simulator that includes this sets
+ * OT_GPTIM_SHIFT first, and it provides rand_prn16(), radio_rssi(),
+ * rm2_pkt_airtime() and session_top().  Each simulated device has its own
+ * copy of dll.comm, dll_fcrank and dll_cca, which it swaps in to call them. */
+#ifndef __DLL_ENV_H
+#define __DLL_ENV_H
+
+#include <stdint.h>
+
+typedef uint8_t     ot_u8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_int;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint8_t     ot_bool;
+typedef union {
+    ot_u16  ushort;
+    ot_u8   ubyte[2];
+} ot_uni16;
+
+#define True        1
+#define False       0
+
+#define M2_PARAM(VAL)           M2_PARAM_##VAL
+#define M2_PARAM_SCOREBANDS     4
+#define M2_PARAM_CCASTATS       8
+
+/* From otsys/syskern.h, for OT_GPTIM_SHIFT != 0 */
+#define CLK_UNIT            ot_long
+#define CLK2TI(CLOCKS)      (ot_u16)(CLOCKS >> OT_GPTIM_SHIFT)
+#define TI2CLK(TICKS)       ((ot_long)TICKS << OT_GPTIM_SHIFT)
+#define MITI2CLK(MITI)      (CLK_UNIT)(((ot_u32)(MITI) + ((1<<(10-OT_GPTIM_SHIFT))-1)) >> (10-OT_GPTIM_SHIFT))
+
+/* From m2/dll.h and m2/session.h */
+#define M2_CSMACA_RIGD      0x00
+#define M2_CSMACA_RAIND     0x08
+#define M2_CSMACA_AIND      0x10
+#define M2_NETSTATE_REQ     0x00
+#define M2_NETSTATE_RESP    0x10
+
+typedef struct {
+    ot_long tc;
+    ot_long tca;
+    ot_u8   csmaca_params;
+    ot_u8   tx_channels;
+    ot_u8*  tx_chanlist;
+} m2comm_struct;
+
+typedef struct {
+    m2comm_struct   comm;
+} m2dll_struct;
+
+typedef struct {
+    ot_u8   channel;
+    ot_u8   tg;
+} phymac_struct;
+
+typedef struct {
+    ot_u8   netstate;
+} m2session;
+
+typedef struct {
+    ot_u32  airtime;        // the packet is not modeled, only its airtime
+} ot_queue;
+
+static m2dll_struct     dll;
+static phymac_struct    phymac[1];
+static ot_queue         txq;
+
+ot_u16 rand_prn16(void);
+ot_int radio_rssi(void);
+m2session* session_top(void);
+
+static ot_u32 rm2_pkt_airtime(ot_queue* pkt_q) {
+    return pkt_q->airtime;
+}
+
+#endif
@@ -0,0 +1,139 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_eax/eax_bench.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Frames per second, per core, of the stdc EAX driver
+  *
+  * Decrypts DLLS frames (7 byte nonce, 4 byte tag) of several sizes, with
+  * the frames spread over 8 keys, as on a gateway.  The rows are:
+  * <LI> rekey: EAXdrv_init() then EAXdrv_decrypt() for every frame, which is
+  *      what auth_decrypt() did before the keyed contexts were cached </LI>
+  * <LI> single: EAXdrv_decrypt() with cached contexts </LI>
+  * <LI> batch: EAXdrv_decrypt_batch() with 64 frames per call </LI>
+  * The driver is /platform/stdc/otlib_eax_stdc.c from the tree: tbeaxbench
+  * uses AES-NI if the CPU has it, and tbeaxbench_ct always uses the bitsliced
+  * AES.  It runs on one thread, so the figures are per core.
+  *
+  * Usage: tbeaxbench [frames per point]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <otlib/crypto.h>
+
+#ifndef KERNEL_NAME
+#   define KERNEL_NAME  "AES-NI if available"
+#endif
+
+#define BATCH       64
+#define KEYS        8
+
+static const int sizes[] = { 16, 32, 64, 128, 255 };
+#define NUM_SIZES   (int)(sizeof(sizes)/sizeof(sizes[0]))
+
+static uint8_t      keydata[KEYS][16];
+static EAXdrv_t     ctx[KEYS];
+static uint8_t      buf[BATCH][260];
+static uint8_t      nonce[BATCH][8];
+static EAXdrv_frame frame[BATCH];
+
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+static double run(int mode, int size, long frames) {
+    double  t0, t1;
+    long    n;
+    int     f;
+
+    for (f=0; f<BATCH; f++) {
+        frame[f].nonce      = nonce[f];
+        frame[f].data       = buf[f];
+        frame[f].datalen    = (ot_uint)(size + 4);
+        frame[f].context    = &ctx[f % KEYS];
+    }
+
+    t0 = now();
+    for (n=0; n<frames; n+=BATCH) {
+        switch (mode) {
+        case 0: for (f=0; f<BATCH; f++) {
+                    EAXdrv_init(keydata[f % KEYS], &ctx[f % KEYS]);
+                    EAXdrv_decrypt(nonce[f], buf[f], (ot_uint)(size+4), &ctx[f % KEYS]);
+                }
+                break;
+        case 1: for (f=0; f<BATCH; f++) {
+                    EAXdrv_decrypt(nonce[f], buf[f], (ot_uint)(size+4), &ctx[f % KEYS]);
+                }
+                break;
+        case 2: EAXdrv_decrypt_batch(frame, BATCH);
+                break;
+        }
+    }
+    t1 = now();
+    return (double)n / (t1 - t0);
+}
+
+
+static void bench(long frames) {
+    static const char* rows[] = { "rekey", "single", "batch" };
+    int mode, s;
+
+    for (mode=0; mode<3; mode++) {
+        printf("%-14s", rows[mode]);
+        for (s=0; s<NUM_SIZES; s++) {
+            printf(" %9.0f", run(mode, sizes[s], frames) / 1000.0);
+        }
+        printf("\n");
+    }
+}
+
+
+int main(int argc, char** argv) {
+    long    frames = (argc > 1) ? atol(argv[1]) : 200000;
+    int     i, s;
+
+    srand(1);
+    for (i=0; i<KEYS; i++) {
+        for (s=0; s<16; s++) keydata[i][s] = (uint8_t)rand();
+        EAXdrv_init(keydata[i], &ctx[i]);
+    }
+    for (i=0; i<BATCH; i++) {
+        for (s=0; s<260; s++) buf[i][s] = (uint8_t)rand();
+        for (s=0; s<7; s++)   nonce[i][s] = (uint8_t)rand();
+    }
+
+    printf(KERNEL_NAME ": kframes/s per core, by frame payload bytes\n");
+    printf("%-14s", "");
+    for (s=0; s<NUM_SIZES; s++) {
+        printf(" %9d", sizes[s]);
+    }
+    printf("\n");
+
+    bench(frames);
+    return 0;
+}
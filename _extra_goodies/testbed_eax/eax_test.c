@@ -0,0 +1,436 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_eax/eax_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Known answer tests for the stdc EAX driver and auth.c
+  *
+  * /platform/stdc/otlib_eax_stdc.c and /otlib/auth.c are built from the tree,
+  * with the headers in shim/.  The Makefile builds this test twice: tbeaxtest
+  * uses AES-NI if the CPU has it, and tbeaxtest_ct is built with EAX_NOAESNI,
+  * so it always runs the constant-time bitsliced AES.
+  *
+  * The known answers are for the M2NP DLLS profile (7 byte nonce, no header,
+  * 4 byte tag).  They were made with OpenSSL (AES-128-CTR and CMAC, composed
+  * as EAX), after that composition gave the vectors of the EAX paper.  The
+  * checks are:
+  * <LI> E([0]) in the keyed context, against FIPS-197 AES-128 </LI>
+  * <LI> the vectors through EAXdrv_encrypt(), EAXdrv_decrypt() and
+  *      EAXdrv_decrypt_batch(), with tampered frames and frames that are too
+  *      short for a tag </LI>
+  * <LI> the vectors with the last key through auth_encrypt(), auth_decrypt()
+  *      and auth_decrypt_batch(), with the key in a key file </LI>
+  * <LI> random frames, 0 to 255 bytes: batch and single decrypt must agree,
+  *      and undo the encryption </LI>
+  *
+  * Usage: tbeaxtest [random frames]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <otstd.h>
+#include <otlib/auth.h>
+#include <otlib/crypto.h>
+#include <otsys/veelite.h>
+
+#ifndef KERNEL_NAME
+#   define KERNEL_NAME  "AES-NI if available"
+#endif
+
+static int  failures = 0;
+
+#define CHECK(COND, ...)    do { if (!(COND)) { failures++; printf("FAIL: " __VA_ARGS__); printf("\n"); } } while (0)
+
+
+
+/** Veelite and rand stand-ins: the two root key files, in RAM
+  * ============================================================================
+  * auth.c loads 18 bytes from the start of auth_info.length, which is 2 bytes
+  * into auth_info.  So the key file is length, protocol, a 4 byte lifetime,
+  * and then the key, of which only the first 12 bytes reach the key cache.
+  * The rest of the cache stays 0, so the auth.c vectors use a key that ends
+  * in 4 zero bytes.
+  */
+static ot_u8    keyfile_data[2][22];
+static vlFILE   keyfile[2];
+static ot_u16   keyfile_gen[2];
+
+ot_u16 vl_generation(ot_u8 block_id, ot_u8 data_id) {
+    return keyfile_gen[data_id - ISF_ID(root_authentication_key)];
+}
+
+vlFILE* ISF_open_su(ot_u8 id) {
+    return &keyfile[id - ISF_ID(root_authentication_key)];
+}
+
+ot_uint vl_load(vlFILE* fp, ot_uint length, ot_u8* data) {
+    length = (length < fp->length) ? length : fp->length;
+    memcpy(data, fp->data, length);
+    return length;
+}
+
+ot_u8 vl_close(vlFILE* fp) {
+    return 0;
+}
+
+void rand_stream(ot_u8* rand_out, ot_int bytes_out) {
+    while (--bytes_out >= 0) *rand_out++ = (ot_u8)rand();
+}
+
+ot_u16 rand_prn16() {
+    return (ot_u16)rand();
+}
+
+
+static void put_keyfile(int index, const ot_u8* key) {
+    memset(keyfile_data[index], 0, sizeof(keyfile_data[index]));
+    keyfile_data[index][0]  = 16;           // length
+    memcpy(&keyfile_data[index][6], key, 16);
+    keyfile[index].length   = 22;
+    keyfile[index].data     = keyfile_data[index];
+    keyfile_gen[index]++;
+}
+
+
+
+
+/** Known answers
+  * ============================================================================
+  */
+static int hex(const char* s, ot_u8* out) {
+    int n = 0;
+    while (s[0] && s[1]) {
+        unsigned int v;
+        sscanf(s, "%2x", &v);
+        out[n++] = (ot_u8)v;
+        s += 2;
+    }
+    return n;
+}
+
+static const char* aes_kat[][2] = {
+    /* key, E(key, [0]) */
+    { "00000000000000000000000000000000", "66E94BD4EF8A2C3B884CFA59CA342B2E" },
+    { "000102030405060708090A0B0C0D0E0F", "C6A13B37878F5B826F4F8162A1C8D879" },
+};
+
+static const char* eax_kat[][4] = {
+    /* key, nonce, message, cipher || tag */
+    { "000102030405060708090A0B0C0D0E0F", "A1CC60AB69DADF",
+      "",
+      "3B16A33F" },
+    { "000102030405060708090A0B0C0D0E0F", "FC0BCDB740E35A",
+      "F1",
+      "8A1DCDD704" },
+    { "000102030405060708090A0B0C0D0E0F", "69840E2F477C74",
+      "85D7D1CCB728599416F5C48D103409",
+      "EF30CBB94D58D5E4D9EC54BD77EE0C0AEDD818" },
+    { "000102030405060708090A0B0C0D0E0F", "656A377D9EAC4C",
+      "50376A73B66522087F352712B56355D3",
+      "D8AC230933F35454C65CD17C973A150144A194AA" },
+    { "000102030405060708090A0B0C0D0E0F", "33C915DD75C9CE",
+      "F247C681EEB539BAB2124E8CB783EEEFEA",
+      "A2956A0DB772B934959636025A8241398F1CDD8FEB" },
+    { "2B7E151628AED2A6ABF7158809CF4F3C", "B309F09CC72C57",
+      "1AD4BD0CDC88493859BF4D23E083466B229392A96E0538A1439980355C137F",
+      "891AC51F95655BAC93988E935B2FE692F10B79B0122818963ACC31338ECBCA39"
+      "F3F3FA" },
+    { "2B7E151628AED2A6ABF7158809CF4F3C", "8EAC8B8B485B7A",
+      "E69D9E3CCDEFAE049CB0F0F24B0832DF4C89B19E1FA130A3E83D9AD4BD93566B",
+      "4DCC4E5F925D3191C0B12C42A6B9794E5A6505EF695A85A11C9D8BC07AAEDC8D"
+      "89CFEAF7" },
+    { "2B7E151628AED2A6ABF7158809CF4F3C", "D0F82047AC24D1",
+      "6BDF6B7318B19A16C86C8EB70373E0A300DC3B88BE68BAF0164D67A4DCB9D9E3"
+      "7DD7FFDDF63E375C09DBE2500E98808C",
+      "42AF0FCA3C8B3C49C92D1E84577E6179CCCF0D807F11A2EB8B87B7DFC18FD6EA"
+      "18AC5E937885174781D68148C8085C14C6D26974" },
+    { "2B7E151628AED2A6ABF7158809CF4F3C", "9EC65970C1B7E0",
+      "F39B3470FAF5C4BE2753CA6D14AA4AA38C7B02307ED5E4A325FBA9B557718BBF"
+      "D69DB301478285B6BB65C0D063556206FDC360A741AF44414D117A08AA9629",
+      "13F28B631D3CA1EF43D248916640FBA0E8067C40DA02848897B2E9FD50CE6D84"
+      "A7A07E9B3E2D4ABEE377205CFF0FF43905B9735AAAE95B7E65D26B1D24A7C19A"
+      "BFD284" },
+    { "2B7E151628AED2A6ABF7158809CF4F3C", "C39AC6DEE624AB",
+      "57BCA3D25A33805537956E289B5CCAF71F63D67736B1A2DA241E1BFF7911BC9D"
+      "8E80A5370DAA98EF7D0673DA939B92D195446F1D76FB5F6FE8FA88991FFA2E9E"
+      "ADF77CD0D991AE18A6578E6D4D4FE9FBA5D47FF612B897FCFE53FCD5E526DE40"
+      "F6CB23BF12D4B60F0875DF1A18ECCA09752DB2B6867A5943A2ABE6C5B9F6E842"
+      "985936E5CA7B4C9B3CB6580477A35E72E818B564C6FCD4565F68012244630E1F"
+      "7B6E8CA7F23B03862C59757D0C19B70B162481FB35D27483D488A2CA991BDDAD"
+      "188BA94FE31ECD2D130AEBE03D9D9B0D84C923FB3792BF815AE1FAD4472712D9"
+      "5ECB1033E9FE57EE5B909419660CFE011F770C81E4A1351704228936568803",
+      "18CDD6D0C67421661662C69234FBD055F3F83879CDA75323340D0A494C43E6CA"
+      "C9EC2E34CE54806A54CD5C6160B6B119BE157B22ED3A231A7B8CD2C7DF9F3C82"
+      "47BE2D015495B9345D06B22269FE7CFBF94E272A2868A86298D1D64C7C9F3C8E"
+      "405295A92138F6325DAD398B1DBCA9D3B3458AD3607AABBD7448F05037E2130C"
+      "87EBF04DE0B3726CC19E33440CDEF9DCAFA2C2F3FB8FF52300960D60D4F84BCE"
+      "A144ABCBAF86DB56878CB5EC45067F78629570E2B8B1306397E6DA8191FB7DF3"
+      "64E56CC2D1C80F793EC2EFD51C9B3A2B2D20C675D06390FE7BF2620B21C5574A"
+      "F542F392C8D7579E7EB6C89F6F9B624FF9D04813FD25D63A905940D7BBD0AFD4"
+      "32F1F8" },
+    { "8E73B0F7DA0E6452C810F32B00000000", "D3623A2AAB1BE5",
+      "",
+      "B31997D4" },
+    { "8E73B0F7DA0E6452C810F32B00000000", "88B59F2CC33834",
+      "6133E2B16BD6A5",
+      "992BA768BD725F7075AFEF" },
+    { "8E73B0F7DA0E6452C810F32B00000000", "807CE90A11B789",
+      "C969D5D737C6B930DC59B9AA6ACAEF78",
+      "C4523C3D2EBD0566D65CA34AC77E76C2A1DCBF25" },
+    { "8E73B0F7DA0E6452C810F32B00000000", "BA9D03C243B958",
+      "C5E6EBF9515BBD458514D37C7B6FA92EECFE2455A747C8CD9A0380EABFC4A391"
+      "9155C443C05B6B7C",
+      "2B34AC73063885105F7E125FDBB3B637E36C7BFF069676EC43EB8785102E932D"
+      "2B181E97484FEB40A5AE11B9" },
+};
+
+#define NUM_KAT     (int)(sizeof(eax_kat)/sizeof(eax_kat[0]))
+#define AUTH_KEY    "8E73B0F7DA0E6452C810F32B00000000"
+
+typedef struct {
+    ot_u8   key[16];
+    ot_u8   nonce[8];
+    ot_u8   plain[256];
+    ot_u8   cipher[260];
+    int     len;
+} kat_vector;
+
+static kat_vector   kat[NUM_KAT];
+static EAXdrv_t     kat_ctx[NUM_KAT];
+
+
+static void load_kat(void) {
+    int i;
+    for (i=0; i<NUM_KAT; i++) {
+        hex(eax_kat[i][0], kat[i].key);
+        hex(eax_kat[i][1], kat[i].nonce);
+        kat[i].len = hex(eax_kat[i][2], kat[i].plain);
+        hex(eax_kat[i][3], kat[i].cipher);
+        EAXdrv_init(kat[i].key, &kat_ctx[i]);
+    }
+}
+
+
+
+
+/** Tests
+  * ============================================================================
+  */
+static void test_aes(void) {
+    EAXdrv_t    ctx;
+    ot_u8       key[16], exp[16];
+    int         i;
+
+    for (i=0; i<(int)(sizeof(aes_kat)/sizeof(aes_kat[0])); i++) {
+        hex(aes_kat[i][0], key);
+        hex(aes_kat[i][1], exp);
+        EAXdrv_init(key, &ctx);
+        CHECK(memcmp(ctx.e0, exp, 16) == 0, "AES-128 of [0], key %s", aes_kat[i][0]);
+        EAXdrv_clear(&ctx);
+    }
+}
+
+
+static void test_driver(void) {
+    static ot_u8    buf[NUM_KAT+2][260];
+    EAXdrv_frame    frame[NUM_KAT+2];
+    int             i, n, bad, good;
+
+    for (i=0; i<NUM_KAT; i++) {
+        int len = kat[i].len;
+
+        memcpy(buf[i], kat[i].plain, len);
+        n = EAXdrv_encrypt(kat[i].nonce, buf[i], (ot_uint)len, &kat_ctx[i]);
+        CHECK((n == 0) && (memcmp(buf[i], kat[i].cipher, len+4) == 0),
+              "EAXdrv_encrypt, vector %d (%d bytes)", i, len);
+
+        n = EAXdrv_decrypt(kat[i].nonce, buf[i], (ot_uint)(len+4), &kat_ctx[i]);
+        CHECK((n == 0) && (memcmp(buf[i], kat[i].plain, len) == 0),
+              "EAXdrv_decrypt, vector %d (%d bytes)", i, len);
+
+        memcpy(buf[i], kat[i].cipher, len+4);
+        buf[i][rand() % (len+4)] ^= (ot_u8)(1 << (rand() & 7));
+        n = EAXdrv_decrypt(kat[i].nonce, buf[i], (ot_uint)(len+4), &kat_ctx[i]);
+        CHECK(n != 0, "EAXdrv_decrypt, vector %d tampered: accepted", i);
+    }
+
+    /// All vectors in one batch, every third one tampered, and two frames
+    /// that are too short for a tag.
+    for (i=0, bad=0; i<NUM_KAT+2; i++) {
+        int k = i % NUM_KAT;
+        memcpy(buf[i], kat[k].cipher, kat[k].len+4);
+        if ((i % 3) == 1) {
+            buf[i][rand() % (kat[k].len+4)] ^= 0x10;
+        }
+        frame[i].nonce      = kat[k].nonce;
+        frame[i].data       = buf[i];
+        frame[i].datalen    = (ot_uint)(kat[k].len+4);
+        frame[i].context    = &kat_ctx[k];
+        frame[i].retval     = 99;
+    }
+    frame[NUM_KAT].datalen      = 3;
+    frame[NUM_KAT+1].datalen    = 0;
+    good = EAXdrv_decrypt_batch(frame, NUM_KAT+2);
+
+    for (i=0, n=0; i<NUM_KAT+2; i++) {
+        int k = i % NUM_KAT;
+        bad = ((i % 3) == 1) || (i >= NUM_KAT);
+        n  += !bad;
+        CHECK((frame[i].retval != 0) == bad, "EAXdrv_decrypt_batch, frame %d: verdict", i);
+        CHECK(bad || (memcmp(buf[i], kat[k].plain, kat[k].len) == 0),
+              "EAXdrv_decrypt_batch, frame %d: data", i);
+    }
+    CHECK(good == n, "EAXdrv_decrypt_batch: %d good, expected %d", good, n);
+}
+
+
+static void test_auth(void) {
+    static ot_u8    buf[NUM_KAT][260];
+    auth_frame      frame[NUM_KAT];
+    ot_u8           key[16], other[16];
+    int             i, n, len, count;
+    ot_int          r;
+
+    hex(AUTH_KEY, key);
+    memset(other, 0x5A, 16);
+    put_keyfile(0, key);
+    put_keyfile(1, other);
+    auth_init();
+
+    for (i=0, count=0; i<NUM_KAT; i++) {
+        if (memcmp(kat[i].key, key, 16) != 0) {
+            continue;
+        }
+        len = kat[i].len;
+
+        memcpy(buf[i], kat[i].plain, len);
+        r = auth_encrypt(kat[i].nonce, buf[i], (ot_uint)len, 0, 0);
+        CHECK((r == 4) && (memcmp(buf[i], kat[i].cipher, len+4) == 0),
+              "auth_encrypt, vector %d: returned %d", i, r);
+
+        r = auth_decrypt(kat[i].nonce, buf[i], (ot_uint)(len+4), 0, 0);
+        CHECK((r == 4) && (memcmp(buf[i], kat[i].plain, len) == 0),
+              "auth_decrypt, vector %d: returned %d", i, r);
+
+        /// The other key file, and then a tampered frame
+        memcpy(buf[i], kat[i].cipher, len+4);
+        r = auth_decrypt(kat[i].nonce, buf[i], (ot_uint)(len+4), 1, 0);
+        CHECK(r == -2, "auth_decrypt, vector %d, wrong key: returned %d", i, r);
+        memcpy(buf[i], kat[i].cipher, len+4);
+        buf[i][len] ^= 1;
+        r = auth_decrypt(kat[i].nonce, buf[i], (ot_uint)(len+4), 0, 0);
+        CHECK(r == -2, "auth_decrypt, vector %d, tampered: returned %d", i, r);
+
+        /// For the batch: the right key file on even frames, the other on odd
+        memcpy(buf[i], kat[i].cipher, len+4);
+        frame[count].nonce      = kat[i].nonce;
+        frame[count].data       = buf[i];
+        frame[count].datalen    = (ot_uint)(len+4);
+        frame[count].key_index  = (ot_u8)(count & 1);
+        frame[count].retval     = 99;
+        count++;
+    }
+    CHECK(count == 4, "auth.c vectors: %d, expected 4", count);
+
+    n = auth_decrypt_batch(frame, (ot_int)count, 0);
+    CHECK(n == (count+1)/2, "auth_decrypt_batch: %d good, expected %d", n, (count+1)/2);
+    for (i=0; i<count; i++) {
+        CHECK(frame[i].retval == ((i & 1) ? -2 : 4), "auth_decrypt_batch, frame %d: returned %d",
+              i, frame[i].retval);
+    }
+
+    /// Rewriting the key file must reload the key
+    put_keyfile(1, key);
+    for (i=0; i<NUM_KAT; i++) {
+        if (memcmp(kat[i].key, key, 16) == 0) {
+            len = kat[i].len;
+            memcpy(buf[i], kat[i].cipher, len+4);
+            r = auth_decrypt(kat[i].nonce, buf[i], (ot_uint)(len+4), 1, 0);
+            CHECK((r == 4) && (memcmp(buf[i], kat[i].plain, len) == 0),
+                  "auth_decrypt, vector %d, key file rewritten: returned %d", i, r);
+        }
+    }
+}
+
+
+static void test_random(int frames) {
+/// Without a reference: decrypt must undo encrypt, batch and single must
+/// agree, and tampered frames must fail.  Lengths are mixed, so the lanes
+/// of the batch engine end at different blocks.
+    static ot_u8    plain[64][260], cipher[64][260], buf[64][260];
+    static ot_u8    nonce[64][8];
+    EAXdrv_t        ctx[4];
+    EAXdrv_frame    frame[64];
+    ot_u8           key[16];
+    int             i, f, n, len[64], bad[64];
+
+    for (i=0; i<frames; i+=64) {
+        for (f=0; f<4; f++) {
+            rand_stream(key, 16);
+            EAXdrv_init(key, &ctx[f]);
+        }
+        for (f=0; f<64; f++) {
+            len[f] = rand() % 256;
+            bad[f] = ((rand() % 5) == 0);
+            rand_stream(nonce[f], 7);
+            rand_stream(plain[f], len[f]);
+            memcpy(cipher[f], plain[f], len[f]);
+            EAXdrv_encrypt(nonce[f], cipher[f], (ot_uint)len[f], &ctx[f&3]);
+            if (bad[f]) {
+                cipher[f][rand() % (len[f]+4)] ^= (ot_u8)(1 << (rand() & 7));
+            }
+
+            memcpy(buf[f], cipher[f], len[f]+4);
+            n = EAXdrv_decrypt(nonce[f], buf[f], (ot_uint)(len[f]+4), &ctx[f&3]);
+            CHECK((n != 0) == bad[f], "random frame, %d bytes: verdict", len[f]);
+            CHECK(bad[f] || (memcmp(buf[f], plain[f], len[f]) == 0), "random frame, %d bytes: data", len[f]);
+
+            memcpy(buf[f], cipher[f], len[f]+4);
+            frame[f].nonce      = nonce[f];
+            frame[f].data       = buf[f];
+            frame[f].datalen    = (ot_uint)(len[f]+4);
+            frame[f].context    = &ctx[f&3];
+        }
+        EAXdrv_decrypt_batch(frame, 64);
+        for (f=0; f<64; f++) {
+            CHECK((frame[f].retval != 0) == bad[f], "random batch, frame %d: verdict", f);
+            CHECK(bad[f] || (memcmp(buf[f], plain[f], len[f]) == 0), "random batch, frame %d: data", f);
+        }
+    }
+}
+
+
+
+
+int main(int argc, char** argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 4096;
+
+    srand(1);
+    printf(KERNEL_NAME "\n");
+    load_kat();
+    test_aes();
+    test_driver();
+    test_auth();
+    test_random(frames);
+
+    printf("%d vectors, %d random frames: %s (%d failures)\n", NUM_KAT, frames,
+            failures ? "FAILED" : "PASSED", failures);
+    return (failures != 0);
+}
@@ -0,0 +1,44 @@
+/* Host stand-in for the OpenTag otstd.h, for the EAX testbed */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef int8_t      ot_s8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_s16;
+typedef int16_t     ot_int;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint32_t    ot_ulong;
+typedef int32_t     ot_s32;
+typedef uint8_t     ot_bool;
+
+typedef union {
+    ot_u16  ushort;
+    ot_u8   ubyte[2];
+} ot_uni16;
+
+#define True            1
+#define False           0
+#define ENABLED         1
+#define DISABLED        0
+#define NOT_AVAILABLE   0
+#define OT_INLINE       inline
+#define OT_WEAK         __attribute__((weak))
+
+#define OT_FEATURE(VAL)             OT_FEATURE_##VAL
+#define OT_FEATURE_DLL_SECURITY     ENABLED
+#define OT_FEATURE_NL_SECURITY      DISABLED
+#define OT_FEATURE_VL_SECURITY      DISABLED
+#define OT_FEATURE_CRYPTO_RFAES     DISABLED
+#define OT_FEATURE_CRYPTO_KEYCACHE  ENABLED
+#define OT_FEATURE_TIME             DISABLED
+
+#define OT_PARAM(VAL)               OT_PARAM_##VAL
+
+#endif
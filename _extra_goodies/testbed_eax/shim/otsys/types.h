@@ -0,0 +1,5 @@
+/* Host stand-in for otsys/types.h */
+#ifndef __SHIM_OTSYS_TYPES_H
+#define __SHIM_OTSYS_TYPES_H
+#include <otstd.h>
+#endif
@@ -0,0 +1,21 @@
+/* Host stand-in for otsys/veelite.h: the calls auth.c makes for key files */
+#ifndef __SHIM_OTSYS_VEELITE_H
+#define __SHIM_OTSYS_VEELITE_H
+#include <otstd.h>
+#include <m2/tmpl.h>
+
+#define VL_ISF_BLOCKID          3
+#define ISF_ID(NAME)            ISF_ID_##NAME
+#define ISF_ID_root_authentication_key  0x1A
+
+typedef struct {
+    ot_u16  length;
+    ot_u8*  data;
+} vlFILE;
+
+ot_u16  vl_generation(ot_u8 block_id, ot_u8 data_id);
+vlFILE* ISF_open_su(ot_u8 id);
+ot_uint vl_load(vlFILE* fp, ot_uint length, ot_u8* data);
+ot_u8   vl_close(vlFILE* fp);
+
+#endif
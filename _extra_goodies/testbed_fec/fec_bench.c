@@ -0,0 +1,365 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_fec/fec_bench.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      SW FEC codec of /m2/encode.c against the old Viterbi decoder
+  *
+  * m2/encode.c, otlib/crc16.c and otlib/queue.c are built from the tree, for
+  * a radio with no HW PN9, CRC or FEC (shim/otstd.h).  The radio FIFO is a
+  * buffer of bytes on air, filled and emptied four bytes at a time, like
+  * radio_null.  tbfec_sse2 also links /platform/stdc/m2_encode_stdc.c, so
+  * its em2_fec_viterbi() is the SSE2 one.
+  *
+  * A batch of random frames is encoded with em2_encode_data(), and channel
+  * bits are flipped at the given rate.  The batch is decoded twice:
+  * <LI> reference: the symbol-at-a-time Viterbi that /m2/encode.c used to
+  *      have (trellis tables, hamming_weight(), output from state 0).  It
+  *      only does FEC, so its output is compared with the whitened frame,
+  *      which is the frame XOR the PN9 sequence from the old LFSR. </LI>
+  * <LI> tree: em2_decode_data() and em2_decode_endframe(), which do FEC, PN9
+  *      and CRC.  A frame error is a CRC error or a mismatch. </LI>
+  *
+  * With no channel errors, both must decode every frame.  This also checks
+  * the tree FEC encoder and PN9 keystream against the old decoder and LFSR.
+  *
+  * Usage: tbfec [frame bytes] [channel errors per 1000 bits] [frames]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <otlib/buffers.h>
+#include <otlib/crc16.h>
+#include <m2/encode.h>
+#include <m2/radio.h>
+
+#ifndef KERNEL_NAME
+#   define KERNEL_NAME  "scalar"
+#endif
+
+#define MAX_FRAME       254                         // before CRC
+#define MAX_AIR         ((((MAX_FRAME+2) >> 1) + 1) << 2)
+
+ot_queue    txq;
+ot_queue    rxq;
+
+
+
+/** Radio FIFO stand-ins: a buffer of bytes on air
+  * ============================================================================
+  */
+static ot_u8*   air;
+static ot_int   air_put;
+static ot_int   air_get;
+static ot_int   air_len;
+
+ot_bool radio_txopen_4()    { return (ot_bool)((air_put + 4) <= MAX_AIR); }
+ot_bool radio_rxopen_4()    { return (ot_bool)((air_get + 4) <= air_len); }
+ot_int radio_txspan()       { return (ot_int)(MAX_AIR - air_put); }
+ot_int radio_rxspan()       { return (ot_int)(air_len - air_get); }
+
+void radio_putfourbytes(ot_u8* data) {
+/// As in radio_null: the high byte goes first
+    air[air_put++] = data[3];
+    air[air_put++] = data[2];
+    air[air_put++] = data[1];
+    air[air_put++] = data[0];
+}
+
+void radio_getfourbytes(ot_u8* data) {
+    memcpy(data, &air[air_get], 4);
+    air_get += 4;
+}
+
+void radio_putbytes(ot_u8* data, ot_int length) {
+    memcpy(&air[air_put], data, length);
+    air_put += length;
+}
+
+void radio_getbytes(ot_u8* data, ot_int length) {
+    memcpy(data, &air[air_get], length);
+    air_get += length;
+}
+
+
+
+
+/** Reference decoder (the old em2_decode_data_FEC)
+  * ============================================================================
+  */
+static const uint8_t TrellisSourceState[8][2] = {
+    {0, 4}, {0, 4}, {1, 5}, {1, 5}, {2, 6}, {2, 6}, {3, 7}, {3, 7}
+};
+static const uint8_t TrellisTransitionOutput[8][2] = {
+    {0, 3}, {3, 0}, {1, 2}, {2, 1}, {3, 0}, {0, 3}, {2, 1}, {1, 2}
+};
+static const uint8_t TrellisTransitionInput[8] = { 0, 1, 0, 1, 0, 1, 0, 1 };
+
+static uint8_t hamming_weight(uint8_t a) {
+    a = ((a & 0xAA) >> 1) + (a & 0x55);
+    a = ((a & 0xCC) >> 2) + (a & 0x33);
+    a = ((a & 0xF0) >> 4) + (a & 0x0F);
+    return a;
+}
+
+static uint8_t min(uint8_t a, uint8_t b) {
+    return (a <= b) ? a : b;
+}
+
+static int ref_decode(uint8_t* dst, const uint8_t* air, int n) {
+    uint8_t     cost_matrix[2][8]   = { {0,100,100,100,100,100,100,100}, {0} };
+    uint32_t    path_matrix[2][8]   = { {0}, {0} };
+    int         last = 0, current = 1;
+    int         path_bits = 0;
+    int         databytes = n;
+    int         out = 0;
+    int         i, j;
+    uint8_t     min_cost = 0;
+
+    while (1) {
+        uint8_t deint_data[4];
+        uint8_t* data_in = deint_data;
+        int bit_shift = 6;
+
+        for (i=0; i<4; i++) {
+            uint8_t input = 0;
+            for (j=3; j>=0; j--) {
+                input <<= 2;
+                input  |= (air[j] >> (i<<1)) & 0x03;
+            }
+            deint_data[i] = input;
+        }
+        air += 4;
+
+        for (i=16; i>0; i--) {
+            uint8_t symbol;
+            min_cost    = 0xFF;
+            symbol      = ((*data_in) >> bit_shift) & 0x03;
+            bit_shift  -= 2;
+            if (bit_shift < 0) {
+                bit_shift = 6;
+                data_in++;
+            }
+
+            for (j=0; j<8; j++) {
+                uint8_t state0, state1, cost0, cost1, input;
+                input   = TrellisTransitionInput[j];
+                state0  = TrellisSourceState[j][0];
+                cost0   = cost_matrix[last][state0];
+                cost0  += hamming_weight(symbol ^ TrellisTransitionOutput[j][0]);
+                state1  = TrellisSourceState[j][1];
+                cost1   = cost_matrix[last][state1];
+                cost1  += hamming_weight(symbol ^ TrellisTransitionOutput[j][1]);
+
+                if (cost0 <= cost1) {
+                    cost_matrix[current][j] = cost0;
+                    path_matrix[current][j] = (path_matrix[last][state0] << 1) | input;
+                    min_cost                = min(min_cost, cost0);
+                }
+                else {
+                    cost_matrix[current][j] = cost1;
+                    path_matrix[current][j] = (path_matrix[last][state1] << 1) | input;
+                    min_cost                = min(min_cost, cost1);
+                }
+            }
+            path_bits++;
+
+            if (path_bits == 32) {
+                path_bits  -= 8;
+                dst[out++]  = (uint8_t)(path_matrix[current][0] >> 24);
+                databytes--;
+            }
+            if ((databytes <= 3) && (path_bits == ((databytes<<3) + 3))) {
+                while (path_bits >= 8) {
+                    path_bits  -= 8;
+                    dst[out++]  = (uint8_t)(path_matrix[current][0] >> path_bits);
+                }
+                return out;
+            }
+            last    = (last+1) & 1;
+            current = (current+1) & 1;
+        }
+        for (j=0; j<8; j++) {
+            cost_matrix[last][j] -= min_cost;
+        }
+    }
+}
+
+
+
+
+/** Old PN9 LFSR, nibble-wise, from the 0x1FF seed
+  * ============================================================================
+  */
+static void ref_pn9(uint8_t* key, int n) {
+    uint16_t reg = 0x01FF;
+    uint16_t x;
+    int i;
+
+    for (i=0; i<n; i++) {
+        key[i]  = (uint8_t)reg;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+    }
+}
+
+
+
+
+/** Tree codec
+  * ============================================================================
+  */
+static ot_u8 txbuf[256];
+static ot_u8 rxbuf[256];
+
+static int tree_encode(ot_u8* frame, ot_u8* dst, const ot_u8* payload, int bytes) {
+/// Encodes a frame of "bytes" bytes (length byte, link control, payload) and
+/// returns the bytes on air.  The frame with its CRC5 and CRC16 goes in frame.
+    int i;
+
+    q_init(&txq, txbuf, sizeof(txbuf));
+    txq.options.ubyte[UPPER]    = 1;        // first TX: add the CRC
+    txq.options.ubyte[LOWER]    = 1;        // FEC
+    q_writebyte(&txq, (ot_u8)(bytes - 1));
+    q_writebyte(&txq, 0);
+    for (i=2; i<bytes; i++) {
+        q_writebyte(&txq, payload[i]);
+    }
+
+    air     = dst;
+    air_put = 0;
+    em2_encode_newpacket();
+    em2_encode_newframe();
+    em2_encode_data();
+
+    memcpy(frame, txbuf, bytes + 2);
+    return air_put;
+}
+
+
+static int tree_decode(const ot_u8* frame, ot_u8* src, int air_bytes) {
+/// Returns 0 if the frame is decoded without error
+    q_init(&rxq, rxbuf, sizeof(rxbuf));
+    rxq.options.ubyte[LOWER]    = 1;        // FEC
+    txq.options.ubyte[LOWER]    = 1;        // em2_decode_newpacket() looks here
+
+    air     = src;
+    air_get = 0;
+    air_len = (ot_int)air_bytes;
+    em2_decode_newpacket();
+    em2_decode_newframe();
+    while ((em2_remaining_bytes() > 0) && radio_rxopen_4()) {
+        em2_decode_data();
+    }
+    if (em2_remaining_bytes() > 0) {
+        return -1;
+    }
+    if (em2_decode_endframe() != 0) {
+        return -1;
+    }
+    /// em2_decode_endframe() leaves the number of frame bytes without CRC16
+    /// in the length byte, i.e. the length byte + 1 before the CRC was added.
+    return (rxbuf[0] != (frame[0] - 1)) || (memcmp(&rxbuf[1], &frame[1], rxbuf[0] - 1) != 0);
+}
+
+
+
+
+/** Benchmark
+  * ============================================================================
+  */
+
+int main(int argc, char** argv) {
+    int         bytes   = 64;
+    int         ber     = 0;
+    int         frames  = 20000;
+    int         air_bytes = 0;
+    ot_u8*      frame;
+    ot_u8*      onair;
+    ot_u8       key[256];
+    ot_u8       dst[256];
+    ot_u8       payload[256];
+    int         d, f, i;
+
+    if (argc > 1)   bytes   = atoi(argv[1]);
+    if (argc > 2)   ber     = atoi(argv[2]);
+    if (argc > 3)   frames  = atoi(argv[3]);
+    bytes = (bytes < 4) ? 4 : ((bytes > MAX_FRAME) ? MAX_FRAME : bytes);
+
+    frame   = malloc((size_t)frames * 256);
+    onair   = malloc((size_t)frames * MAX_AIR);
+    ref_pn9(key, sizeof(key));
+    srand(1);
+
+    /// Encode the batch, then flip channel bits at the given rate
+    for (f=0; f<frames; f++) {
+        for (i=0; i<bytes; i++) {
+            payload[i] = (ot_u8)rand();
+        }
+        air_bytes = tree_encode(&frame[f*256], &onair[f*MAX_AIR], payload, bytes);
+        for (i=0; i<(air_bytes<<3); i++) {
+            if ((rand() % 1000) < ber) {
+                onair[f*MAX_AIR + (i>>3)] ^= (ot_u8)(1 << (i&7));
+            }
+        }
+    }
+
+    printf("%d byte frames + CRC (%d bytes on air), %d/1000 channel bit errors, %d frames\n",
+            bytes, air_bytes, ber, frames);
+    printf("decoder          frames/s   Mbit/s   frame errors\n");
+
+    for (d=0; d<2; d++) {
+        clock_t start;
+        double  secs;
+        int     errors = 0;
+
+        start = clock();
+        for (f=0; f<frames; f++) {
+            ot_u8* fr = &frame[f*256];
+            ot_u8* fa = &onair[f*MAX_AIR];
+            if (d == 0) {
+                ref_decode(dst, fa, bytes+2);
+                for (i=0; (i<bytes+2) && ((dst[i] ^ key[i]) == fr[i]); i++);
+                errors += (i < bytes+2);
+            }
+            else {
+                errors += (tree_decode(fr, fa, air_bytes) != 0);
+            }
+        }
+        secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        printf("%-14s %10.0f %8.2f %14d\n", (d == 0) ? "reference" : "tree " KERNEL_NAME,
+                frames / secs, (8.0 * bytes * frames) / (secs * 1e6), errors);
+        if ((ber == 0) && (errors != 0)) {
+            printf("\nFAILED: frame errors with no channel errors\n");
+            return 1;
+        }
+    }
+
+    free(frame);
+    free(onair);
+    return 0;
+}
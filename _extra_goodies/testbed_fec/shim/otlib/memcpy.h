@@ -0,0 +1,4 @@
+/* Host stand-in for otlib/memcpy.h */
+#include <otstd.h>
+#define ot_memcpy(DST, SRC, LEN)    memcpy(DST, SRC, LEN)
+#define ot_memset(DST, VAL, LEN)    memset(DST, VAL, LEN)
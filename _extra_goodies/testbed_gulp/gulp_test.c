@@ -0,0 +1,217 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_gulp/gulp_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Big GULP yielding: pre-emption points and resume order
+  *
+  * otsys/system_gulp.c is built from the tree, with the task list of an
+  * endpoint without MPipe (shim/otsys/syskern.h): radio, hold, sleep.  The
+  * DLL task functions are the test tasks.  The sleep task is a long task
+  * written with SYS_THREAD_BEGIN/YIELD/END, that does 8 chunks of work and
+  * has a pre-emption point after each one.  The radio task is the higher
+  * priority task, and it is pended from inside a chunk, as an ISR would.
+  *
+  * The kernel timer is simulated: work() advances it, and the run loop does
+  * what platform_ot_run() does, running sys_event_manager() and then either
+  * the selected task or a sleep until the kernel timer.  Each case checks the
+  * order in which the chunks, the yields and the radio task run.
+  *
+  * Usage: tbgulptest
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <otstd.h>
+#include <otsys/syskern.h>
+#include <m2/dll.h>
+
+
+#define LONG_CHUNKS     8
+#define LONG_CHUNKTI    5
+
+static ot_u32   now_abs;
+static ot_u32   ktim_base;
+static char     trace[256];
+
+static struct {
+    ot_int  chunk;
+    ot_int  irq_chunk;          // chunk during which the radio task is pended
+    ot_int  tick_chunk;         // chunk during which sys_task_manager() runs
+    ot_int  sync_chunk;         // chunk after which the task is resynchronized
+} lt;
+
+
+
+/** Platform and kernel timer stand-ins
+  * ========================================================================
+  */
+ot_u32 systim_get()                     { return now_abs - ktim_base; }
+void systim_flush()                     { ktim_base = now_abs; }
+void systim_disable()                   { }
+void platform_set_ktim(ot_u16 value)    { }
+void platform_ot_preempt()              { }
+void platform_drop_context(ot_uint i)   { }
+void time_add_ti(ot_u32 ticks)          { }
+void dll_init(void)                     { }
+void dll_clock(ot_uint ticks)           { }
+
+
+static void log_str(const char* s) {
+    strncat(trace, s, sizeof(trace) - strlen(trace) - 1);
+}
+
+static void work(ot_u32 ticks) {
+    now_abs += ticks;
+}
+
+
+
+
+/** Test tasks
+  * ========================================================================
+  */
+void dll_systask_rf(ot_task task) {
+    if (task->event != 0) {
+        task->event = 0;
+        log_str("R ");
+    }
+}
+
+void dll_systask_holdscan(ot_task task) {
+}
+
+void dll_systask_sleepscan(ot_task task) {
+/// The long task.  Its only state across a yield is lt.chunk, which is static.
+    char s[16];
+
+    if (task->event == 0) {
+        return;
+    }
+
+    SYS_THREAD_BEGIN(task);
+    for (lt.chunk=0; lt.chunk<LONG_CHUNKS; lt.chunk++) {
+        work(LONG_CHUNKTI);
+        if (lt.chunk == lt.irq_chunk) {
+            sys.task[TASK_radio].event = 1;
+            sys_task_setnext_clocks(&sys.task[TASK_radio], 0);
+        }
+        if (lt.chunk == lt.tick_chunk) {
+            sys_task_manager();
+        }
+        sprintf(s, "L%d ", lt.chunk);
+        log_str(s);
+
+        SYS_THREAD_YIELD(task, 1);
+    }
+    task->event = 0;
+    SYS_THREAD_END(task);
+}
+
+
+
+
+/** Run loop and cases
+  * ========================================================================
+  */
+static void run(ot_u32 duration) {
+/// What platform_ot_run() does, without the sleep: the task runs if the event
+/// manager returns 0, else the kernel timer is advanced to the next event.
+    ot_u32  end = now_abs + duration;
+    ot_uint wait;
+
+    while (now_abs < end) {
+        wait = sys_event_manager();
+        if (wait == 0) {
+            Task_Index active = sys.active;
+
+            sys_run_task();
+            if ((active == TASK_sleep) && (sys.task[active].event != 0)) {
+                log_str("| ");      // returned at a pre-emption point
+            }
+        }
+        else {
+            work((wait < (end - now_abs)) ? wait : (end - now_abs));
+        }
+    }
+}
+
+
+static int run_case(const char* name, ot_u8 reserve, ot_int irq_chunk,
+                    ot_int tick_chunk, ot_int sync_chunk, const char* expected) {
+    ot_int  len;
+
+    now_abs     = 0;
+    ktim_base   = 0;
+    trace[0]    = 0;
+    lt.irq_chunk    = irq_chunk;
+    lt.tick_chunk   = tick_chunk;
+    lt.sync_chunk   = sync_chunk;
+
+    sys_init();
+    sys.task[TASK_radio].latency    = 255;
+    sys.task[TASK_sleep].event      = 1;
+    sys.task[TASK_sleep].reserve    = reserve;
+    sys.task[TASK_sleep].latency    = 255;
+    sys_task_setnext(&sys.task[TASK_sleep], 0);
+
+    if (sync_chunk >= 0) {
+        /// Run until the task has yielded after the chunk, then resynchronize
+        /// it, which must restart the coroutine from the top.
+        while ((lt.chunk <= sync_chunk) || (sys.task[TASK_sleep].cursor == 0)) {
+            run(1);
+        }
+        log_str("S ");
+        lt.sync_chunk = -1;
+        sys_synchronize(TASK_sleep);
+    }
+    run(500);
+
+    len = (ot_int)strlen(trace);
+    if ((len > 0) && (trace[len-1] == ' ')) {
+        trace[len-1] = 0;
+    }
+    if (strcmp(trace, expected) != 0) {
+        printf("%-24s FAILED\n    got:      %s\n    expected: %s\n", name, trace, expected);
+        return -1;
+    }
+    printf("%-24s %s\n", name, trace);
+    return 0;
+}
+
+
+
+int main(int argc, char** argv) {
+    int rc = 0;
+
+    rc |= run_case("no pre-emption", 255, -1, -1, -1,
+                   "L0 L1 L2 L3 L4 L5 L6 L7");
+    rc |= run_case("higher priority pends", 255, 1, -1, -1,
+                   "L0 L1 | R L2 L3 L4 L5 L6 L7");
+    rc |= run_case("reserve is spent", 12, -1, -1, -1,
+                   "L0 L1 L2 | L3 L4 L5 | L6 L7");
+    rc |= run_case("sys_task_manager()", 255, -1, 4, -1,
+                   "L0 L1 L2 L3 L4 | L5 L6 L7");
+    rc |= run_case("resync restarts", 12, -1, -1, 1,
+                   "L0 L1 L2 | S L0 L1 L2 | L3 L4 L5 | L6 L7");
+
+    printf("\n%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
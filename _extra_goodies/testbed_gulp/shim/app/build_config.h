@@ -0,0 +1,2 @@
+/* Host stand-in: the testbed builds the GULP kernel */
+#define __KERNEL_GULP__
@@ -0,0 +1,7 @@
+/* Host stand-in for m2/dll.h: the DLL tasks are the test tasks */
+#include <otsys/syskern.h>
+void dll_init(void);
+void dll_clock(ot_uint ticks);
+void dll_systask_rf(ot_task task);
+void dll_systask_holdscan(ot_task task);
+void dll_systask_sleepscan(ot_task task);
@@ -0,0 +1,13 @@
+/* Host stand-in for otplatform.h: the kernel timer, provided by the test */
+#ifndef __OTPLATFORM_H
+#define __OTPLATFORM_H
+#include <otstd.h>
+
+ot_u32 systim_get();
+void systim_flush();
+void systim_disable();
+void platform_set_ktim(ot_u16 value);
+void platform_ot_preempt();
+void platform_drop_context(ot_uint i);
+
+#endif
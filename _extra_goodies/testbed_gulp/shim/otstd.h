@@ -0,0 +1,51 @@
+/* Host stand-in for the OpenTag otstd.h, for the GULP kernel testbed */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef int8_t      ot_s8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_int;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint32_t    ot_ulong;
+typedef uint8_t     ot_bool;
+typedef void (*ot_sub)(void);
+
+#define True        1
+#define False       0
+#define ENABLED     1
+#define DISABLED    0
+#define OT_INLINE   inline
+#define OT_WEAK     __attribute__((weak))
+
+#define OT_FEATURE(VAL)                 OT_FEATURE_##VAL
+#define OT_FEATURE_SYSTASK_CALLBACKS    DISABLED
+#define OT_FEATURE_SYSKERN_CALLBACKS    DISABLED
+#define OT_FEATURE_MPIPE                DISABLED
+#define OT_FEATURE_CRON                 DISABLED
+#define OT_FEATURE_EXT_TASK             DISABLED
+#define OT_FEATURE_ENERGY               DISABLED
+#define OT_PARAM(VAL)                   OT_PARAM_##VAL
+#define OT_PARAM_EXOTASKS               0
+#define OT_PARAM_KERNELTASKS            0
+
+#define M2_FEATURESET                   ENABLED
+#define M2_FEATURE(VAL)                 ((M2_FEATURE_##VAL) && (M2_FEATURESET))
+#define M2_FEATURE_BEACONS              DISABLED
+#define M2_FEATURE_ENDPOINT             ENABLED
+#define M2_FEATURE_RTC_SCHEDULER        DISABLED
+#define M2_FEATURE_BEACON_THRESH        0
+
+/* The kernel functions that drive the radio and the MCU sleep modes */
+#define EXTF_sys_panic
+#define EXTF_sys_powerdown
+#define EXTF_sys_halt
+#define EXTF_sys_resume
+
+#endif
@@ -0,0 +1,3 @@
+/* Host stand-in: energy accounting is off */
+#define ENERGY_CPU(STATE)        do { } while(0)
+#define ENERGY_FLUSH(ELAPSED)    do { } while(0)
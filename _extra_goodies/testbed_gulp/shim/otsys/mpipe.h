@@ -0,0 +1 @@
+/* Host stand-in: MPipe is off */
@@ -0,0 +1 @@
+/* Host stand-in: the external task is off */
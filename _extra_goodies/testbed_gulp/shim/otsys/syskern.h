@@ -0,0 +1,44 @@
+/* Host stand-in for otsys/syskern.h: the task list of an endpoint without
+ * MPipe, and the kernel calls that system_gulp.c uses before defining them */
+#ifndef __OTSYS_SYSKERN_H
+#define __OTSYS_SYSKERN_H
+
+#include <otplatform.h>
+#include <app/build_config.h>
+#include <otsys/kernels/system_gulp.h>
+
+#define TI2CLK(TICKS)   ((ot_long)(TICKS))
+
+typedef enum {
+    TASK_idle = -1,
+    TASK_radio = 0,
+    TASK_hold,
+    TASK_sleep,
+    TASK_terminus
+} Task_Index;
+
+#define SYS_TASKS       TASK_terminus
+#define RFA_INDEX       TASK_radio
+#define task_RFA        task[RFA_INDEX]
+
+typedef struct {
+    Task_Index      active;
+    ot_task_struct  task[TASK_terminus];
+} sys_struct;
+
+extern sys_struct sys;
+
+void sys_init();
+void sys_kill(Task_Index i);
+void sys_kill_active();
+void sys_kill_all();
+ot_uint sys_event_manager();
+void sys_task_manager();
+void sys_run_task();
+void sys_preempt(ot_task task, ot_uint nextevent_ti);
+void sys_synchronize(Task_Index task_id);
+void sys_refresh_scheduler();
+void sys_task_setnext(ot_task task, ot_u16 nextevent_ti);
+void sys_task_setnext_clocks(ot_task task, ot_long nextevent_clocks);
+
+#endif
@@ -0,0 +1,3 @@
+/* Host stand-in for otsys/time.h: only the time base update */
+#include <otstd.h>
+void time_add_ti(ot_u32 ticks);
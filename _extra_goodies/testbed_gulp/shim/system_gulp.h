@@ -0,0 +1,2 @@
+/* Host stand-in: system_gulp.c includes its header by plain name */
+#include <otsys/kernels/system_gulp.h>
@@ -0,0 +1,400 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_m2dp/m2dp_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Multiframe packets, from m2dp_append() to network_route_ff()
+  *
+  * m2/network.c, m2/encode.c, otlib/crc16.c and otlib/queue.c are built from
+  * the tree, for a radio with no HW PN9, CRC or FEC, and M2DP with up to 4
+  * frames per packet (shim/otstd.h).
+  *
+  * Each packet is an M2NP request from m2np_header() and m2np_footer(), with
+  * M2DP frames added by m2dp_append() and m2dp_footer(), each with a random
+  * part of the payload.  Packets are broadcast or unicast, with RS coding or
+  * not, with FEC or not, and with DLLS or not.  DLLS is a toy cipher here,
+  * keyed by the nonce and with a 4 byte MAC, so a frame decrypted with the
+  * wrong nonce or bytes fails.
+  *
+  * The packet goes through em2_encode_data() into a buffer of bytes on air,
+  * a frame at a time as the radio drivers do it, and back through
+  * em2_decode_data() and em2_decode_endframe(), with network_mark_ff() on
+  * damaged frames.  Then network_route_ff() must give m2qp_parse_frame() the
+  * whole payload, in order.
+  *
+  * Packets with one byte on air changed in a frame that RS cannot correct
+  * must not get to m2qp_parse_frame(), whichever frame it is in.
+  *
+  * Usage: tbm2dptest [packets]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <otstd.h>
+#include <otlib/buffers.h>
+#include <otlib/crc16.h>
+#include <m2/encode.h>
+#include <m2/radio.h>
+#include <m2/network.h>
+#include <m2/dll.h>
+
+#define QUEUE_SIZE  1024
+#define MAC_BYTES   4
+
+m2dll_struct    dll;
+ot_queue        txq;
+ot_queue        rxq;
+
+static ot_u8    txbuf[QUEUE_SIZE];
+static ot_u8    rxbuf[QUEUE_SIZE];
+static ot_u8    nonce_seed;
+
+
+
+/** Radio FIFO stand-ins: a buffer of bytes on air
+  * ============================================================================
+  * The radio takes or gives a random number of bytes per call, so the codecs
+  * are cut at every point of the packet.
+  */
+static ot_u8    air[4096];
+static ot_int   air_put;
+static ot_int   air_get;
+static ot_int   air_len;
+
+static ot_int sub_span(ot_int space) {
+    ot_int n = (ot_int)(1 + rand() % 40);
+    return (n < space) ? n : space;
+}
+
+ot_bool radio_txopen_4()    { return (ot_bool)((air_put + 4) <= (ot_int)sizeof(air)); }
+ot_bool radio_rxopen_4()    { return (ot_bool)((air_get + 4) <= air_len); }
+ot_int radio_txspan()       { return sub_span((ot_int)sizeof(air) - air_put); }
+ot_int radio_rxspan()       { return sub_span(air_len - air_get); }
+
+void radio_putfourbytes(ot_u8* data) {
+    air[air_put++] = data[3];
+    air[air_put++] = data[2];
+    air[air_put++] = data[1];
+    air[air_put++] = data[0];
+}
+
+void radio_getfourbytes(ot_u8* data) {
+    memcpy(data, &air[air_get], 4);
+    air_get += 4;
+}
+
+void radio_putbytes(ot_u8* data, ot_int length) {
+    memcpy(&air[air_put], data, length);
+    air_put += length;
+}
+
+void radio_getbytes(ot_u8* data, ot_int length) {
+    memcpy(data, &air[air_get], length);
+    air_get += length;
+}
+
+
+
+
+/** DLLS and M2QP stand-ins
+  * ============================================================================
+  * The toy cipher XORs each byte with a keystream from the 7 byte nonce (the
+  * Dialog ID and the 6 that follow), and appends a MAC of the plain data.
+  */
+static ot_u8*   parsed_data;
+static ot_int   parsed_len;
+
+void auth_putnonce(ot_u8* dst, ot_uint limit) {
+    while (limit-- != 0) {
+        *dst++ = nonce_seed++;
+    }
+}
+
+static void sub_toy_mac(ot_u8* mac, ot_u8* data, ot_uint datalen) {
+    ot_uint i;
+    memset(mac, 0x5A, MAC_BYTES);
+    for (i=0; i<datalen; i++) {
+        mac[i & 3] = (ot_u8)((mac[i & 3] << 1) ^ (mac[i & 3] >> 7) ^ data[i]);
+    }
+}
+
+static void sub_toy_xor(ot_u8* nonce, ot_u8* data, ot_uint datalen) {
+    ot_uint i;
+    for (i=0; i<datalen; i++) {
+        data[i] ^= (ot_u8)(nonce[i % 7] + 31*i);
+    }
+}
+
+ot_int auth_encrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index, ot_u8 options) {
+    sub_toy_mac(&data[datalen], data, datalen);
+    sub_toy_xor(nonce, data, datalen);
+    return MAC_BYTES;
+}
+
+ot_int auth_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index, ot_u8 options) {
+    ot_u8 mac[MAC_BYTES];
+    if (datalen < MAC_BYTES) {
+        return -1;
+    }
+    datalen -= MAC_BYTES;
+    sub_toy_xor(nonce, data, datalen);
+    sub_toy_mac(mac, data, datalen);
+    return (memcmp(mac, &data[datalen], MAC_BYTES) == 0) ? MAC_BYTES : -1;
+}
+
+ot_int m2qp_parse_frame(m2session* active) {
+/// Take the payload, and do not answer: m2np_footer() is not run on txq.
+    parsed_data = rxq.getcursor;
+    parsed_len  = (ot_int)(rxq.putcursor - rxq.getcursor);
+    return -1;
+}
+
+
+
+
+/** Packet build, codec and parse
+  * ============================================================================
+  */
+typedef struct {
+    int     frames;
+    int     addressing;
+    int     rscode;
+    int     fec;
+    int     length[M2_PARAM_MFPP];
+} pkt_spec;
+
+static ot_u8    payload[QUEUE_SIZE];
+static ot_int   payload_len;
+
+static void sub_put_payload(ot_int n) {
+    ot_int space;
+    space = (ot_int)(txq.back - txq.putcursor) - MAC_BYTES;
+    if (n > space) {
+        n = space;
+    }
+    q_writestring(&txq, &payload[payload_len], n);
+    payload_len += n;
+}
+
+static void build_packet(pkt_spec* spec) {
+    m2session s;
+    int k;
+
+    q_init(&txq, txbuf, sizeof(txbuf));
+    memset(&s, 0, sizeof(s));
+    s.netstate  = M2_NETSTATE_REQTX | M2_NETSTATE_INIT;
+    s.subnet    = 0xF5;
+    s.dialog_id = (ot_u8)rand();
+    s.flags     = spec->rscode ? M2_FLAG_RSCODE : 0;
+    if ((spec->addressing & M2FI_ADDRMASK) == M2FI_UCAST) {
+        m2np.rt.dlog.length = 8;
+        m2np.rt.dlog.value  = dll.netconf.uid;
+    }
+    nonce_seed  = (ot_u8)rand();
+    payload_len = 0;
+
+    m2np_header(&s, (ot_u8)spec->addressing, 0);
+    sub_put_payload(spec->length[0]);
+    m2np_footer();
+    for (k=1; k<spec->frames; k++) {
+        m2dp_append();
+        sub_put_payload(spec->length[k]);
+        m2dp_footer();
+    }
+}
+
+static int encode_packet(int fec) {
+/// As the radio drivers do it: at the end of each frame that has more after
+/// it, the encoder goes on to the next one.
+    txq.options.ubyte[UPPER]    = 1;
+    txq.options.ubyte[LOWER]    = (ot_u8)fec;
+    air_put = 0;
+    em2_encode_newpacket();
+    em2_encode_newframe();
+    for (;;) {
+        while (em2_remaining_bytes() > 0) {
+            em2_encode_data();
+        }
+        if (em2_remaining_frames() == 0) {
+            break;
+        }
+        em2_encode_nextframe();
+    }
+    return air_put;
+}
+
+static int decode_packet(int fec, int air_bytes) {
+/// As rm2_rxdata_isr() and dll_rfevt_frx() do it.  Returns 0 if the packet
+/// would be given to the network layer.
+    q_init(&rxq, rxbuf, sizeof(rxbuf));
+    rxq.options.ubyte[LOWER]    = (ot_u8)fec;
+    txq.options.ubyte[LOWER]    = (ot_u8)fec;   // em2_decode_newpacket() looks here
+    air_get = 0;
+    air_len = (ot_int)air_bytes;
+    em2_decode_newpacket();
+    em2_decode_newframe();
+    for (;;) {
+        while ((em2_remaining_bytes() > 0) && (air_get < air_len)) {
+            em2_decode_data();
+        }
+        if (em2_remaining_bytes() > 0) {
+            em2_decode_endpacket();
+            return -1;
+        }
+        if (em2_remaining_frames() == 0) {
+            break;
+        }
+        if (em2_decode_endframe() != 0) {
+            network_mark_ff();
+        }
+        em2_decode_nextframe();
+    }
+    if (em2_decode_endframe() != 0) {
+        return -1;
+    }
+    return (rxq.front[1] & M2LC_DMGMARK) ? -1 : 0;
+}
+
+static int parse_packet(void) {
+/// Returns 0 if m2qp_parse_frame() got the whole payload
+    m2session r;
+
+    memset(&r, 0, sizeof(r));
+    r.netstate  = M2_NETSTATE_REQRX;
+    parsed_data = NULL;
+    network_route_ff(&r);
+    if (parsed_data == NULL) {
+        return -1;
+    }
+    return (parsed_len != payload_len) || (memcmp(parsed_data, payload, payload_len) != 0);
+}
+
+
+
+
+/** Cases
+  * ============================================================================
+  */
+static void random_spec(pkt_spec* spec, long n) {
+    static const ot_u8 dlls[4] = { 0, 0, M2FI_DLLS, M2FI_DLLSUSER };
+    int k;
+
+    spec->frames        = 1 + (int)(n % M2_PARAM_MFPP);
+    spec->addressing    = ((n & 4) ? M2FI_UCAST : M2FI_BCAST) | dlls[(n >> 3) & 3];
+    spec->rscode        = (int)((n >> 5) & 1);
+    spec->fec           = (int)((n >> 6) & 1);
+    for (k=0; k<spec->frames; k++) {
+        /// Short, long, and full frames
+        switch (rand() % 3) {
+            case 0:  spec->length[k] = rand() % 16;     break;
+            case 1:  spec->length[k] = rand() % 250;    break;
+            default: spec->length[k] = 255;             break;
+        }
+    }
+}
+
+static int test_packets(long packets) {
+    pkt_spec    spec;
+    long        n, frames = 0;
+    int         i, air_bytes;
+
+    for (n=0; n<packets; n++) {
+        random_spec(&spec, n);
+        for (i=0; i<(int)sizeof(payload); i++) {
+            payload[i] = (ot_u8)rand();
+        }
+        build_packet(&spec);
+        air_bytes = encode_packet(spec.fec);
+
+        if (decode_packet(spec.fec, air_bytes) != 0) {
+            printf("packet %ld: %d frames, addr=%02X rs=%d fec=%d: not decoded\n",
+                    n, spec.frames, spec.addressing, spec.rscode, spec.fec);
+            return -1;
+        }
+        if (parse_packet() != 0) {
+            printf("packet %ld: %d frames, addr=%02X rs=%d fec=%d: payload %d of %d bytes%s\n",
+                    n, spec.frames, spec.addressing, spec.rscode, spec.fec,
+                    parsed_data ? parsed_len : 0, payload_len,
+                    parsed_data ? ", not the same" : ", not parsed");
+            return -1;
+        }
+        frames += spec.frames;
+    }
+    printf("packets: %ld, %ld frames, 1-%d per packet: OK\n", packets, frames, M2_PARAM_MFPP);
+    return 0;
+}
+
+static int test_damaged(long packets) {
+/// One byte changed in a frame without RS or FEC.  The CRC of that frame
+/// fails, so the packet must not get to M2QP, whichever frame it is.
+    pkt_spec    spec;
+    long        n;
+    int         i, k, air_bytes, hit;
+    ot_u8*      frame;
+
+    for (n=0; n<packets; n++) {
+        random_spec(&spec, n);
+        spec.rscode = 0;
+        spec.fec    = 0;
+        for (i=0; i<(int)sizeof(payload); i++) {
+            payload[i] = (ot_u8)rand();
+        }
+        build_packet(&spec);
+        air_bytes = encode_packet(0);
+
+        /// A byte after the header of frame "hit": the frames are back-to-back
+        /// on air as in txq, each with its 2 CRC bytes.
+        hit     = rand() % spec.frames;
+        frame   = txbuf;
+        for (k=0; k<hit; k++) {
+            frame += frame[0] + 1;
+        }
+        i = (int)(frame - txbuf) + 2 + rand() % (frame[0] - 1);
+        air[i] ^= (ot_u8)(1 + rand() % 255);
+
+        if ((decode_packet(0, air_bytes) == 0) && (parse_packet() == 0)) {
+            printf("packet %ld: %d frames: error in frame %d passed to M2QP\n",
+                    n, spec.frames, hit);
+            return -1;
+        }
+    }
+    printf("damaged packets: %ld, none passed to M2QP: OK\n", packets);
+    return 0;
+}
+
+
+
+int main(int argc, char** argv) {
+    long    packets = (argc > 1) ? atol(argv[1]) : 20000;
+    int     i, rc;
+
+    srand(1);
+    for (i=0; i<8; i++) {
+        dll.netconf.uid[i] = (ot_u8)rand();
+    }
+    network_init();
+
+    rc  = test_packets(packets);
+    rc |= test_damaged(packets);
+
+    printf("\n%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
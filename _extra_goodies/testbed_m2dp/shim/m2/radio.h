@@ -0,0 +1,11 @@
+/* Host stand-in for m2/radio.h: the FIFO calls of the encoder, which the
+ * testbed implements on a buffer of bytes on air */
+#include <otstd.h>
+void radio_putfourbytes(ot_u8* data);
+void radio_getfourbytes(ot_u8* data);
+void radio_putbytes(ot_u8* data, ot_int length);
+void radio_getbytes(ot_u8* data, ot_int length);
+ot_int radio_rxspan();
+ot_int radio_txspan();
+ot_bool radio_rxopen_4();
+ot_bool radio_txopen_4();
@@ -0,0 +1,3 @@
+/* Host stand-in for m2/transport.h: the testbed takes the M2QP payload */
+#include <m2/session.h>
+ot_int m2qp_parse_frame(m2session* active);
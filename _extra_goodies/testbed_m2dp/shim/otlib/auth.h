@@ -0,0 +1,5 @@
+/* Host stand-in for otlib/auth.h: the testbed has a toy cipher with a MAC */
+#include <otstd.h>
+void auth_putnonce(ot_u8* dst, ot_uint limit);
+ot_int auth_encrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index, ot_u8 options);
+ot_int auth_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index, ot_u8 options);
@@ -0,0 +1 @@
+/* Host stand-in: nothing from it is used by network.c or encode.c */
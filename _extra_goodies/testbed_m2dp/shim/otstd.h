@@ -0,0 +1,96 @@
+/* Host stand-in for the OpenTag otstd.h, for the multiframe testbed: a radio
+ * with no HW PN9, CRC or FEC, and M2DP with up to 4 frames per packet. */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef int8_t      ot_s8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_int;
+typedef int16_t     ot_s16;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint32_t    ot_ulong;
+typedef int32_t     ot_s32;
+typedef uint8_t     ot_bool;
+typedef void (*ot_sig)(ot_int);
+typedef void (*ot_sig2)(ot_int, void*);
+typedef void (*ot_sigv)(void*);
+typedef void (*ot_sigv2)(void*, void*);
+
+typedef union {
+    ot_u16  ushort;
+    ot_int  sshort;
+    ot_u8   ubyte[2];
+} ot_uni16;
+
+typedef union {
+    ot_u32  ulong;
+    ot_u16  ushort[2];
+    ot_u8   ubyte[4];
+} ot_uni32;
+
+#define UPPER       1
+#define LOWER       0
+#define B3          3
+#define B2          2
+#define B1          1
+#define B0          0
+#define True        1
+#define False       0
+#define ENABLED     1
+#define DISABLED    0
+#define OT_INLINE   inline
+#define OT_WEAK     __attribute__((weak))
+
+#define PLATFORM_WORD_SIZE      4
+#define PLATFORM_POINTER_SIZE   8
+
+#define OT_FEATURE(VAL)                 OT_FEATURE_##VAL
+#define OT_FEATURE_SERVER               ENABLED
+#define OT_FEATURE_M2                   ENABLED
+#define OT_FEATURE_DLL_SECURITY         ENABLED
+#define OT_FEATURE_NL_SECURITY          DISABLED
+#define OT_FEATURE_M2NP_CALLBACKS       DISABLED
+#define OT_FEATURE_VL_SECURITY          DISABLED
+#define OT_FEATURE_RF_LINKINFO          DISABLED
+#define OT_PARAM(VAL)                   OT_PARAM_##VAL
+#define OT_PARAM_SESSION_DEPTH          4
+#define OT_PARAM_CRC16_SLICES           1
+
+#define M2_FEATURESET                   ENABLED
+#define M2_FEATURE(VAL)                 ((M2_FEATURE_##VAL) && (M2_FEATURESET))
+#define M2_FEATURE_FECTX                ENABLED
+#define M2_FEATURE_FECRX                ENABLED
+#define M2_FEATURE_FEC                  ENABLED
+#define M2_FEATURE_RSCODE               ENABLED
+#define M2_FEATURE_M2DP                 ENABLED
+#define M2_FEATURE_MULTIHOP             DISABLED
+#define M2_FEATURE_HDRCACHE             DISABLED
+#define M2_PARAM(VAL)                   M2_PARAM_##VAL
+#define M2_PARAM_MFPP                   4
+#define M2_FEATURE_MULTIFRAME           (M2_PARAM_MFPP > 1)
+#define SYS_FLOOD                       DISABLED
+
+#define RF_FEATURE(VAL)                 RF_FEATURE_##VAL
+#define RF_FEATURE_PN9                  DISABLED
+#define RF_FEATURE_CRC                  DISABLED
+#define RF_FEATURE_CRC16                DISABLED
+#define RF_FEATURE_CRC5                 DISABLED
+#define RF_FEATURE_FEC                  DISABLED
+
+#define MCU_FEATURE(VAL)                MCU_FEATURE_##VAL
+#define MCU_FEATURE_CRC16               DISABLED
+
+/* Everything in network.c except M2NP and M2DP frame building and parsing */
+#define EXTF_network_parse_bf
+#define EXTF_m2advp_open
+#define EXTF_m2advp_update
+#define EXTF_m2advp_close
+
+#endif
@@ -0,0 +1,279 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_m2hdr/hdr_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      M2NP header templates: cached vs. built, and build time
+  *
+  * m2/network.c is built twice: with M2_FEATURE_HDRCACHE, and without it
+  * (the functions renamed by shim/ref_names.h).  The test makes random
+  * requests and responses, with session parameters, targets and device IDs
+  * drawn from small pools, so that templates get reused, replaced and
+  * flushed.  Each header is built by both versions, and the frame bytes, the
+  * rebased target ID, the session and m2np.header must be the same.  Dialog
+  * ID and DLLS nonce are new in each frame, so the bytes patched into a
+  * template copy are checked too.
+  *
+  * A template hit is the only way through m2np_header() without a call to
+  * q_writebyte(), so the test has its own q_writebyte() (queue.c is built
+  * with EXTF_q_writebyte) and counts the calls to report the hit rate.
+  *
+  * The benchmark times m2np_header() for a unicast response and a broadcast
+  * request, with the cache and without it.
+  *
+  * Usage: tbm2hdrtest [frames] [calls per benchmark]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <m2/network.h>
+#include <m2/dll.h>
+#include <otlib/buffers.h>
+
+extern m2np_struct m2np_ref;
+void network_init_ref(void);
+void m2np_header_ref(m2session* active, ot_u8 addressing, ot_u8 nack);
+void m2np_flush_ref(void);
+
+m2dll_struct    dll;
+ot_queue        txq;
+ot_queue        rxq;
+
+static ot_u8    nonce_seed;
+static ot_u8    txbuf[2][256];
+static ot_u8    ids[4][8];
+static ot_u8    uids[3][8];
+static ot_u8    vids[3][2];
+static long     writebytes;
+
+
+void q_writebyte(ot_queue* q, ot_u8 byte_in) {
+    writebytes++;
+    *q->putcursor++ = byte_in;
+}
+
+
+void auth_putnonce(ot_u8* dst, ot_uint limit) {
+    while (limit-- != 0) {
+        *dst++ = nonce_seed++;
+    }
+}
+
+
+
+static void set_netconf(int i) {
+    memcpy(dll.netconf.uid, uids[i], 8);
+    memcpy(dll.netconf.vid, vids[i], 2);
+}
+
+
+static int run_both(m2session* s, ot_u8 addressing, int idn, int idlen, int* hits) {
+/// Builds the same header with the reference build (in txbuf[0]) and with the
+/// cache (in txbuf[1]), and compares everything the header build touches.
+    m2session   sref, scache;
+    ot_u8*      out[2];
+    ot_int      len[2];
+    ot_int      idofs[2];
+    ot_u8       seed;
+
+    /// A new nonce for each frame, so a stale one in a template shows up
+    seed    = (ot_u8)rand();
+    sref    = *s;
+    scache  = *s;
+
+    q_init(&txq, txbuf[0], 256);
+    m2np_ref.rt.dlog.length = (ot_u8)idlen;
+    m2np_ref.rt.dlog.value  = ids[idn];
+    nonce_seed              = seed;
+    m2np_header_ref(&sref, addressing, 0);
+    out[0]      = txq.getcursor;
+    len[0]      = q_span(&txq);
+    idofs[0]    = (ot_int)(m2np_ref.rt.dlog.value - txq.getcursor);
+
+    q_init(&txq, txbuf[1], 256);
+    m2np.rt.dlog.length     = (ot_u8)idlen;
+    m2np.rt.dlog.value      = ids[idn];
+    nonce_seed              = seed;
+    writebytes              = 0;
+    m2np_header(&scache, addressing, 0);
+    *hits                  += (writebytes == 0);
+    out[1]      = txq.getcursor;
+    len[1]      = q_span(&txq);
+    idofs[1]    = (ot_int)(m2np.rt.dlog.value - txq.getcursor);
+
+    if ((len[0] != len[1]) || memcmp(out[0], out[1], len[0])) {
+        printf("  frame bytes differ (len %d vs %d)\n", len[0], len[1]);
+        return -1;
+    }
+    if ((m2np_ref.header.fr_info & M2FI_UCAST) && (idofs[0] != idofs[1])) {
+        printf("  target ID rebased to %d vs %d\n", idofs[0], idofs[1]);
+        return -1;
+    }
+    if (memcmp(&sref, &scache, sizeof(m2session)) ||
+        (m2np_ref.header.fr_info != m2np.header.fr_info)) {
+        printf("  session or frame info differ\n");
+        return -1;
+    }
+    if (txq.back != txbuf[1] + ((s->flags & M2_FLAG_RSCODE) ? 221 : 254)) {
+        printf("  txq.back not set\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+
+static int test_equivalence(long frames) {
+    long    n;
+    int     hits    = 0;
+    int     flushes = 0;
+    int     cur_nc  = 0;
+
+    network_init_ref();
+    network_init();
+    set_netconf(0);
+
+    for (n=0; n<frames; n++) {
+        m2session s;
+        ot_u8   addressing;
+        int     idn, idlen;
+
+        memset(&s, 0, sizeof(s));
+        s.dialog_id = (ot_u8)rand();
+        s.subnet    = (rand() & 3) ? 0xF1 : 0x21;
+        s.flags     = (ot_u8)((rand() & 1) ? (rand() & 0xFC) : 0x40);
+        s.extra     = (rand() % 5 == 0) ? (ot_u8)rand() : 0;
+        s.netstate  = (rand() & 1) ? M2_NETSTATE_RESPTX : M2_NETSTATE_REQTX;
+        addressing  = (ot_u8)((rand() & 3) | ((rand() & 3) << 5) | (rand() & 0x80));
+        idn         = rand() & 3;
+        idlen       = (rand() & 1) ? 8 : 2;
+
+        /// Device IDs change now and then, as when ISF 0/1 are written
+        if (rand() % 97 == 0) {
+            cur_nc = (cur_nc + 1) % 3;
+            set_netconf(cur_nc);
+            m2np_flush_ref();
+            m2np_flush();
+            flushes++;
+        }
+
+        if (run_both(&s, addressing, idn, idlen, &hits) != 0) {
+            printf("  frame %ld: flags=%02X extra=%02X netstate=%02X addr=%02X idlen=%d\n",
+                    n, s.flags, s.extra, s.netstate, addressing, idlen);
+            return -1;
+        }
+    }
+    printf("equivalence: %ld frames, %d template hits, %d flushes: OK\n",
+            frames, hits, flushes);
+    return 0;
+}
+
+
+
+static int test_stale_id(void) {
+/// Without the flush, a template keeps the old source ID.  This makes sure
+/// that the test above would catch a missing flush.
+    m2session   s;
+    int         hits = 0;
+    int         rc;
+
+    network_init_ref();
+    network_init();
+    set_netconf(0);
+    memset(&s, 0, sizeof(s));
+    s.subnet    = 0xF1;
+    s.netstate  = M2_NETSTATE_RESPTX;
+
+    run_both(&s, 0, 0, 8, &hits);
+    set_netconf(2);
+    rc = run_both(&s, 0, 0, 8, &hits);
+    printf("stale ID without flush: %s\n", (rc != 0) ? "caught" : "NOT CAUGHT");
+    return (rc != 0) ? 0 : -1;
+}
+
+
+
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+static double bench(void (*header)(m2session*, ot_u8, ot_u8), id_tmpl* dlog,
+                    ot_u8 netstate, ot_u8 addressing, long calls) {
+    m2session   s;
+    double      t0;
+    long        n;
+
+    memset(&s, 0, sizeof(s));
+    s.subnet    = 0xF1;
+
+    t0 = now();
+    for (n=0; n<calls; n++) {
+        s.netstate      = netstate;
+        s.flags         = 0;
+        s.dialog_id     = (ot_u8)n;
+        dlog->value     = ids[0];
+        dlog->length    = 8;
+        q_init(&txq, txbuf[0], 256);
+        header(&s, addressing, 0);
+    }
+    return (now() - t0) * 1e9 / (double)calls;
+}
+
+
+
+int main(int argc, char** argv) {
+    long    frames  = (argc > 1) ? atol(argv[1]) : 100000;
+    long    calls   = (argc > 2) ? atol(argv[2]) : 2000000;
+    int     i, j, rc;
+
+    srand(1);
+    for (i=0; i<4; i++) for (j=0; j<8; j++) ids[i][j]  = (ot_u8)rand();
+    for (i=0; i<3; i++) for (j=0; j<8; j++) uids[i][j] = (ot_u8)rand();
+    vids[0][0] = 0x12;  vids[0][1] = 0x34;
+    vids[1][0] = 0;     vids[1][1] = 0;
+    vids[2][0] = 0xAB;  vids[2][1] = 0xCD;
+
+    rc  = test_equivalence(frames);
+    rc |= test_stale_id();
+
+    network_init_ref();
+    network_init();
+    set_netconf(0);
+    printf("\nm2np_header() ns/call     built   cached\n");
+    for (i=0; i<2; i++) {
+        double t_ref, t_cache;
+        ot_u8  netstate = (i == 0) ? M2_NETSTATE_RESPTX : M2_NETSTATE_REQTX;
+        ot_u8  addr     = (i == 0) ? 0 : M2FI_BCAST;
+
+        bench(&m2np_header_ref, &m2np_ref.rt.dlog, netstate, addr, calls);
+        t_ref   = bench(&m2np_header_ref, &m2np_ref.rt.dlog, netstate, addr, calls);
+        t_cache = bench(&m2np_header, &m2np.rt.dlog, netstate, addr, calls);
+        printf("%-22s %8.1f %8.1f\n",
+                (i == 0) ? "unicast response" : "broadcast request", t_ref, t_cache);
+    }
+    printf("\n%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+/* Host stand-in for m2/dll.h: only the device IDs in dll.netconf */
+#include <otstd.h>
+typedef struct {
+    ot_u8   uid[8];
+    ot_u8   vid[2];
+} netconf_struct;
+typedef struct {
+    netconf_struct  netconf;
+} m2dll_struct;
+extern m2dll_struct dll;
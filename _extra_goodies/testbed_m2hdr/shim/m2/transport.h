@@ -0,0 +1 @@
+/* Host stand-in: nothing from it is used by the M2NP header code */
@@ -0,0 +1,3 @@
+/* Host stand-in for otlib/auth.h */
+#include <otstd.h>
+void auth_putnonce(ot_u8* dst, ot_uint limit);
@@ -0,0 +1,4 @@
+/* Host stand-in for otlib/buffers.h */
+#include <otlib/queue.h>
+extern ot_queue txq;
+extern ot_queue rxq;
@@ -0,0 +1,9 @@
+/* Host stand-in for otlib/memcpy.h: a byte copy, like the STM32 platforms'
+ * ot_memcpy() without DMA.  glibc memcpy() is not used for 20 byte copies, so
+ * that the host timing is closer to the MCU. */
+#include <otstd.h>
+static inline void ot_memcpy(void* dst, void* src, ot_uint length) {
+    ot_u8* d = dst;
+    ot_u8* s = src;
+    while (length-- != 0) *d++ = *s++;
+}
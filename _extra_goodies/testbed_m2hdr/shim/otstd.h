@@ -0,0 +1,83 @@
+/* Host stand-in for the OpenTag otstd.h, for the M2NP header testbed */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef int8_t      ot_s8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_int;
+typedef int16_t     ot_s16;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint32_t    ot_ulong;
+typedef int32_t     ot_s32;
+typedef uint8_t     ot_bool;
+typedef void (*ot_sig)(ot_int);
+typedef void (*ot_sig2)(ot_int, void*);
+typedef void (*ot_sigv)(void*);
+typedef void (*ot_sigv2)(void*, void*);
+
+typedef union {
+    ot_u16  ushort;
+    ot_int  sshort;
+    ot_u8   ubyte[2];
+} ot_uni16;
+
+typedef union {
+    ot_u32  ulong;
+    ot_u16  ushort[2];
+    ot_u8   ubyte[4];
+} ot_uni32;
+
+#define UPPER       1
+#define LOWER       0
+#define B3          3
+#define B2          2
+#define B1          1
+#define B0          0
+#define True        1
+#define False       0
+#define ENABLED     1
+#define DISABLED    0
+#define OT_INLINE   inline
+#define OT_WEAK     __attribute__((weak))
+
+#define PLATFORM_WORD_SIZE      4
+#define PLATFORM_POINTER_SIZE   8
+
+#define OT_FEATURE(VAL)                 OT_FEATURE_##VAL
+#define OT_FEATURE_SERVER               ENABLED
+#define OT_FEATURE_M2                   ENABLED
+#define OT_FEATURE_DLL_SECURITY         ENABLED
+#define OT_FEATURE_NL_SECURITY          DISABLED
+#define OT_FEATURE_M2NP_CALLBACKS       DISABLED
+#define OT_FEATURE_VL_SECURITY          DISABLED
+#define OT_PARAM(VAL)                   OT_PARAM_##VAL
+#define OT_PARAM_SESSION_DEPTH          4
+
+#define M2_FEATURESET                   ENABLED
+#define M2_FEATURE(VAL)                 ((M2_FEATURE_##VAL) && (M2_FEATURESET))
+#define M2_FEATURE_RSCODE               ENABLED
+#define M2_FEATURE_MULTIHOP             DISABLED
+#ifndef M2_FEATURE_HDRCACHE
+#   define M2_FEATURE_HDRCACHE          ENABLED
+#endif
+#define SYS_FLOOD                       DISABLED
+
+/* Everything in network.c except the M2NP header functions */
+#define EXTF_network_parse_bf
+#define EXTF_network_mark_ff
+#define EXTF_network_route_ff
+#define EXTF_m2np_footer
+#define EXTF_m2advp_open
+#define EXTF_m2advp_update
+#define EXTF_m2advp_close
+#define EXTF_m2dp_append
+#define EXTF_m2dp_footer
+
+#endif
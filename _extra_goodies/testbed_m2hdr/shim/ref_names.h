@@ -0,0 +1,7 @@
+/* Forced include for the reference build of network.c (no header cache) */
+#define m2np                m2np_ref
+#define network_init        network_init_ref
+#define m2np_header         m2np_header_ref
+#define m2np_put_deviceid   m2np_put_deviceid_ref
+#define m2np_idcmp          m2np_idcmp_ref
+#define m2np_flush          m2np_flush_ref
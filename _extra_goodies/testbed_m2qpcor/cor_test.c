@@ -0,0 +1,357 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_m2qpcor/cor_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      M2QP masked token correlation: bit-parallel vs. byte-wise
+  *
+  * The Makefile copies the correlator (m2qp_cor, sub_init_charcorrelation(),
+  * sub_load_charcorrelation()) and m2qp_load_isf() out of m2/transport.c into
+  * cor_tree.h, so the code under test is the code in the tree.  ref_load() is
+  * the byte-wise correlator that transport.c had before, with its own buffer.
+  *
+  * The ISF files are in RAM, behind stand-ins for the Veelite calls.  The
+  * test runs random masked tokens (0-32 bytes) and thresholds over random
+  * series, with copies of the token planted in them, and the score from
+  * m2qp_load_isf() must be the same with both correlators.  The empty token
+  * must score as before when it is fed bytes directly, and a 33 byte token
+  * must be rejected.  The benchmark runs a search over a series of 32 files
+  * of 240 bytes, and over one file of 24 bytes, with the setup included.
+  *
+  * Usage: tbm2qpcortest [trials] [searches per benchmark]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef uint8_t     ot_u8;
+typedef uint16_t    ot_u16;
+typedef uint32_t    ot_u32;
+typedef int16_t     ot_int;
+typedef uint16_t    ot_uint;
+typedef uint8_t     ot_bool;
+typedef union {
+    ot_u16  ushort;
+    ot_u8   ubyte[2];
+} ot_uni16;
+
+#define OT_WEAK
+#define M2QC_COR_THRMASK    (0x1F)
+#define VL_ACCESS_R         (4)
+
+typedef struct {
+    ot_u8   length;
+    ot_u8   value[8];
+} id_tmpl;
+
+typedef struct {
+    ot_u16  length;
+    ot_u8*  data;
+} vlFILE;
+
+typedef struct {
+    ot_u8   code;
+    ot_u8   length;
+    ot_u8*  mask;
+    ot_u8*  value;
+} query_tmpl;
+
+struct {
+    query_tmpl  qtmpl;
+} m2qp;
+
+
+
+/** Veelite stand-ins: files 0-63 and series 0-3 in RAM
+  * ========================================================================
+  */
+#define NUM_FILES   64
+#define FILE_MAX    240
+
+static ot_u8    file_data[NUM_FILES][FILE_MAX];
+static vlFILE   file_fp[NUM_FILES];
+static ot_u8    series_ids[4][NUM_FILES];
+static vlFILE   series_fp[4];
+
+
+vlFILE* ISF_open(ot_u8 id, ot_u8 mod, id_tmpl* user_id) {
+    return (id < NUM_FILES) ? &file_fp[id] : NULL;
+}
+
+vlFILE* ISFS_open(ot_u8 id, ot_u8 mod, id_tmpl* user_id) {
+    return (id < 4) ? &series_fp[id] : NULL;
+}
+
+ot_u16 vl_read(vlFILE* fp, ot_uint offset) {
+    ot_uni16 d;
+    d.ubyte[0] = fp->data[offset];
+    d.ubyte[1] = (offset+1 < fp->length) ? fp->data[offset+1] : 0;
+    return d.ushort;
+}
+
+ot_u8 vl_close(vlFILE* fp) {
+    return 0;
+}
+
+
+
+/** Code from the tree
+  * ========================================================================
+  */
+#include "cor_tree.h"
+
+
+
+/** Reference: the byte-wise correlator that was in transport.c
+  * ========================================================================
+  */
+static ot_u8 ref_buf[1+32];
+
+static ot_int ref_load(ot_int* cursor, ot_u8 data_byte) {
+    ot_int i;
+    ot_int c;
+    ot_u8* local_buf;
+
+    local_buf = &ref_buf[1];
+    local_buf[*cursor] = data_byte;
+
+    if ( *cursor < (m2qp.qtmpl.length-1) ) {
+        (*cursor)++;
+        return 0;
+    }
+    else {
+        for (i=0, c=0; i<m2qp.qtmpl.length; i++) {
+            c += ( (local_buf[i] & m2qp.qtmpl.mask[i]) == \
+                   (m2qp.qtmpl.value[i] & m2qp.qtmpl.mask[i]) ) << 1;
+            c -= 1;
+
+            local_buf[i-1] = local_buf[i];
+        }
+    }
+    return (c >= (ot_int)(m2qp.qtmpl.code & 0x1F));
+}
+
+
+
+
+static ot_u8 tok_mask[32];
+static ot_u8 tok_value[32];
+
+
+static void make_files(int alphabet, int files, int length) {
+/// Random file data from a small alphabet, so that partial matches are
+/// common, with copies of the token (under random masks) planted in it.
+    int f, i, k, p;
+
+    for (f=0; f<NUM_FILES; f++) {
+        file_fp[f].length   = (ot_u16)((f < files) ? length : (1 + rand() % FILE_MAX));
+        file_fp[f].data     = file_data[f];
+        for (i=0; i<FILE_MAX; i++) {
+            file_data[f][i] = (ot_u8)(0x30 + rand() % alphabet);
+        }
+    }
+    for (k=0; k<4; k++) {
+        series_fp[k].length = (ot_u16)(1 + rand() % files);
+        series_fp[k].data   = series_ids[k];
+        for (i=0; i<NUM_FILES; i++) {
+            series_ids[k][i] = (ot_u8)(rand() % files);
+        }
+    }
+    for (k=0; k<64; k++) {
+        f = rand() % NUM_FILES;
+        p = rand() % FILE_MAX;
+        for (i=0; (i<m2qp.qtmpl.length) && (p+i < FILE_MAX); i++) {
+            file_data[f][p+i] = (rand() & 7) ? tok_value[i] : (ot_u8)rand();
+        }
+    }
+}
+
+
+static void make_token(int length, int alphabet) {
+    int i;
+
+    m2qp.qtmpl.length   = (ot_u8)length;
+    m2qp.qtmpl.mask     = tok_mask;
+    m2qp.qtmpl.value    = tok_value;
+    for (i=0; i<length; i++) {
+        switch (rand() & 3) {
+            case 0:  tok_mask[i] = (ot_u8)rand();   break;
+            case 1:  tok_mask[i] = 0;               break;
+            default: tok_mask[i] = 0xFF;            break;
+        }
+        tok_value[i] = (rand() & 3) ? (ot_u8)(0x30 + rand() % alphabet) : (ot_u8)rand();
+    }
+}
+
+
+static ot_int run_tree(ot_u8 is_series, ot_u8 id, ot_int offset) {
+    if (sub_init_charcorrelation() != 0) {
+        return -1;
+    }
+    return m2qp_load_isf(is_series, id, offset, m2qp.qtmpl.length,
+                         &sub_load_charcorrelation, NULL);
+}
+
+
+static ot_int run_ref(ot_u8 is_series, ot_u8 id, ot_int offset) {
+    return m2qp_load_isf(is_series, id, offset, m2qp.qtmpl.length, &ref_load, NULL);
+}
+
+
+
+static int test_equivalence(long trials) {
+    long    n;
+    long    hits = 0;
+
+    for (n=0; n<trials; n++) {
+        ot_u8   is_series   = (ot_u8)(rand() & 1);
+        ot_u8   id          = (ot_u8)(is_series ? (rand() & 3) : (rand() % NUM_FILES));
+        int     alphabet    = 2 + rand() % 6;
+        ot_int  offset      = (ot_int)(rand() % 300);
+        ot_int  s_tree, s_ref;
+
+        make_token(rand() % 33, alphabet);
+        m2qp.qtmpl.code = (ot_u8)(0x40 | (rand() & 0x1F));
+        if ((n & 3) == 0) {
+            m2qp.qtmpl.code = (ot_u8)(0x40 | m2qp.qtmpl.length);   // exact
+        }
+        make_files(alphabet, 16, FILE_MAX);
+
+        s_tree  = run_tree(is_series, id, offset);
+        s_ref   = run_ref(is_series, id, offset);
+        if (s_tree != s_ref) {
+            printf("trial %ld: length=%d code=%02X series=%d id=%d offset=%d: %d vs %d\n",
+                    n, m2qp.qtmpl.length, m2qp.qtmpl.code, is_series, id, offset,
+                    s_tree, s_ref);
+            return -1;
+        }
+        hits += (s_ref > 0);
+    }
+    printf("equivalence: %ld trials, %ld with hits: OK\n", trials, hits);
+    return 0;
+}
+
+
+static int test_long_token(void) {
+    make_token(32, 4);
+    m2qp.qtmpl.length = 33;
+    if (sub_init_charcorrelation() != -1) {
+        printf("33 byte token: NOT REJECTED\n");
+        return -1;
+    }
+    printf("33 byte token: rejected\n");
+    return 0;
+}
+
+
+static int test_empty_token(void) {
+/// m2qp_load_isf() does not feed bytes for an empty token, but the correlator
+/// must still score it as 0 against the threshold, as before.
+    int     thr;
+    ot_int  c_tree, c_ref;
+
+    make_token(0, 4);
+    for (thr=0; thr<32; thr++) {
+        m2qp.qtmpl.code = (ot_u8)(0x40 | thr);
+        c_tree  = 0;
+        c_ref   = 0;
+        if ((sub_init_charcorrelation() != 0) ||
+            (sub_load_charcorrelation(&c_tree, 0x30) != ref_load(&c_ref, 0x30))) {
+            printf("empty token, threshold %d: WRONG\n", thr);
+            return -1;
+        }
+    }
+    printf("empty token: OK\n");
+    return 0;
+}
+
+
+
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+static void bench(long searches) {
+    static const int lengths[] = { 2, 4, 5, 8, 16, 32 };
+    long    bytes;
+    int     i, k;
+
+    /// Series 0: 32 files of 240 bytes, 7680 bytes in all.  File 32 has 24.
+    make_token(32, 16);
+    make_files(16, 32, FILE_MAX);
+    series_fp[0].length = 32;
+    for (i=0; i<32; i++) series_ids[0][i] = (ot_u8)i;
+    file_fp[32].length  = 24;
+
+    printf("\nns/byte                       %5ld byte series        24 byte file\n", 32L*FILE_MAX);
+    printf("                            byte-wise  bit-parallel  byte-wise  bit-parallel\n");
+    for (k=0; k<2; k++) {
+        for (i=0; i<(int)(sizeof(lengths)/sizeof(int)); i++) {
+            double  t0, t_ref[2], t_tree[2];
+            long    n, loops;
+            int     f;
+            ot_int  sum = 0;
+
+            make_token(lengths[i], 16);
+            m2qp.qtmpl.code = (ot_u8)(0x40 | ((k == 0) ? lengths[i] : lengths[i]/2));
+
+            for (f=0; f<2; f++) {
+                bytes   = (f == 0) ? (32L * FILE_MAX) : 24;
+                loops   = searches * ((32L * FILE_MAX) / bytes);
+
+                t0 = now();
+                for (n=0; n<loops; n++) sum += run_ref((ot_u8)(f == 0), (ot_u8)((f == 0) ? 0 : 32), 0);
+                t_ref[f] = (now() - t0) * 1e9 / (double)(loops * bytes);
+
+                t0 = now();
+                for (n=0; n<loops; n++) sum -= run_tree((ot_u8)(f == 0), (ot_u8)((f == 0) ? 0 : 32), 0);
+                t_tree[f] = (now() - t0) * 1e9 / (double)(loops * bytes);
+            }
+
+            printf("%2d byte token, %-11s  %8.2f  %8.2f      %8.2f  %8.2f%s\n", lengths[i],
+                    (k == 0) ? "exact" : "correlation",
+                    t_ref[0], t_tree[0], t_ref[1], t_tree[1],
+                    (sum != 0) ? "  (scores differ!)" : "");
+        }
+    }
+}
+
+
+
+int main(int argc, char** argv) {
+    long    trials      = (argc > 1) ? atol(argv[1]) : 20000;
+    long    searches    = (argc > 2) ? atol(argv[2]) : 200;
+    int     rc;
+
+    srand(1);
+    rc  = test_equivalence(trials);
+    rc |= test_long_token();
+    rc |= test_empty_token();
+    bench(searches);
+
+    printf("\n%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
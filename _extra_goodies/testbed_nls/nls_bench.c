@@ -0,0 +1,117 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_nls/nls_bench.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Lookup cost of the NLS user & key store, up to 10000 users
+  *
+  * otlib/auth.c is built from the tree with OT_PARAM_NLS_USERS = 10000, as a
+  * gateway would have it.  The store is filled with 100, 1000 and then 10000
+  * users (8 byte IDs, 16 byte keys), and auth_search_user() is timed on hits
+  * spread over all of them, and on misses.  With the hash index, the cost
+  * should not grow with the number of users, apart from cache misses.
+  *
+  * Usage: tbnlsbench [lookups per point]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <otlib/auth.h>
+#include <otlib/crypto.h>
+#include <otsys/veelite.h>
+
+extern void sub_nls_init(void);
+
+
+/// Stand-ins: nothing is saved here, and the clock stays at 1
+vlFILE* GFB_open_su(ot_u8 id)                               { return NULL; }
+ot_u16  vl_read(vlFILE* fp, ot_uint offset)                 { return 0; }
+ot_u8   vl_store(vlFILE* fp, ot_uint length, ot_u8* data)   { return 255; }
+ot_u8   vl_append(vlFILE* fp, ot_uint length, ot_u8* data)  { return 255; }
+ot_u8   vl_close(vlFILE* fp)                                { return 0; }
+ot_u32  time_get_utc(void)                                  { return 1; }
+ot_u16  rand_prn16()                                        { return (ot_u16)rand(); }
+
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
+static void make_id(ot_u32 k, ot_u8* id) {
+    ot_u32 h = k * 2654435761UL;
+    memcpy(&id[0], &h, 4);
+    memcpy(&id[4], &k, 4);
+}
+
+
+int main(int argc, char** argv) {
+    static const int users[] = { 100, 1000, 10000 };
+    long        lookups = (argc > 1) ? atol(argv[1]) : 2000000;
+    auth_info   info;
+    id_tmpl     user;
+    ot_u8       id[8];
+    ot_u8       key[16];
+    int         p, i;
+
+    memset(&info, 0, sizeof(info));
+    memset(key, 0, sizeof(key));
+    info.length = 16;
+    user.length = 8;
+    user.value  = id;
+
+    printf("OT_PARAM_NLS_USERS = %d\n", OT_PARAM_NLS_USERS);
+    printf(" users      hit ns     miss ns\n");
+    for (p=0; p<(int)(sizeof(users)/sizeof(users[0])); p++) {
+        volatile int    found = 0;
+        double          t0, t_hit, t_miss;
+        long            n;
+
+        sub_nls_init();
+        for (i=0; i<users[p]; i++) {
+            make_id((ot_u32)i, id);
+            info.lifetime = 100 + i;
+            auth_new_nlsuser(NULL, &user, &info, key);
+        }
+
+        t0 = now();
+        for (n=0; n<lookups; n++) {
+            make_id((ot_u32)((n * 7919) % users[p]), id);
+            found += (auth_search_user(NULL, &user, 0) == 0);
+        }
+        t_hit = now() - t0;
+
+        t0 = now();
+        for (n=0; n<lookups; n++) {
+            make_id((ot_u32)(users[p] + n), id);
+            found -= (auth_search_user(NULL, &user, 0) == 0);
+        }
+        t_miss = now() - t0;
+
+        printf("%6d  %10.1f  %10.1f%s\n", users[p],
+                t_hit * 1e9 / (double)lookups, t_miss * 1e9 / (double)lookups,
+                (found != lookups) ? "  (lookups failed!)" : "");
+    }
+    return 0;
+}
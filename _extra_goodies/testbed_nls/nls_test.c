@@ -0,0 +1,416 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_nls/nls_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      NLS user & key store of otlib/auth.c against a model
+  *
+  * otlib/auth.c is built from the tree with NL_SECURITY, 16 users and 320
+  * bytes of key heap, so that the table and the heap both fill up.  The GFB
+  * files 1-3 are in RAM, behind stand-ins for the Veelite calls.
+  *
+  * The model is a flat array of users with their keys and expiry times.  The
+  * random run adds, replaces, deletes and looks up users, and moves the clock
+  * forward.  After each add, a user of the model that is gone from the store
+  * must have been evicted in expiry order: it expires no later than any user
+  * that is left.  Every lookup must agree with the model, and the hash index,
+  * the expiry heap and the key heap are checked as the run goes.  Then:
+  * <LI> eviction order, with a user that never expires </LI>
+  * <LI> auth_save_nlsusers() and auth_load_nlsusers() over the 3 files </LI>
+  * <LI> crypto_cull(), and a save of an empty store </LI>
+  *
+  * Usage: tbnlstest [operations]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <otstd.h>
+#include <otlib/auth.h>
+#include <otlib/crypto.h>
+#include <otsys/veelite.h>
+
+#define NUM_USERS   OT_PARAM_NLS_USERS
+#define NUM_IDS     (3*NUM_USERS)
+#define FILE_ALLOC  512
+
+static int  failures = 0;
+
+#define CHECK(COND, ...)    do { if (!(COND)) { if (failures++ < 20) { printf("FAIL: " __VA_ARGS__); printf("\n"); } } } while (0)
+
+
+/// The store, as auth.c lays it out, for the invariant checks
+typedef struct {
+    auth_info   info;
+    auth_id     id;
+    ot_u16      next;
+    ot_u16      rank;
+    ot_u32      key;
+} auth_entry;
+
+extern struct {
+    ot_u16      count;
+    ot_u16      free;
+    ot_u32      end;
+    ot_u32      holes;
+    ot_u16      bucket[OT_PARAM_NLS_USERS];
+    ot_u16      order[OT_PARAM_NLS_USERS];
+    auth_entry  entry[OT_PARAM_NLS_USERS];
+    ot_u8       heap[OT_PARAM_NLS_HEAPSIZE];
+} auth_nls;
+
+extern void sub_nls_init(void);
+
+
+
+
+/** Veelite, time and rand stand-ins: GFB files 1-3 in RAM
+  * ============================================================================
+  */
+static ot_u8    file_data[4][FILE_ALLOC];
+static vlFILE   file_fp[4];
+static int      files_open = 0;
+static ot_u32   utc = 1000;
+
+vlFILE* GFB_open_su(ot_u8 id) {
+    if ((id < 1) || (id > 3)) {
+        return NULL;
+    }
+    file_fp[id].id      = id;
+    file_fp[id].alloc   = FILE_ALLOC;
+    files_open++;
+    return &file_fp[id];
+}
+
+ot_u16 vl_read(vlFILE* fp, ot_uint offset) {
+    return file_data[fp->id][offset] | (file_data[fp->id][offset+1] << 8);
+}
+
+ot_u8 vl_store(vlFILE* fp, ot_uint length, ot_u8* data) {
+    if (length > fp->alloc) {
+        return 255;
+    }
+    fp->length = length;
+    memcpy(file_data[fp->id], data, length);
+    return 0;
+}
+
+ot_u8 vl_append(vlFILE* fp, ot_uint length, ot_u8* data) {
+    if ((fp->length + length) > fp->alloc) {
+        return 255;
+    }
+    memcpy(&file_data[fp->id][fp->length], data, length);
+    fp->length += length;
+    return 0;
+}
+
+ot_u8 vl_close(vlFILE* fp) {
+    files_open--;
+    return 0;
+}
+
+ot_u32 time_get_utc(void) {
+    return utc;
+}
+
+ot_u16 rand_prn16() {
+    return (ot_u16)rand();
+}
+
+
+
+
+/** Model
+  * ============================================================================
+  */
+typedef struct {
+    ot_bool live;
+    ot_u8   id[8];
+    ot_u8   idlen;
+    ot_u8   key[64];
+    ot_u8   keylen;
+    ot_u8   protocol;
+    ot_u32  lifetime;
+} model_user;
+
+static model_user model[NUM_IDS];
+
+
+static void make_id(int k, id_tmpl* user) {
+/// Fixed per k: 2 byte IDs for even k, 8 byte IDs for odd k
+    int i;
+    user->length    = (k & 1) ? 8 : 2;
+    user->value     = model[k].id;
+    for (i=0; i<8; i++) {
+        model[k].id[i] = (ot_u8)(((ot_u32)k * 2654435761UL) >> (i*3)) ^ (ot_u8)i;
+    }
+    model[k].idlen = user->length;
+}
+
+
+static ot_u32 expiry(ot_u32 lifetime) {
+    return (lifetime == 0) ? 0xFFFFFFFF : lifetime;
+}
+
+
+static ot_bool expired(int k) {
+    return (ot_bool)(expiry(model[k].lifetime) <= utc);
+}
+
+
+static ot_u8 find(int k, auth_handle* handle, ot_u8 mod_flags) {
+    id_tmpl user;
+    make_id(k, &user);
+    return auth_search_user(handle, &user, mod_flags);
+}
+
+
+static void check_store(void) {
+/// The hash chains, the expiry heap and the key heap must all agree
+    ot_u32  used = 0;
+    int     i, live = 0, chained = 0;
+
+    for (i=0; i<NUM_USERS; i++) {
+        auth_entry* e = &auth_nls.entry[i];
+        if (e->id.length != 0) {
+            ot_u8* item = &auth_nls.heap[e->key - 4];
+            live++;
+            used += 4 + ((e->info.length + 3) & ~3);
+            CHECK(auth_nls.order[e->rank] == i, "entry %d: rank %d is wrong", i, e->rank);
+            CHECK(((item[0] | (item[1] << 8)) == i) && (item[2] == e->info.length),
+                  "entry %d: key item header is wrong", i);
+        }
+    }
+    CHECK(live == auth_nls.count, "count %d, %d entries in use", auth_nls.count, live);
+    CHECK(used + auth_nls.holes == auth_nls.end, "key heap: %u used + %u holes != %u",
+          (unsigned)used, (unsigned)auth_nls.holes, (unsigned)auth_nls.end);
+
+    for (i=1; i<auth_nls.count; i++) {
+        ot_u32 parent   = expiry(auth_nls.entry[auth_nls.order[(i-1)/2]].info.lifetime);
+        ot_u32 child    = expiry(auth_nls.entry[auth_nls.order[i]].info.lifetime);
+        CHECK(parent <= child, "expiry heap out of order at rank %d", i);
+    }
+    for (i=0; i<NUM_USERS; i++) {
+        ot_u16 j;
+        for (j=auth_nls.bucket[i]; j!=0xFFFF; j=auth_nls.entry[j].next) {
+            chained++;
+        }
+    }
+    CHECK(chained == live, "%d entries in the hash chains, %d in use", chained, live);
+}
+
+
+
+
+/** Operations
+  * ============================================================================
+  */
+static void do_add(int k) {
+    auth_handle handle;
+    auth_info   info;
+    id_tmpl     user;
+    ot_u32      kept = 0xFFFFFFFF;
+    ot_u32      gone = 0;
+    int         i;
+
+    memset(&info, 0, sizeof(info));
+    info.protocol   = (rand() & 1) ? AUTH_FLAG_ISROOT : 0;
+    info.length     = (rand() & 3) ? 16 : (ot_u8)(1 + rand() % 40);
+    info.lifetime   = (rand() & 7) ? (utc + 1 + rand() % 5000) : 0;
+
+    make_id(k, &user);
+    for (i=0; i<info.length; i++) {
+        model[k].key[i] = (ot_u8)rand();
+    }
+    CHECK(auth_new_nlsuser(&handle, &user, &info, model[k].key) == 0, "add user %d", k);
+    CHECK(memcmp(handle.keydata, model[k].key, info.length) == 0, "add user %d: handle key", k);
+    model[k].live       = True;
+    model[k].keylen     = info.length;
+    model[k].protocol   = info.protocol;
+    model[k].lifetime   = info.lifetime;
+
+    /// Users that are gone were evicted, and they expire first.  A lookup of
+    /// an expired user deletes it, so expired users are left to do_find().
+    for (i=0; i<NUM_IDS; i++) {
+        if (model[i].live && (i != k) && !expired(i)) {
+            if (find(i, NULL, 0) == 0) {
+                kept = (expiry(model[i].lifetime) < kept) ? expiry(model[i].lifetime) : kept;
+            }
+            else {
+                gone = (expiry(model[i].lifetime) > gone) ? expiry(model[i].lifetime) : gone;
+                model[i].live = False;
+            }
+        }
+    }
+    CHECK(gone <= kept, "add user %d: evicted a user that expires at %u, kept one at %u",
+          k, (unsigned)gone, (unsigned)kept);
+}
+
+
+static void do_del(int k) {
+    id_tmpl user;
+    ot_u8   rc;
+
+    /// An expired user may have been evicted already, so then either is right
+    make_id(k, &user);
+    rc = auth_del_nlsuser(&user);
+    CHECK(((rc == 0) == model[k].live) || (model[k].live && expired(k)),
+          "delete user %d: returned %d", k, rc);
+    model[k].live = False;
+}
+
+
+static void do_find(int k) {
+    auth_handle handle;
+    ot_bool     expect = model[k].live && !expired(k);
+    ot_u8       rc;
+
+    rc = find(k, &handle, 0);
+    CHECK((rc == 0) == expect, "find user %d: returned %d, model says %s", k, rc,
+          expect ? "there" : (model[k].live ? "expired" : "gone"));
+    if ((rc == 0) && expect) {
+        CHECK((handle.info->length == model[k].keylen) \
+              && (memcmp(handle.keydata, model[k].key, model[k].keylen) == 0),
+              "find user %d: wrong key", k);
+        rc = find(k, NULL, AUTH_FLAG_ISROOT);
+        CHECK((rc == 0) == ((model[k].protocol & AUTH_FLAG_ISROOT) != 0),
+              "find user %d: flags", k);
+    }
+    if (!expect) {
+        model[k].live = False;
+    }
+}
+
+
+
+
+/** Cases
+  * ============================================================================
+  */
+static void test_random(long ops) {
+    long n;
+
+    sub_nls_init();
+    memset(model, 0, sizeof(model));
+    for (n=0; n<ops; n++) {
+        int k   = rand() % NUM_IDS;
+        int op  = rand() % 10;
+
+        if (op < 4)         do_add(k);
+        else if (op < 5)    do_del(k);
+        else if (op < 6)    utc += rand() % 50;
+        else                do_find(k);
+
+        if ((n % 101) == 0) {
+            check_store();
+        }
+    }
+    check_store();
+    printf("random: %ld operations, %d failures\n", ops, failures);
+}
+
+
+static void test_eviction(void) {
+/// Full table with expiry times in a shuffled order, then one more user that
+/// never expires: the user with the earliest expiry must be the one to go.
+    auth_info   info;
+    id_tmpl     user;
+    ot_u8       key[16];
+    int         k;
+
+    sub_nls_init();
+    memset(model, 0, sizeof(model));
+    memset(&info, 0, sizeof(info));
+    memset(key, 0xA5, sizeof(key));
+    utc         = 1000;
+    info.length = 16;
+
+    for (k=0; k<NUM_USERS; k++) {
+        make_id(k, &user);
+        info.lifetime = 2000 + ((k*7) % NUM_USERS) * 10;
+        auth_new_nlsuser(NULL, &user, &info, key);
+    }
+    make_id(NUM_USERS, &user);
+    info.lifetime = 0;
+    auth_new_nlsuser(NULL, &user, &info, key);
+
+    for (k=0; k<NUM_USERS; k++) {
+        ot_u8 rc = find(k, NULL, 0);
+        CHECK((rc != 0) == (((k*7) % NUM_USERS) == 0), "eviction: user %d", k);
+    }
+    CHECK(find(NUM_USERS, NULL, 0) == 0, "eviction: the user that never expires is gone");
+    check_store();
+    printf("eviction order: checked\n");
+}
+
+
+static void test_persistence(void) {
+/// The store from test_eviction(), saved, cleared and loaded back
+    auth_handle handle;
+    int         k, count, saved, loaded;
+
+    count   = auth_nls.count;
+    saved   = auth_save_nlsusers();
+    CHECK(files_open == 0, "save: %d files left open", files_open);
+    sub_nls_init();
+    loaded  = auth_load_nlsusers();
+    CHECK(files_open == 0, "load: %d files left open", files_open);
+    CHECK((saved == count) && (loaded == count), "save %d, load %d, of %d users", saved, loaded, count);
+    CHECK(file_fp[2].length != 0, "the save did not spill into the second file");
+
+    for (k=1; k<NUM_USERS; k++) {
+        ot_u8 rc = find(k, &handle, 0);
+        CHECK((rc != 0) == (((k*7) % NUM_USERS) == 0), "load: user %d", k);
+        if (rc == 0) {
+            CHECK((handle.keydata[0] == 0xA5) \
+                  && (handle.info->lifetime == 2000 + ((k*7) % NUM_USERS) * 10),
+                  "load: user %d has the wrong key or lifetime", k);
+        }
+    }
+    check_store();
+
+    /// crypto_cull() drops the users that have expired by now
+    utc = 2000 + 10*(NUM_USERS/2);
+    crypto_cull();
+    CHECK(auth_nls.count == NUM_USERS - NUM_USERS/2, "cull: %d users left", auth_nls.count);
+    check_store();
+
+    /// Saving an empty store empties the files of the last save
+    sub_nls_init();
+    saved   = auth_save_nlsusers();
+    sub_nls_init();
+    loaded  = auth_load_nlsusers();
+    CHECK((saved == 0) && (loaded == 0), "empty store: saved %d, loaded %d", saved, loaded);
+    printf("save, load and cull: checked\n");
+}
+
+
+
+
+int main(int argc, char** argv) {
+    long ops = (argc > 1) ? atol(argv[1]) : 200000;
+
+    srand(7);
+    test_random(ops);
+    test_eviction();
+    test_persistence();
+
+    printf("\n%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return (failures != 0);
+}
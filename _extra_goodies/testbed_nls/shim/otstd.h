@@ -0,0 +1,53 @@
+/* Host stand-in for the OpenTag otstd.h, for the NLS key store testbed */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef int8_t      ot_s8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_s16;
+typedef int16_t     ot_int;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint32_t    ot_ulong;
+typedef int32_t     ot_s32;
+typedef uint8_t     ot_bool;
+
+typedef union {
+    ot_u16  ushort;
+    ot_u8   ubyte[2];
+} ot_uni16;
+
+#define True            1
+#define False           0
+#define ENABLED         1
+#define DISABLED        0
+#define NOT_AVAILABLE   0
+#define OT_INLINE       inline
+#define OT_WEAK         __attribute__((weak))
+
+#define OT_FEATURE(VAL)             OT_FEATURE_##VAL
+#define OT_FEATURE_DLL_SECURITY     DISABLED
+#define OT_FEATURE_NL_SECURITY      ENABLED
+#define OT_FEATURE_VL_SECURITY      DISABLED
+#define OT_FEATURE_CRYPTO_RFAES     DISABLED
+#define OT_FEATURE_CRYPTO_KEYCACHE  ENABLED
+#define OT_FEATURE_TIME             ENABLED
+
+#define OT_PARAM(VAL)               OT_PARAM_##VAL
+#ifndef OT_PARAM_NLS_USERS
+#   define OT_PARAM_NLS_USERS       16
+#endif
+#define OT_PARAM_NLS_HEAPSIZE       (OT_PARAM_NLS_USERS*20)
+#define OT_PARAM_NLS_GFB_ID         1
+#define OT_PARAM_NLS_GFB_FILES      3
+
+/* The GFB files 1-3 are the ones the test has, and file 0 is off limits */
+#define GFB_NUM_FILES               4
+
+#endif
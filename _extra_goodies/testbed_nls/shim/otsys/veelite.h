@@ -0,0 +1,26 @@
+/* Host stand-in for otsys/veelite.h: the calls auth.c makes for GFB files */
+#ifndef __SHIM_OTSYS_VEELITE_H
+#define __SHIM_OTSYS_VEELITE_H
+#include <otstd.h>
+#include <m2/tmpl.h>
+
+typedef enum {
+    VL_NULL_BLOCKID = 0,
+    VL_GFB_BLOCKID  = 1,
+    VL_ISFS_BLOCKID = 2,
+    VL_ISF_BLOCKID  = 3
+} vlBLOCK;
+
+typedef struct {
+    ot_u16  id;
+    ot_u16  alloc;
+    ot_u16  length;
+} vlFILE;
+
+vlFILE* GFB_open_su(ot_u8 id);
+ot_u16  vl_read(vlFILE* fp, ot_uint offset);
+ot_u8   vl_store(vlFILE* fp, ot_uint length, ot_u8* data);
+ot_u8   vl_append(vlFILE* fp, ot_uint length, ot_u8* data);
+ot_u8   vl_close(vlFILE* fp);
+
+#endif
@@ -0,0 +1,16 @@
+/* Host stand-in for platform/config.h: EAXdrv_t as platform_stdc.h gives it */
+#ifndef __PLATFORM_CONFIG_H
+#define __PLATFORM_CONFIG_H
+#include <otstd.h>
+
+typedef struct {
+    uint32_t    rk[44];
+    ot_u8       l2[16];
+    ot_u8       l4[16];
+    ot_u8       e0[16];
+    ot_u8       e2[16];
+    ot_u8       h[16];
+    ot_u8       c0[16];
+} EAXdrv_t;
+
+#endif
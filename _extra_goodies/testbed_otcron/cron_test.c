@@ -0,0 +1,351 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_otcron/cron_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      OTcron calendar queue against a brute-force model
+  *
+  * otsys/otcron.c is built from the tree with its default queue (8 buckets
+  * of 64 seconds).  Each event gets a task of its own, so the test can see
+  * which events sys_preempt() was called for.  The model keeps the next time
+  * of each event, found by scanning forward a second at a time.
+  *
+  * The OTcron task runs on time, or late, as when a higher priority task has
+  * blocked it: then events are overdue, sometimes by more than a lap of the
+  * calendar.  After each run, the events that fired must be the ones that are
+  * due in the model, and the RTC alarm and the task timeout must be set for
+  * the earliest event that is left.
+  *
+  * Usage: tbcrontest [steps]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <otstd.h>
+#include <otplatform.h>
+#include <otsys/syskern.h>
+#include <otsys/otcron.h>
+
+
+#define NUM_TASKS   16
+
+sys_struct      sys;
+static ot_u32   utc;
+static task_marker tasks[NUM_TASKS];
+static ot_u32   fired;              // bit per task in tasks[]
+static ot_long  alarm_offset;       // -1 if not set
+static ot_long  task_timeout;
+
+static struct {
+    int     used;
+    int     task;
+    ot_u32  value;
+    ot_u32  mask;
+    ot_u32  next;
+} model[OT_PARAM_CRON_EVENTS];
+
+
+
+/** Kernel and platform stand-ins
+  * ========================================================================
+  */
+ot_u32 time_get_utc(void) {
+    return utc;
+}
+
+void sys_preempt(ot_task task, ot_uint nextevent_ti) {
+    if ((task >= &tasks[0]) && (task < &tasks[NUM_TASKS])) {
+        fired |= (ot_u32)1 << (task - &tasks[0]);
+    }
+}
+
+void sys_task_setnext_clocks(ot_task task, ot_long nextevent_clocks) {
+    task_timeout = nextevent_clocks;
+}
+
+void platform_set_rtc_alarm(ot_u8 alarm_id, ot_u8 task_id, ot_u16 offset) {
+    alarm_offset = offset;
+}
+
+
+
+
+/** Model
+  * ========================================================================
+  */
+static int model_nextmatch(ot_u32* next, ot_u32 start, ot_u32 value, ot_u32 mask) {
+/// Masks are either full (one-shot) or within the lower 11 bits.  Returns 0
+/// if there is no match before the 32 bit range ends.
+    ot_u32 t;
+    int    k;
+
+    if (mask == 0xFFFFFFFF) {
+        *next = value;
+        return (value >= start);
+    }
+    for (k=0, t=start; (k<2048) && (t>=start); k++, t++) {
+        if ((t & mask) == (value & mask)) {
+            *next = t;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+static int free_task(void) {
+    int i, j;
+    for (i=0; i<NUM_TASKS; i++) {
+        for (j=0; j<OT_PARAM_CRON_EVENTS; j++) {
+            if (model[j].used && (model[j].task == i)) break;
+        }
+        if (j == OT_PARAM_CRON_EVENTS) return i;
+    }
+    return -1;
+}
+
+
+static int do_add(CRONTIME_Type type, ot_u32 time, ot_u32 mask) {
+    int     t;
+    ot_int  h;
+    ot_u32  next = 0;
+    int     expect_ok;
+    int     n;
+
+    t = free_task();
+    for (n=0, h=0; h<OT_PARAM_CRON_EVENTS; h++) n += model[h].used;
+
+    if (type == CRONTIME_relative) {
+        expect_ok = model_nextmatch(&next, utc, utc + time, 0xFFFFFFFF);
+    }
+    else {
+        expect_ok = model_nextmatch(&next, utc, time, mask);
+    }
+    expect_ok = expect_ok && (n < OT_PARAM_CRON_EVENTS);
+
+    h = otcron_add(&tasks[t], type, time, mask);
+    if ((h >= 0) != expect_ok) {
+        printf("  add(%d, %u, %08X) at %u: handle %d, expected %s\n",
+                type, time, mask, utc, h, expect_ok ? "a handle" : "-1");
+        return -1;
+    }
+    if (h >= 0) {
+        if (model[h].used) {
+            printf("  add: handle %d is in use\n", h);
+            return -1;
+        }
+        model[h].used   = 1;
+        model[h].task   = t;
+        model[h].value  = (type == CRONTIME_relative) ? utc + time : time;
+        model[h].mask   = (type == CRONTIME_relative) ? 0xFFFFFFFF : mask;
+        model[h].next   = next;
+    }
+    return 0;
+}
+
+
+static void do_del(int h) {
+    otcron_del(h);
+    model[h].used = 0;
+}
+
+
+static int do_run(void) {
+/// Runs the OTcron task at the current time and checks it against the model
+    ot_u32  expect_fired = 0;
+    ot_u32  earliest = 0;
+    int     any = 0;
+    int     h;
+
+    for (h=0; h<OT_PARAM_CRON_EVENTS; h++) {
+        if (model[h].used && (model[h].next <= utc)) {
+            expect_fired |= (ot_u32)1 << model[h].task;
+            model[h].used = (utc != 0xFFFFFFFF) && \
+                            model_nextmatch(&model[h].next, utc+1, model[h].value, model[h].mask);
+        }
+    }
+    for (h=0; h<OT_PARAM_CRON_EVENTS; h++) {
+        if (model[h].used && (!any || (model[h].next < earliest))) {
+            earliest    = model[h].next;
+            any         = 1;
+        }
+    }
+
+    fired           = 0;
+    alarm_offset    = -1;
+    task_timeout    = -1;
+    if (sys.task[TASK_otcron].event != 0) {
+        otcron_systask(&sys.task[TASK_otcron]);
+    }
+
+    if (fired != expect_fired) {
+        printf("  at %u: fired %04X, expected %04X\n", utc, fired, expect_fired);
+        return -1;
+    }
+    if (any) {
+        ot_u32 wait = earliest - utc;
+        if ((sys.task[TASK_otcron].event == 0) ||
+            (alarm_offset != (ot_long)((wait > 65535) ? 65535 : wait)) ||
+            (task_timeout != ((ot_long)((wait > 2000000) ? 2000000 : wait) << 10))) {
+            printf("  at %u: alarm %ld, timeout %ld, expected wait %u\n",
+                    utc, (long)alarm_offset, (long)task_timeout, wait);
+            return -1;
+        }
+    }
+    else if (sys.task[TASK_otcron].event != 0) {
+        printf("  at %u: OTcron task still active with no events\n", utc);
+        return -1;
+    }
+    return 0;
+}
+
+
+static void reset(ot_u32 start) {
+    memset(model, 0, sizeof(model));
+    memset(&sys, 0, sizeof(sys));
+    utc = start;
+    otcron_init();
+}
+
+
+
+
+/** Cases
+  * ========================================================================
+  */
+static int test_overdue(void) {
+/// Events at 63 and 100, and the task runs at 64 instead of 63: the event at
+/// 63 is in the bucket before the one of "now," and it must still fire.
+    int rc = 0;
+
+    reset(10);
+    rc |= do_add(CRONTIME_absolute, 63, 0xFFFFFFFF);
+    rc |= do_add(CRONTIME_absolute, 100, 0xFFFFFFFF);
+    rc |= do_run();
+    utc = 64;
+    rc |= do_run();
+    utc = 100;
+    rc |= do_run();
+
+    /// The same, overdue by more than a lap of the calendar
+    reset(1000);
+    rc |= do_add(CRONTIME_absolute, 1100, 0xFFFFFFFF);
+    rc |= do_add(CRONTIME_absolute, 1900, 0xFFFFFFFF);
+    rc |= do_add(CRONTIME_absolute, 0x100, 0x3FF);
+    rc |= do_run();
+    utc = 1750;
+    rc |= do_run();
+    utc = 1900;
+    rc |= do_run();
+
+    printf("overdue events: %s\n", (rc == 0) ? "OK" : "FAILED");
+    return rc;
+}
+
+
+static int test_range_ends(void) {
+/// Before UTC is set, the clock starts at 0, and an event that first matches
+/// at 0 must be accepted.  At the end of the 32 bit range, recurring events
+/// fire on the last second and then have no next time.
+    int rc = 0;
+
+    reset(0);
+    rc |= do_add(CRONTIME_absolute, 0, 0);
+    rc |= do_add(CRONTIME_absolute, 0, 0xFFFFFFFF);
+    rc |= do_add(CRONTIME_relative, 0, 0);
+    if (!model[0].used || !model[1].used || !model[2].used) {
+        printf("  events at time 0 were not added\n");
+        rc = -1;
+    }
+    rc |= do_run();
+    utc = 1;
+    rc |= do_run();
+
+    reset(0xFFFFFFF0);
+    rc |= do_add(CRONTIME_absolute, 0, 0);
+    rc |= do_add(CRONTIME_absolute, 0xFFFFFFFF, 0xFFFFFFFF);
+    rc |= do_add(CRONTIME_absolute, 0x7, 0x7);
+    rc |= do_run();
+    utc = 0xFFFFFFFE;
+    rc |= do_run();
+    utc = 0xFFFFFFFF;
+    rc |= do_run();
+
+    printf("range ends: %s\n", (rc == 0) ? "OK" : "FAILED");
+    return rc;
+}
+
+
+static int test_random(long steps) {
+    long    n;
+    int     h;
+    long    runs = 0;
+
+    reset(1000000);
+    for (n=0; n<steps; n++) {
+        int op = rand() % 10;
+
+        if (op < 3) {
+            switch (rand() % 3) {
+            case 0:  h = do_add(CRONTIME_relative, 1 + rand() % 1500, 0); break;
+            case 1:  h = do_add(CRONTIME_absolute, utc - 100 + rand() % 1600, 0xFFFFFFFF); break;
+            default: h = do_add(CRONTIME_absolute, (ot_u32)rand(), (ot_u32)rand() & 0x7FF); break;
+            }
+            if (h != 0) goto test_random_FAIL;
+        }
+        else if (op < 4) {
+            h = rand() % OT_PARAM_CRON_EVENTS;
+            if (model[h].used) do_del(h);
+        }
+        else {
+            /// Run on time, a little late, or very late
+            ot_u32 wait = (task_timeout > 0) ? (ot_u32)(task_timeout >> 10) : 1;
+            switch (rand() % 4) {
+            case 0:  utc += wait;                       break;
+            case 1:  utc += wait + rand() % 8;          break;
+            case 2:  utc += rand() % 200;               break;
+            default: utc += rand() % 2000;              break;
+            }
+            if (do_run() != 0) goto test_random_FAIL;
+            runs++;
+        }
+    }
+    printf("random: %ld steps, %ld runs: OK\n", steps, runs);
+    return 0;
+
+    test_random_FAIL:
+    printf("random: FAILED at step %ld\n", n);
+    return -1;
+}
+
+
+
+int main(int argc, char** argv) {
+    long    steps = (argc > 1) ? atol(argv[1]) : 200000;
+    int     rc;
+
+    srand(1);
+    rc  = test_overdue();
+    rc |= test_range_ends();
+    rc |= test_random(steps);
+
+    printf("\n%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+/* Host stand-in for otplatform.h: one RTC alarm, captured by the test */
+#ifndef __OTPLATFORM_H
+#define __OTPLATFORM_H
+#include <otstd.h>
+
+#define RTC_ALARMS  1
+void platform_set_rtc_alarm(ot_u8 alarm_id, ot_u8 task_id, ot_u16 offset);
+
+#endif
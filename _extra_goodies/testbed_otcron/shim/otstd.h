@@ -0,0 +1,25 @@
+/* Host stand-in for the OpenTag otstd.h, for the OTcron testbed */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_int;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint8_t     ot_bool;
+
+#define True        1
+#define False       0
+#define ENABLED     1
+#define DISABLED    0
+
+#define OT_FEATURE(VAL)                 OT_FEATURE_##VAL
+#define OT_FEATURE_CRON                 ENABLED
+
+#endif
@@ -0,0 +1,33 @@
+/* Host stand-in for otsys/syskern.h: the task marker, the OTcron task, and
+ * the kernel calls that OTcron makes (provided by the test) */
+#ifndef __OTSYS_SYSKERN_H
+#define __OTSYS_SYSKERN_H
+#include <otstd.h>
+
+#define TI2CLK(TICKS)   ((ot_long)(TICKS))
+
+typedef struct task_marker_struct {
+    ot_u8   event;
+    ot_u8   cursor;
+    ot_u8   reserve;
+    ot_u8   latency;
+    ot_long nextevent;
+} task_marker;
+
+typedef task_marker*    ot_task;
+
+typedef enum {
+    TASK_otcron = 0,
+    TASK_terminus
+} Task_Index;
+
+typedef struct {
+    task_marker task[TASK_terminus];
+} sys_struct;
+
+extern sys_struct sys;
+
+void sys_preempt(ot_task task, ot_uint nextevent_ti);
+void sys_task_setnext_clocks(ot_task task, ot_long nextevent_clocks);
+
+#endif
@@ -0,0 +1,3 @@
+/* Host stand-in for otsys/time.h: UTC seconds, set by the test */
+#include <otstd.h>
+ot_u32 time_get_utc(void);
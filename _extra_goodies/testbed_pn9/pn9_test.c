@@ -0,0 +1,387 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_pn9/pn9_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      SW PN9 codec of /m2/encode.c against the old byte-wise loop
+  *
+  * m2/encode.c, otlib/crc16.c and otlib/queue.c are built from the tree, for
+  * a radio with no HW PN9, CRC or FEC (shim/otstd.h).  The frames have FEC
+  * off, so em2_encode_data() and em2_decode_data() are the PN9 codecs.
+  *
+  * The reference is what the PN9 codec did a byte at a time before: the
+  * nibble-wise LFSR from the 0x1FF seed, and a byte-wise CRC16 from 0xFFFF,
+  * with its own table worked out bit by bit.
+  * <LI> em2_pn9_apply(): every source and destination alignment, keystream
+  *      position and length, in place and not, against the LFSR. </LI>
+  * <LI> Frames: the radio takes or gives a random number of bytes per call,
+  *      so the codecs are cut at every point of the frame.  The CRC16 in the
+  *      queue must be the reference CRC, the bytes on air must be the frame
+  *      XOR the LFSR keystream, and the decoder must return the frame with
+  *      no CRC error.  With one byte on air changed, it must report one. </LI>
+  *
+  * The benchmark times both ways of encoding a frame, in ns/byte.  The tree
+  * time includes loading the queue and em2_encode_newframe().
+  *
+  * Usage: tbpn9test [frames] [benchmark frames]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <otlib/buffers.h>
+#include <otlib/crc16.h>
+#include <m2/encode.h>
+#include <m2/radio.h>
+
+#define MAX_FRAME   254                 // before CRC
+
+ot_queue    txq;
+ot_queue    rxq;
+volatile ot_u8 sink;
+
+
+
+/** Radio FIFO stand-ins: a buffer of bytes on air
+  * ============================================================================
+  * burst_max is the most bytes that radio_txspan() or radio_rxspan() report
+  * at one time, as when the FIFO is partly full.  0 means random.
+  */
+static ot_u8    air[256];
+static ot_int   air_put;
+static ot_int   air_get;
+static ot_int   air_len;
+static ot_int   burst_max;
+
+static ot_int sub_span(ot_int space) {
+    ot_int n = (burst_max != 0) ? burst_max : (ot_int)(1 + rand() % 40);
+    return (n < space) ? n : space;
+}
+
+ot_bool radio_txopen_4()    { return (ot_bool)((air_put + 4) <= (ot_int)sizeof(air)); }
+ot_bool radio_rxopen_4()    { return (ot_bool)((air_get + 4) <= air_len); }
+ot_int radio_txspan()       { return sub_span((ot_int)sizeof(air) - air_put); }
+ot_int radio_rxspan()       { return sub_span(air_len - air_get); }
+
+void radio_putfourbytes(ot_u8* data) {
+    air[air_put++] = data[3];
+    air[air_put++] = data[2];
+    air[air_put++] = data[1];
+    air[air_put++] = data[0];
+}
+
+void radio_getfourbytes(ot_u8* data) {
+    memcpy(data, &air[air_get], 4);
+    air_get += 4;
+}
+
+void radio_putbytes(ot_u8* data, ot_int length) {
+    memcpy(&air[air_put], data, length);
+    air_put += length;
+}
+
+void radio_getbytes(ot_u8* data, ot_int length) {
+    memcpy(data, &air[air_get], length);
+    air_get += length;
+}
+
+
+
+
+/** Reference: the old LFSR and byte-wise CRC16
+  * ============================================================================
+  */
+static ot_u8 key[256];
+
+static void ref_pn9(ot_u8* dst, int n) {
+    ot_u16 reg = 0x01FF;
+    ot_u16 x;
+    int i;
+
+    for (i=0; i<n; i++) {
+        dst[i]  = (ot_u8)reg;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+    }
+}
+
+static ot_u16 ref_table[256];
+
+static void ref_crc16_init(void) {
+/// The byte table, worked out bit by bit: polynomial 0x8005, as in
+/// /include/otlib/crc16_table.h
+    int i, b;
+
+    for (i=0; i<256; i++) {
+        ot_u16 crc = (ot_u16)(i << 8);
+        for (b=0; b<8; b++) {
+            crc = (crc & 0x8000) ? (ot_u16)((crc << 1) ^ 0x8005) : (ot_u16)(crc << 1);
+        }
+        ref_table[i] = crc;
+    }
+}
+
+static ot_u16 ref_crc16(const ot_u8* data, int n) {
+    ot_u16 crc = 0xFFFF;
+    int i;
+
+    for (i=0; i<n; i++) {
+        crc = (ot_u16)(crc << 8) ^ ref_table[(crc >> 8) ^ data[i]];
+    }
+    return crc;
+}
+
+static void ref_encode(ot_u8* dst, const ot_u8* frame, int bytes) {
+/// The old encoder, a byte at a time: CRC the byte, whiten it with the LFSR,
+/// rotate the LFSR.  The CRC goes after the frame, whitened the same way.
+    ot_u8   crc[2];
+    ot_u16  reg = 0x01FF;
+    ot_u16  x;
+    int     i;
+
+    x       = ref_crc16(frame, bytes);
+    crc[0]  = (ot_u8)(x >> 8);
+    crc[1]  = (ot_u8)x;
+    for (i=0; i<bytes+2; i++) {
+        dst[i]  = ((i < bytes) ? frame[i] : crc[i-bytes]) ^ (ot_u8)reg;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+    }
+}
+
+
+
+
+/** Tree codec
+  * ============================================================================
+  */
+static ot_u8 txbuf[256];
+static ot_u8 rxbuf[256];
+
+static int tree_encode(ot_u8* frame, const ot_u8* payload, int bytes) {
+/// Encodes a frame of "bytes" bytes (length byte, link control, payload) into
+/// air[] and returns the bytes on air.  The frame with its CRC5 and CRC16
+/// goes in frame.
+    q_init(&txq, txbuf, sizeof(txbuf));
+    txq.options.ubyte[UPPER]    = 1;        // first TX: add the CRC
+    txq.options.ubyte[LOWER]    = 0;        // no FEC: PN9
+    q_writebyte(&txq, (ot_u8)(bytes - 1));
+    q_writebyte(&txq, 0);
+    q_writestring(&txq, (ot_u8*)&payload[2], bytes - 2);
+
+    air_put = 0;
+    em2_encode_newpacket();
+    em2_encode_newframe();
+    while (em2_remaining_bytes() > 0) {
+        em2_encode_data();
+    }
+
+    memcpy(frame, txbuf, bytes + 2);
+    return air_put;
+}
+
+
+static int tree_decode(const ot_u8* frame, int air_bytes) {
+/// Returns 0 if the frame is decoded without error
+    q_init(&rxq, rxbuf, sizeof(rxbuf));
+    rxq.options.ubyte[LOWER]    = 0;
+    txq.options.ubyte[LOWER]    = 0;        // em2_decode_newpacket() looks here
+
+    air_get = 0;
+    air_len = (ot_int)air_bytes;
+    em2_decode_newpacket();
+    em2_decode_newframe();
+    while ((em2_remaining_bytes() > 0) && (air_get < air_len)) {
+        em2_decode_data();
+    }
+    if (em2_remaining_bytes() > 0) {
+        return -1;
+    }
+    if (em2_decode_endframe() != 0) {
+        return -1;
+    }
+    /// em2_decode_endframe() leaves the number of frame bytes without CRC16
+    /// in the length byte, i.e. the length byte + 1 before the CRC was added.
+    return (rxbuf[0] != (frame[0] - 1)) || (memcmp(&rxbuf[1], &frame[1], rxbuf[0] - 1) != 0);
+}
+
+
+
+
+/** Cases
+  * ============================================================================
+  */
+static int test_apply(void) {
+/// em2_pn9_apply() from every keystream position, for every alignment of the
+/// buffers, checked byte for byte, and with the bytes around it untouched.
+    static ot_u32   sbuf[80];
+    static ot_u32   dbuf[80];
+    ot_u8*  s8 = (ot_u8*)sbuf;
+    ot_u8*  d8 = (ot_u8*)dbuf;
+    int     pos, sa, da, len, i;
+    int     cases = 0;
+
+    for (i=0; i<(int)sizeof(sbuf); i++) {
+        s8[i] = (ot_u8)rand();
+    }
+    for (pos=0; pos<256; pos++) {
+        for (sa=0; sa<4; sa++) {
+            for (da=0; da<5; da++) {
+                /// da == 4 is in place
+                ot_u8*  src = &s8[8+sa];
+                ot_u8*  dst = (da == 4) ? &d8[8+sa] : &d8[8+da];
+
+                for (len=0; len<=(256-pos) && (len<=40 || (len & 31) == 0); len++) {
+                    memset(d8, 0x5A, sizeof(dbuf));
+                    if (da == 4) {
+                        memcpy(dst, src, len);
+                    }
+                    em2.PN9_pos = (ot_u8)pos;
+                    em2_pn9_apply(dst, (da == 4) ? dst : src, (ot_int)len);
+
+                    for (i=0; i<len; i++) {
+                        if (dst[i] != (ot_u8)(src[i] ^ key[pos+i])) break;
+                    }
+                    if ((i < len) || (dst[-1] != 0x5A) || (dst[len] != 0x5A) ||
+                        (em2.PN9_pos != (ot_u8)(pos + len))) {
+                        printf("em2_pn9_apply: pos=%d src+%d dst+%d len=%d: wrong at byte %d\n",
+                                pos, sa, (da == 4) ? sa : da, len, i);
+                        return -1;
+                    }
+                    cases++;
+                }
+            }
+        }
+    }
+    printf("em2_pn9_apply: %d cases: OK\n", cases);
+    return 0;
+}
+
+
+static int test_frames(long frames) {
+    ot_u8   frame[256];
+    ot_u8   payload[256];
+    ot_u8   expect[256];
+    long    n;
+    int     i;
+
+    for (n=0; n<frames; n++) {
+        int bytes, air_bytes;
+
+        bytes       = 2 + (int)(n % (MAX_FRAME - 1));
+        burst_max   = (n & 1) ? 0 : (ot_int)(1 + (n >> 1) % 64);
+        for (i=0; i<bytes; i++) {
+            payload[i] = (ot_u8)rand();
+        }
+
+        air_bytes = tree_encode(frame, payload, bytes);
+        ref_encode(expect, frame, bytes);
+        if ((air_bytes != bytes+2) || (memcmp(air, expect, bytes+2) != 0)) {
+            for (i=0; (i<bytes+2) && (air[i] == expect[i]); i++);
+            printf("frame %ld: %d bytes, bursts of %d: encoded wrong at byte %d of %d\n",
+                    n, bytes, burst_max, i, air_bytes);
+            return -1;
+        }
+        if (tree_decode(frame, air_bytes) != 0) {
+            printf("frame %ld: %d bytes, bursts of %d: not decoded\n", n, bytes, burst_max);
+            return -1;
+        }
+
+        /// Any byte after the length changed: the CRC must catch it
+        i = 1 + rand() % (air_bytes - 1);
+        air[i] ^= (ot_u8)(1 + rand() % 255);
+        if (tree_decode(frame, air_bytes) == 0) {
+            printf("frame %ld: %d bytes: error at byte %d not detected\n", n, bytes, i);
+            return -1;
+        }
+    }
+    printf("frames: %ld, 2-%d bytes, bursts of 1-64 and random: OK\n", frames, MAX_FRAME);
+    return 0;
+}
+
+
+
+
+/** Benchmark
+  * ============================================================================
+  */
+static void bench(long frames) {
+    static const int sizes[] = { 16, 64, 254 };
+    ot_u8   frame[256];
+    ot_u8   payload[256];
+    int     s, i;
+
+    printf("\nns/byte to encode      byte-wise     tree\n");
+    burst_max = 64;
+    for (s=0; s<3; s++) {
+        clock_t start;
+        double  t_ref, t_tree;
+        long    n;
+
+        for (i=0; i<sizes[s]; i++) {
+            payload[i] = (ot_u8)rand();
+        }
+        tree_encode(frame, payload, sizes[s]);
+
+        start = clock();
+        for (n=0; n<frames; n++) {
+            frame[2 + (n & 7)] = (ot_u8)n;
+            ref_encode(air, frame, sizes[s]);
+            sink = air[n & 7];
+        }
+        t_ref = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        start = clock();
+        for (n=0; n<frames; n++) {
+            payload[2 + (n & 7)] = (ot_u8)n;
+            tree_encode(frame, payload, sizes[s]);
+            sink = air[n & 7];
+        }
+        t_tree = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        printf("%3d byte frames   %10.2f %10.2f\n", sizes[s],
+                t_ref * 1e9 / ((double)frames * sizes[s]),
+                t_tree * 1e9 / ((double)frames * sizes[s]));
+    }
+}
+
+
+
+int main(int argc, char** argv) {
+    long    frames  = (argc > 1) ? atol(argv[1]) : 20000;
+    long    bframes = (argc > 2) ? atol(argv[2]) : 200000;
+    int     rc;
+
+    srand(1);
+    ref_pn9(key, sizeof(key));
+    ref_crc16_init();
+    rc  = test_apply();
+    rc |= test_frames(frames);
+    bench(bframes);
+
+    printf("\n%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
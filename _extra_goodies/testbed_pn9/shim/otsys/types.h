@@ -0,0 +1 @@
+#include <otstd.h>
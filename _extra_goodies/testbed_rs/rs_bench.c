@@ -0,0 +1,471 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_rs/rs_bench.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      RS coding of /m2/encode.c, through the frame codecs
+  *
+  * m2/encode.c, otlib/crc16.c and otlib/queue.c are built from the tree with
+  * RS coding on (shim/otstd.h).  The Makefile builds it three ways:
+  * <LI> tbrsbench: SW PN9 codec, and the weak em2_rs_syndrome() </LI>
+  * <LI> tbrsbench_stdc: the same, with the SSE2 em2_rs_syndrome() from
+  *      /platform/stdc/m2_encode_stdc.c </LI>
+  * <LI> tbrsbench_hwcrc: a radio that does PN9 (TB_HWCRC), so the HWCRC codec
+  *      is used </LI>
+  *
+  * The reference is worked out here from RS_GFPOLY, bit by bit: GF(256)
+  * multiplication, the syndromes of a codeword, PN9 and CRC16.
+  * <LI> Parity length: em2_rs_init_decode() must find the parity of every
+  *      frame length from em2_rs_paritylength() of its message. </LI>
+  * <LI> Frames: RS frames of every length go through em2_encode_data(), with
+  *      the radio taking a random number of bytes per call.  On air, the
+  *      frame must be the one in txq (whitened for the PN9 codec), with the
+  *      reference CRC16 and parity that makes it a codeword. </LI>
+  * <LI> The frame goes back through em2_decode_data() and
+  *      em2_decode_endframe() with up to t byte errors after the header,
+  *      which must be corrected, and with more, which must be corrected or
+  *      reported, never passed on wrong. </LI>
+  *
+  * The benchmark gives the throughput of em2_rs_syndrome(), and the goodput
+  * of frames through the codecs at several bit error rates, with CRC16 only
+  * and with RS+CRC16.  Goodput is delivered payload bytes over frame bytes
+  * sent, so a frame that fails counts as a full retry.
+  *
+  * Usage: tbrsbench [frames] [frames per goodput point]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <otlib/buffers.h>
+#include <otlib/crc16.h>
+#include <m2/encode.h>
+#include <m2/radio.h>
+
+#if (RF_FEATURE(PN9) == ENABLED)
+#   define CODEC_NAME   "HWCRC"
+#else
+#   define CODEC_NAME   "PN9"
+#endif
+
+ot_queue    txq;
+ot_queue    rxq;
+volatile ot_u8 sink;
+
+
+
+/** Radio FIFO stand-ins: a buffer of bytes on air
+  * ============================================================================
+  * burst_max is the most bytes that radio_txspan() or radio_rxspan() report
+  * at one time, as when the FIFO is partly full.  0 means random.
+  */
+static ot_u8    air[256];
+static ot_int   air_put;
+static ot_int   air_get;
+static ot_int   air_len;
+static ot_int   burst_max;
+
+static ot_int sub_span(ot_int space) {
+    ot_int n = (burst_max != 0) ? burst_max : (ot_int)(1 + rand() % 40);
+    return (n < space) ? n : space;
+}
+
+ot_bool radio_txopen_4()    { return (ot_bool)((air_put + 4) <= (ot_int)sizeof(air)); }
+ot_bool radio_rxopen_4()    { return (ot_bool)((air_get + 4) <= air_len); }
+ot_int radio_txspan()       { return sub_span((ot_int)sizeof(air) - air_put); }
+ot_int radio_rxspan()       { return sub_span(air_len - air_get); }
+
+void radio_putfourbytes(ot_u8* data) {
+    air[air_put++] = data[3];
+    air[air_put++] = data[2];
+    air[air_put++] = data[1];
+    air[air_put++] = data[0];
+}
+
+void radio_getfourbytes(ot_u8* data) {
+    memcpy(data, &air[air_get], 4);
+    air_get += 4;
+}
+
+void radio_putbytes(ot_u8* data, ot_int length) {
+    memcpy(&air[air_put], data, length);
+    air_put += length;
+}
+
+void radio_getbytes(ot_u8* data, ot_int length) {
+    memcpy(data, &air[air_get], length);
+    air_get += length;
+}
+
+
+
+
+/** Reference: GF(256), PN9 and CRC16, bit by bit
+  * ============================================================================
+  */
+static ot_u8    key[256];
+static ot_u16   ref_table[256];
+
+static ot_u8 ref_gf_mul(ot_u8 a, ot_u8 b) {
+    ot_u8 p = 0;
+    while (b != 0) {
+        if (b & 1) {
+            p ^= a;
+        }
+        a   = (ot_u8)((a << 1) ^ ((a & 0x80) ? (RS_GFPOLY & 0xFF) : 0));
+        b >>= 1;
+    }
+    return p;
+}
+
+static int ref_is_codeword(const ot_u8* cw, int n, int parity) {
+/// The syndromes are cw(x) at the generator roots, a^0 ... a^(parity-1)
+    ot_u8   root = 1;
+    int     i, j;
+
+    for (j=0; j<parity; j++) {
+        ot_u8 s = 0;
+        for (i=0; i<n; i++) {
+            s = ref_gf_mul(s, root) ^ cw[i];
+        }
+        if (s != 0) {
+            return 0;
+        }
+        root = ref_gf_mul(root, 2);
+    }
+    return 1;
+}
+
+static void ref_pn9(ot_u8* dst, int n) {
+    ot_u16 reg = 0x01FF;
+    ot_u16 x;
+    int i;
+
+    for (i=0; i<n; i++) {
+        dst[i]  = (ot_u8)reg;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+        x       = ((reg << 5) ^ reg) & 0x01E0;
+        reg     = (reg >> 4) | x;
+    }
+}
+
+static void ref_crc16_init(void) {
+    int i, b;
+
+    for (i=0; i<256; i++) {
+        ot_u16 crc = (ot_u16)(i << 8);
+        for (b=0; b<8; b++) {
+            crc = (crc & 0x8000) ? (ot_u16)((crc << 1) ^ 0x8005) : (ot_u16)(crc << 1);
+        }
+        ref_table[i] = crc;
+    }
+}
+
+static ot_u16 ref_crc16(const ot_u8* data, int n) {
+    ot_u16 crc = 0xFFFF;
+    int i;
+
+    for (i=0; i<n; i++) {
+        crc = (ot_u16)(crc << 8) ^ ref_table[(crc >> 8) ^ data[i]];
+    }
+    return crc;
+}
+
+static int frame_fits(int bytes, int use_rs) {
+/// A frame, with its CRC16 and RS parity, must fit in 256 bytes
+    int msg = bytes + 2;
+    return (msg + (use_rs ? em2_rs_paritylength((ot_int)msg) : 0)) <= 256;
+}
+
+
+
+
+/** Tree codec
+  * ============================================================================
+  */
+static ot_u8 txbuf[256];
+static ot_u8 rxbuf[256];
+
+static int tree_encode(const ot_u8* payload, int bytes, int use_rs) {
+/// Encodes a frame of "bytes" bytes (length byte, link control, payload) into
+/// air[] and returns the bytes on air.  The frame with its CRC5, CRC16 and
+/// parity is left in txbuf.
+    q_init(&txq, txbuf, sizeof(txbuf));
+    txq.options.ubyte[UPPER]    = 1;        // first TX: add the CRC and parity
+    txq.options.ubyte[LOWER]    = 0;        // no FEC
+    q_writebyte(&txq, (ot_u8)(bytes - 1));
+    q_writebyte(&txq, use_rs ? 0x40 : 0);
+    q_writestring(&txq, (ot_u8*)&payload[2], bytes - 2);
+
+    air_put = 0;
+    em2_encode_newpacket();
+    em2_encode_newframe();
+    while (em2_remaining_bytes() > 0) {
+        em2_encode_data();
+    }
+    return air_put;
+}
+
+
+static int tree_decode(int air_bytes, int bytes) {
+/// Returns 0 if the frame of "bytes" bytes is decoded without error, 1 if it
+/// is decoded but not the same as the one in txbuf.  em2_decode_endframe()
+/// leaves the frame length without CRC16 and parity in the length byte.
+    q_init(&rxq, rxbuf, sizeof(rxbuf));
+    rxq.options.ubyte[LOWER]    = 0;
+    txq.options.ubyte[LOWER]    = 0;        // em2_decode_newpacket() looks here
+
+    air_get = 0;
+    air_len = (ot_int)air_bytes;
+    em2_decode_newpacket();
+    em2_decode_newframe();
+    while ((em2_remaining_bytes() > 0) && (air_get < air_len)) {
+        em2_decode_data();
+    }
+    if (em2_remaining_bytes() > 0) {
+        return -1;
+    }
+    if (em2_decode_endframe() != 0) {
+        return -1;
+    }
+    if ((rxbuf[0] != bytes) || (memcmp(&rxbuf[1], &txbuf[1], bytes - 1) != 0)) {
+        return 1;
+    }
+    return 0;
+}
+
+
+static void air_unwhiten(ot_u8* dst, int n) {
+    int i;
+    for (i=0; i<n; i++) {
+#       if (RF_FEATURE(PN9) == ENABLED)
+        dst[i] = air[i];
+#       else
+        dst[i] = air[i] ^ key[i];
+#       endif
+    }
+}
+
+
+static void air_errors(int n, int air_bytes) {
+/// n byte errors after the header, at different places.  The header is
+/// guarded by CRC5, and the decoder needs it to find the frame.
+    int pos[RS_MAXPARITY];
+    int i, k;
+
+    for (i=0; i<n; i++) {
+        do {
+            pos[i] = 2 + rand() % (air_bytes - 2);
+            for (k=0; (k<i) && (pos[k] != pos[i]); k++);
+        } while (k < i);
+        air[pos[i]] ^= (ot_u8)(1 + rand() % 255);
+    }
+}
+
+
+
+
+/** Cases
+  * ============================================================================
+  */
+static int test_paritylength(void) {
+/// em2_rs_init_decode() finds the parity from the frame length alone, which
+/// must undo em2_rs_paritylength() of the message for every message length.
+    ot_queue    q;
+    ot_u8       buf[256];
+    int         msg;
+
+    for (msg=4; frame_fits(msg-2, 1); msg++) {
+        int parity = em2_rs_paritylength((ot_int)msg);
+        q_init(&q, buf, sizeof(buf));
+        buf[0] = (ot_u8)(msg + parity - 1);
+        if (em2_rs_init_decode(&q) != parity) {
+            printf("em2_rs_init_decode: %d byte message: parity %d, not %d\n",
+                    msg, em2_rs_init_decode(&q), parity);
+            return -1;
+        }
+    }
+    printf("parity length: %d-%d byte messages: OK\n", 4, msg-1);
+    return 0;
+}
+
+
+static int test_frames(long frames) {
+    ot_u8   payload[256];
+    ot_u8   onair[256];
+    long    n, over_t = 0;
+    int     i;
+
+    for (n=0; n<frames; n++) {
+        int bytes, msg, parity, air_bytes, t, errors, rc;
+
+        do {
+            bytes = 2 + rand() % 254;
+        } while (frame_fits(bytes, 1) == 0);
+        msg         = bytes + 2;
+        parity      = em2_rs_paritylength((ot_int)msg);
+        t           = parity >> 1;
+        burst_max   = (n & 1) ? 0 : (ot_int)(1 + (n >> 1) % 64);
+        for (i=0; i<bytes; i++) {
+            payload[i] = (ot_u8)rand();
+        }
+
+        /// 1. Encoder: CRC16 and parity written out into txq, and loaded
+        air_bytes = tree_encode(payload, bytes, 1);
+        air_unwhiten(onair, air_bytes);
+        if ((air_bytes != msg + parity) || (txbuf[0] != (ot_u8)(air_bytes - 1))
+        ||  (memcmp(onair, txbuf, air_bytes) != 0)) {
+            printf("frame %ld: %d bytes, bursts of %d: %d bytes on air, not as in txq\n",
+                    n, bytes, burst_max, air_bytes);
+            return -1;
+        }
+        if ((((txbuf[bytes] << 8) | txbuf[bytes+1]) != ref_crc16(txbuf, bytes))
+        ||  (ref_is_codeword(txbuf, air_bytes, parity) == 0)) {
+            printf("frame %ld: %d bytes, bursts of %d: wrong CRC16 or parity\n",
+                    n, bytes, burst_max);
+            return -1;
+        }
+
+        /// 2. Decoder: up to t byte errors are corrected
+        errors = rand() % (t + 1);
+        air_errors(errors, air_bytes);
+        if (tree_decode(air_bytes, bytes) != 0) {
+            printf("frame %ld: %d bytes, bursts of %d: %d errors, t=%d, not corrected\n",
+                    n, bytes, burst_max, errors, t);
+            return -1;
+        }
+
+        /// 3. More than t errors: corrected or reported, never passed on wrong
+        tree_encode(payload, bytes, 1);
+        errors = t + 1 + rand() % 4;
+        air_errors(errors, air_bytes);
+        rc = tree_decode(air_bytes, bytes);
+        if (rc > 0) {
+            printf("frame %ld: %d bytes: %d errors, t=%d, decoded wrong\n", n, bytes, errors, t);
+            return -1;
+        }
+        over_t += (rc == 0);
+    }
+    printf("frames (%s codec): %ld with up to t errors corrected, "
+           "%ld of %ld with more than t decoded right, the rest reported: OK\n",
+            CODEC_NAME, frames, over_t, frames);
+    return 0;
+}
+
+
+
+
+/** Benchmark
+  * ============================================================================
+  */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (1e-9 * ts.tv_nsec);
+}
+
+
+static void channel(int air_bytes, double ber) {
+/// Flips each bit after the header with probability ber, skipping ahead by
+/// geometric gaps.
+    double  lnq = log(1.0 - ber);
+    long    bit = 15;
+    for (;;) {
+        double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+        bit += 1 + (long)(log(u) / lnq);
+        if (bit >= ((long)air_bytes << 3)) {
+            break;
+        }
+        air[bit >> 3] ^= (ot_u8)(1 << (bit & 7));
+    }
+}
+
+
+static void bench(long frames) {
+    static const int    payloads[]  = { 32, 128, 219 };
+    static const double bers[]      = { 1e-5, 1e-4, 3e-4, 1e-3, 2e-3, 4e-3 };
+    ot_u8   payload[256];
+    ot_u8   syn[RS_MAXPARITY];
+    double  start;
+    long    n, loops = 200000;
+    int     p, b, i;
+
+    /// 1. Syndrome throughput on the longest RS frame
+    for (i=0; i<254; i++) {
+        payload[i] = (ot_u8)rand();
+    }
+    start = now();
+    for (n=0; n<loops; n++) {
+        memset(syn, 0, sizeof(syn));
+        em2_rs_syndrome(syn, 30, payload, 254);
+        sink ^= syn[0];
+    }
+    printf("\nem2_rs_syndrome(), 254 byte frame: %.1f MB/s\n\n",
+            (double)(loops * 254) / ((now() - start) * 1e6));
+
+    /// 2. Goodput vs. bit error rate
+    burst_max = 64;
+    printf("payload      BER   frame(crc)  goodput(crc)   frame(rs)  goodput(rs)\n");
+    for (p=0; p<(int)(sizeof(payloads)/sizeof(int)); p++) {
+        for (b=0; b<(int)(sizeof(bers)/sizeof(double)); b++) {
+            long    ok_crc = 0, ok_rs = 0;
+            int     total_crc = 0, total_rs = 0;
+            for (n=0; n<frames; n++) {
+                for (i=2; i<payloads[p]+2; i++) {
+                    payload[i] = (ot_u8)rand();
+                }
+                total_crc   = tree_encode(payload, payloads[p]+2, 0);
+                channel(total_crc, bers[b]);
+                ok_crc     += (tree_decode(total_crc, payloads[p]+2) == 0);
+
+                total_rs    = tree_encode(payload, payloads[p]+2, 1);
+                channel(total_rs, bers[b]);
+                ok_rs      += (tree_decode(total_rs, payloads[p]+2) == 0);
+            }
+            printf("%7d  %7.0e  %10d  %11.1f%%  %10d  %10.1f%%\n", payloads[p], bers[b],
+                    total_crc, 100.0 * ok_crc * payloads[p] / ((double)frames * total_crc),
+                    total_rs, 100.0 * ok_rs * payloads[p] / ((double)frames * total_rs));
+        }
+    }
+}
+
+
+
+int main(int argc, char** argv) {
+    long    frames  = (argc > 1) ? atol(argv[1]) : 20000;
+    long    bframes = (argc > 2) ? atol(argv[2]) : 2000;
+    int     rc;
+
+    srand(1);
+    ref_pn9(key, sizeof(key));
+    ref_crc16_init();
+    rc  = test_paritylength();
+    rc |= test_frames(frames);
+    if (rc == 0) {
+        bench(bframes);
+    }
+
+    printf("\n%s\n", (rc == 0) ? "PASSED" : "FAILED");
+    return (rc == 0) ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+/* Host stand-in for the OpenTag otstd.h, for the RS testbed: a radio with no
+ * HW CRC or FEC, and HW PN9 only when TB_HWCRC is defined.  RS coding is on. */
+#ifndef __OTSTD_H
+#define __OTSTD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t     ot_u8;
+typedef int8_t      ot_s8;
+typedef uint16_t    ot_u16;
+typedef int16_t     ot_int;
+typedef int16_t     ot_s16;
+typedef uint16_t    ot_uint;
+typedef uint32_t    ot_u32;
+typedef int32_t     ot_long;
+typedef uint32_t    ot_ulong;
+typedef int32_t     ot_s32;
+typedef uint8_t     ot_bool;
+
+typedef union {
+    ot_u16  ushort;
+    ot_int  sshort;
+    ot_u8   ubyte[2];
+} ot_uni16;
+
+typedef union {
+    ot_u32  ulong;
+    ot_u16  ushort[2];
+    ot_u8   ubyte[4];
+} ot_uni32;
+
+#define UPPER       1
+#define LOWER       0
+#define B3          3
+#define B2          2
+#define B1          1
+#define B0          0
+#define True        1
+#define False       0
+#define ENABLED     1
+#define DISABLED    0
+#define OT_INLINE
+#define OT_WEAK     __attribute__((weak))
+
+#define OT_FEATURE(VAL)                 OT_FEATURE_##VAL
+#define OT_FEATURE_SERVER               ENABLED
+#define OT_FEATURE_M2                   ENABLED
+#define OT_FEATURE_RF_LINKINFO          DISABLED
+#define OT_PARAM(VAL)                   OT_PARAM_##VAL
+#define OT_PARAM_CRC16_SLICES           1
+
+#define M2_FEATURESET                   ENABLED
+#define M2_FEATURE(VAL)                 ((M2_FEATURE_##VAL) && (M2_FEATURESET))
+#define M2_FEATURE_FECTX                ENABLED
+#define M2_FEATURE_FECRX                ENABLED
+#define M2_FEATURE_FEC                  ENABLED
+#define M2_FEATURE_RSCODE               ENABLED
+#define M2_FEATURE_MULTIFRAME           DISABLED
+
+#define RF_FEATURE(VAL)                 RF_FEATURE_##VAL
+#ifdef TB_HWCRC
+#   define RF_FEATURE_PN9               ENABLED
+#else
+#   define RF_FEATURE_PN9               DISABLED
+#endif
+#define RF_FEATURE_CRC                  DISABLED
+#define RF_FEATURE_CRC16                DISABLED
+#define RF_FEATURE_CRC5                 DISABLED
+#define RF_FEATURE_FEC                  DISABLED
+
+#define MCU_FEATURE(VAL)                MCU_FEATURE_##VAL
+#define MCU_FEATURE_CRC16               DISABLED
+
+#endif
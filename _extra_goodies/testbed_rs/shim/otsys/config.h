@@ -0,0 +1,2 @@
+/* Host stand-in: nothing from it is used by the encoder */
+#include <otstd.h>
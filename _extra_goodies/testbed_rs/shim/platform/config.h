@@ -0,0 +1,3 @@
+/* Host stand-in for platform/config.h */
+#include <otstd.h>
+#define delay_ti(TI)    ((void)(TI))
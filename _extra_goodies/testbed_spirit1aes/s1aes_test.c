@@ -0,0 +1,555 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /_extra_goodies/testbed_spirit1aes/s1aes_test.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Tests for the SPIRIT1 EAX driver, against a register model
+  *
+  * The driver (/io/spirit1/SPIRIT1_eax.c) and the SPIRIT1 interface
+  * (/io/spirit1/SPIRIT1_interface.c) are built from the tree, with the host
+  * stand-ins in shim/.  Below them is a model of the SPIRIT1 at the SPI level:
+  * a register file, the strobes, and the AES engine (AES_ON, key and data
+  * registers, the AES IRQ).  The model flags any misuse, e.g. an AES strobe
+  * with the engine off or with the XO off, or no wait for the IRQ.
+  *
+  * The model's clock is host time, less the time spent in the model, plus a
+  * set cost per SPI byte and per wake-up.  So the software AES is timed for
+  * real, and the SPI bus is as slow as the test says.  The checks are:
+  * <LI> the FIPS-197 block through the engine, and the register byte order </LI>
+  * <LI> random frames against a plain reference EAX (below),
+  *      with a fast bus, a slow bus, and with the radio busy </LI>
+  * <LI> which engine is picked in each case </LI>
+  * <LI> key caching in the radio, and what invalidates it </LI>
+  * <LI> waking the SPIRIT1 for the engine, and putting it back </LI>
+  *
+  * Usage: tbs1aestest [random frames]
+  ******************************************************************************
+  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <otstd.h>
+#include <otlib/crypto.h>
+#include <io/spirit1/interface.h>
+#include <m2/radio.h>
+#include <m2/dll.h>
+
+static int  failures = 0;
+
+#define CHECK(COND, ...)    do { if (!(COND)) { failures++; printf("FAIL: " __VA_ARGS__); printf("\n"); } } while (0)
+
+
+
+/** Reference AES-128 and EAX
+  * ============================================================================
+  */
+static uint8_t ref_sbox[256];
+
+static uint8_t ref_gmul(uint8_t a, uint8_t b) {
+    uint8_t p = 0;
+    while (b) {
+        if (b & 1) p ^= a;
+        a = (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1B : 0));
+        b >>= 1;
+    }
+    return p;
+}
+
+static void ref_init(void) {
+    int x, y;
+    for (x=0; x<256; x++) {
+        uint8_t inv = 0, b;
+        for (y=1; (x != 0) && (y < 256); y++) {
+            if (ref_gmul((uint8_t)x, (uint8_t)y) == 1) { inv = (uint8_t)y; break; }
+        }
+        b = inv;
+        b ^= (uint8_t)((inv << 1) | (inv >> 7));
+        b ^= (uint8_t)((inv << 2) | (inv >> 6));
+        b ^= (uint8_t)((inv << 3) | (inv >> 5));
+        b ^= (uint8_t)((inv << 4) | (inv >> 4));
+        ref_sbox[x] = b ^ 0x63;
+    }
+}
+
+static void ref_expand(const uint8_t* key, uint8_t* w) {
+    uint8_t rcon = 1, t[4];
+    int     i;
+    memcpy(w, key, 16);
+    for (i=4; i<44; i++) {
+        memcpy(t, &w[4*(i-1)], 4);
+        if ((i % 4) == 0) {
+            uint8_t u = t[0];
+            t[0] = ref_sbox[t[1]] ^ rcon;
+            t[1] = ref_sbox[t[2]];
+            t[2] = ref_sbox[t[3]];
+            t[3] = ref_sbox[u];
+            rcon = ref_gmul(rcon, 2);
+        }
+        w[4*i+0] = w[4*(i-4)+0] ^ t[0];
+        w[4*i+1] = w[4*(i-4)+1] ^ t[1];
+        w[4*i+2] = w[4*(i-4)+2] ^ t[2];
+        w[4*i+3] = w[4*(i-4)+3] ^ t[3];
+    }
+}
+
+static void ref_aes(const uint8_t* w, const uint8_t* in, uint8_t* out) {
+    uint8_t s[16], t[16];
+    int     i, r, c;
+    for (i=0; i<16; i++) s[i] = in[i] ^ w[i];
+    for (r=1; r<=10; r++) {
+        for (i=0; i<16; i++) s[i] = ref_sbox[s[i]];
+        for (i=0; i<16; i++) t[i] = s[(i + 4*(i%4)) % 16];     // ShiftRows
+        if (r != 10) {
+            for (c=0; c<4; c++) {
+                uint8_t* a = &t[4*c];
+                uint8_t  b0 = a[0], b1 = a[1], b2 = a[2], b3 = a[3];
+                a[0] = ref_gmul(b0,2) ^ ref_gmul(b1,3) ^ b2 ^ b3;
+                a[1] = b0 ^ ref_gmul(b1,2) ^ ref_gmul(b2,3) ^ b3;
+                a[2] = b0 ^ b1 ^ ref_gmul(b2,2) ^ ref_gmul(b3,3);
+                a[3] = ref_gmul(b0,3) ^ b1 ^ b2 ^ ref_gmul(b3,2);
+            }
+        }
+        for (i=0; i<16; i++) s[i] = t[i] ^ w[16*r + i];
+    }
+    memcpy(out, s, 16);
+}
+
+static void ref_omac(const uint8_t* w, int tweak, const uint8_t* msg, int len, uint8_t* out) {
+/// OMAC1 of [tweak]_16 || msg
+    uint8_t L[16], L2[16], L4[16], x[16], blk[16];
+    int     total = 16 + len;
+    int     pos, i;
+
+    memset(blk, 0, 16);
+    ref_aes(w, blk, L);
+    for (i=0; i<16; i++) L2[i] = (uint8_t)((L[i] << 1) | ((i < 15) ? (L[i+1] >> 7) : 0));
+    if (L[0] & 0x80) L2[15] ^= 0x87;
+    for (i=0; i<16; i++) L4[i] = (uint8_t)((L2[i] << 1) | ((i < 15) ? (L2[i+1] >> 7) : 0));
+    if (L2[0] & 0x80) L4[15] ^= 0x87;
+
+    memset(x, 0, 16);
+    for (pos=0; pos<total; pos+=16) {
+        int n = (total - pos > 16) ? 16 : (total - pos);
+        for (i=0; i<16; i++) {
+            int     k = pos + i;
+            uint8_t b;
+            if (i >= n)         b = (i == n) ? 0x80 : 0;
+            else if (k < 16)    b = (k == 15) ? (uint8_t)tweak : 0;
+            else                b = msg[k-16];
+            blk[i] = x[i] ^ b;
+        }
+        if (pos + 16 >= total) {
+            for (i=0; i<16; i++) blk[i] ^= (n == 16) ? L2[i] : L4[i];
+        }
+        ref_aes(w, blk, x);
+    }
+    memcpy(out, x, 16);
+}
+
+static void ref_eax(const uint8_t* key, const uint8_t* nonce, int nlen,
+                    const uint8_t* hdr, int hlen, uint8_t* msg, int mlen,
+                    uint8_t* tag, int taglen) {
+/// Encrypts msg in place and writes the tag
+    uint8_t w[176], N[16], H[16], C[16], ctr[16], ks[16];
+    int     i, j;
+
+    ref_expand(key, w);
+    ref_omac(w, 0, nonce, nlen, N);
+    ref_omac(w, 1, hdr, hlen, H);
+    memcpy(ctr, N, 16);
+    for (i=0; i<mlen; i+=16) {
+        ref_aes(w, ctr, ks);
+        for (j=0; (j<16) && (i+j<mlen); j++) msg[i+j] ^= ks[j];
+        for (j=15; (j>=0) && (++ctr[j] == 0); j--);
+    }
+    ref_omac(w, 2, msg, mlen, C);
+    for (i=0; i<taglen; i++) tag[i] = N[i] ^ H[i] ^ C[i];
+}
+
+
+
+
+
+
+/** SPIRIT1 model
+  * ============================================================================
+  * Register IN<n> (and OUT<n>) holds byte n of the block, as the interface
+  * header says, so IN0 is the highest address of each group.
+  */
+static struct {
+    uint8_t     reg[256];
+    int         xo;                     // READY (or active): the engine can run
+    int         armed;                  // spirit1_wfe_aes() was called
+    int         aes_irq;
+    long        spi_bytes;
+    long        key_loads;
+    long        aes_runs;
+    long        wakes;
+    long        misuse;
+    long        ns_per_byte;
+    long        ns_per_wake;
+    long        model_ns;               // host time spent in the model
+} rf;
+
+radio_struct    radio;
+dll_struct      dll;
+
+static long host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+ot_u32 systim_chronstamp(ot_u32* timestamp) {
+    ot_u32 now = (ot_u32)(host_ns() - rf.model_ns + (rf.spi_bytes * rf.ns_per_byte)
+                        + (rf.wakes * rf.ns_per_wake));
+    return (timestamp == NULL) ? now : (now - *timestamp);
+}
+
+static void model_aes(void) {
+    uint8_t key[16], in[16], out[16], w[176];
+    int     n;
+    for (n=0; n<16; n++) {
+        key[n]  = rf.reg[RFREG(AES_KEY_IN0) - n];
+        in[n]   = rf.reg[RFREG(AES_DATA_IN0) - n];
+    }
+    ref_expand(key, w);
+    ref_aes(w, in, out);
+    for (n=0; n<16; n++) {
+        rf.reg[RFREG(AES_DATA_OUT0) - n] = out[n];
+    }
+}
+
+void spirit1_spibus_io(ot_u8 cmd_len, ot_u8 resp_len, ot_u8* cmd) {
+    long    t0 = host_ns();
+    int     i;
+
+    rf.spi_bytes += cmd_len + resp_len;
+    switch (cmd[0]) {
+    case 0x00:
+        for (i=2; i<cmd_len; i++) {
+            rf.reg[(uint8_t)(cmd[1] + i - 2)] = cmd[i];
+        }
+        if ((cmd[1] <= RFREG(AES_KEY_IN0)) && ((cmd[1] + cmd_len - 2) > RFREG(AES_KEY_IN15))) {
+            rf.key_loads++;
+        }
+        break;
+
+    case 0x01:
+        for (i=0; i<resp_len; i++) {
+            spirit1.busrx[i] = rf.reg[(uint8_t)(cmd[1] + i)];
+        }
+        break;
+
+    case 0x80:
+        switch (cmd[1]) {
+        case RFSTROBE_READY:    rf.xo = 1;  break;
+        case RFSTROBE_STANDBY:
+        case RFSTROBE_SLEEP:    rf.xo = 0;  break;
+        case RFSTROBE_SRES:     memset(rf.reg, 0, sizeof(rf.reg));
+                                rf.xo = 1;
+                                break;
+        case RFSTROBE_AES_ENC:
+            if (((rf.reg[RFREG(ANA_FUNC_CONF0)] & _AES_ON) == 0) || !rf.xo || !rf.armed
+            ||  (radio.state != RADIO_Idle)) {
+                rf.misuse++;
+            }
+            model_aes();
+            rf.aes_runs++;
+            rf.aes_irq = 1;
+            break;
+        default: break;
+        }
+        break;
+
+    default:
+        rf.misuse++;
+        break;
+    }
+    rf.model_ns += host_ns() - t0;
+}
+
+void spirit1_wfe_aes(void)  { rf.armed = 1; rf.aes_irq = 0; }
+void spirit1_wfe(void) {
+    if (!rf.armed || !rf.aes_irq) {
+        rf.misuse++;
+    }
+    rf.armed    = 0;
+    rf.aes_irq  = 0;
+}
+
+/// Pins and the radio driver functions the EAX driver uses (radio_rm2.c)
+ot_uint spirit1_readypin_ishigh(void)   { return (ot_uint)rf.xo; }
+ot_uint spirit1_resetpin_ishigh(void)   { return 1; }
+ot_uint spirit1_abortpin_ishigh(void)   { return 0; }
+ot_uint spirit1_cspin_ishigh(void)      { return 0; }
+ot_uint spirit1_sdnpin_sethigh(void)    { rf.xo = 0; return 0; }
+ot_uint spirit1_sdnpin_setlow(void)     { return 0; }
+void spirit1_int_config(ot_u32 ie_sel)  { }
+void spirit1_int_turnoff(ot_u16 ie_sel) { }
+void spirit1_int_clearall(void)         { }
+void spirit1_virtual_isr(ot_u8 code)    { }
+void delay_us(ot_uint us)               { }
+void delay_ms(ot_uint ms)               { }
+void dll_init(void)                     { }
+ot_int otutils_bin2hex(ot_u8* dst, ot_u8* src, ot_int size) { return 0; }
+ot_int logger_msg(ot_u8 type, ot_int ll, ot_int dl, ot_u8* l, ot_u8* d) { return 0; }
+
+void spirit1drv_force_ready(void) {
+    if (!rf.xo) {
+        spirit1_strobe(RFSTROBE_READY);
+        rf.wakes++;
+    }
+}
+void spirit1drv_smart_standby(void) {
+    spirit1_strobe(RFSTROBE_STANDBY);
+}
+
+
+
+
+/** Tests
+  * ============================================================================
+  */
+static int hex(const char* s, uint8_t* out) {
+    int n = 0;
+    while (s[0] && s[1]) {
+        unsigned int v;
+        sscanf(s, "%2x", &v);
+        out[n++] = (uint8_t)v;
+        s += 2;
+    }
+    return n;
+}
+
+
+static void test_engine(void) {
+    uint8_t key[16], blk[16], exp[16];
+    int     n;
+
+    hex("000102030405060708090a0b0c0d0e0f", key);
+    hex("00112233445566778899aabbccddeeff", blk);
+    hex("69c4e0d86a7b0430d8cdb78070b4c55a", exp);
+
+    spirit1_strobe(RFSTROBE_READY);
+    spirit1_aes_loadkey(key);
+    CHECK(rf.reg[RFREG(ANA_FUNC_CONF0)] & _AES_ON, "engine: AES_ON not set by the key load");
+    for (n=0; n<16; n++) {
+        CHECK(rf.reg[RFREG(AES_KEY_IN0) - n] == key[n], "engine: key byte %d is not in KEY_IN%d", n, n);
+    }
+    spirit1_aes_encrypt(blk);
+    CHECK(memcmp(blk, exp, 16) == 0, "engine: AES-128, FIPS-197 C.1");
+
+    spirit1_aes_off();
+    CHECK((rf.reg[RFREG(ANA_FUNC_CONF0)] & _AES_ON) == 0, "engine: AES_ON still set");
+    for (n=0; n<16; n++) {
+        CHECK(rf.reg[RFREG(AES_KEY_IN15) + n] == 0, "engine: key not wiped");
+    }
+    CHECK(spirit1.aeskey == NULL, "engine: aeskey not cleared");
+    CHECK(rf.misuse == 0, "engine: %ld misuses", rf.misuse);
+    printf("engine   FIPS-197 block and register order\n");
+}
+
+
+static void run_frames(const char* name, int frames, long* hw_frames) {
+/// Random frames on 4 keys, each encrypted, decrypted, and decrypted again
+/// after tampering.  Returns how many of the frames ran on the SPIRIT1.
+    static uint8_t  plain[272], refc[272], buf[272];
+    EAXdrv_t        ctx[4];
+    uint8_t         keys[4][16], nonce[8];
+    int             i, f, n, len, r;
+    long            runs, hw = 0;
+
+    for (f=0; f<4; f++) {
+        for (n=0; n<16; n++) keys[f][n] = (uint8_t)rand();
+        EAXdrv_init(keys[f], &ctx[f]);
+    }
+    for (i=0; i<frames; i++) {
+        f   = (i / 8) & 3;
+        len = rand() % 256;
+        for (n=0; n<7; n++)   nonce[n] = (uint8_t)rand();
+        for (n=0; n<len; n++) plain[n] = (uint8_t)rand();
+        memcpy(refc, plain, len);
+        ref_eax(keys[f], nonce, 7, NULL, 0, refc, len, refc+len, 4);
+
+        runs = rf.aes_runs;
+        memcpy(buf, plain, len);
+        r = EAXdrv_encrypt(nonce, buf, (ot_uint)len, &ctx[f]);
+        CHECK((r == 0) && (memcmp(buf, refc, len+4) == 0), "%s: encrypt, %d bytes", name, len);
+        hw += (rf.aes_runs != runs);
+
+        r = EAXdrv_decrypt(nonce, buf, (ot_uint)(len+4), &ctx[f]);
+        CHECK((r == 0) && (memcmp(buf, plain, len) == 0), "%s: decrypt, %d bytes", name, len);
+
+        memcpy(buf, refc, len+4);
+        buf[rand() % (len+4)] ^= (uint8_t)(1 << (rand() & 7));
+        r = EAXdrv_decrypt(nonce, buf, (ot_uint)(len+4), &ctx[f]);
+        CHECK(r == 1, "%s: tampered frame accepted, %d bytes", name, len);
+    }
+    r = EAXdrv_decrypt(nonce, buf, 3, &ctx[0]);
+    CHECK(r < 0, "%s: short frame not rejected", name);
+    for (f=0; f<4; f++) {
+        EAXdrv_clear(&ctx[f]);
+    }
+    *hw_frames = hw;
+}
+
+
+static void test_frames(int frames) {
+    long hw, runs;
+
+    /// Slow bus (~1 MHz SPI, ~50 bytes a block): software should win
+    rf.ns_per_byte = 8000;
+    run_frames("slow bus", frames, &hw);
+    CHECK(hw < frames / 8, "slow bus: %ld of %d frames on the SPIRIT1", hw, frames);
+    printf("slow bus %ld of %d encrypts on the SPIRIT1\n", hw, frames);
+
+    /// Fast bus: the SPIRIT1 should win, except on probe messages, once the
+    /// probes have brought its figure down
+    rf.ns_per_byte = 0;
+    run_frames("fast bus", frames, &hw);
+    CHECK(hw > (frames * 3) / 4, "fast bus: only %ld of %d frames on the SPIRIT1", hw, frames);
+    printf("fast bus %ld of %d encrypts on the SPIRIT1\n", hw, frames);
+
+    /// Radio busy: never the SPIRIT1
+    rf.ns_per_byte = 0;
+    radio.state = RADIO_DataRX;
+    runs = rf.aes_runs;
+    run_frames("busy", frames/4, &hw);
+    CHECK(rf.aes_runs == runs, "busy: the SPIRIT1 was used while the radio was busy");
+    radio.state = RADIO_Idle;
+    printf("busy     %ld of %d encrypts on the SPIRIT1\n", hw, frames/4);
+
+    CHECK(rf.misuse == 0, "frames: %ld misuses of the model", rf.misuse);
+}
+
+
+static void test_keycache(void) {
+    EAXdrv_t    ctx[2];
+    uint8_t     key[2][16], nonce[7] = { 0 }, buf[40];
+    long        loads, runs;
+    int         i, n;
+
+    for (n=0; n<16; n++) {
+        key[0][n] = (uint8_t)n;
+        key[1][n] = (uint8_t)(n * 7);
+    }
+    EAXdrv_init(key[0], &ctx[0]);
+    EAXdrv_init(key[1], &ctx[1]);
+
+    /// Fast bus and no probes in the way: count SPIRIT1 runs and key loads
+    rf.ns_per_byte = 0;
+    loads = rf.key_loads;
+    runs  = rf.aes_runs;
+    for (i=0; i<40; i++) {
+        EAXdrv_encrypt(nonce, buf, 32, &ctx[0]);
+    }
+    CHECK(rf.aes_runs > runs, "keycache: the SPIRIT1 was not used");
+    CHECK(rf.key_loads - loads <= 3, "keycache: %ld key loads for one key", rf.key_loads - loads);
+
+    /// Alternating keys reload
+    loads = rf.key_loads;
+    for (i=0; i<40; i++) {
+        EAXdrv_encrypt(nonce, buf, 32, &ctx[i & 1]);
+    }
+    CHECK(rf.key_loads - loads >= 30, "keycache: %ld key loads for alternating keys", rf.key_loads - loads);
+
+    /// Rekeying the context in the radio, or resetting the radio, reloads
+    EAXdrv_encrypt(nonce, buf, 32, &ctx[0]);
+    EAXdrv_encrypt(nonce, buf, 32, &ctx[0]);
+    if (spirit1.aeskey == ctx[0].rk) {
+        EAXdrv_init(key[1], &ctx[0]);
+        CHECK(spirit1.aeskey == NULL, "keycache: rekey did not forget the radio key");
+        EAXdrv_init(key[0], &ctx[0]);
+        spirit1_reset();
+        CHECK(spirit1.aeskey == NULL, "keycache: reset did not forget the radio key");
+    }
+    else {
+        CHECK(0, "keycache: key not in the radio after two frames");
+    }
+
+    /// Clearing the context in the radio wipes the radio key
+    EAXdrv_encrypt(nonce, buf, 32, &ctx[0]);
+    EAXdrv_encrypt(nonce, buf, 32, &ctx[0]);
+    EAXdrv_clear(&ctx[0]);
+    CHECK(spirit1.aeskey == NULL, "keycache: clear did not forget the radio key");
+    for (n=0; n<16; n++) {
+        CHECK(rf.reg[RFREG(AES_KEY_IN15) + n] == 0, "keycache: clear did not wipe the radio key");
+    }
+    EAXdrv_clear(&ctx[1]);
+    CHECK(rf.misuse == 0, "keycache: %ld misuses of the model", rf.misuse);
+    printf("keycache %ld key loads in all\n", rf.key_loads);
+}
+
+
+static void test_wake(void) {
+    EAXdrv_t    ctx;
+    uint8_t     key[16] = { 1 }, nonce[7] = { 0 }, buf[40], ref[40];
+    long        wakes = rf.wakes;
+    int         i, hw = 0;
+
+    EAXdrv_init(key, &ctx);
+    rf.ns_per_byte  = 0;
+    rf.ns_per_wake  = 0;
+    for (i=0; i<32; i++) {
+        long runs = rf.aes_runs;
+        spirit1_strobe(RFSTROBE_STANDBY);
+        memset(buf, i, 32);
+        memcpy(ref, buf, 32);
+        ref_eax(key, nonce, 7, NULL, 0, ref, 32, ref+32, 4);
+        EAXdrv_encrypt(nonce, buf, 32, &ctx);
+        CHECK(memcmp(buf, ref, 36) == 0, "wake: encrypt");
+        CHECK(rf.xo == 0, "wake: SPIRIT1 left awake");
+        hw += (rf.aes_runs != runs);
+    }
+    CHECK((hw > 0) && (rf.wakes - wakes == hw), "wake: %d SPIRIT1 frames, %ld wakes", hw, rf.wakes - wakes);
+
+    /// A costly wake-up makes the software path the cheaper one
+    rf.ns_per_wake = 5000000;
+    for (i=0, hw=0; i<64; i++) {
+        long runs = rf.aes_runs;
+        spirit1_strobe(RFSTROBE_STANDBY);
+        EAXdrv_encrypt(nonce, buf, 32, &ctx);
+        hw += (rf.aes_runs != runs);
+    }
+    CHECK(hw <= 64/8, "wake: %d of 64 frames woke the SPIRIT1 for 5 ms", hw);
+    rf.ns_per_wake = 0;
+    spirit1_strobe(RFSTROBE_READY);
+    EAXdrv_clear(&ctx);
+    CHECK(rf.misuse == 0, "wake: %ld misuses of the model", rf.misuse);
+    printf("wake     %d of 64 frames on the SPIRIT1 with 5 ms wakes\n", hw);
+}
+
+
+int main(int argc, char** argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : 2048;
+
+    srand(1);
+    ref_init();
+    radio.state = RADIO_Idle;
+
+    test_engine();
+    test_frames(frames);
+    test_keycache();
+    test_wake();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return (failures != 0);
+}
@@ -0,0 +1,18 @@
+/* Host stand-in for a SPIRIT1 board header, for the SPIRIT1 AES testbed */
+#ifndef __BOARD_H
+#define __BOARD_H
+
+#include <otstd.h>
+
+#define __SPIRIT1__
+#define BOARD_FEATURE_RFXTAL    ENABLED
+#define BOARD_FEATURE_RFXTALOUT DISABLED
+#define BOARD_PARAM_RFHz        48000000
+#define BOARD_PARAM_HFHz        48000000
+#define RF_HDB_ATTEN            6
+
+#define RADIO_IRQ0_SRCLINE  0
+#define RADIO_IRQ1_SRCLINE  1
+#define RADIO_IRQ2_SRCLINE  2
+
+#endif
@@ -0,0 +1,11 @@
+/* Host stand-in, for the SPIRIT1 AES testbed */
+#ifndef __SHIM_M2_DLL_H
+#define __SHIM_M2_DLL_H
+#include <otstd.h>
+void dll_init(void);
+#include <platform/timers.h>
+typedef struct {
+    ot_u16  counter;
+} dll_struct;
+extern dll_struct dll;
+#endif
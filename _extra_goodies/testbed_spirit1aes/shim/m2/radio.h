@@ -0,0 +1,23 @@
+/* Host stand-in for m2/radio.h, for the SPIRIT1 AES testbed */
+#ifndef __M2_RADIO_H
+#define __M2_RADIO_H
+#include <otstd.h>
+
+typedef enum {
+    RADIO_Idle      = 0,
+    RADIO_Listening = 1,
+    RADIO_Csma      = 2,
+    RADIO_DataRX    = 5,
+    RADIO_DataTX    = 6
+} radio_state;
+
+typedef struct {
+    radio_state state;
+} radio_struct;
+
+extern radio_struct radio;
+
+#define M2_PARAM(VAL)           M2_PARAM_##VAL
+#define M2_PARAM_MAXFRAME       256
+#define M2_PARAM_MFPP           1
+#endif
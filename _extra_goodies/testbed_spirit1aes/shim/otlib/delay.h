@@ -0,0 +1,7 @@
+/* Host stand-in, for the SPIRIT1 AES testbed */
+#ifndef __SHIM_OTLIB_DELAY_H
+#define __SHIM_OTLIB_DELAY_H
+#include <otstd.h>
+void delay_us(ot_uint us);
+void delay_ms(ot_uint ms);
+#endif
@@ -0,0 +1,7 @@
+/* Host stand-in, for the SPIRIT1 AES testbed */
+#ifndef __SHIM_OTLIB_LOGGER_H
+#define __SHIM_OTLIB_LOGGER_H
+#include <otstd.h>
+#define MSG_raw     0
+ot_int logger_msg(ot_u8 type, ot_int label_len, ot_int data_len, ot_u8* label, ot_u8* data);
+#endif
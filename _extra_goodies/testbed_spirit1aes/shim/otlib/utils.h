@@ -0,0 +1,6 @@
+/* Host stand-in, for the SPIRIT1 AES testbed */
+#ifndef __SHIM_OTLIB_UTILS_H
+#define __SHIM_OTLIB_UTILS_H
+#include <otstd.h>
+ot_int otutils_bin2hex(ot_u8* dst, ot_u8* src, ot_int size);
+#endif
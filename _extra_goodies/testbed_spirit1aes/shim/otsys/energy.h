@@ -0,0 +1,10 @@
+/* Host stand-in, for the SPIRIT1 AES testbed */
+#ifndef __SHIM_OTSYS_ENERGY_H
+#define __SHIM_OTSYS_ENERGY_H
+#include <otstd.h>
+#define ENERGY_rf_off           0
+#define ENERGY_rf_idle          1
+#define ENERGY_rf_rx            2
+#define ENERGY_rf_tx            3
+#define ENERGY_RADIO(STATE)     do { } while(0)
+#endif
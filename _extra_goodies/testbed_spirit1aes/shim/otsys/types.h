@@ -0,0 +1,5 @@
+/* Host stand-in, for the SPIRIT1 AES testbed */
+#ifndef __SHIM_OTSYS_TYPES_H
+#define __SHIM_OTSYS_TYPES_H
+#include <otstd.h>
+#endif
@@ -0,0 +1,7 @@
+/* Host stand-in for platform/config.h: EAXdrv_t as platform_stdc.h gives it */
+#ifndef __PLATFORM_CONFIG_H
+#define __PLATFORM_CONFIG_H
+#include <otstd.h>
+#include <io/spirit1/eax.h>
+typedef spirit1_eaxctx EAXdrv_t;
+#endif
@@ -0,0 +1,5 @@
+#ifndef __PLATFORM_TIMERS_H
+#define __PLATFORM_TIMERS_H
+#include <otstd.h>
+ot_u32 systim_chronstamp(ot_u32* timestamp);
+#endif
@@ -107,6 +107,20 @@
 #ifndef OT_PARAM_KERNEL_LIMIT
 #   define OT_PARAM_KERNEL_LIMIT        -1                                  // Maximum ticks between kernel calls (if<=0, no limit)
 #endif
+#ifndef OT_PARAM_CRC16_SLICES
+#   define OT_PARAM_CRC16_SLICES        1                                   // SW CRC16 bytes per step: 1, 4 or 8 (costs 512 B RAM per extra slice)
+#endif
+#ifndef OT_PARAM_NLS_USERS
+#   define OT_PARAM_NLS_USERS           16                                  // Users in the NLS key store (gateways: thousands)
+#endif
+#ifndef OT_PARAM_NLS_HEAPSIZE
+#   define OT_PARAM_NLS_HEAPSIZE        (OT_PARAM_NLS_USERS*20)             // Bytes of NLS key data: 20 per AES128 key
+#endif
+// OT_PARAM_NLS_GFB_ID has no default: with NL_SECURITY, the app must give the
+// first GFB file that it reserves for the NLS users, or auth.c will not build.
+#ifndef OT_PARAM_NLS_GFB_FILES
+#   define OT_PARAM_NLS_GFB_FILES       1                                   // Number of GFB files that store the NLS users
+#endif
 
 
 
@@ -170,6 +184,12 @@
 #ifndef OT_FEATURE_NL_SECURITY
 #   define OT_FEATURE_NL_SECURITY       NOT_AVAILABLE                       // Network Layer Security & key exchange
 #endif
+#ifndef OT_FEATURE_CRYPTO_KEYCACHE
+#   define OT_FEATURE_CRYPTO_KEYCACHE   ENABLED                             // Keep keyed EAX contexts, no per-frame key expansion
+#endif
+#ifndef OT_FEATURE_CRYPTO_RFAES
+#   define OT_FEATURE_CRYPTO_RFAES      DISABLED                            // EAX driver may use the radio's AES engine (SPIRIT1)
+#endif
 #ifndef OT_FEATURE_SENSORS
 #   define OT_FEATURE_SENSORS           NOT_AVAILABLE                       // (formal, spec-based sensor config)
 #endif
@@ -188,6 +208,12 @@
 #ifndef OT_FEATURE_TIME
 #   define OT_FEATURE_TIME               DISABLED                            // Do you have a precise 32768 Hz clock?
 #endif
+#ifndef OT_FEATURE_CRON
+#   define OT_FEATURE_CRON              DISABLED                            // OTcron real-time scheduler (requires TIME)
+#endif
+#ifndef OT_FEATURE_ENERGY
+#   define OT_FEATURE_ENERGY            DISABLED                            // Energy accounting per task & radio state
+#endif
 #ifndef OT_FEATURE_RF_LINKINFO
 #   define OT_FEATURE_RF_LINKINFO       ENABLED
 #endif
@@ -232,6 +258,9 @@
 #ifndef LOG_FEATURE_RESPONSES
 #   define LOG_FEATURE_RESPONSES        ENABLED
 #endif
+#ifndef LOG_FEATURE_TIMESTAMP
+#   define LOG_FEATURE_TIMESTAMP        DISABLED                            // Prefix log payloads with monotonic sec & nsec (needs TIME)
+#endif
 
 /// These are RFU
 #define LOG_METHOD_DEFAULT              0                                   // Logging over NDEF+MPIPE, using OTAPI_logger.c
@@ -272,6 +301,12 @@
 #ifndef M2_FEATURE_FECRX
 #   define M2_FEATURE_FECRX             ENABLED                             // FEC support for receptions
 #endif
+#ifndef M2_FEATURE_RSCODE
+#   define M2_FEATURE_RSCODE            DISABLED                            // Reed-Solomon block coding of frames (LC 0x40)
+#endif
+#ifndef M2_FEATURE_HDRCACHE
+#   define M2_FEATURE_HDRCACHE          DISABLED                            // Cached M2NP header templates, one per addressing mode
+#endif
 #ifndef M2_FEATURE_AUTOSCALE
 #   define M2_FEATURE_AUTOSCALE         DISABLED                            // Adaptive TX power fall-off algorithm
 #endif
@@ -281,6 +316,15 @@
 #ifndef M2_PARAM_BEACON_TCA
 #   define M2_PARAM_BEACON_TCA          12                                  // Ticks to do CSMA for Beacons
 #endif
+#ifndef M2_PARAM_SCOREBANDS
+#   define M2_PARAM_SCOREBANDS          4                                   // Response slot bands for query scores (1 = no priority)
+#endif
+#ifndef M2_PARAM_CCASTATS
+#   define M2_PARAM_CCASTATS            8                                   // Channels tracked for CCA occupancy (0 = no tracking)
+#endif
+#ifndef M2_PARAM_CHANTABLE
+#   define M2_PARAM_CHANTABLE           7                                   // Channels compiled from the channel config ISF (7 fit in its 48 bytes)
+#endif
 #ifndef M2_PARAM_MI_CHANNELS
 #   define M2_PARAM_MI_CHANNELS         1                                   // Multi-input channel support, e.g. "MIMO" (1-8)
 #endif
@@ -296,13 +340,17 @@
 
 
 /// General derived constants
-#if (!defined(M2_PARAM_MFPP) && M2_FEATURE_M2DP)
-#   define M2_PARAM_MFPP                4                                   // Max Frames Per Packet (1-255, partly device-dependent)
-#else
+/// Multiframe packets (MFPP > 1) are opt-in: define M2_PARAM_MFPP in
+/// app_config.h.  On RX, network_route_ff() appends the payloads of the M2DP
+/// frames to the M2NP payload.  They are tested on the host only, in
+/// _extra_goodies/testbed_m2dp.
+#if (M2_FEATURE_M2DP != ENABLED)
 #   undef M2_PARAM_MFPP
 #   define M2_PARAM_MFPP                1                                   // MFPP always 1 when M2DP is DISABLED (don't change)
+#elif !defined(M2_PARAM_MFPP)
+#   define M2_PARAM_MFPP                1                                   // Max Frames Per Packet (1-255, partly device-dependent, >1 is opt-in)
 #endif
-#define M2_FEATURE_MULTIFRAME           (M2_PARAM_MFPP > 1)
+#define M2_FEATURE_MULTIFRAME           (M2_PARAM_MFPP > 1)                 // Opt-in, see above
 #define M2_FEATURE_RTC_SCHEDULER        (M2_FEATURE_RTCSLEEP || M2_FEATURE_RTCHOLD || M2_FEATURE_RTCSBEACON)
 #define M2_FEATURE_FEC                  (M2_FEATURE_FECTX || M2_FEATURE_FECTX)
 
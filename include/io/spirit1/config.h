@@ -94,6 +94,13 @@
 #define RF_PARAM_RCO_CAL_INTERVAL       32                      //SPIRIT1-Specific
 #define RF_PARAM_VCO_CAL_INTERVAL       32                      //SPIRIT1-Specific
 
+/// Supply current (uA) per radio state, for the Energy module.  Off is
+/// STANDBY, Idle is READY, TX is at +11 dBm.
+#define RF_PARAM_ENERGY_OFF             1
+#define RF_PARAM_ENERGY_IDLE            650
+#define RF_PARAM_ENERGY_RX              9200
+#define RF_PARAM_ENERGY_TX              21000
+
 
 /** Radio Buffer Allocation constants
   * SPIRIT1 has internal buffer
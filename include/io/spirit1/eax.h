@@ -0,0 +1,52 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /include/io/spirit1/eax.h
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      EAX driver context for the SPIRIT1 AES-128 engine
+  * @ingroup    SPIRIT1
+  *
+  * The platform config aliases EAXdrv_t to spirit1_eaxctx when
+  * OT_FEATURE_CRYPTO_RFAES is enabled.  The driver is io/spirit1/SPIRIT1_eax.c.
+  * It only includes basic types, so the platform config can include it.
+  *
+  ******************************************************************************
+  */
+
+#ifndef __IO_SPIRIT1_EAX_H
+#define __IO_SPIRIT1_EAX_H
+
+#include <otsys/types.h>
+
+
+/** @typedef spirit1_eaxctx
+  * Everything in the context depends only on the key, and EAXdrv_init() fills
+  * it.  The first round key of the schedule is the key itself, and it is what
+  * gets loaded into the SPIRIT1.
+  */
+typedef struct {
+    ot_u8   rk[176];        // AES-128 schedule, for the software path
+    ot_u8   l[16];          // L = E([0]), first OMAC^0 chain value
+    ot_u8   l2[16];         // OMAC subkey 2L, for a full last block
+    ot_u8   l4[16];         // OMAC subkey 4L, for a padded last block
+    ot_u8   e2[16];         // E([2]), first OMAC^2 chain value
+    ot_u8   h[16];          // OMAC^1 of the empty header
+} spirit1_eaxctx;
+
+
+#endif
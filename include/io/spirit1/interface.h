@@ -59,6 +59,7 @@
   * <LI>imode   (SPIRIT1_IMode) Enumeration used for IRQ state management </LI>
   * <LI>status  (ot_u8) Stores the 2-byte chip-status obtained on each SPI access </LI>
   * <LI>busrx   (ot_u8) scratch space for RX'ed SPI bus data </LI>
+  * <LI>aeskey  (const ot_u8*) key now in the AES engine, or NULL </LI>
   *
   * @note The maximum SPI transfer depends on the allocation of busrx.  A DMA
   *       is used with the SPI, so it needs to dump the RX data here.  24 bytes
@@ -86,6 +87,9 @@ typedef struct {
     SPIRIT1_IMode   imode;
     ot_u16          status;
     ot_u8           busrx[24];
+#   if (OT_FEATURE(CRYPTO_RFAES) == ENABLED)
+    const ot_u8*    aeskey;
+#   endif
 } spirit1_struct;
 
 extern spirit1_struct spirit1;
@@ -413,6 +417,50 @@ void spirit1_burstwrite(ot_u8 start_addr, ot_u8 length, ot_u8* cmd_data);
 
 
 
+/** AES-128 Engine <BR>
+  * ============================================================================
+  * Used by the EAX driver in io/spirit1/SPIRIT1_eax.c, when CRYPTO_RFAES is
+  * enabled.  The engine runs from the XO, so the SPIRIT1 must not be in SLEEP,
+  * STANDBY or SHUTDOWN.  Register IN<n> holds byte n of the key or block, so
+  * the bursts go in reverse byte order.
+  */
+
+/** @brief  Loads a key into the AES engine, turning the engine on if needed
+  * @param  key         (const ot_u8*) 16 byte key
+  * @retval none
+  * @ingroup SPIRIT1
+  *
+  * The key pointer is kept in spirit1.aeskey, so a driver can skip the load
+  * when the key is already there.  Reset and shutdown clear it.
+  */
+void spirit1_aes_loadkey(const ot_u8* key);
+
+
+
+/** @brief  Wipes the key from the AES engine and turns the engine off
+  * @param  None
+  * @retval none
+  * @ingroup SPIRIT1
+  */
+void spirit1_aes_off(void);
+
+
+
+/** @brief  Encrypts one block in place with the loaded key
+  * @param  block       (ot_u8*) 16 byte block
+  * @retval none
+  * @ingroup SPIRIT1
+  *
+  * Blocks until the engine is done, using spirit1_wfe_aes() and spirit1_wfe().
+  */
+void spirit1_aes_encrypt(ot_u8* block);
+
+
+
+
+
+
+
 /** Advanced Configuration <BR>
   * ========================================================================<BR>
   */
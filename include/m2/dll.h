@@ -385,6 +385,9 @@ void dll_init(void);
   * sys_refresh() does two things.  First, it grabs the registry data from the
   * Network Settings ISF (ISF 0) and applies it to the system object.  Then it
   * puts OpenTag in a default idle state with no pending or ongoing sessions.
+  *
+  * The files are only read again if they were written since the last refresh
+  * (see vl_generation()), and likewise for dll_refresh_rts().
   */
 void dll_refresh(void);
 
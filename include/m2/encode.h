@@ -57,22 +57,33 @@ typedef struct {
     // CRC Streaming object for M2 encoding module
     crcstream_t crc;
 
-    // PN9 register needed for SW PN9 
+    // PN9 keystream position needed for SW PN9
     // You should pick a radio that has this in HW, so this is mostly relegated
     // to Software Simulation.
 #   if ( (RF_FEATURE(PN9) != ENABLED) || \
          ((M2_FEATURE(FEC) == ENABLED) && (RF_FEATURE(FEC) != ENABLED)) )
-        ot_uni16 PN9_lfsr;
+        ot_u8   PN9_pos;
 #   endif
 
-    // FEC registers needed for SW FEC
-    // SW FEC is fairly slow and not recommended
+    // FEC encoder state (last 3 input bits), which must persist between
+    // calls to the encoder
+#   if ((M2_FEATURE(FECTX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
+        ot_u8 FEC_state;
+#   endif
+
+    // First frame of a multiframe packet being decoded.  rxq.front follows
+    // the frame that is being decoded, and it is returned here at the end.
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+        ot_u8*  pkt_front;
+#   endif
+
+    // FEC registers needed for SW FEC: Viterbi path metrics and survivor
+    // paths for each encoder state, and the decoded bits not yet output.
 #   if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
         ot_int  databytes;
         ot_int  path_bits;
-        ot_u8   last_buffer;
-        ot_u8   current_buffer;
-        ot_u8   cost_matrix[2][8];
+        ot_u8   FEC_cost[8];
+        ot_u32  FEC_path[8];
 #   endif
 
 } em2_struct;
@@ -185,6 +196,69 @@ ot_u16 em2_decode_endframe();
 ot_u8 em2_remaining_frames();
 
 
+
+/** @brief  Returns the bytes that the encoder appends to a frame
+  * @param  frame       (ot_u8*) start of the frame (its length byte)
+  * @retval ot_int      CRC16 bytes (unless done by the radio) plus RS parity
+  * @ingroup Encode
+  *
+  * Frames of a multiframe packet are queued back-to-back, and each one must
+  * leave this many bytes free after it.  The frame length byte must not yet
+  * include them.
+  */
+ot_int em2_frame_overhead(ot_u8* frame);
+
+
+
+#if (M2_FEATURE(MULTIFRAME) == ENABLED)
+/** @brief  Initializes the encoder for the next frame of a multiframe packet
+  * @param  None
+  * @retval None
+  * @ingroup Encode
+  *
+  * Call when em2_remaining_bytes() is 0 and em2_remaining_frames() is non-
+  * zero.  txq.getcursor is then at the start of the next frame, and the TX
+  * queue window (getcursor to putcursor) is moved onto this frame.
+  */
+void em2_encode_nextframe();
+
+
+/** @brief  Initializes the decoder for the next frame of a multiframe packet
+  * @param  None
+  * @retval None
+  * @ingroup Encode
+  *
+  * Call after em2_decode_endframe() on a frame that has more frames after it.
+  * The next frame is downloaded right after this one, and rxq.front is moved
+  * onto it until em2_decode_endpacket() is called.
+  */
+void em2_decode_nextframe();
+
+
+/** @brief  Returns rxq.front to the first frame of a multiframe packet
+  * @param  None
+  * @retval None
+  * @ingroup Encode
+  *
+  * em2_decode_endframe() calls this on the last frame.  The radio driver must
+  * also call it when it drops a packet part-way.  It does nothing otherwise.
+  */
+void em2_decode_endpacket();
+
+
+/** @brief  Returns the bytes that a received frame takes in rxq
+  * @param  frame       (ot_u8*) start of the frame (its length byte)
+  * @retval ot_int      bytes from the frame to the one after it
+  * @ingroup Encode
+  *
+  * Use on a frame that em2_decode_endframe() is done with.  The next frame of
+  * a multiframe packet is this many bytes after it, past the CRC16 and RS
+  * parity that are left in rxq.
+  */
+ot_int em2_decode_framebytes(ot_u8* frame);
+#endif
+
+
 /** @brief  Returns bytes remaining to encode or decode
   * @param none
   * @retval ot_int      value from em2.bytes
@@ -212,9 +286,33 @@ ot_bool em2_complete();
 
 #if (M2_FEATURE(RSCODE))
 
+/** RS code parameters
+  * The code is over GF(256) with field polynomial RS_GFPOLY and alpha = 2.
+  * The generator roots are alpha^0 ... alpha^(parity-1), and a frame never
+  * has more than RS_MAXPARITY parity bytes.
+  */
+#define RS_GFPOLY       0x11D
+#define RS_MAXPARITY    32
+
+ot_int em2_rs_paritylength(ot_int msg_length);
 ot_int em2_rs_init_decode(ot_queue* q);
 void em2_rs_decode(ot_int n_bytes);
 
+
+/** @brief  Runs received bytes into the RS syndromes
+  * @param  syndrome    (ot_u8*) RS_MAXPARITY syndromes, updated in place
+  * @param  parity      (ot_int) number of syndromes in use
+  * @param  data        (ot_u8*) received bytes, in order
+  * @param  length      (ot_int) number of bytes
+  * @retval None
+  * @ingroup Encode
+  *
+  * em2_rs_decode() calls this on each span it gets.  The weak default in
+  * /m2/encode.c uses the log tables.  Platforms with SIMD can override it,
+  * and they may update all RS_MAXPARITY syndromes, not just the ones in use.
+  */
+void em2_rs_syndrome(ot_u8* syndrome, ot_int parity, ot_u8* data, ot_int length);
+
 ot_int em2_rs_check(void);
 ot_int em2_rs_postprocess(void);
 ot_int em2_rs_init_encode(ot_queue* q);
@@ -236,6 +334,45 @@ void em2_encode_data_PN9();
 void em2_decode_data_PN9();
 void em2_encode_data_FEC();
 void em2_decode_data_FEC();
+
+
+
+#if ( (RF_FEATURE(PN9) != ENABLED) || \
+     ((M2_FEATURE(FEC) == ENABLED) && (RF_FEATURE(FEC) != ENABLED)) )
+/** @brief  Whitens or dewhitens a block of data with the PN9 keystream
+  * @param  dst         (ot_u8*) output data
+  * @param  src         (ot_u8*) input data, which may be the same as dst
+  * @param  length      (ot_int) number of bytes
+  * @retval None
+  * @ingroup Encode
+  *
+  * The keystream continues from the present frame position, and it advances
+  * by length.  The XOR is done a word at a time when dst, src and the frame
+  * position are aligned alike, which is the case when the frame starts on a
+  * word boundary.
+  */
+void em2_pn9_apply(ot_u8* dst, ot_u8* src, ot_int length);
+#endif
+
+
+
+#if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
+/** @brief  Runs the FEC Viterbi decoder over one de-interleaved byte
+  * @param  cost        (ot_u8*) path metrics for the 8 encoder states
+  * @param  path        (ot_u32*) survivor paths for the 8 encoder states
+  * @param  symbols     (ot_u8) 4 received symbols, first one in b7-6
+  * @retval ot_u8       encoder state with the lowest path metric
+  * @ingroup Encode
+  *
+  * Each symbol shifts one decoded bit into the survivor paths (into bit 0).
+  * The path metrics are normalized on return, so the lowest one is 0.
+  *
+  * em2_decode_data_FEC() calls this for each de-interleaved byte.  It is weak,
+  * so a platform with SIMD may supply its own.
+  */
+ot_u8 em2_fec_viterbi(ot_u8* cost, ot_u32* path, ot_u8 symbols);
+#endif
+
     
 #endif
 
@@ -273,6 +273,21 @@ void m2np_footer();
 
 
 
+/** @brief  Discards the M2NP header templates
+  * @retval None
+  * @ingroup Network
+  * @sa m2np_header()
+  *
+  * With M2_FEATURE_HDRCACHE, m2np_header() keeps the last header it built for
+  * each addressing mode, and it copies it when the next header has the same
+  * session parameters.  The source Device ID is not compared, so call this
+  * function after dll.netconf.vid or dll.netconf.uid change.  dll_refresh()
+  * does it when it reloads them.
+  */
+void m2np_flush(void);
+
+
+
 /** @brief  Appends to the TX ot_queue the Device ID of this Device
   * @param  use_vid     (ot_bool) Set to True to use 2 byte Virtual ID
   * @retval None
@@ -385,7 +400,7 @@ void m2advp_update(ot_u16 countdown);
   * <PRE>
   * M2DP Frame Format
   * 
-  * 0     1        4     4+a         4+a+n    
+  * 0     1        6      6+a          6+a+n
   * +-----+--------+------+------------+---------------+-----+
   * | Len | FF Hdr | DLLS | UL Payload | DLLS Padding  | CRC |
   * +-----+--------+------+------------+---------------+-----+
@@ -394,8 +409,10 @@ void m2advp_update(ot_u16 countdown);
   * The Upper Layer Payload and Padding may be encrypted.  Padding bytes take
   * random values, and the amount of padding is specified in DLLS field.
   *
-  * - FF Hdr Info Field must have En_Addr = 0 and Frame_Type = 2
-  * - a: length of DLLS header.  Typcially 1 byte in M2DP.
+  * - FF Hdr is Link Control, TX EIRP, Subnet, Frame Info, and Dialog ID.
+  * - Frame Info must have addressing bits = 0 (Stream).  Subnet and Dialog
+  *   ID are the same as in the M2NP frame.
+  * - a: length of DLLS header (Nonce), 0 or 6 bytes.
   * - n: length of Upper Layer Payload
   * </PRE>
   */
@@ -408,10 +425,13 @@ void m2advp_update(ot_u16 countdown);
   * OpenTag only supports usage of M2DP frames as subsequent frames in 
   * multiframe packets, where the first frame is always an M2NP frame.  This
   * function can be used to append such an M2DP frame to the packet currently
-  * in the transmit queue.
+  * in the transmit queue.  The frame before it must be finished already, with
+  * m2np_footer() or m2dp_footer().
   *
   * m2dp_append() does three things:
-  * <LI> only writes the header(s) of the M2DP frame, and it a
+  * <LI> Sets the FRCONT link control flag of the last frame in the packet </LI>
+  * <LI> Leaves room after that frame for its CRC and RS parity </LI>
+  * <LI> Writes the header of the new frame, and opens txq for its payload </LI>
   */
 void m2dp_append();
 
@@ -421,6 +441,9 @@ void m2dp_append();
   * @param  none
   * @retval none
   * @ingroup Network
+  *
+  * After the footer, txq is ready for TX: the window (getcursor to putcursor)
+  * is on the first frame, and txq.back is the end of the whole packet.
   */
 void m2dp_footer();
 
@@ -46,6 +46,7 @@
 #include <otsys/config.h>
 #include <otlib/queue.h>
 #include <otsys/veelite.h>
+#include <otsys/time.h>
 
 
 typedef enum {
@@ -86,6 +87,7 @@ typedef struct {
   * state       A high-level description of what is happening on the radio
   * last_rssi   Used to buffer the last-read RSSI value -- not always implemented
   * evtdone     A callback that is used when RX or TX is completed (i.e. done)
+  * rxstamp     Monotonic time of the sync word of the last received frame
   */
 typedef struct {
     radio_state         state;
@@ -93,6 +95,9 @@ typedef struct {
     ot_int              last_linkloss;
     ot_sig2             evtdone;
     radio_link_struct   link;
+#   if (OT_FEATURE(TIME) == ENABLED)
+    ot_timespec         rxstamp;
+#   endif
 } radio_struct;
 
 extern radio_struct radio;
@@ -279,15 +284,53 @@ ot_uint rm2_rxtimeout_floor(ot_u8 chan_id);
 
 
 
-/** @brief  Returns approximate duration of pending packet, in ticks.
+/** @brief  Rebuilds the airtime model for the active channel
+  * @param  None
+  * @retval None
+  * @ingroup Radio
+  * @sa rm2_airtime()
+  *
+  * The radio driver calls this from rm2_enter_channel().  The airtime
+  * functions also call it if they find that phymac[0].channel has changed.
+  */
+void rm2_airtime_refresh(void);
+
+
+
+/** @brief  Returns exact airtime of a frame on the active channel
+  * @param  frame_bytes (ot_uint) number of bytes in the frame, before FEC
+  * @retval ot_u32      Airtime in miti (units: 1/1024 ticks, 2^-20 seconds)
+  * @ingroup Radio
+  * @sa rm2_pkt_airtime(), rm2_pkt_duration()
+  *
+  * The airtime includes the pre-header (power ramp, preamble, sync word) and
+  * the FEC expansion with its terminator, if the channel uses FEC.  If the
+  * frame uses RS coding, include the RS parity bytes in frame_bytes.
+  * Applications may use it to budget response windows: MITI2CLK() converts
+  * it to kernel clocks without rounding to ticks first.
+  */
+ot_u32 rm2_airtime(ot_uint frame_bytes);
+
+
+
+/** @brief  Returns exact airtime of the pending packet
+  * @param  pkt_q       (ot_queue*) pointer to queue containing packet
+  * @retval ot_u32      Airtime in miti (units: 1/1024 ticks, 2^-20 seconds)
+  * @ingroup Radio
+  * @sa rm2_airtime()
+  */
+ot_u32 rm2_pkt_airtime(ot_queue* pkt_q);
+
+
+
+/** @brief  Returns duration of pending packet, in ticks.
   * @param  pkt_q       (ot_queue*) pointer to queue containing packet
   * @retval ot_uint     Duration of packet in ticks (units: 1/1024 seconds)
   * @ingroup Radio
-  * @sa rm2_scale_codec()
+  * @sa rm2_pkt_airtime()
   * @sa rm2_bgpkt_duration()
   *
-  * Basically identical to rm2_scale_codec(), except that some padding is added
-  * to the output in order to account for FIFO lag of the radio.
+  * This is rm2_pkt_airtime() rounded up to the next tick.
   */
 ot_uint rm2_pkt_duration(ot_queue* pkt_q);
 
@@ -383,6 +426,11 @@ ot_bool rm2_channel_fastcheck(ot_u8 chan_id);
   * Preferred usage is instead to call rm2_test_channel or rm2_chanscan, which
   * both call this function internally.
   *
+  * The channel configuration file is compiled into a RAM table indexed by
+  * spectrum ID, so the lookup is a single indexed access.  fp is only used if
+  * the table needs to be compiled (at startup or after the file is written,
+  * which is detected by its Veelite generation).
+  * fp may be NULL, in which case the file is opened if it is needed.
   */
 ot_bool rm2_channel_lookup(ot_u8 chan_id, vlFILE *fp);
 
@@ -394,6 +442,7 @@ ot_bool rm2_channel_lookup(ot_u8 chan_id, vlFILE *fp);
 
 
 
+
 /** General Purpose, High-Level Radio Module control    <BR>
   * ========================================================================<BR>
   * Used for module configuration and utility, not specifically related to
@@ -951,6 +1000,48 @@ void radio_getfourbytes(ot_u8* data);
 
 
 
+/** @brief Puts a burst of bytes to the TX radio buffer
+  * @param data         (ot_u8*) bytes to put on TX
+  * @param length       (ot_int) number of bytes
+  * @retval None
+  * @ingroup Radio
+  *
+  * The caller must make sure the bytes fit, via radio_txspan().  On radios
+  * with an SPI-attached FIFO, the bytes go in one bus transaction (or a few,
+  * if the bus driver limits the transaction size, as the SPIRIT1 one does),
+  * rather than one per byte.
+  */
+void radio_putbytes(ot_u8* data, ot_int length);
+
+/** @brief Gets a burst of bytes from the RX radio buffer
+  * @param data         (ot_u8*) pointer to an array to load into
+  * @param length       (ot_int) number of bytes
+  * @retval None
+  * @ingroup Radio
+  *
+  * The caller must not ask for more bytes than radio_rxspan() reports.
+  */
+void radio_getbytes(ot_u8* data, ot_int length);
+
+/** @brief Returns the number of bytes waiting in the RX buffer
+  * @param none
+  * @retval ot_int      Bytes that can be read with radio_getbytes()
+  * @ingroup Radio
+  */
+ot_int radio_rxspan();
+
+/** @brief Returns the number of bytes that can be put to the TX buffer
+  * @param none
+  * @retval ot_int      Bytes that can be put with radio_putbytes()
+  * @ingroup Radio
+  *
+  * The TX buffer is considered full at the TX limit of the driver, the same
+  * as with radio_txopen().
+  */
+ot_int radio_txspan();
+
+
+
 /** @brief Checks the RX buffer to see if there is at least 1 more byte in it
   * @param none
   * @retval ot_bool     True if at least 1 more byte in buffer
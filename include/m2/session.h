@@ -34,11 +34,10 @@
   * The session module implements a session stack.  The stack is sorted when a
   * new session is inserted.  The implementation of the stack itself is in the
   * session.c file, and it is completely abstracted in case you want to do 
-  * something more complex than the really basic stack implementation that is
-  * currently used.  The current implementation is good for systems where there
-  * are fewer that four simultaneous sessions permitted, which is actually more
-  * than a lot of devices will ever need -- for many devices, one session is all
-  * that will ever be used at any given time.
+  * something more complex.  The current implementation is an index-linked
+  * list, so all stack operations are constant-time, and the stack may be as
+  * deep as 254 sessions.  For many devices, one session is all that will ever
+  * be used at any given time, but gateways may run dozens.
   * 
   ******************************************************************************
   */
@@ -57,8 +56,8 @@
 
 #if (OT_PARAM_SESSION_DEPTH < 3)
 #   error "OT_PARAM_SESSION_DEPTH is less than 3."
-#elif (OT_PARAM_SESSION_DEPTH > 8)
-#   warning "OT_PARAM_SESSION_DEPTH is greater than 8.  This can slow things down."
+#elif (OT_PARAM_SESSION_DEPTH > 254)
+#   error "OT_PARAM_SESSION_DEPTH is greater than 254."
 #endif
 
 
@@ -246,9 +245,29 @@ typedef struct m2session {
   */
 typedef void (*ot_app)(m2session*);
 
+/** @typedef session_struct
+  * top         Session at the top of the stack.  If the stack is empty, it is
+  *             the dummy session at heap[OT_PARAM_SESSION_DEPTH].
+  * count       Number of sessions in the stack
+  * free        Index of first free session
+  * last        Index of the session at the bottom of the stack
+  * lasthead    Index of the first session of the bottom sequence
+  * link        Index of the next session (stack) or next free session.  The
+  *             top of the stack is link[OT_PARAM_SESSION_DEPTH], and the index
+  *             OT_PARAM_SESSION_DEPTH terminates the lists.
+  * seqend      Index of the last session of a joined session sequence, valid
+  *             for the first session of the sequence.
+  * heap        Session storage.  Sessions never move once they are stored.
+  */
 typedef struct {
     m2session*  top;
-    m2session   heap[OT_PARAM(SESSION_DEPTH)];
+    ot_u8       count;
+    ot_u8       free;
+    ot_u8       last;
+    ot_u8       lasthead;
+    ot_u8       link[OT_PARAM(SESSION_DEPTH)+1];
+    ot_u8       seqend[OT_PARAM(SESSION_DEPTH)];
+    m2session   heap[OT_PARAM(SESSION_DEPTH)+1];
 } session_struct;
 
 extern session_struct session;
@@ -414,6 +414,11 @@ ot_bool m2qp_sig_a2p(   ot_u8 code,     ot_u8 subcode,  id_tmpl* user_id    );
   * these types of comparisons, a threshold value is specified in the comparison
   * input data.  If the score is below threshold, it will be returned as 0.  If
   * it is equal or higher, the actual score will be returned.
+  *
+  * @note Correlation token length
+  * The correlation token may be up to 32 bytes long, which is as high as the
+  * 5 bit threshold goes.  A longer token is not searched, and the comparison
+  * returns -1.
   */
 ot_int m2qp_isf_comp(ot_u8 is_series, id_tmpl* user_id);
 
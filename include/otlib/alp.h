@@ -605,6 +605,18 @@ ot_bool alp_proc_logger(alp_tmpl* alp, id_tmpl* user_id);
 
 
 
+#if (OT_FEATURE(ENERGY) == ENABLED)
+/** @brief  Process a received Energy accounting ALP record
+  * @param  alp         (alp_tmpl*) ALP I/O control structure
+  * @param  user_id     (id_tmpl*) user id for performing the record
+  * @retval ot_bool     True if atomic, False if this ALP needs delayed processing
+  * @ingroup ALP
+  */
+ot_bool alp_proc_energy(alp_tmpl* alp, id_tmpl* user_id);
+#endif
+
+
+
 
 
 
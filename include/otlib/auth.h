@@ -45,6 +45,7 @@
 
 #define AUTH_FLAG_ISGLOBAL  0x80
 #define AUTH_FLAG_ISROOT    0x40
+#define AUTH_FLAG_ISUSER    0x00        // every NLS user is at least a user
 
 
 ///@todo bring this into OT_config.h eventually, when the feature gets supported
@@ -75,6 +76,14 @@ typedef struct {
     ot_u8*      keydata;
 } auth_handle;
 
+typedef struct {
+    ot_u8*      nonce;
+    ot_u8*      data;
+    ot_uint     datalen;
+    ot_u8       key_index;
+    ot_int      retval;     // written by auth_decrypt_batch()
+} auth_frame;
+
 
 
 
@@ -171,6 +180,23 @@ ot_int auth_encrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index,
 ot_int auth_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index, ot_u8 options);
 
 
+
+/** @brief Decrypts several datastreams, in-place, each with its own key
+  * @param frame        (auth_frame*) array of streams to decrypt
+  * @param count        (ot_int) number of streams in the array
+  * @param options      (ot_u8) Decryption options specific to type of Crypto
+  * @retval ot_int      number of streams that decrypted and authenticated
+  * @ingroup auth
+  * @sa auth_decrypt
+  *
+  * For gateways that collect secured frames from many endpoints.  Each
+  * frame->retval gets what auth_decrypt() would have returned for that
+  * stream, but the streams go to the crypto driver together, which is
+  * faster when the driver can interleave them.
+  */
+ot_int auth_decrypt_batch(auth_frame* frame, ot_int count, ot_u8 options);
+
+
 /** @brief Returns Decryption-Key DATA of a given key index, but no Auth/Sec metadata
   * @param index    (ot_u8) Key Index input
   * @retval void*   Pointer to Key Data.  Always is word-aligned.
@@ -301,30 +327,109 @@ ot_u8 auth_delete_key(ot_u16 key_index);
 
 
 
-/* @brief Adds a new key entry and associated key data to the Crypto_Heap.
-  * @param handle       (auth_handle*) Output handle for this new entry
+/** NLS User & Key Store <BR>
+  * ========================================================================<BR>
+  * Network Layer Security keys are stored per user (UID or VID).  The store
+  * holds OT_PARAM_NLS_USERS users and OT_PARAM_NLS_HEAPSIZE bytes of key
+  * data, and finds users through a hash on the ID, so a lookup costs the
+  * same with 10 users as with 10000.  The user flags (AUTH_FLAG_...) are the
+  * top bits of auth_info.protocol, and auth_info.lifetime is the expiry time
+  * in UTC seconds, or 0 if the key does not expire.
+  *
+  * The store is in RAM.  auth_save_nlsusers() writes it to the GFB files
+  * from OT_PARAM_NLS_GFB_ID, and auth_init() loads it back.  Those files are
+  * overwritten, so OT_PARAM_NLS_GFB_ID has no default: the app must set it
+  * to files that it reserves for this.
+  */
+
+/** @brief Adds a new user, with its key, to the NLS store
+  * @param handle       (auth_handle*) Output handle for this new entry, or NULL
   * @param new_user     (id_tmpl*) ID information for new user
   * @param new_info     (auth_info*) Auth/Sec parameters
-  * @param new_key      (ot_u8*) cryptographic key data
+  * @param new_key      (ot_u8*) cryptographic key data, new_info->length bytes
   * @retval ot_u8       Zero (0) on success, else an error code
   * @ingroup Authentication
   *
-  * If a new key is added, but there is no room left, the oldest key will be
-  * deleted to make room for this new key.
-
+  * If the user is already in the store, its entry is replaced.  If there is
+  * no room left, the users nearest to expiry are deleted to make room.  The
+  * handle points into the store, and handle->keydata is only good until the
+  * next call that adds users or calls crypto_clean().
+  */
 ot_u8 auth_new_nlsuser(auth_handle* handle, id_tmpl* new_user, auth_info* new_info, ot_u8* new_key);
-*/
 
 
-/* @brief Searches and returns a key based on UID or VID (if UID is NULL).
-  * @param handle       (auth_handle*) Output handle for this new entry
+/** @brief Searches for a user in the NLS store, by UID or VID
+  * @param handle       (auth_handle*) Output handle for the entry, or NULL
   * @param user_id      (id_tmpl*) Device ID of user to find auth/sec data
-  * @param mod_flags    (ot_u8) extra user flags
-  * @retval ot_u8       Zero (0) on success, else an error code
+  * @param mod_flags    (ot_u8) AUTH_FLAG_... that the user must have
+  * @retval ot_u8       Zero (0) on success, 1 if not found, 4 if the user
+  *                       does not have the flags
   * @ingroup Authentication
-
+  *
+  * When the system has OT_FEATURE_TIME, an expired user is deleted here and
+  * is not found.
+  */
 ot_u8 auth_search_user(auth_handle* handle, id_tmpl* user_id, ot_u8 mod_flags);
-*/
+
+
+/** @brief Deletes a user from the NLS store
+  * @param user_id      (id_tmpl*) Device ID of user to delete
+  * @retval ot_u8       Zero (0) on success, 1 if not found
+  * @ingroup Authentication
+  */
+ot_u8 auth_del_nlsuser(id_tmpl* user_id);
+
+
+/** @brief Saves the NLS store to its GFB files
+  * @param None
+  * @retval ot_int      Number of users saved
+  * @ingroup Authentication
+  *
+  * Users are saved until the OT_PARAM_NLS_GFB_FILES files are full, and files
+  * that are not needed are emptied.  This writes a lot of data, so call it
+  * when there is a reason to, e.g. before shutdown or after new keys.
+  */
+ot_int auth_save_nlsusers();
+
+
+/** @brief Loads the NLS store from its GFB files
+  * @param None
+  * @retval ot_int      Number of users loaded
+  * @ingroup Authentication
+  *
+  * Users are added to the ones already in the store.  auth_init() calls it.
+  */
+ot_int auth_load_nlsusers();
+
+
+/** @brief Rebuilds the expiry order of the NLS store
+  * @param None
+  * @retval None
+  * @ingroup Authentication
+  *
+  * The order is kept as users are added and deleted.  Call this only after
+  * changing auth_info.lifetime of users through their handles.
+  */
+void crypto_sort();
+
+
+/** @brief Deletes the NLS users that have expired (needs OT_FEATURE_TIME)
+  * @param None
+  * @retval None
+  * @ingroup Authentication
+  */
+void crypto_cull();
+
+
+/** @brief Compacts the key data of the NLS store
+  * @param None
+  * @retval None
+  * @ingroup Authentication
+  *
+  * Deleted keys leave holes in the key heap.  auth_new_nlsuser() calls this
+  * when the heap is full, so it is not normally needed.
+  */
+void crypto_clean();
 
 #endif
 
@@ -121,6 +121,28 @@ void crc_calc_nstream(crcstream_t* stream, ot_u16 n);
 
 
 
+/** @brief Copies stream bytes XOR'ed with a key, with the CRC in the same pass
+  * @param stream       (crcstream_t*) allocated crcstream "object"
+  * @param dst          (ot_u8*) destination of n bytes, may be the stream cursor
+  * @param key          (const ot_u8*) n bytes of key stream (e.g. PN9)
+  * @param n            (ot_u16) number of stream bytes
+  * @param crc_dst      (ot_bool) CRC the output (True) or the stream (False)
+  * @retval None
+  * @ingroup CRC16
+  * @sa crc_calc_nstream()
+  *
+  * This is for codecs that whiten (crc_dst = False) or dewhiten in place
+  * (crc_dst = True) a whole span at once.  Unlike crc_calc_nstream(), the
+  * cursor always moves by n: bytes past the end of the CRC are copied without
+  * it.  When writeout is set, the CRC is put into the stream ahead of them,
+  * so it is copied too.
+  */
+void crc_calc_nstream_xor(crcstream_t* stream, ot_u8* dst, const ot_u8* key,
+                          ot_u16 n, ot_bool crc_dst);
+
+
+
+
 /** @brief Checks the CRC in the stream against the known, good value.
   * @param stream       (crcstream_t*) allocated crcstream "object"
   * @retval ot_bool     TRUE if CRC passes check.
@@ -155,6 +177,38 @@ ot_u16 crc16drv_init();
 ot_u16 crc16drv_block(ot_u8* block_addr, ot_int block_size);
 ot_u16 crc16drv_block_manual(ot_u8* block_addr, ot_int block_size, ot_u16 init);
 
+
+/** @brief Copies a block XOR'ed with a key, and runs the CRC16 in the same pass
+  * @param dst          (ot_u8*) output block, may be the same as src
+  * @param src          (ot_u8*) input block
+  * @param key          (const ot_u8*) key block
+  * @param size         (ot_int) bytes in each block
+  * @param init         (ot_u16) running CRC value
+  * @param crc_dst      (ot_bool) CRC over dst (True) or over src (False)
+  * @retval ot_u16      Updated CRC value
+  * @ingroup CRC16
+  *
+  * The software driver does it in one pass.  With a CRC peripheral, the weak
+  * default in /otlib/crc16.c does the copy and the CRC separately.
+  */
+ot_u16 crc16drv_block_xor(ot_u8* dst, ot_u8* src, const ot_u8* key,
+                          ot_int size, ot_u16 init, ot_bool crc_dst);
+
+
+/** @brief Platform hook for a wide CRC16 engine, used on long blocks
+  * @param block_addr   (ot_u8*) start of the block
+  * @param block_size   (ot_int) bytes in the block
+  * @param crc          (ot_u16*) running CRC value, updated in place
+  * @retval ot_int      Number of bytes taken from the front of the block
+  * @ingroup CRC16
+  *
+  * The software driver offers each long block to crc16drv_fold() before it
+  * does the rest with tables.  The weak default in /otlib/crc16.c takes no
+  * bytes.  Platforms with a carry-less multiply instruction can override it
+  * and fold most of the block at once.
+  */
+ot_int crc16drv_fold(ot_u8* block_addr, ot_int block_size, ot_u16* crc);
+
 // Obsolete
 //void crc16drv_byte(ot_u8 databyte);
 //ot_u16 crc16drv_result();
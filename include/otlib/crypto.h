@@ -111,6 +111,11 @@ ot_int EAX_decrypt(ot_u8* dst, ot_u8* src, ot_uint srclen, ot_u8* nonce, ot_u8*
 /** EAX Driver prototypes <BR>
   * ========================================================================<BR>
   * The driver/platform code must implement these functions.
+  *
+  * EAXdrv_init() does the key expansion and the OMAC subkey setup, and the
+  * context it fills is kept across messages (see OT_FEATURE_CRYPTO_KEYCACHE).
+  * EAXdrv_encrypt() and EAXdrv_decrypt() must therefore set up their own
+  * per-message state and leave the keyed part of the context untouched.
   */
 
 ot_int EAXdrv_init(ot_u8* key, EAXdrv_t* context);
@@ -119,6 +124,34 @@ ot_int EAXdrv_encrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, EAXdrv_t* cont
 ot_int EAXdrv_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, EAXdrv_t* context);
 
 
+
+/** @brief One frame for EAXdrv_decrypt_batch()
+  * nonce, data, datalen and context are the same as for EAXdrv_decrypt().
+  * retval is written by the driver, and it is what EAXdrv_decrypt() would
+  * have returned for this frame (0 when the frame is authentic).
+  */
+typedef struct {
+    ot_u8*      nonce;
+    ot_u8*      data;
+    ot_uint     datalen;
+    EAXdrv_t*   context;
+    ot_int      retval;
+} EAXdrv_frame;
+
+
+/** @brief Decrypts and authenticates several independent frames
+  * @param frame        (EAXdrv_frame*) array of frames
+  * @param count        (ot_int) number of frames in the array
+  * @retval ot_int      number of frames that are authentic
+  * @ingroup EAX Driver
+  *
+  * The frames may use different contexts.  A driver can interleave the
+  * frames to keep its AES pipeline busy, which is what the stdc driver does.
+  * The default (weak) implementation calls EAXdrv_decrypt() for each frame.
+  */
+ot_int EAXdrv_decrypt_batch(EAXdrv_frame* frame, ot_int count);
+
+
 #endif
 
 
@@ -0,0 +1,288 @@
+/*  Copyright 2010-2014, JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /include/otsys/energy.h
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Energy Accounting Model
+  * @defgroup   Energy
+  * @ingroup    System-Kernel
+  *
+  * The Energy module keeps track of how long the device spends in each power
+  * state, and it converts these times into an estimate of consumed charge.
+  * It is enabled by OT_FEATURE_ENERGY.
+  *
+  * There are two independent power domains: the CPU and the radio.
+  * <LI> CPU: one state per sys_powerdown() code (MCU_SLEEP, MCU_SLEEP_WHILE_IO,
+  *      MCU_SLEEP_WHILE_RF, MCU_STOP), one state for the kernel itself
+  *      (scheduler and ISRs), and one state per kernel task. </LI>
+  * <LI> Radio: off (standby/sleep/shutdown), idle (ready), RX, and TX.  These
+  *      states are reported by the radio driver. </LI>
+  *
+  * Times are measured with the kernel timer (systim), so no extra hardware is
+  * needed.  Charge is estimated from a current table.  The MCU currents come
+  * from the platform (MCU_PARAM_ENERGY_...) and the radio currents come from
+  * the radio driver config (RF_PARAM_ENERGY_...).  Any of these may be
+  * overridden in the board or app config to match a measured device.
+  *
+  * Records and polling:
+  * <LI> Each record keeps whole seconds and the kernel clocks below a second.
+  *      It does not wrap for 136 years, so a node can be polled rarely, or
+  *      never, over its life. </LI>
+  * <LI> Charge is worked out from the records and the current table when it
+  *      is read.  It is reported in mC, with the uC below that as an option.
+  *      A single state wraps at 2^32 mC (4.3 MC): about 6.8 years of
+  *      continuous TX at 20 mA. </LI>
+  * <LI> energy_reset() clears all records.  The ALP energy processor does it
+  *      only for root users, so a client that shares the node with others
+  *      should not reset, and it should take differences between polls
+  *      instead. </LI>
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __OTSYS_ENERGY_H
+#define __OTSYS_ENERGY_H
+
+#include <otstd.h>
+#include <otsys/syskern.h>
+
+
+/** Current table defaults (uA)
+  * These are only used if the platform or radio do not supply values.
+  */
+#ifndef MCU_PARAM_ENERGY_RUN
+#   define MCU_PARAM_ENERGY_RUN         3000    // CPU active
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP
+#   define MCU_PARAM_ENERGY_SLEEP       1000    // powerdown code 0: MCU_SLEEP
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP_IO
+#   define MCU_PARAM_ENERGY_SLEEP_IO    1000    // powerdown code 1: MCU_SLEEP_WHILE_IO
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP_RF
+#   define MCU_PARAM_ENERGY_SLEEP_RF    1000    // powerdown code 2: MCU_SLEEP_WHILE_RF
+#endif
+#ifndef MCU_PARAM_ENERGY_STOP
+#   define MCU_PARAM_ENERGY_STOP        2       // powerdown code 3: MCU_STOP
+#endif
+#ifndef RF_PARAM_ENERGY_OFF
+#   define RF_PARAM_ENERGY_OFF          1
+#endif
+#ifndef RF_PARAM_ENERGY_IDLE
+#   define RF_PARAM_ENERGY_IDLE         500
+#endif
+#ifndef RF_PARAM_ENERGY_RX
+#   define RF_PARAM_ENERGY_RX           10000
+#endif
+#ifndef RF_PARAM_ENERGY_TX
+#   define RF_PARAM_ENERGY_TX           20000
+#endif
+
+
+/** Battery capacity (mAh) used for lifetime projection when none is given.
+  * The default is a CR2032 coin cell.
+  */
+#ifndef OT_PARAM_ENERGY_CAPACITY
+#   define OT_PARAM_ENERGY_CAPACITY     220
+#endif
+
+
+/** CPU states
+  * ENERGY_cpu_sleep + code is the state for sys_powerdown() code 0-3.
+  * ENERGY_cpu_task + index is the state for kernel task "index."
+  */
+#define ENERGY_cpu_sleep        0
+#define ENERGY_cpu_kernel       4
+#define ENERGY_cpu_task         5
+#define ENERGY_CPU_STATES       (ENERGY_cpu_task + TASK_terminus)
+
+
+/** Radio states
+  */
+#define ENERGY_rf_off           0
+#define ENERGY_rf_idle          1
+#define ENERGY_rf_rx            2
+#define ENERGY_rf_tx            3
+#define ENERGY_RF_STATES        4
+
+
+/** Hook macros
+  * Kernel and driver code uses these, so the hooks compile to nothing when the
+  * feature is disabled.
+  */
+#if (OT_FEATURE(ENERGY) == ENABLED)
+#   define ENERGY_CPU(STATE)        energy_cpu(STATE)
+#   define ENERGY_RADIO(STATE)      energy_radio(STATE)
+#   define ENERGY_FLUSH(ELAPSED)    energy_flush(ELAPSED)
+#else
+#   define ENERGY_CPU(STATE)        do { } while(0)
+#   define ENERGY_RADIO(STATE)      do { } while(0)
+#   define ENERGY_FLUSH(ELAPSED)    do { } while(0)
+#endif
+
+
+
+#if (OT_FEATURE(ENERGY) == ENABLED)
+
+/** @brief  Initialize the Energy module and clear all records
+  * @param  None
+  * @retval None
+  * @ingroup Energy
+  *
+  * Called by sys_init().
+  */
+void energy_init(void);
+
+
+
+/** @brief  Clear all records, without changing the present states
+  * @param  None
+  * @retval None
+  * @ingroup Energy
+  */
+void energy_reset(void);
+
+
+
+/** @brief  Change the CPU state
+  * @param  state       (ot_u8) new CPU state (ENERGY_cpu_...)
+  * @retval None
+  * @ingroup Energy
+  *
+  * The time since the last change is charged to the previous state.  The
+  * kernel calls this when it enters or leaves sys_powerdown() and when it
+  * starts or finishes a task.
+  */
+void energy_cpu(ot_u8 state);
+
+
+
+/** @brief  Change the radio state
+  * @param  state       (ot_u8) new radio state (ENERGY_rf_...)
+  * @retval None
+  * @ingroup Energy
+  *
+  * The radio driver calls this whenever the transceiver changes its power
+  * state.  It may be called from ISRs.
+  */
+void energy_radio(ot_u8 state);
+
+
+
+/** @brief  Synchronize the Energy module to the kernel timer
+  * @param  elapsed     (ot_uint) value of systim_get() before systim_flush()
+  * @retval None
+  * @ingroup Energy
+  *
+  * The kernel event manager must call this right before it flushes the kernel
+  * timer.  The CPU state returns to ENERGY_cpu_kernel.
+  */
+void energy_flush(ot_uint elapsed);
+
+
+
+/** @brief  Time spent in a CPU state
+  * @param  state       (ot_u8) CPU state (ENERGY_cpu_...)
+  * @param  ticks       (ot_u16*) if not NULL, gets the ticks (1/1024 s) above
+  *                     the whole seconds
+  * @retval ot_u32      time in seconds
+  * @ingroup Energy
+  */
+ot_u32 energy_cpu_time(ot_u8 state, ot_u16* ticks);
+
+
+
+/** @brief  Time spent in a radio state
+  * @param  state       (ot_u8) radio state (ENERGY_rf_...)
+  * @param  ticks       (ot_u16*) if not NULL, gets the ticks (1/1024 s) above
+  *                     the whole seconds
+  * @retval ot_u32      time in seconds
+  * @ingroup Energy
+  */
+ot_u32 energy_rf_time(ot_u8 state, ot_u16* ticks);
+
+
+
+/** @brief  Estimated charge consumed in a CPU state
+  * @param  state       (ot_u8) CPU state (ENERGY_cpu_...)
+  * @param  uC          (ot_u16*) if not NULL, gets the uC (0-999) above the
+  *                     whole mC
+  * @retval ot_u32      charge in mC (mA*s)
+  * @ingroup Energy
+  */
+ot_u32 energy_cpu_charge(ot_u8 state, ot_u16* uC);
+
+
+
+/** @brief  Estimated charge consumed in a radio state
+  * @param  state       (ot_u8) radio state (ENERGY_rf_...)
+  * @param  uC          (ot_u16*) if not NULL, gets the uC (0-999) above the
+  *                     whole mC
+  * @retval ot_u32      charge in mC (mA*s)
+  * @ingroup Energy
+  */
+ot_u32 energy_rf_charge(ot_u8 state, ot_u16* uC);
+
+
+
+/** @brief  Total accounted time since init or reset
+  * @param  ticks       (ot_u16*) if not NULL, gets the ticks (1/1024 s) above
+  *                     the whole seconds
+  * @retval ot_u32      time in seconds
+  * @ingroup Energy
+  */
+ot_u32 energy_uptime(ot_u16* ticks);
+
+
+
+/** @brief  Total estimated charge since init or reset
+  * @param  uC          (ot_u16*) if not NULL, gets the uC (0-999) above the
+  *                     whole mC
+  * @retval ot_u32      charge in mC (mA*s)
+  * @ingroup Energy
+  */
+ot_u32 energy_charge(ot_u16* uC);
+
+
+
+/** @brief  Average current since init or reset
+  * @param  None
+  * @retval ot_u32      current in uA
+  * @ingroup Energy
+  *
+  * It is exact to 1 uA for up to 13 years of uptime.
+  */
+ot_u32 energy_avgcurrent(void);
+
+
+
+/** @brief  Projected battery life at the average current
+  * @param  capacity_mAh    (ot_u32) battery capacity, in mAh
+  * @retval ot_u32          projected battery life in hours
+  * @ingroup Energy
+  *
+  * This is the number that is useful for comparing beacon and scan
+  * configurations.  It does not model battery self-discharge or derating.
+  */
+ot_u32 energy_lifetime(ot_u32 capacity_mAh);
+
+
+#endif
+
+#endif
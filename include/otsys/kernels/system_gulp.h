@@ -119,5 +119,52 @@ typedef void (*systask_fn)(ot_task);
 
 
 
+/** Big GULP Co-operative Yielding   <BR>
+  * ========================================================================<BR>
+  * Long-running tasks (crypto, defragmentation, FFT, etc) can be written as
+  * stackless coroutines.  The task body is wrapped in SYS_THREAD_BEGIN() and
+  * SYS_THREAD_END(), and SYS_THREAD_YIELD() is placed at each pre-emption
+  * point.  The resume point is stored in task->cursor, so a task that uses
+  * these macros must not use the cursor field for anything else.  Call to
+  * sys_synchronize() will restart the coroutine from the top.
+  *
+  * At a pre-emption point, the task yields if its time-slice (task->reserve)
+  * is spent, if a higher priority task is pending, or if the platform has
+  * called sys_task_manager().  The yielding task is rescheduled immediately,
+  * so it resumes as soon as the higher priority work is done.  Worst-case
+  * scheduling latency for RF and MPipe tasks is therefore bounded by the
+  * longest runtime between two pre-emption points.
+  *
+  * Like any stackless coroutine, local (auto) variables are not preserved
+  * across a yield.  Keep persistent state in static or task-owned storage.
+  * POINT must be a unique, non-zero constant within the task (1-255).
+  */
+#define SYS_THREAD_BEGIN(TASK)          switch ((TASK)->cursor) { case 0:
+
+#define SYS_THREAD_YIELD(TASK, POINT)   do {                                \
+                                            (TASK)->cursor = (POINT);       \
+                                            if (sys_task_yield(TASK))       \
+                                                return;                     \
+                                            case (POINT):;                  \
+                                        } while (0)
+
+#define SYS_THREAD_END(TASK)            } (TASK)->cursor = 0
+
+
+
+/** @brief  Pre-emption point check for long-running (Big GULP) tasks
+  * @param  task        (ot_task) The active task, which is calling
+  * @retval ot_bool     True if the task must return to the scheduler now
+  * @ingroup System-Kernel
+  * @sa SYS_THREAD_YIELD()
+  *
+  * Normally this is used via SYS_THREAD_YIELD(), but it can also be called
+  * directly by tasks that manage their own state.  When it returns True, the
+  * task has been rescheduled for immediate re-entry and it should return.
+  */
+ot_bool sys_task_yield(ot_task task);
+
+
+
 #endif
 
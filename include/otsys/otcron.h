@@ -0,0 +1,137 @@
+/*  Copyright 2010-2014, JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /include/otsys/otcron.h
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      OTcron Real-Time Scheduler
+  * @defgroup   OTcron
+  * @ingroup    System-Kernel
+  *
+  * OTcron synchronizes kernel tasks to RTC time (UTC seconds, from the Time
+  * module).  It is a kernel task of its own (TASK_otcron), and it requires
+  * OT_FEATURE_TIME.
+  *
+  * Events are kept in a calendar queue: a ring of buckets, each covering
+  * 2^OT_PARAM_CRON_SHIFT seconds, with a sorted list of events per bucket.
+  * Adding, deleting, and finding the earliest event are amortized O(1) when
+  * the events are spread over time.  Only the earliest event is programmed
+  * into the RTC alarm (platform_set_rtc_alarm()), so each event costs one
+  * wakeup, no matter how many events are scheduled.
+  *
+  * Event times are matched against UTC seconds using a mask and a value.  The
+  * event happens when (UTC & mask) == (value & mask).  Bits that are 0 in the
+  * mask are "don't care," so a mask of 0x0000FFFF makes an event that recurs
+  * every 65536 seconds, and a mask of 0xFFFFFFFF makes a one-shot event.  This
+  * is the same convention used by the Real Time Scheduler ISF.
+  *
+  ******************************************************************************
+  */
+
+
+#ifndef __OTSYS_OTCRON_H
+#define __OTSYS_OTCRON_H
+
+#include <otstd.h>
+#include <otsys/syskern.h>
+
+#if (OT_FEATURE(CRON) == ENABLED)
+
+#ifndef OT_PARAM_CRON_EVENTS
+#   define OT_PARAM_CRON_EVENTS     8       // Max number of scheduled events
+#endif
+#ifndef OT_PARAM_CRON_BUCKETS
+#   define OT_PARAM_CRON_BUCKETS    8       // Calendar buckets (power of 2)
+#endif
+#ifndef OT_PARAM_CRON_SHIFT
+#   define OT_PARAM_CRON_SHIFT      6       // Bucket width = 2^SHIFT seconds
+#endif
+
+
+/** @typedef CRONTIME_Type
+  * CRONTIME_absolute:  time & mask are matched against UTC seconds
+  * CRONTIME_relative:  one-shot event, time is seconds from now (mask ignored)
+  */
+typedef enum {
+    CRONTIME_absolute = 0,
+    CRONTIME_relative = 1
+} CRONTIME_Type;
+
+
+
+
+/** @brief  Initialize OTcron, clearing all events
+  * @param  None
+  * @retval None
+  * @ingroup OTcron
+  *
+  * Called by sys_init().  It may also be used to flush all OTcron events.
+  */
+void otcron_init(void);
+
+
+
+/** @brief  Add an event to OTcron
+  * @param  task        (ot_task) kernel task to synchronize on the event
+  * @param  type        (CRONTIME_Type) how to interpret time & mask
+  * @param  time        (ot_u32) event time value, in seconds
+  * @param  mask        (ot_u32) event time mask (CRONTIME_absolute only)
+  * @retval ot_int      Event handle (>=0), or -1 if the event could not be added
+  * @ingroup OTcron
+  *
+  * When the event happens, the task will be synchronized, which is the same
+  * thing that sys_synchronize() does: task->cursor is set to 0 and the task is
+  * pre-empted to run immediately.
+  */
+ot_int otcron_add(ot_task task, CRONTIME_Type type, ot_u32 time, ot_u32 mask);
+
+
+
+/** @brief  Delete an event from OTcron
+  * @param  handle      (ot_int) event handle returned by otcron_add()
+  * @retval None
+  * @ingroup OTcron
+  */
+void otcron_del(ot_int handle);
+
+
+
+/** @brief  Delete all OTcron events that synchronize a given task
+  * @param  task        (ot_task) kernel task
+  * @retval None
+  * @ingroup OTcron
+  */
+void otcron_deltask(ot_task task);
+
+
+
+/** @brief  OTcron kernel task
+  * @param  task        (ot_task) Task marker for OTcron (TASK_otcron)
+  * @retval None
+  * @ingroup OTcron
+  *
+  * Runs each time the RTC alarm fires.  It synchronizes the tasks of all due
+  * events, reschedules recurring events, and programs the alarm again for the
+  * new earliest event.  Platforms without RTC alarms (RTC_ALARMS == 0) use the
+  * task's own kernel timeout instead of the alarm.
+  */
+void otcron_systask(ot_task task);
+
+
+#endif
+
+#endif
@@ -86,6 +86,9 @@
 #   define TI2CLK(TICKS)    (TICKS)
 #endif
 
+/// miti (1/1024 tick) to clocks, rounded up
+#define MITI2CLK(MITI)      (CLK_UNIT)(((ot_u32)(MITI) + ((1<<(10-OT_GPTIM_SHIFT))-1)) >> (10-OT_GPTIM_SHIFT))
+
 
 typedef enum {
     TASK_idle = -1,
@@ -107,9 +110,9 @@ typedef enum {
 #if (1)
     TASK_sleep,
 #endif
-//#if(OT_FEATURE(CRON))
-//    TASK_otcron,
-//#endif
+#if (OT_FEATURE(CRON))
+    TASK_otcron,
+#endif
 ///@todo: rearrange user tasks with external, or simply remove external.
 #if (OT_PARAM(KERNELTASKS) > 0)
     OT_PARAM_KERNELTASK_IDS,
@@ -469,8 +472,15 @@ void sys_task_setnext_clocks(ot_task task, ot_long nextevent_clocks);
 void sys_synchronize(Task_Index task_id);
 
 
-/**
-  * @todo this is replaced by OTcron
+/** @brief  Reloads the real-time schedules of the kernel tasks
+  * @param  none
+  * @retval none
+  * @ingroup System
+  * @sa dll_refresh_rts()
+  *
+  * The schedules in the Real Time Scheduler ISF are run by OTcron, so this is
+  * a wrapper to dll_refresh_rts().  It does nothing unless OTcron and
+  * M2_FEATURE_RTC_SCHEDULER are enabled.
   */
 void sys_refresh_scheduler();
 
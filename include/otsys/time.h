@@ -21,7 +21,19 @@
   * @brief      System Time Interface
   * @defgroup   Time
   * @ingroup    Time
-  *  
+  *
+  * Time is kept in ticks (1/1024 s).  The kernel timer supplies the ticks
+  * elapsed since the scheduler last ran, and the kernel adds them to the time
+  * base via time_add_ti().  There are two clocks:
+  * <LI> Realtime: UTC, which can be set and may jump. </LI>
+  * <LI> Monotonic: time since boot, which never jumps.  Use it to measure
+  *      intervals and latencies. </LI>
+  *
+  * Both clocks can be read as an ot_timespec with nanosecond fields.  The
+  * resolution below one tick depends on the platform: systim_get_subtick()
+  * supplies it, and platforms without a finer clock resolve to one tick.
+  * The POSIX platform uses clock_gettime(), so it is accurate to the host.
+  *
   ******************************************************************************
   */
 
@@ -37,6 +49,11 @@ typedef struct {
     ot_u32 ticks;
 } ot_time;
 
+typedef struct {
+    ot_u32 sec;
+    ot_u32 nsec;
+} ot_timespec;
+
 void time_init_utc(ot_u32 utc);
 
 void time_set_utc(ot_u32 utc);
@@ -50,4 +67,49 @@ ot_u32 time_uptime(void);
 ot_u32 time_uptime_ti(void);
 
 
+
+/** @brief  Set the realtime clock with sub-tick precision
+  * @param  ts          (ot_timespec*) UTC time to set
+  * @retval None
+  * @ingroup Time
+  *
+  * Same as time_set_utc(), but the fractional second is kept as well.  The
+  * monotonic clock is not affected.
+  */
+void time_set_realtime(ot_timespec* ts);
+
+
+
+/** @brief  Read the realtime clock (UTC)
+  * @param  ts          (ot_timespec*) loaded with the present UTC time
+  * @retval None
+  * @ingroup Time
+  */
+void time_get_realtime(ot_timespec* ts);
+
+
+
+/** @brief  Read the monotonic clock (time since boot)
+  * @param  ts          (ot_timespec*) loaded with the present monotonic time
+  * @retval None
+  * @ingroup Time
+  *
+  * Use this for timestamps that are compared against each other, such as the
+  * timestamps of received frames (radio.rxstamp) and of logger records.
+  */
+void time_get_monotonic(ot_timespec* ts);
+
+
+
+/** @brief  Convert a monotonic timestamp into realtime (UTC)
+  * @param  ts          (ot_timespec*) monotonic time in, UTC time out
+  * @retval None
+  * @ingroup Time
+  *
+  * The conversion uses the present offset between the clocks, so it is exact
+  * unless the realtime clock has been set since the timestamp was taken.
+  */
+void time_mono2real(ot_timespec* ts);
+
+
 #endif
@@ -500,6 +500,36 @@ ot_u8 vl_erase(vlFILE* fp);
   */
 ot_u8 vl_close( vlFILE* fp );
 
+
+/** @brief Write hook: called by Veelite each time data is written to a file
+  * @param fp           (vlFILE*) file pointer of the file that was written
+  * @retval None
+  * @ingroup Veelite
+  * @sa vl_generation
+  *
+  * vl_write(), vl_store(), and vl_append() call this after they write, and
+  * after the generation of the file has been incremented.  The default is an
+  * empty weak function, so an application can subscribe to file changes by
+  * implementing its own.  Modules that cache file data in RAM should use
+  * vl_generation() instead, so they are not called on each write.
+  */
+void vl_written( vlFILE* fp );
+
+
+/** @brief Returns the generation counter of a file
+  * @param block_id     (vlBLOCK) Block ID of the file
+  * @param data_id      (ot_u8) ID of the file
+  * @retval (ot_u16)    Generation of the file
+  * @ingroup Veelite
+  *
+  * The generation is incremented each time the file is written, created, or
+  * deleted.  A module that caches file data can save the generation when it
+  * loads the cache, and then reload the cache only if the generation has
+  * changed.  Each stock ISF has its own counter.  All other files share one
+  * counter, so a change to any of them is reported as a change to all.
+  */
+ot_u16 vl_generation( vlBLOCK block_id, ot_u8 data_id );
+
 /** @brief Returns the length of the open file (GFB, ISF, ISFS)
   * @param none
   * @retval (ot_uint) : length in bytes
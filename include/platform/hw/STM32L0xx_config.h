@@ -359,6 +359,30 @@ ot_u16 platform_ext_lsihz();
 #define MCU_STOP()              PWR_EnterSTOPMode(PWR_Regulator_LowPower, PWR_STOPEntry_WFI)
 #define MCU_STANDBY()           PWR_EnterSTANDBYMode(void)
 
+
+/** Energy Accounting Current Table (uA)
+  * ========================================================================<BR>
+  * Typical datasheet supply currents for the sys_powerdown() modes, used by
+  * the Energy module (OT_FEATURE_ENERGY).  Values are for 16 MHz
+  * from Flash, and STOP with RTC running.
+  * Board or app config may override these with measured values.
+  */
+#ifndef MCU_PARAM_ENERGY_RUN
+#   define MCU_PARAM_ENERGY_RUN         2300
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP
+#   define MCU_PARAM_ENERGY_SLEEP       700
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP_IO
+#   define MCU_PARAM_ENERGY_SLEEP_IO    700
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP_RF
+#   define MCU_PARAM_ENERGY_SLEEP_RF    700
+#endif
+#ifndef MCU_PARAM_ENERGY_STOP
+#   define MCU_PARAM_ENERGY_STOP        1
+#endif
+
 //Legacy
 //#define SLEEP_WHILE_UHF     MCU_SLEEP
 //#define SLEEP_MCU           MCU_SLEEP
@@ -538,10 +562,15 @@ void platform_isr_rng(void);
 
 /** STM32L Cryptography Include <BR>
   * ========================================================================<BR>
-  * Alias OTEAX Data Type into generic type for OpenTag
+  * Alias OTEAX Data Type into generic type for OpenTag.  With CRYPTO_RFAES,
+  * the EAX driver is the one for the radio AES engine (SPIRIT1).
   * 
   */
-#if OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY)
+#if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY)) \
+ && (OT_FEATURE(CRYPTO_RFAES) == ENABLED)
+#   include <io/spirit1/eax.h>
+    typedef spirit1_eaxctx EAXdrv_t;
+#elif OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY)
 #   include <oteax.h>
 //#   define EAXdrv_t eax_ctx
     typedef eax_ctx EAXdrv_t;
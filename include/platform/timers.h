@@ -153,6 +153,19 @@ void systim_init(void* tim_init);
 ot_u32 systim_get();
 
 
+/** @brief Returns the time elapsed since the last flush, in ticks, with the
+  *        remainder below one tick in nanoseconds
+  * @param subtick_ns   (ot_u32*) Loaded with the ns past the last whole tick.
+  *                     It may be NULL.
+  * @retval ot_u32      Elapsed ticks since last refresh
+  * @ingroup Platform
+  *
+  * A weak default in otsys/time.c derives the remainder from systim_get().
+  * Platforms with a finer clock (e.g. POSIX clock_gettime()) override it.
+  */
+ot_u32 systim_get_subtick(ot_u32* subtick_ns);
+
+
 /** @brief Reloads ktim to update calls to systim_get()
   * @param None
   * @retval None
@@ -203,6 +216,28 @@ ot_u16 systim_schedule(ot_u32 nextevent, ot_u32 overhead);
 
 
 
+/** RTC Alarm functions  <BR>
+  * ========================================================================<BR>
+  * Platforms with an RTC may implement one or more alarms (RTC_ALARMS).  When
+  * an alarm fires, the platform calls sys_synchronize() with the alarm's task.
+  * Alarms are one-shot.  OTcron uses alarm 0 for its earliest event, and it
+  * also runs the schedules of the Real Time Scheduler ISF.
+  */
+
+/** @brief Sets an RTC alarm
+  * @param alarm_id     (ot_u8) Alarm number, 0 to RTC_ALARMS-1
+  * @param task_id      (ot_u8) Task index to synchronize when the alarm fires
+  * @param offset       (ot_u16) Seconds from now until the alarm fires
+  * @retval None
+  * @ingroup Platform
+  */
+void platform_set_rtc_alarm(ot_u8 alarm_id, ot_u8 task_id, ot_u16 offset);
+
+void platform_clear_rtc_alarms();
+
+
+
+
 
 
 
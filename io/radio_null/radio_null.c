@@ -50,6 +50,7 @@
 #include <m2/session.h>
 #include <m2/dll.h>
 #include <otlib/crc16.h>
+#include <otlib/memcpy.h>
 #include <m2/encode.h>
 #include <otlib/buffers.h>
 #include <otlib/queue.h>
@@ -381,6 +382,23 @@ OT_WEAK void radio_getfourbytes(ot_u8* data) {
 #endif
 
 
+#ifndef EXTF_radio_putbytes
+OT_WEAK void radio_putbytes(ot_u8* data, ot_int length) {
+    memcpy(&fake_data[fake_put], data, length);
+    fake_put += length;
+}
+#endif
+
+
+#ifndef EXTF_radio_getbytes
+OT_WEAK void radio_getbytes(ot_u8* data, ot_int length) {
+    memcpy(data, &fake_data[fake_get], length);
+    fake_get += length;
+    fake_put -= length;
+}
+#endif
+
+
 #ifndef EXTF_radio_flush_rx
 OT_WEAK void radio_flush_rx() {
     fake_get = 0;
@@ -430,6 +448,20 @@ OT_WEAK ot_bool radio_txopen_4() {
 #endif
 
 
+#ifndef EXTF_radio_rxspan
+OT_WEAK ot_int radio_rxspan() {
+    return fake_put;
+}
+#endif
+
+
+#ifndef EXTF_radio_txspan
+OT_WEAK ot_int radio_txspan() {
+    return (fake_put < rfctl.txlimit) ? (rfctl.txlimit - fake_put) : 0;
+}
+#endif
+
+
 
 
 
@@ -587,6 +619,9 @@ OT_WEAK void rm2_rxinit(ot_u8 channel, ot_u8 psettings, ot_sig2 callback) {
 void rm2_rxsync_isr() {
 /// Prepare driver for data reception, update high-level module state, and have
 /// supervisor task (DLL) go into high-priority mode.
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+    em2_decode_endpacket();     // rxq.front back from a dropped multiframe packet
+#   endif
     q_empty(&rxq);
     radio.state = RADIO_DataRX;
     ///@todo when kernel is properly emulated: dll_block();
@@ -631,8 +666,9 @@ void rm2_rxdata_isr() {
     rm2_rxdata_isr_DECODE:
     em2_decode_data();      // Contains logic to prevent over-run
 
-    /// 3. Software-based FIFO resizing and CRC5 filtering
-    if (rfctl.flags & RADIO_FLAG_CRC5) {
+    /// 3. Software-based FIFO resizing and CRC5 filtering, once the frame
+    ///    header has been parsed by the decoder
+    if ((rfctl.flags & RADIO_FLAG_CRC5) && (em2.state < 0)) {
         rfctl.flags ^= RADIO_FLAG_CRC5;
         if (em2.crc5 != 0) {
             rm2_reenter_rx(radio.evtdone);
@@ -648,15 +684,30 @@ void rm2_rxdata_isr() {
             break;
 
         /// RX State 1: Paging Mode
-        /// Paging Mode is used for Foreground packet reception.  Multiframe packets
-        /// use it for the final frame.
+        /// Paging Mode is used for Foreground packet reception.  Frames of a
+        /// multiframe packet are received back-to-back in the same mode.
         case (RADIO_STATE_RXPAGE >> RADIO_STATE_RXSHIFT): {
             ot_int chipoctets_left;
 
             if (em2.bytes <= 0) {
+#               if (M2_FEATURE(MULTIFRAME) == ENABLED)
+                if (em2_remaining_frames() != 0) {
+                    radio.evtdone(1, em2_decode_endframe());
+                    em2_decode_nextframe();
+                    rfctl.flags |= RADIO_FLAG_CRC5;
+                    goto rm2_rxdata_isr_DECODE;
+                }
+#               endif
                 goto rm2_rxdata_isr_DONE;
             }
 
+#           if (M2_FEATURE(MULTIFRAME) == ENABLED)
+            if ((em2.state >= 0) || (em2_remaining_frames() != 0)) {
+                rfctl.rxlimit = (em2.state >= 0) ? _RXMINTHR : _RXMAXTHR;
+                break;
+            }
+#           endif
+
             chipoctets_left = (em2.bytes*_SPREAD);
             if (chipoctets_left  <= 96) {
                 rfctl.rxlimit   = chipoctets_left;
@@ -670,29 +721,6 @@ void rm2_rxdata_isr() {
             break;
         }
 
-        /// RX State 2 & 3:
-        /// Multiframe packets (only compiled when MFPs are supported)
-        ///@todo Experimental, not presently supported
-#       if (M2_FEATURE(MULTIFRAME) == ENABLED)
-#       error "Multiframe Not presently supported"
-        case (RADIO_STATE_RXMFP >> RADIO_STATE_RXSLOT):
-        case (RADIO_STATE_RXMFP >> RADIO_STATE_RXSHIFT): {
-            ot_int  frames_left = em2_remaining_frames();
-            if (em2.bytes == 0) {
-                if (frames_left == 0) {
-                    goto rm2_rxdata_isr_DONE;
-                }
-                radio.evtdone(frames_left, em2_decode_endframe());
-                q_rebase(&rxq, rxq.putcursor);
-                em2_decode_newframe();
-                rfctl.flags |= RADIO_FLAG_CRC5;
-                goto rm2_rxdata_isr_DECODE;
-            }
-            else if (frames_left == 0) {
-            }
-        } break;
-#       endif
-
         /// Bug Trap
        default: rm2_kill();
                 break;
@@ -725,9 +753,6 @@ void rm2_txinit(ot_u8 psettings, ot_sig2 callback) {
                           | RADIO_FLAG_CRC5     );
 #   if (SYS_FLOOD == ENABLED)
     rfctl.flags    |= (psettings != 0);   //sets RADIO_FLAG_BG
-#   endif
-#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
-    rfctl.flags    |= ((session_netstate() & M2_NETSTATE_DSDIALOG) >> 1); //sets RADIO_FLAG_FRCONT
 #   endif
     radio.evtdone   = callback;
     radio.state     = RADIO_Csma;
@@ -954,23 +979,20 @@ void rm2_txdata_isr() {
     rm2_txpkt_TXDATA:
     em2_encode_data();
     if (em2_remaining_bytes() == 0) {
-        rfctl.state = RADIO_STATE_TXDONE;
-        //spirit1_int_txdone();
-    }
-#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
-    else {
-        /// If the frame is done, but more need to be sent (e.g. MFP's)
-        /// queue it up.  The additional encode stage is there to fill up
-        /// what's left of the buffer.
+#       if (M2_FEATURE(MULTIFRAME) == ENABLED)
+        /// If the frame is done, but more need to be sent (e.g. MFP's), the
+        /// next frame is already queued right after this one, so encode it
+        /// into what's left of the buffer.
         if (em2_remaining_frames() != 0) {
-            q_rebase(&txq, txq.getcursor);
             radio.evtdone(1, 0);        //callback action for next frame
-            em2_encode_newframe();
-            txq.front[2] = (phymac[0].tx_eirp & 0x7f);
+            em2_encode_nextframe();
+            txq.getcursor[2] = (phymac[0].tx_eirp & 0x7f);
             goto rm2_txpkt_TXDATA;
         }
+#       endif
+        rfctl.state = RADIO_STATE_TXDONE;
+        //spirit1_int_txdone();
     }
-#   endif
 }
 #endif
 
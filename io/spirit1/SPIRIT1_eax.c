@@ -0,0 +1,418 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /io/spirit1/SPIRIT1_eax.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      EAX Cryptographic Driver using the SPIRIT1 AES-128 engine
+  * @defgroup   EAX Driver
+  * @ingroup    EAX Driver
+  *
+  * EAX is AES-CTR plus OMAC, and both only use the forward block cipher.  This
+  * driver does the EAX mode on the MCU and sends each AES block either to the
+  * SPIRIT1 engine over SPI, or to a compact software AES.  The profile is the
+  * one used by M2NP DLLS: 7 byte nonce, no header, and a 4 byte tag after the
+  * data.  EAXdrv_decrypt() takes the length with the tag.
+  *
+  * Which engine is faster depends on the SPI clock, the MCU clock, and on
+  * whether the SPIRIT1 has to be woken, so the driver times both with
+  * systim_chronstamp() and uses the cheaper one.  Every EAXRF_PROBE messages
+  * it uses the other one, so the figures stay current.  The SPIRIT1 engine is
+  * only used while the radio is idle, because waiting on the AES IRQ takes
+  * over the radio IRQ lines.
+  *
+  * The key last loaded into the SPIRIT1 stays there (spirit1.aeskey), so
+  * frames with the same key do not reload it.
+  *
+  ******************************************************************************
+  */
+
+#include <otstd.h>
+#include <board.h>
+#if defined(__SPIRIT1__) && (OT_FEATURE(CRYPTO_RFAES) == ENABLED) \
+ && (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY))
+
+#include <io/spirit1/config.h>
+#include <io/spirit1/interface.h>
+#include "radio_rm2.h"
+
+#include <otlib/crypto.h>
+#include <otlib/memcpy.h>
+#include <platform/timers.h>
+#include <m2/radio.h>
+
+#if (RF_FEATURE(AES128) != ENABLED)
+#   error "OT_FEATURE_CRYPTO_RFAES needs RF_FEATURE_AES128"
+#endif
+
+#define EAX_NONCELEN    7               // M2NP DLLS nonce field
+#define EAX_TAGLEN      4
+
+#define EAXRF_SW        0
+#define EAXRF_HW        1
+#define EAXRF_PROBE     16              // messages between runs on the other engine
+
+#define XTIME(X)        (ot_u8)(((X) << 1) ^ (((X) & 0x80) ? 0x1B : 0))
+
+static struct {
+    ot_u32  cost[2];                    // chronstamp ticks per block x256, averaged
+    ot_bool timed[2];                   // [EAXRF_SW], [EAXRF_HW]
+    ot_u8   probe;
+} eaxrf;
+
+
+static const ot_u8 aes_sbox[256] = {
+    0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+    0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+    0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+    0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+    0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+    0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+    0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+    0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+    0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+    0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+    0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+    0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+    0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+    0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+    0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+    0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+
+
+
+
+/** Software AES-128
+  * ============================================================================
+  * Byte oriented, so it is small and has no alignment needs.  It is the path
+  * when the radio is busy, and EAXdrv_init() always uses it.
+  */
+
+static void sub_expand(ot_u8* key, ot_u8* rk) {
+    ot_u8   rcon = 1;
+    ot_int  i;
+
+    memcpy(rk, key, 16);
+    for (i=16; i<176; i+=4) {
+        if ((i & 15) == 0) {
+            rk[i]   = rk[i-16] ^ aes_sbox[rk[i-3]] ^ rcon;
+            rk[i+1] = rk[i-15] ^ aes_sbox[rk[i-2]];
+            rk[i+2] = rk[i-14] ^ aes_sbox[rk[i-1]];
+            rk[i+3] = rk[i-13] ^ aes_sbox[rk[i-4]];
+            rcon    = XTIME(rcon);
+        }
+        else {
+            rk[i]   = rk[i-16] ^ rk[i-4];
+            rk[i+1] = rk[i-15] ^ rk[i-3];
+            rk[i+2] = rk[i-14] ^ rk[i-2];
+            rk[i+3] = rk[i-13] ^ rk[i-1];
+        }
+    }
+}
+
+
+static void sub_aes(const ot_u8* rk, ot_u8* s) {
+    ot_u8   t[16];
+    ot_u8   a0, a1, a2, a3, x;
+    ot_int  i, r;
+
+    for (i=0; i<16; i++) {
+        s[i] ^= rk[i];
+    }
+    for (r=1; r<=10; r++) {
+        /// SubBytes and ShiftRows: byte (row i&3, column i>>2) moves to
+        /// column (column - row)
+        for (i=0; i<16; i++) {
+            t[i] = aes_sbox[s[(i + 4*(i & 3)) & 15]];
+        }
+
+        /// MixColumns, except in the last round
+        if (r < 10) {
+            for (i=0; i<16; i+=4) {
+                a0      = t[i];
+                a1      = t[i+1];
+                a2      = t[i+2];
+                a3      = t[i+3];
+                x       = a0 ^ a1 ^ a2 ^ a3;
+                t[i]    = a0 ^ x ^ XTIME(a0 ^ a1);
+                t[i+1]  = a1 ^ x ^ XTIME(a1 ^ a2);
+                t[i+2]  = a2 ^ x ^ XTIME(a2 ^ a3);
+                t[i+3]  = a3 ^ x ^ XTIME(a3 ^ a0);
+            }
+        }
+
+        rk += 16;
+        for (i=0; i<16; i++) {
+            s[i] = t[i] ^ rk[i];
+        }
+    }
+}
+
+
+
+
+/** EAX mode
+  * ============================================================================
+  */
+
+static void sub_xor16(ot_u8* dst, const ot_u8* src) {
+    ot_int i;
+    for (i=0; i<16; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+
+static void sub_double(ot_u8* dst, const ot_u8* src) {
+/// Multiply by x in GF(2^128), for the OMAC subkeys
+    ot_u8   carry = (src[0] & 0x80) ? 0x87 : 0;
+    ot_int  i;
+    for (i=0; i<15; i++) {
+        dst[i] = (ot_u8)((src[i] << 1) | (src[i+1] >> 7));
+    }
+    dst[15] = (ot_u8)(src[15] << 1) ^ carry;
+}
+
+
+static void sub_block(ot_u8* block, const EAXdrv_t* context, ot_u8 engine) {
+    if (engine == EAXRF_HW) {
+        spirit1_aes_encrypt(block);
+    }
+    else {
+        sub_aes(context->rk, block);
+    }
+}
+
+
+static void sub_macblock(ot_u8* mac, const ot_u8* data, ot_int rem,
+                         const EAXdrv_t* context, ot_u8 engine) {
+/// One OMAC step.  rem is the number of message bytes from data onward, so
+/// rem <= 16 means this is the last block.
+    ot_int i;
+
+    if (rem > 16) {
+        sub_xor16(mac, data);
+    }
+    else {
+        for (i=0; i<rem; i++) {
+            mac[i] ^= data[i];
+        }
+        if (rem == 16) {
+            sub_xor16(mac, context->l2);
+        }
+        else {
+            mac[rem] ^= 0x80;
+            sub_xor16(mac, context->l4);
+        }
+    }
+    sub_block(mac, context, engine);
+}
+
+
+static ot_u8 sub_pick(void) {
+/// The cheaper engine per block, except on probe messages.  An engine with
+/// no figures yet is used first, so that it gets some.
+    ot_u8 engine;
+
+    if (radio.state != RADIO_Idle) {
+        return EAXRF_SW;
+    }
+    if (eaxrf.timed[EAXRF_HW] == False) {
+        return EAXRF_HW;
+    }
+    if (eaxrf.timed[EAXRF_SW] == False) {
+        return EAXRF_SW;
+    }
+
+    engine = (eaxrf.cost[EAXRF_HW] < eaxrf.cost[EAXRF_SW]) ? EAXRF_HW : EAXRF_SW;
+
+    if (++eaxrf.probe >= EAXRF_PROBE) {
+        eaxrf.probe = 0;
+        engine     ^= 1;
+    }
+    return engine;
+}
+
+
+static void sub_charge(ot_u8 engine, ot_u32 ticks, ot_int blocks) {
+/// Moving average of the cost per block, 1/4 weight to the new message.  A
+/// coarse chronstamp gives 0 or 1 tick for most messages, but the average of
+/// these still converges on the real cost.
+    ot_u32 sample = (ticks << 8) / (ot_u32)blocks;
+
+    if (eaxrf.timed[engine] == False) {
+        eaxrf.timed[engine] = True;
+        eaxrf.cost[engine]  = sample;
+    }
+    else {
+        eaxrf.cost[engine] += (sample >> 2) - (eaxrf.cost[engine] >> 2);
+    }
+}
+
+
+static ot_int sub_eax(ot_u8* nonce, ot_u8* data, ot_uint datalen,
+                      EAXdrv_t* context, ot_bool encrypt) {
+    ot_u8   n[16];
+    ot_u8   mac[16];
+    ot_u8   ks[16];
+    ot_u8*  tag;
+    ot_u32  stamp;
+    ot_int  length, rem, i;
+    ot_int  blocks;
+    ot_u8   engine;
+    ot_bool wake    = False;
+    ot_u8   diff    = 0;
+
+    length = (ot_int)datalen - (encrypt ? 0 : EAX_TAGLEN);
+    if (length < 0) {
+        return -1;
+    }
+
+    engine  = sub_pick();
+    stamp   = systim_chronstamp(NULL);
+
+    /// The engine needs the XO on.  Waking the SPIRIT1 is part of the cost.
+    if (engine == EAXRF_HW) {
+        if (spirit1_isready() == 0) {
+            spirit1drv_force_ready();
+            wake = True;
+        }
+        if (spirit1.aeskey != context->rk) {
+            spirit1_aes_loadkey(context->rk);
+        }
+    }
+
+    /// N = OMAC^0(nonce): E([0]) = L, then one padded block
+    memset(n, 0, 16);
+    memcpy(n, nonce, EAX_NONCELEN);
+    n[EAX_NONCELEN] = 0x80;
+    sub_xor16(n, context->l);
+    sub_xor16(n, context->l4);
+    sub_block(n, context, engine);
+    blocks = 1;
+
+    /// CTR from N, and OMAC^2 over the ciphertext, one block at a time.  The
+    /// OMAC takes the block before decryption, or after encryption.
+    memcpy(mac, context->e2, 16);
+    memcpy(ks, n, 16);
+    for (i=0; i<length; i+=16) {
+        ot_u8   ctr[16];
+        ot_int  b;
+
+        rem = length - i;
+        if (encrypt == False) {
+            sub_macblock(mac, &data[i], rem, context, engine);
+        }
+        memcpy(ctr, ks, 16);
+        sub_block(ctr, context, engine);
+        for (b=0; (b<16) && (b<rem); b++) {
+            data[i+b] ^= ctr[b];
+        }
+        if (encrypt) {
+            sub_macblock(mac, &data[i], rem, context, engine);
+        }
+        for (b=15; (b>=0) && (++ks[b] == 0); b--);
+        blocks += 2;
+    }
+
+    /// An empty message is only the block [2], which is full
+    if (length == 0) {
+        memcpy(mac, context->l2, 16);
+        mac[15] ^= 2;
+        sub_block(mac, context, engine);
+        blocks++;
+    }
+
+    if (wake) {
+        spirit1drv_smart_standby();
+    }
+    sub_charge(engine, systim_chronstamp(&stamp), blocks);
+
+    /// Tag = N ^ H ^ C, truncated
+    sub_xor16(n, context->h);
+    sub_xor16(n, mac);
+    tag = &data[length];
+    if (encrypt) {
+        memcpy(tag, n, EAX_TAGLEN);
+    }
+    else {
+        for (i=0; i<EAX_TAGLEN; i++) {
+            diff |= tag[i] ^ n[i];
+        }
+    }
+    return (diff != 0);
+}
+
+
+
+
+/** Driver functions
+  * ============================================================================
+  */
+
+ot_int EAXdrv_init(ot_u8* key, EAXdrv_t* context) {
+/// The schedule, the OMAC subkeys, and the OMAC values that do not depend on
+/// the message.  These use the software AES, so the radio is not touched,
+/// except to forget a key that this context had put there.
+    if (spirit1.aeskey == context->rk) {
+        spirit1.aeskey = NULL;
+    }
+    sub_expand(key, context->rk);
+
+    memset(context->l, 0, 16);
+    sub_aes(context->rk, context->l);
+    sub_double(context->l2, context->l);
+    sub_double(context->l4, context->l2);
+
+    memset(context->e2, 0, 16);
+    context->e2[15] = 2;
+    sub_aes(context->rk, context->e2);
+
+    memcpy(context->h, context->l2, 16);
+    context->h[15] ^= 1;
+    sub_aes(context->rk, context->h);
+
+    return 0;
+}
+
+
+ot_int EAXdrv_clear(EAXdrv_t* context) {
+    volatile ot_u8* wipe = (volatile ot_u8*)context;
+    ot_uint         i;
+
+    if (spirit1.aeskey == context->rk) {
+        spirit1_aes_off();
+    }
+    for (i=0; i<sizeof(EAXdrv_t); i++) {
+        wipe[i] = 0;
+    }
+    return 0;
+}
+
+
+ot_int EAXdrv_encrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, EAXdrv_t* context) {
+    return sub_eax(nonce, data, datalen, context, True);
+}
+
+
+ot_int EAXdrv_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, EAXdrv_t* context) {
+    return sub_eax(nonce, data, datalen, context, False);
+}
+
+
+#endif
@@ -49,6 +49,8 @@
 
 #include <otlib/delay.h>
 
+#include <otsys/energy.h>
+
 
 
 ///@todo right now these are used with m2DLL.... move those functions elsewhere
@@ -174,6 +176,24 @@ void spirit1_strobe(ot_u8 strobe) {
     cmd[0]  = 0x80;
     cmd[1]  = strobe;
     spirit1_spibus_io(2, 0, cmd);
+
+    /// State-changing strobes are the power transitions of the SPIRIT1, so
+    /// they are also where the Energy module is notified.  Strobes 0x60-0x67
+    /// are TX, RX, READY, STANDBY, SLEEP, LOCKRX, LOCKTX, SABORT.  SRES ends
+    /// in READY.  The other strobes do not change the state.
+#   if (OT_FEATURE(ENERGY) == ENABLED)
+    {   static const ot_u8 rfstate[8] = {
+            ENERGY_rf_tx,   ENERGY_rf_rx,   ENERGY_rf_idle, ENERGY_rf_off,
+            ENERGY_rf_off,  ENERGY_rf_idle, ENERGY_rf_idle, ENERGY_rf_idle
+        };
+        if ((ot_u8)(strobe - RFSTROBE_TX) < 8) {
+            energy_radio(rfstate[strobe - RFSTROBE_TX]);
+        }
+        else if (strobe == RFSTROBE_SRES) {
+            energy_radio(ENERGY_rf_idle);
+        }
+    }
+#   endif
 }
 
 ot_u8 spirit1_read(ot_u8 addr) {
@@ -206,6 +226,52 @@ void spirit1_burstwrite(ot_u8 start_addr, ot_u8 length, ot_u8* cmd_data) {
     spirit1_spibus_io((2+length), 0, cmd_data);
 }
 
+
+
+#if (OT_FEATURE(CRYPTO_RFAES) == ENABLED)
+void spirit1_aes_loadkey(const ot_u8* key) {
+    ot_u8   cmd[18];
+    ot_int  i;
+
+    if (spirit1.aeskey == NULL) {
+        spirit1_write(RFREG(ANA_FUNC_CONF0), spirit1_read(RFREG(ANA_FUNC_CONF0)) | _AES_ON);
+    }
+    for (i=0; i<16; i++) {
+        cmd[17-i] = key[i];
+    }
+    spirit1_burstwrite(RFREG(AES_KEY_IN15), 16, cmd);
+    spirit1.aeskey = key;
+}
+
+void spirit1_aes_off(void) {
+    ot_u8 cmd[18] = { 0 };
+
+    spirit1_burstwrite(RFREG(AES_KEY_IN15), 16, cmd);
+    spirit1_write(RFREG(ANA_FUNC_CONF0), spirit1_read(RFREG(ANA_FUNC_CONF0)) & ~_AES_ON);
+    spirit1.aeskey = NULL;
+}
+
+void spirit1_aes_encrypt(ot_u8* block) {
+    ot_u8   cmd[18];
+    ot_int  i;
+
+    for (i=0; i<16; i++) {
+        cmd[17-i] = block[i];
+    }
+    spirit1_burstwrite(RFREG(AES_DATA_IN15), 16, cmd);
+
+    /// Completion is signalled by the AES IRQ, which is routed to GPIO2
+    spirit1_wfe_aes();
+    spirit1_strobe(RFSTROBE_AES_ENC);
+    spirit1_wfe();
+
+    spirit1_burstread(RFREG(AES_DATA_OUT15), 16, cmd);
+    for (i=0; i<16; i++) {
+        block[i] = cmd[15-i];
+    }
+}
+#endif
+
 void spirit1_load_defaults() {
 /// The data ordering is: WRITE LENGTH, WRITE HEADER (0), START ADDR, VALUES
 /// Ignore registers that are set later, are unused, or use the hardware default values.
@@ -285,6 +351,10 @@ void spirit1_coredump() {
 void spirit1_shutdown(ot_uint us) {
 /// Raise the Shutdown Line
     spirit1_sdnpin_sethigh();
+    ENERGY_RADIO(ENERGY_rf_off);
+#   if (OT_FEATURE(CRYPTO_RFAES) == ENABLED)
+    spirit1.aeskey = NULL;
+#   endif
     delay_us(us);
 }
 
@@ -293,6 +363,9 @@ void spirit1_reset() {
     spirit1_int_turnoff(RFI_ALL);
     spirit1_strobe(STROBE(SRES));
     spirit1_waitforreset();
+#   if (OT_FEATURE(CRYPTO_RFAES) == ENABLED)
+    spirit1.aeskey = NULL;
+#   endif
 }
 
 void spirit1_waitforreset() {
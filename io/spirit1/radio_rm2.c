@@ -63,6 +63,7 @@
 
 #include <otlib/buffers.h>
 #include <otlib/crc16.h>
+#include <otlib/memcpy.h>
 #include <otlib/utils.h>
 
 // Local header for subroutines and implementation constants (supports patching)
@@ -304,6 +305,11 @@ OT_WEAK void rm2_enter_channel(ot_u8 old_chan_id, ot_u8 old_tx_eirp) {
     if (fc_i != (old_chan_id & 0x0F)) {
         spirit1_write(RFREG(CHNUM), fc_i-1);
     }
+
+    /// Rebuild the airtime model if the encoding or rate has changed
+    if ((old_chan_id ^ phymac[0].channel) & 0xF0) {
+        rm2_airtime_refresh();
+    }
 }
 #endif
 
@@ -563,6 +569,17 @@ OT_WEAK void rm2_rxsync_isr() {
 
     __DEBUG_ERRCODE_EVAL(=210);
 
+    /// A multiframe packet that was dropped part-way leaves rxq.front on its
+    /// last frame.  Put it back before the queue is reused.
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+    em2_decode_endpacket();
+#   endif
+
+    /// Timestamp the frame as early as possible: the sync word is the most
+    /// precise timing reference there is on RX.
+#   if (OT_FEATURE(TIME) == ENABLED)
+    time_get_monotonic(&radio.rxstamp);
+#   endif
 
     if (rfctl.flags & RADIO_FLAG_BG) {
         rxq.getcursor       = rxq.front;
@@ -616,8 +633,9 @@ OT_WEAK void rm2_rxdata_isr() {
     rm2_rxdata_isr_DECODE:
     em2_decode_data();      // Contains logic to prevent over-run
 
-    /// 3. Software-based FIFO resizing and CRC5 filtering
-    if (rfctl.flags & RADIO_FLAG_CRC5) {
+    /// 3. Software-based FIFO resizing and CRC5 filtering, once the frame
+    ///    header has been parsed by the decoder
+    if ((rfctl.flags & RADIO_FLAG_CRC5) && (em2.state < 0)) {
 
         __DEBUG_ERRCODE_EVAL(=222);
         rfctl.flags ^= RADIO_FLAG_CRC5;
@@ -640,8 +658,10 @@ OT_WEAK void rm2_rxdata_isr() {
             break;
 
         /// RX State 1: Paging Mode
-        /// Paging Mode is used for Foreground packet reception.  Multiframe packets
-        /// use it for the final frame.
+        /// Paging Mode is used for Foreground packet reception.  Frames of a
+        /// multiframe packet are received back-to-back in the same mode: at
+        /// the end of each frame that has more after it, the DLL gets the
+        /// frame result and the decoder is set-up for the next frame.
 //#       if ((M2_FEATURE(MULTIFRAME) == ENABLED) || (M2_FEATURE(FECRX) == ENABLED))
         case (RADIO_STATE_RXPAGE >> RADIO_STATE_RXSHIFT): {
             ot_int chipoctets_left;
@@ -649,9 +669,33 @@ OT_WEAK void rm2_rxdata_isr() {
 
 
             if (em2.bytes <= 0) {
+#               if (M2_FEATURE(MULTIFRAME) == ENABLED)
+                if (em2_remaining_frames() != 0) {
+                    __DEBUG_ERRCODE_EVAL(=224);
+                    radio.evtdone(1, em2_decode_endframe());
+                    em2_decode_nextframe();
+                    rfctl.flags |= RADIO_FLAG_CRC5;
+                    goto rm2_rxdata_isr_DECODE;
+                }
+#               endif
                 goto rm2_rxdata_isr_DONE;
             }
 
+#           if (M2_FEATURE(MULTIFRAME) == ENABLED)
+            /// Header of the next frame is not in yet: wait for a few bytes.
+            /// The end of the packet can only be anticipated on its last frame.
+            if (em2.state >= 0) {
+                if (rfctl.rxlimit != (96-_RXMINTHR)) {
+                    rfctl.rxlimit = (96-_RXMINTHR);
+                    goto rm2_rxdata_isr_RESIZE;
+                }
+                break;
+            }
+            if (em2_remaining_frames() != 0) {
+                goto rm2_rxdata_isr_MAXFILL;
+            }
+#           endif
+
             ///@todo reduce from max-fill, so that more work can be done while
             ///      data is being read-in.
             chipoctets_left = (em2.bytes*_SPREAD);
@@ -660,6 +704,9 @@ OT_WEAK void rm2_rxdata_isr() {
                 rfctl.state     = RADIO_STATE_RXDONE;
                 goto rm2_rxdata_isr_RESIZE;
             }
+#           if (M2_FEATURE(MULTIFRAME) == ENABLED)
+            rm2_rxdata_isr_MAXFILL:
+#           endif
             if (rfctl.rxlimit != (96-_RXMAXTHR)) {
                 rfctl.rxlimit   = (96-_RXMAXTHR);
                 goto rm2_rxdata_isr_RESIZE;
@@ -672,34 +719,6 @@ OT_WEAK void rm2_rxdata_isr() {
 //#       endif
         }
 
-        /// RX State 2 & 3:
-        /// Multiframe packets (only compiled when MFPs are supported)
-        ///@todo Experimental, not presently supported
-#       if (M2_FEATURE(MULTIFRAME) == ENABLED)
-#       error "Multiframe Not presently supported"
-        case (RADIO_STATE_RXMFP >> RADIO_STATE_RXSLOT):
-        case (RADIO_STATE_RXMFP >> RADIO_STATE_RXSHIFT): {
-            ot_int  frames_left = em2_remaining_frames();
-
-            __DEBUG_ERRCODE_EVAL(=224);
-
-
-            if (em2.bytes == 0) {
-                if (frames_left == 0) {
-                    goto rm2_rxdata_isr_DONE;
-                }
-                radio.evtdone(frames_left, em2_decode_endframe());
-                q_rebase(&rxq, rxq.putcursor);
-                em2_decode_newframe();
-                rfctl.flags |= RADIO_FLAG_CRC5;
-                goto rm2_rxdata_isr_DECODE;
-            }
-            else if (frames_left == 0) {
-
-            }
-        } break;
-#       endif
-
         /// Bug Trap
        default: rm2_kill();
                 break;
@@ -896,7 +915,15 @@ OT_WEAK void rm2_txcsma_isr() {
                                 (DRF_PROTOCOL0 | _PERS_TX) : DRF_PROTOCOL0;
 #           endif
 
-            spirit1drv_buffer_config(type, (em2.bytes*_SPREAD) /*q_span(&txq)*/);
+            // A multiframe packet goes out as one SPIRIT1 packet.  The last
+            // frame ends at txq.back, including its CRC and RS parity.
+            pktlen = em2.bytes;
+#           if (M2_FEATURE(MULTIFRAME) == ENABLED)
+            if (em2_remaining_frames() != 0) {
+                pktlen = (ot_u16)(txq.back - txq.front);
+            }
+#           endif
+            spirit1drv_buffer_config(type, (pktlen*_SPREAD));
             spirit1_int_off();
             spirit1_iocfg_tx();
 
@@ -1006,24 +1033,20 @@ OT_WEAK void rm2_txdata_isr() {
     rm2_txpkt_TXDATA:
     em2_encode_data();
     if (em2_remaining_bytes() == 0) {
-        rfctl.state = RADIO_STATE_TXDONE;
-        spirit1_int_txdone();
-    }
-
-#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
-    else {
+#       if (M2_FEATURE(MULTIFRAME) == ENABLED)
         /// If the frame is done, but more need to be sent (e.g. MFP's)
         /// queue it up.  The additional encode stage is there to fill up
         /// what's left of the buffer.
         if (em2_remaining_frames() != 0) {
-            q_rebase(&txq, txq.getcursor);
             radio.evtdone(1, 0);        //callback action for next frame
-            em2_encode_newframe();
-            txq.front[2] = (phymac[0].tx_eirp & 0x7f);
+            em2_encode_nextframe();
+            txq.getcursor[2] = (phymac[0].tx_eirp & 0x7f);
             goto rm2_txpkt_TXDATA;
         }
+#       endif
+        rfctl.state = RADIO_STATE_TXDONE;
+        spirit1_int_txdone();
     }
-#   endif
 }
 #endif
 
@@ -1346,6 +1369,45 @@ OT_WEAK void radio_getfourbytes(ot_u8* data) {
 }
 #endif
 
+/** FIFO bursts
+  * spirit1_spibus_io() always runs the RX DMA channel, into spirit1.status and
+  * then spirit1.busrx, for the whole transaction.  On a write, the bytes that
+  * come back (status, then garbage) land there too, so a transaction is never
+  * longer than status + busrx: two command bytes and sizeof(busrx) bytes of
+  * data, in either direction.  Longer bursts are split at that size.
+  */
+#define _BURSTMAX   ((ot_int)sizeof(spirit1.busrx))
+
+#ifndef EXTF_radio_putbytes
+OT_WEAK void radio_putbytes(ot_u8* data, ot_int length) {
+/// The write command goes in the two bytes ahead of the data, and the caller's
+/// buffer has no room for it, so each burst is staged behind the command.
+    ot_u8   cmd[2+_BURSTMAX];
+    ot_int  burst;
+
+    while (length > 0) {
+        burst = (length < _BURSTMAX) ? length : _BURSTMAX;
+        memcpy(&cmd[2], data, burst);
+        spirit1_burstwrite(RFREG(FIFO), (ot_u8)burst, cmd);
+        data   += burst;
+        length -= burst;
+    }
+}
+#endif
+
+#ifndef EXTF_radio_getbytes
+OT_WEAK void radio_getbytes(ot_u8* data, ot_int length) {
+    ot_int burst;
+
+    while (length > 0) {
+        burst = (length < _BURSTMAX) ? length : _BURSTMAX;
+        spirit1_burstread(RFREG(FIFO), (ot_u8)burst, data);
+        data   += burst;
+        length -= burst;
+    }
+}
+#endif
+
 
 ///@note this IRQ flushing is needed if you are using a driver interrupt based
 ///      on the SPIRIT1 IRQ system.  Presently, all driver interrupts are using
@@ -1390,6 +1452,19 @@ OT_WEAK ot_bool radio_txopen_4() {
 }
 #endif
 
+#ifndef EXTF_radio_rxspan
+OT_WEAK ot_int radio_rxspan() {
+    return (ot_int)spirit1_rxbytes();
+}
+#endif
+
+#ifndef EXTF_radio_txspan
+OT_WEAK ot_int radio_txspan() {
+    ot_int span = rfctl.txlimit - (ot_int)spirit1_txbytes();
+    return (span > 0) ? span : 0;
+}
+#endif
+
 #ifndef EXTF_radio_rssi
 OT_WEAK ot_int radio_rssi() {
 /// @note SPIRIT1 only guarantees RSSI reading after end of packet RX
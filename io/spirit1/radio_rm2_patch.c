@@ -57,7 +57,10 @@ void em2_decode_newpacket() {
 void em2_encode_newframe() {
     /// 1. Prepare the CRC and RS encoding, which need to be computed
     ///    when the upper options byte is set.  That is, it is non-zero
-    ///    on the first packet and 0 for retransmissions.
+    ///    on the first packet and 0 for retransmissions.  The link control
+    ///    flags are always loaded, because the FRCONT flag is needed on
+    ///    retransmissions of multiframe packets, too.
+    em2.lctl = txq.front[1];
     if (txq.options.ubyte[UPPER] != 0) {
         crc_init_stream(&em2.crc, True, q_span(&txq), txq.getcursor);
         txq.putcursor  += 2;
@@ -147,8 +150,14 @@ void em2_decode_data(void) {
 
     em2_decode_data_TOP:
 
+    /// The frame header is parsed from the first grab, so it must include
+    /// the length and link control bytes.  In multiframe packets, the next
+    /// frame follows right away, so don't grab past the end of this frame.
     grab = spirit1_rxbytes();
-    if (grab != 0) {
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+    if (grab > em2.bytes)   grab = em2.bytes;
+#   endif
+    if (grab > (ot_u16)(em2.state == 0)) {
         if (grab > 24)  grab = 24;
 
         spirit1_spibus_io(2, grab, (ot_u8*)cmd);
@@ -52,6 +52,7 @@
 
 #include <otlib/auth.h>         ///@todo might not be necessary here
 #include <otlib/buffers.h>
+#include <otlib/memcpy.h>
 #include <otlib/rand.h>
 #include <otlib/utils.h>
 #include <otsys/veelite.h>
@@ -60,7 +61,7 @@
 //#include <otplatform.h>         // only needed for certain testing
 
 #if (OT_FEATURE(CRON))
-#   include "otcron.h"
+#   include <otsys/otcron.h>
 #endif
 
 #if (M2_FEATURE(BEACONS))
@@ -72,6 +73,52 @@ m2dll_struct    dll;
 static void sub_dll_flush(void);
 
 
+/** Veelite generations of the files cached by dll_refresh(): ISF 0, ISF 1,
+  * and the Real Time Scheduler ISF.
+  */
+static struct {
+    ot_bool valid;
+    ot_u16  value[3];
+} dll_gen;
+
+/** Response slot band from the last query score: 0 is no priority (whole
+  * contention period), 1 to M2_PARAM_SCOREBANDS is the rank set by sub_fceval()
+  */
+static ot_u8 dll_fcrank;
+
+
+#if (M2_PARAM(CCASTATS) > 0)
+/** Channel occupancy, learned from the CCA results of CSMA-CA.  busy is the
+  * CCA fail rate as an EWMA (0-255), and rssi is an EWMA of the RSSI sampled
+  * at CCA fail.  Entries are replaced round-robin, and channel 0 is empty.
+  */
+typedef struct {
+    ot_u8   channel;
+    ot_u8   busy;
+    ot_int  rssi;
+} dll_ccastat;
+
+static struct {
+    ot_u8       next;
+    dll_ccastat entry[M2_PARAM(CCASTATS)];
+} dll_cca;
+#endif
+
+
+#if (M2_FEATURE(BEACONS) == ENABLED)
+/** RAM copy of the Beacon Transmit Sequence ISF.  It is reloaded by the beacon
+  * task only when the Veelite generation of the file has changed, so the file
+  * is not opened for each beacon.  Each beacon is 8 bytes.
+  */
+static struct {
+    ot_bool valid;
+    ot_u8   count;
+    ot_u16  gen;
+    ot_u8   data[ISF_MAX(beacon_transmit_sequence)];
+} dll_bts;
+#endif
+
+
 
 
 
@@ -97,6 +144,36 @@ static void sub_dll_flush(void);
 static void sub_csma_scramble(void);
 
 
+/** @brief Returns the occupancy record of a channel
+  * @param  channel     (ot_u8) channel ID
+  * @param  add         (ot_bool) True to take a record if there is none
+  * @retval dll_ccastat* the record, or NULL if there is none and add is False
+  * @ingroup System
+  */
+#if (M2_PARAM(CCASTATS) > 0)
+static dll_ccastat* sub_ccastat(ot_u8 channel, ot_bool add);
+#endif
+
+
+/** @brief Logs a CCA result on the present channel (phymac[0].channel)
+  * @param  fail        (ot_bool) True if CCA failed
+  * @retval none
+  * @ingroup System
+  */
+static void sub_ccalog(ot_bool fail);
+
+
+/** @brief Random extra backoff for a RAIND loop, from channel occupancy
+  * @param  step        (CLK_UNIT) the fixed loop step (packet duration)
+  * @retval CLK_UNIT    extra backoff, 0 to twice the step on a full channel
+  * @ingroup System
+  *
+  * The fixed RAIND step makes devices that defer on the same TX retry at the
+  * same time.  On a busy channel, this spreads them out.
+  */
+static CLK_UNIT sub_ccajitter(CLK_UNIT step);
+
+
 /** @brief Initializes the flow/congestion control sequence
   * @retval ot_uint     Initial TX backoff, in ticks
   * @ingroup System
@@ -105,14 +182,32 @@ static CLK_UNIT sub_fcinit(void);
 
 
 /** @brief Evaluates the TX slot usage based on the quality of the query
-  * @param  query_score (ot_int) To be defined
+  * @param  query_score (ot_int) Score from the M2QP query, 0 or positive
   * @retval none
   * @ingroup System
-  * @note Optional, not implemented yet
+  *
+  * A score of 0 means the query passed without priority.  Positive scores are
+  * better when higher (e.g. the number of hits of a correlation search).  The
+  * contention period is divided into M2_PARAM_SCOREBANDS bands, and the score
+  * selects the band, on a log2 scale: 1 takes the last band (the back half of
+  * the period), 2-3 the one before it (the quarter before that), and so on.
+  * The response slot is then picked at random within that band, so better
+  * matches respond earlier, and they contend only with responders of similar
+  * score.
   */
 static void sub_fceval(ot_int query_score);
 
 
+/** @brief Picks a random TX offset within a window, restricted to the band of
+  *        the query score if there is one
+  * @param  window      (CLK_UNIT) duration of the window, must be > 0
+  * @retval CLK_UNIT    offset into the window
+  * @ingroup System
+  * @sa sub_fceval()
+  */
+static CLK_UNIT sub_fcslot(CLK_UNIT window);
+
+
 /** @brief Processes the flow/congestion control sequence following initialization
   * @retval ot_uint     Subsequent TX backoff, in ticks
   * @ingroup System
@@ -225,6 +320,13 @@ OT_WEAK void dll_init(void) {
 
     /// Load the Network settings from ISF 0 to the dll.netconf buffer, reset
     /// the session, and send system to idle.
+    dll_gen.valid = False;
+#   if (M2_PARAM(CCASTATS) > 0)
+    memset((ot_u8*)&dll_cca, 0, sizeof(dll_cca));
+#   endif
+#   if (M2_FEATURE(BEACONS) == ENABLED)
+    dll_bts.valid = False;
+#   endif
     dll_refresh();
 }
 #endif
@@ -233,24 +335,45 @@ OT_WEAK void dll_init(void) {
 
 #ifndef EXTF_dll_refresh
 OT_WEAK void dll_refresh(void) {
-    ot_uni16 scratch;
+/// The files are only reloaded if they were written since the last refresh,
+/// so a refresh (e.g. on each sys_resume()) costs nothing when they were not.
+    ot_u16  gen[3];
     vlFILE* fp;
 
+    gen[0]  = vl_generation(VL_ISF_BLOCKID, 0);
+    gen[1]  = vl_generation(VL_ISF_BLOCKID, 1);
+    gen[2]  = vl_generation(VL_ISF_BLOCKID, ISF_ID(real_time_scheduler));
+
     /// Open Network Features ISF and load the values from that file into the
     /// cached dll.netconf settings.
+    if ((dll_gen.valid == False) || (dll_gen.value[0] != gen[0])) {
+        fp = ISF_open_su(0);
+        vl_load(fp, 10, dll.netconf.vid);
+        dll.netconf.dd_flags    = 0;
+        dll.netconf.hold_limit  = PLATFORM_ENDIAN16(dll.netconf.hold_limit);
+        vl_close(fp);
+        m2np_flush();
+    }
 
-    fp = ISF_open_su(0);
-    vl_load(fp, 10, dll.netconf.vid);
-    dll.netconf.dd_flags    = 0;
-    dll.netconf.hold_limit  = PLATFORM_ENDIAN16(dll.netconf.hold_limit);
-    vl_close(fp);
+    if ((dll_gen.valid == False) || (dll_gen.value[1] != gen[1])) {
+        fp = ISF_open_su(1);
+        vl_load(fp, 8, dll.netconf.uid);
+        vl_close(fp);
+        m2np_flush();
+    }
 
-    fp = ISF_open_su(1);
-    vl_load(fp, 8, dll.netconf.uid);
-    vl_close(fp);
+    // Reset the Scheduler (only does anything if scheduler is implemented).
+    // It depends on the active settings from ISF 0 and on the RTS file.
+    if ((dll_gen.valid == False) || (dll_gen.value[0] != gen[0]) \
+                                 || (dll_gen.value[2] != gen[2])) {
+        dll_refresh_rts();
+    }
+
+    dll_gen.valid       = True;
+    dll_gen.value[0]    = gen[0];
+    dll_gen.value[1]    = gen[1];
+    dll_gen.value[2]    = gen[2];
 
-    // Reset the Scheduler (only does anything if scheduler is implemented)
-    dll_refresh_rts();
     sub_dll_flush();
 }
 #endif
@@ -260,40 +383,46 @@ OT_WEAK void dll_refresh(void) {
 #ifndef EXTF_dll_refresh_rts
 OT_WEAK void dll_refresh_rts(void) {
 #if (OT_FEATURE(CRON) && M2_FEATURE(RTC_SCHEDULER))
-///@todo need to update this implementation to also delete the old tasks.
-
+    static const ot_u8 task_id[3] = { HSS_INDEX, SSS_INDEX, BTS_INDEX };
+    ot_u16  sched_enable;
+    ot_u16  cursor;
+    ot_u8*  id;
     vlFILE* fp;
 
-    // Early exit if RTS is not active
-    if (dll.netconf.active_settings & M2_SET_SCHEDMASK) == 0)
+    // Remove any existing real-time schedules, then early exit if RTS is not
+    // active in the settings.
+    for (cursor=0; cursor<3; cursor++) {
+        otcron_deltask(&sys.task[task_id[cursor]]);
+    }
+    sched_enable = dll.netconf.active & M2_SET_SCHEDMASK;
+    if (sched_enable == 0) {
         return;
+    }
 
     // - open the real-time-schedule ISF
     // - make sure the file is there
     // - make sure the file has at least 12 bytes (this is how much DLL uses)
-    fp = ISF_open_su(ISF_ID_real_time_scheduler);
+    // - each 4 byte entry is a 16 bit time mask and a 16 bit time value.  The
+    //   upper 16 bits of the RTC are not matched, so the schedules recur.
+    fp = ISF_open_su(ISF_ID(real_time_scheduler));
     if (fp != NULL) {
-        if (fp->length < 12) {
-            static const ot_task task_fn[3] = { &dll_systask_holdscan,
-                                                &dll_systask_sleepscan,
-                                                &dll_systask_beacon };
-
-            ot_u16  sched_enable    = dll.netconf.active_settings & M2_SET_SCHEDMASK;
-            ot_u16  cursor          = 0;
-            ot_sigv* fn             = task_fn;
+        if (fp->length >= 12) {
+            cursor  = 0;
+            id      = (ot_u8*)task_id;
 
             // Apply Hold, Sleep, and Beacon RTS as specified in enabler bitmask
             while (sched_enable != 0) {
                 if (sched_enable & M2_SET_HOLDSCHED) {
-                    ot_u32 time_evt;
                     ot_u32 time_mask;
-                    time_evt    = vl_read(fp, cursor);
-                    time_mask   = 0xFFFF0000 | vl_read(fp, cursor+2);
-                    otcron_add(*fn, CRONTIME_absolute, time_evt, time_mask);
+                    ot_u32 time_evt;
+                    time_mask   = PLATFORM_ENDIAN16(vl_read(fp, cursor));
+                    time_evt    = PLATFORM_ENDIAN16(vl_read(fp, cursor+2));
+                    otcron_add(&sys.task[*id], CRONTIME_absolute, time_evt, time_mask);
                 }
-                fn++;
+                id++;
                 cursor         += 4;
                 sched_enable  <<= 1;
+                sched_enable   &= M2_SET_SCHEDMASK;
             }
         }
         vl_close(fp);
@@ -394,7 +523,7 @@ OT_WEAK void dll_response_applet(m2session* active) {
         ot_u8 substate = active->netstate & M2_NETSTATE_TMASK;
 
         if (substate == M2_NETSTATE_RESPTX) {
-            dll.comm.tc -= TI2CLK(rm2_pkt_duration(&txq));
+            dll.comm.tc -= MITI2CLK(rm2_pkt_airtime(&txq));
         }
         else if (substate == M2_NETSTATE_REQRX) {
             sys.task_HSS.cursor     = 0;
@@ -719,36 +848,39 @@ OT_WEAK void dll_systask_beacon(ot_task task) {
     }
 
     /// Load file-based beacon:
-    /// Open BTS ISF Element and read the beacon sequence.  Make sure there is
-    /// a beacon file of non-zero length and that beacons are presently enabled.
+    /// Reload the RAM copy of the BTS ISF if it was written since the last
+    /// beacon.  Make sure there is a beacon sequence of non-zero length and
+    /// that beacons are presently enabled.
     if (dll.netconf.dd_flags == 0) {
-        ot_u16  scratch;
-        vlFILE* fp;
+        ot_u16 gen;
 
-        fp = ISF_open_su( ISF_ID(beacon_transmit_sequence) );
-        if (fp == NULL) {
-            return; //goto dll_systask_beacon_STOP;
-        }
-        if (fp->length == 0)    {
+        gen = vl_generation(VL_ISF_BLOCKID, ISF_ID(beacon_transmit_sequence));
+        if ((dll_bts.valid == False) || (dll_bts.gen != gen)) {
+            vlFILE* fp;
+
+            fp = ISF_open_su( ISF_ID(beacon_transmit_sequence) );
+            if (fp == NULL) {
+                return; //goto dll_systask_beacon_STOP;
+            }
+            dll_bts.count   = vl_load(fp, sizeof(dll_bts.data), dll_bts.data) >> 3;
+            dll_bts.gen     = gen;
+            dll_bts.valid   = True;
             vl_close(fp);
+        }
+        if (dll_bts.count == 0) {
             return; //goto dll_systask_beacon_STOP;
         }
 
-        // a little hack
-        scratch     = fp->start;
-        fp->start  += task->cursor;
-
         /// Beacon List Management:
-        /// <LI> Move cursor onto next beacon period (above, +8)</LI>
-        /// <LI> Loop cursor if it is past the length of the list </LI>
-        /// <LI> In special case where cursor = 254, everything still works! </LI>
-        task->cursor   += 8;
-        task->cursor    = (task->cursor >= fp->length) ? 0 : task->cursor;
-
-        // Load next beacon into btemp, then undo the start hack, then close
-        vl_load(fp, 8, dll.netconf.btemp);
-        fp->start = scratch;
-        vl_close(fp);
+        /// <LI> Cursor is the index of the beacon in the RAM sequence </LI>
+        /// <LI> Loop cursor if it is past the end of the list, which also
+        ///      covers a sequence that has gotten shorter since the last beacon </LI>
+        /// <LI> Copy the beacon into btemp and move cursor onto the next one </LI>
+        if (task->cursor >= dll_bts.count) {
+            task->cursor = 0;
+        }
+        memcpy(dll.netconf.btemp, &dll_bts.data[task->cursor << 3], 8);
+        task->cursor++;
     }
 
     // First 2 bytes: Chan ID, Cmd Code
@@ -1031,12 +1163,13 @@ OT_WEAK void dll_rfevt_frx(ot_int pcode, ot_int fcode) {
         }
     }
 
-    // Multiframe packet RX frame check
+    // Multiframe packet RX frame check: mark damaged frames, which stay in
+    // the packet, and wait for the last frame.
 #   if (M2_FEATURE(M2DP) == ENABLED)
     else if (pcode > 0) {
         __DEBUG_ERRCODE_EVAL(=112);
     	if (fcode != 0) {
-    		m2dp_mark_frame();
+    		network_mark_ff();
     	}
     	return;
     }
@@ -1050,6 +1183,11 @@ OT_WEAK void dll_rfevt_frx(ot_int pcode, ot_int fcode) {
     	if (fcode != 0) {
     		frx_code = -1;
     	}
+#       if (M2_FEATURE(M2DP) == ENABLED)
+        else if (rxq.front[1] & M2LC_DMGMARK) {
+            frx_code = -1;      // First frame of multiframe packet is damaged
+        }
+#       endif
         else if (rm2_mac_filter() == False) {
             frx_code = -4;
         }
@@ -1104,6 +1242,9 @@ OT_WEAK void dll_rfevt_txcsma(ot_int pcode, ot_int tcode) {
     /// ON CSMA SUCCESS: pcode == 0, tcode == 1/0 for BG/FG
     if (pcode == 0) {
         __DEBUG_ERRCODE_EVAL(=121);
+        if ((dll.comm.csmaca_params & M2_CSMACA_NOCSMA) == 0) {
+            sub_ccalog(False);
+        }
         sys.task_RFA.latency    = 0;
         sys.task_RFA.event      = 5;
         
@@ -1126,6 +1267,7 @@ OT_WEAK void dll_rfevt_txcsma(ot_int pcode, ot_int tcode) {
         ot_uint nextcsma;
         __DEBUG_ERRCODE_EVAL(=122);
 
+        sub_ccalog(True);
         nextcsma                    = (ot_uint)sub_fcloop();
         if (nextcsma < TI2CLK(2))   radio_idle();
         else                        radio_sleep();
@@ -1251,9 +1393,9 @@ OT_WEAK void dll_rfevt_ftx(ot_int pcode, ot_int scratch) {
     m2session* active;
     __DEBUG_ERRCODE_EVAL(=140);
 
-    /// Non-final frame TX'ed in multiframe packet
+    /// Non-final frame TX'ed in multiframe packet.  The radio driver moves
+    /// on to the next frame by itself, so there is nothing to do.
     if (pcode == 1) {
-        ///@todo possibly put the queue rearrangement here
     }
 
     /// Packet TX is done.  Handle this event and pre-empt the kernel.
@@ -1391,7 +1533,8 @@ OT_WEAK void dll_set_defaults(m2session* s_active) {
 void sub_csma_scramble(void) {
 /// Sort of optional: Go through the channel list and scramble the channel
 /// entries randomly in order to improve band utilization, as multiple devices
-/// will scramble the list differently.
+/// will scramble the list differently.  Then, if occupancy is tracked, sort
+/// the list by it (stable, so channels of equal occupancy stay scrambled).
     ot_u8 txchans = dll.comm.tx_channels - 1;
 
     if (txchans) {
@@ -1414,10 +1557,104 @@ void sub_csma_scramble(void) {
             rot.ushort    >>= 1;
         }
     }
+#   if (M2_PARAM(CCASTATS) > 0)
+    if (txchans) {
+        ot_u8 key[8];
+        ot_u8 i, j, n, chan;
+
+        /// Key: busy in the high nibble, RSSI in 8dB steps above -140 dBm in
+        /// the low nibble.  Lists longer than 8 are only sorted in the front.
+        n = (txchans < 8) ? (txchans+1) : 8;
+        for (i=0; i<n; i++) {
+            dll_ccastat* stat = sub_ccastat(dll.comm.tx_chanlist[i], False);
+            key[i] = 0;
+            if (stat != NULL) {
+                ot_int rssi = (stat->rssi + 140) >> 3;
+                rssi        = (rssi < 0) ? 0 : ((rssi > 15) ? 15 : rssi);
+                key[i]      = (stat->busy & 0xF0) | (ot_u8)rssi;
+            }
+        }
+        for (i=1; i<n; i++) {
+            chan = dll.comm.tx_chanlist[i];
+            for (j=i; (j>0) && (key[j-1] > key[j]); j--) {
+                ot_u8 scratch               = key[j];
+                key[j]                      = key[j-1];
+                key[j-1]                    = scratch;
+                dll.comm.tx_chanlist[j]     = dll.comm.tx_chanlist[j-1];
+                dll.comm.tx_chanlist[j-1]   = chan;
+            }
+        }
+    }
+#   endif
 }
 
 
 
+#if (M2_PARAM(CCASTATS) > 0)
+dll_ccastat* sub_ccastat(ot_u8 channel, ot_bool add) {
+    dll_ccastat* stat;
+    ot_u8 i;
+
+    channel &= 0x7F;
+    for (i=0; i<M2_PARAM(CCASTATS); i++) {
+        if (dll_cca.entry[i].channel == channel) {
+            return &dll_cca.entry[i];
+        }
+    }
+    if ((add == False) || (channel == 0)) {
+        return NULL;
+    }
+
+    stat            = &dll_cca.entry[dll_cca.next];
+    dll_cca.next    = (dll_cca.next + 1) % M2_PARAM(CCASTATS);
+    stat->channel   = channel;
+    stat->busy      = 0;
+    stat->rssi      = -140;
+    return stat;
+}
+#endif
+
+
+
+void sub_ccalog(ot_bool fail) {
+#if (M2_PARAM(CCASTATS) > 0)
+/// EWMAs with weight 1/4 for the newest sample
+    dll_ccastat* stat;
+    stat = sub_ccastat(phymac[0].channel, True);
+
+    if (stat != NULL) {
+        if (fail) {
+            stat->busy += (255 - stat->busy) >> 2;
+            stat->rssi += (radio_rssi() - stat->rssi) / 4;
+        }
+        else {
+            stat->busy -= stat->busy >> 2;
+        }
+    }
+#endif
+}
+
+
+
+CLK_UNIT sub_ccajitter(CLK_UNIT step) {
+#if (M2_PARAM(CCASTATS) > 0)
+    dll_ccastat* stat;
+    ot_u32 span;
+
+    stat = sub_ccastat(phymac[0].channel, False);
+    if (stat != NULL) {
+        span = ((ot_u32)step * stat->busy) >> 7;
+        if (span != 0) {
+            return (CLK_UNIT)(rand_prn16() % span);
+        }
+    }
+#endif
+    return 0;
+}
+
+
+
+
 
 CLK_UNIT sub_fcinit(void) {
 /// Pick a time offset to begin the first transmission attempt, and setup
@@ -1426,17 +1663,23 @@ CLK_UNIT sub_fcinit(void) {
     // Scramble the CSMA channel list
     sub_csma_scramble();
 
+    // The query score only applies to the response to that query
+    if ((session_top()->netstate & M2_NETSTATE_RESP) == 0) {
+        dll_fcrank = 0;
+    }
+
     // Pick a slot offset: currently only RIGD and RAIND need a random slot.
     // {0,1,2,3} = {RIGD, RAIND, AIND, Default MAC CA}
     if (dll.comm.csmaca_params & M2_CSMACA_AIND) {
         return 0;
     }
 
+    // RAIND: the slot must leave room for the packet inside Tc.  If it does
+    // not fit, there is no room to randomize, so TX starts right away.
     if (dll.comm.csmaca_params & M2_CSMACA_RAIND) {
-        CLK_UNIT random;
-        random  = TI2CLK(rand_prn16());
-        random %= (dll.comm.tc - TI2CLK(rm2_pkt_duration(&txq)) );
-        return random;
+        ot_long window;
+        window = dll.comm.tc - MITI2CLK(rm2_pkt_airtime(&txq));
+        return sub_fcslot((window > 0) ? (CLK_UNIT)window : 0);
     }
 
     return sub_rigd_newslot();
@@ -1446,10 +1689,44 @@ CLK_UNIT sub_fcinit(void) {
 
 
 void sub_fceval(ot_int query_score) {
-/// @todo When M2QP returns zero, the query has succeeded with no priorities.
-/// Some queries have priority scores.  In these cases, higher scores may be
-/// used to affect CSMA-CA reply ordering (higher is better).  This feature is
-/// not yet implemented.
+/// When M2QP returns zero, the query has succeeded with no priorities, and the
+/// whole contention period is used.  Otherwise, rank = 1 + log2(score).
+    dll_fcrank = 0;
+#   if (M2_PARAM(SCOREBANDS) > 1)
+    while ((query_score > 0) && (dll_fcrank < M2_PARAM(SCOREBANDS))) {
+        dll_fcrank++;
+        query_score >>= 1;
+    }
+#   endif
+}
+
+
+
+
+CLK_UNIT sub_fcslot(CLK_UNIT window) {
+    CLK_UNIT random;
+
+    if (window <= 0) {
+        return 0;
+    }
+    random = TI2CLK(rand_prn16());
+
+#   if (M2_PARAM(SCOREBANDS) > 1)
+    /// Band 0 (the earliest) is for the highest rank.  Each band is half the
+    /// width of the one after it, except that band 0 and band 1 are the same
+    /// width.  Each higher rank is about half as common as the one below it,
+    /// so this keeps the density of responses even through the window.
+    if (dll_fcrank != 0) {
+        CLK_UNIT start;
+        ot_u8    k;
+        k       = M2_PARAM(SCOREBANDS) - dll_fcrank;
+        window  = window >> ((k == 0) ? (M2_PARAM(SCOREBANDS)-1) : (M2_PARAM(SCOREBANDS)-k));
+        start   = (k == 0) ? 0 : window;
+        return (window == 0) ? start : (start + (random % window));
+    }
+#   endif
+
+    return random % window;
 }
 
 
@@ -1462,9 +1739,14 @@ CLK_UNIT sub_fcloop(void) {
         return TI2CLK(phymac[0].tg);
     }
 
-    // AIND & RAIND Loop
+    // AIND & RAIND Loop: RAIND gets extra backoff on busy channels
     if (dll.comm.csmaca_params & 0x18) {    //RAIND, AIND
-        return TI2CLK(rm2_pkt_duration(&txq));
+        CLK_UNIT wait;
+        wait = MITI2CLK(rm2_pkt_airtime(&txq));
+        if (dll.comm.csmaca_params & M2_CSMACA_RAIND) {
+            wait += sub_ccajitter(wait);
+        }
+        return wait;
     }
 
     // RIGD loop
@@ -1484,7 +1766,7 @@ CLK_UNIT sub_rigd_newslot(void) {
     dll.comm.tc >>= 1;
     if (dll.comm.tc == 0)   return 0;
 
-    return (TI2CLK(rand_prn16()) % (CLK_UNIT)dll.comm.tc);
+    return sub_fcslot((CLK_UNIT)dll.comm.tc);
 }
 
 
@@ -1502,7 +1784,7 @@ CLK_UNIT sub_rigd_nextslot() {
 
 CLK_UNIT sub_aind_nextslot() {
 /// Works for RAIND or AIND next slot
-    return TI2CLK(rm2_pkt_duration(&txq));
+    return MITI2CLK(rm2_pkt_airtime(&txq));
 }
 */
 
@@ -32,6 +32,7 @@
 
 #include <otlib/crc16.h>
 #include <otlib/buffers.h>
+#include <otlib/memcpy.h>
 
 #include <platform/config.h>
 
@@ -112,57 +113,427 @@ ot_u8 em2_check_crc5() {
   * RS coding does not alter the original data, it just appends a block of
   * "checksum" data to the end of the frame.  Therefore, a device without RS
   * coding enabled can receive and decode a frame using RS coding simply by
-  * discarding (or ignoring) the extra block.
+  * discarding (or ignoring) the extra block, which is what the functions below
+  * do when M2_FEATURE_RSCODE is not enabled.
   *
-  * RS coding is not presently available in the open-source distribution of
-  * OpenTag.  The functions below are stub functions, effectively, which just
-  * discard the RS code-block as described above.  If you wish to use RS coding
-  * with your OpenTag-based design, a non-open-source module for RS coding is
-  * maintained by Haystack Technologies (www.haystacktechnologies.com).  Or,
-  * you could try implementing it yourself, as the specification is freely
-  * available on wiki.indigresso.com
+  * The frame is one shortened RS codeword over GF(256): the message is the
+  * whole frame including CRC16, and em2_rs_paritylength() gives the number of
+  * parity bytes (2t), so up to t byte errors can be corrected.  The field and
+  * generator are described with RS_GFPOLY in /include/m2/encode.h.
+  *
+  * Both sides are streamed like the CRC.  The encoder runs the message through
+  * the parity register as it is loaded, and writes the parity into txq right
+  * after the message, before it is read.  The decoder updates the syndromes as
+  * bytes are received, so at the end of the frame they are already done, and
+  * em2_rs_postprocess() only has work to do when the CRC fails.
   */
 #if (M2_FEATURE(RSCODE))
 #   define RS_ENCODE_1BYTE()    if (em2.lctl & 0x40) em2_rs_encode(1)
-#   define RS_DECODE_1BYTE()    if (em2.lctl & 0x40) em2_rs_encode(1)
+#   define RS_DECODE_1BYTE()    if (em2.lctl & 0x40) em2_rs_decode(1)
+#   define RS_ENCODE_NBYTES(N)  if (em2.lctl & 0x40) em2_rs_encode(N)
+#   define RS_DECODE_NBYTES(N)  if (em2.lctl & 0x40) em2_rs_decode(N)
 #   define RS_DECODE_START()    do { \
                                     if ((em2.crc5 == 0) && (em2.lctl & 0x40)) { \
                                         em2_rs_init_decode(&rxq); \
-                                        em2_rs_encode(2);   \
+                                        em2_rs_decode(2);   \
                                 }   } while (0)
 #else
 #   define RS_ENCODE_1BYTE();
 #   define RS_DECODE_1BYTE();
+#   define RS_ENCODE_NBYTES(N);
+#   define RS_DECODE_NBYTES(N);
 #   define RS_DECODE_START();
 
 #endif
 
+
+
+#ifndef EXTF_em2_rs_paritylength
+OT_WEAK ot_int em2_rs_paritylength(ot_int msg_length) {
+    return 4 + (((msg_length + 13) / 18) << 1);
+}
+#endif
+
+
+static ot_int sub_rs_framepar(ot_int frame_bytes) {
+/// Parity bytes in a frame of this many bytes (the frame length byte + 1).
+/// em2_rs_paritylength() goes by the message length, so the parity is the
+/// smallest value that fits with what is left.
+    ot_int parity = 4;
+    while ( (parity < frame_bytes) \
+         && (em2_rs_paritylength(frame_bytes - parity) > parity) ) {
+        parity += 2;
+    }
+    return parity;
+}
+
+
+
+#if (M2_FEATURE(RSCODE))
+/** GF(256) antilog and log tables, for RS_GFPOLY = 0x11D and alpha = 2
+  * gf_exp[] holds two periods, so the sum of two logs needs no modulo.
+  * gf_log[0] is 0xFF, which is not a log of anything.
+  */
+static const ot_u8 gf_exp[510] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26,
+    0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0,
+    0x9D, 0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+    0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1,
+    0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0,
+    0xFD, 0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+    0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE,
+    0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC,
+    0x85, 0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+    0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73,
+    0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF,
+    0xE3, 0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+    0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6,
+    0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09,
+    0x12, 0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+    0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E, 0x01,
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26, 0x4C,
+    0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x9D,
+    0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23, 0x46,
+    0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1, 0x5F,
+    0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0, 0xFD,
+    0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2, 0xD9,
+    0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE, 0x81,
+    0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC, 0x85,
+    0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54, 0xA8,
+    0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73, 0xE6,
+    0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF, 0xE3,
+    0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41, 0x82,
+    0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6, 0x51,
+    0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09, 0x12,
+    0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16, 0x2C,
+    0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E
+};
+
+static const ot_u8 gf_log[256] = {
+    0xFF, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE, 0x1B, 0x68, 0xC7, 0x4B,
+    0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81, 0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71,
+    0x05, 0x8A, 0x65, 0x2F, 0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+    0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78, 0x4D, 0xE4, 0x72, 0xA6,
+    0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD, 0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88,
+    0x36, 0xD0, 0x94, 0xCE, 0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+    0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54, 0xFA, 0x85, 0xBA, 0x3D,
+    0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B, 0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57,
+    0x07, 0x70, 0xC0, 0xF7, 0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+    0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9, 0x23, 0x20, 0x89, 0x2E,
+    0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD, 0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61,
+    0xF2, 0x56, 0xD3, 0xAB, 0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+    0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC, 0x7F, 0x0C, 0x6F, 0xF6,
+    0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA, 0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A,
+    0xCB, 0x59, 0x5F, 0xB0, 0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+    0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA, 0xA8, 0x50, 0x58, 0xAF
+};
+
+/** RS coding state
+  * reg[] is the parity register while encoding and the syndromes while
+  * decoding.  gen[] holds the logs of the generator coefficients, highest
+  * degree first and without the leading 1, for gen_parity parity bytes.
+  */
+typedef struct {
+    ot_u8*  cursor;
+    ot_int  count;
+    ot_int  length;
+    ot_int  parity;
+    ot_bool writeout;
+    ot_int  gen_parity;
+    ot_u8   reg[RS_MAXPARITY];
+    ot_u8   gen[RS_MAXPARITY];
+} rs_struct;
+
+static rs_struct rs;
+
+
+static ot_u8 sub_gf_mul(ot_u8 a, ot_u8 b) {
+    if ((a == 0) || (b == 0)) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+
+static void sub_rs_generator(ot_int parity) {
+/// g(x) = (x + a^0)(x + a^1)...(x + a^(parity-1)), built up one root at a time.
+/// It only changes with the parity length, so it is kept for the next frame.
+    ot_u8   g[RS_MAXPARITY+1];
+    ot_int  i, j;
+
+    if (rs.gen_parity == parity) {
+        return;
+    }
+    g[0] = 1;
+    for (j=0; j<parity; j++) {
+        g[j+1] = g[j];
+        for (i=j; i>0; i--) {
+            g[i] = g[i-1] ^ sub_gf_mul(g[i], gf_exp[j]);
+        }
+        g[0] = sub_gf_mul(g[0], gf_exp[j]);
+    }
+    for (i=0; i<parity; i++) {
+        rs.gen[i] = gf_log[g[parity-1-i]];
+    }
+    rs.gen_parity = parity;
+}
+
+
+#ifndef EXTF_em2_rs_init_encode
+OT_WEAK ot_int em2_rs_init_encode(ot_queue* q) {
+/// The message is everything from the cursor on, with space for the CRC16
+    rs.cursor   = q->getcursor;
+    rs.count    = q_span(q);
+    rs.length   = rs.count;
+    rs.parity   = em2_rs_paritylength(rs.count);
+    rs.writeout = True;
+    memset(rs.reg, 0, sizeof(rs.reg));
+    sub_rs_generator(rs.parity);
+    return rs.parity;
+}
+#endif
+
+
+#ifndef EXTF_em2_rs_encode
+OT_WEAK void em2_rs_encode(ot_int n_bytes) {
+    ot_int  i;
+    ot_int  last;
+
+    if (n_bytes > rs.count) {
+        n_bytes = rs.count;
+    }
+    rs.count   -= n_bytes;
+    last        = rs.parity - 1;
+
+    /// Parity register: the remainder of message * x^parity over g(x)
+    while (--n_bytes >= 0) {
+        ot_u8 fb;
+        fb = *rs.cursor++ ^ rs.reg[0];
+        for (i=0; i<last; i++) {
+            rs.reg[i] = rs.reg[i+1];
+        }
+        rs.reg[last] = 0;
+
+        if (fb != 0) {
+            ot_u8 fb_log = gf_log[fb];
+            for (i=0; i<=last; i++) {
+                if (rs.gen[i] != 0xFF) {
+                    rs.reg[i] ^= gf_exp[fb_log + rs.gen[i]];
+                }
+            }
+        }
+    }
+
+    /// The parity goes right after the message, before it is read out
+    if ((rs.count == 0) && rs.writeout) {
+        rs.writeout = False;
+        memcpy(rs.cursor, rs.reg, rs.parity);
+        rs.cursor  += rs.parity;
+    }
+}
+#endif
+
+
 #ifndef EXTF_em2_rs_init_decode
 OT_WEAK ot_int em2_rs_init_decode(ot_queue* q) {
-    return -1;
+/// The codeword is the whole frame, as given by its length byte
+    rs.cursor   = q->front;
+    rs.length   = (ot_int)q->front[0] + 1;
+    rs.count    = rs.length;
+    rs.parity   = sub_rs_framepar(rs.length);
+    rs.writeout = False;
+    memset(rs.reg, 0, sizeof(rs.reg));
+    return rs.parity;
 }
 #endif
 
+
 #ifndef EXTF_em2_rs_decode
 OT_WEAK void em2_rs_decode(ot_int n_bytes) {
+    if (n_bytes > rs.count) {
+        n_bytes = rs.count;
+    }
+    if (n_bytes > 0) {
+        rs.count -= n_bytes;
+        em2_rs_syndrome(rs.reg, rs.parity, rs.cursor, n_bytes);
+        rs.cursor += n_bytes;
+    }
+}
+#endif
+
+
+#ifndef EXTF_em2_rs_syndrome
+OT_WEAK void em2_rs_syndrome(ot_u8* syndrome, ot_int parity, ot_u8* data, ot_int length) {
+/// Horner's rule on each syndrome: S[j] = S[j]*a^j + byte
+    ot_int j;
+    while (--length >= 0) {
+        ot_u8 r = *data++;
+        for (j=0; j<parity; j++) {
+            ot_u8 s = syndrome[j];
+            syndrome[j] = (s == 0) ? r : (r ^ gf_exp[gf_log[s] + j]);
+        }
+    }
 }
 #endif
 
+
 #ifndef EXTF_em2_rs_check
 OT_WEAK ot_int em2_rs_check(void) {
-    return -1;
+    ot_int j;
+    if (rs.count != 0) {
+        return -1;
+    }
+    for (j=0; j<rs.parity; j++) {
+        if (rs.reg[j] != 0) {
+            return 1;
+        }
+    }
+    return 0;
 }
 #endif
 
+
 #ifndef EXTF_em2_rs_postprocess
 OT_WEAK ot_int em2_rs_postprocess(void) {
-    return 0;
+/// Berlekamp-Massey finds the error locator L(x) from the syndromes, a Chien
+/// search finds the error positions as the roots of L(x), and Forney gives
+/// the error values from the evaluator W(x) = S(x)L(x) mod x^parity.  The
+/// codeword is shortened, so a root outside the frame means it cannot be
+/// corrected.
+    ot_u8   lambda[RS_MAXPARITY+1];
+    ot_u8   prev[RS_MAXPARITY+1];
+    ot_u8   omega[RS_MAXPARITY];
+    ot_u8*  codeword;
+    ot_u8   b;
+    ot_int  L, m, n, i, k;
+    ot_int  found;
+
+    k = em2_rs_check();
+    if (k <= 0) {
+        return k;
+    }
+
+    /// 1. Berlekamp-Massey
+    memset(lambda, 0, sizeof(lambda));
+    memset(prev, 0, sizeof(prev));
+    lambda[0]   = 1;
+    prev[0]     = 1;
+    L           = 0;
+    m           = 1;
+    b           = 1;
+    for (n=0; n<rs.parity; n++) {
+        ot_u8 d = rs.reg[n];
+        for (i=1; i<=L; i++) {
+            d ^= sub_gf_mul(lambda[i], rs.reg[n-i]);
+        }
+        if (d == 0) {
+            m++;
+        }
+        else {
+            ot_u8   t[RS_MAXPARITY+1];
+            ot_u8   coef_log;
+            coef_log = (ot_u8)((gf_log[d] + 255 - gf_log[b]) % 255);
+            memcpy(t, lambda, sizeof(t));
+            for (i=0; (i+m)<=rs.parity; i++) {
+                if (prev[i] != 0) {
+                    lambda[i+m] ^= gf_exp[coef_log + gf_log[prev[i]]];
+                }
+            }
+            if ((L << 1) <= n) {
+                L = n + 1 - L;
+                memcpy(prev, t, sizeof(prev));
+                b = d;
+                m = 1;
+            }
+            else {
+                m++;
+            }
+        }
+    }
+    if ((L << 1) > rs.parity) {
+        return -1;
+    }
+
+    /// 2. Error evaluator W(x) = S(x)L(x) mod x^parity
+    for (n=0; n<rs.parity; n++) {
+        ot_u8 w = 0;
+        for (i=0; (i<=L) && (i<=n); i++) {
+            w ^= sub_gf_mul(lambda[i], rs.reg[n-i]);
+        }
+        omega[n] = w;
+    }
+
+    /// 3. Chien search and Forney, byte by byte.  The byte at offset i is the
+    ///    coefficient of x^e, e = length-1-i, and it is in error if L(x) has
+    ///    a root at a^-e.  Its error value is X*W(1/X)/L'(1/X), with X = a^e.
+    codeword    = rs.cursor - rs.length;
+    found       = 0;
+    for (i=0; i<rs.length; i++) {
+        ot_int  e, inv;
+        ot_u8   sum, num, den;
+        e       = rs.length - 1 - i;
+        inv     = (255 - e) % 255;
+
+        sum = 0;
+        den = 0;
+        for (k=0; k<=L; k++) {
+            if (lambda[k] != 0) {
+                ot_u8 term = gf_exp[(gf_log[lambda[k]] + (k * inv)) % 255];
+                sum ^= term;
+                if (k & 1) {
+                    den ^= term;        // k*lambda[k]*x^(k-1), times x
+                }
+            }
+        }
+        if (sum != 0) {
+            continue;
+        }
+
+        /// den is X^-1 * L'(X^-1) so far; the error value is W(X^-1)/den
+        num = 0;
+        for (k=0; k<rs.parity; k++) {
+            if (omega[k] != 0) {
+                num ^= gf_exp[(gf_log[omega[k]] + (k * inv)) % 255];
+            }
+        }
+        if ((den == 0) || (i == 0)) {
+            return -1;                  // Bad locator, or the length byte
+        }
+        if (num != 0) {
+            codeword[i] ^= gf_exp[gf_log[num] + 255 - gf_log[den]];
+        }
+        found++;
+    }
+
+    return (found == L) ? L : -1;
 }
 #endif
 
-#ifndef EXTF_em2_rs_paritylength
-OT_WEAK ot_int em2_rs_paritylength(ot_int msg_length) {
-    return 4 + (((msg_length + 13) / 18) << 1);
+
+#else
+/// Without RS coding, a frame with RS coding can still be received: the
+/// parity is left out of the CRC and stripped from the frame.
+
+#ifndef EXTF_em2_rs_init_decode
+OT_WEAK ot_int em2_rs_init_decode(ot_queue* q) {
+    return sub_rs_framepar((ot_int)q->front[0] + 1);
+}
+#endif
+
+#ifndef EXTF_em2_rs_decode
+OT_WEAK void em2_rs_decode(ot_int n_bytes) {
+}
+#endif
+
+#ifndef EXTF_em2_rs_check
+OT_WEAK ot_int em2_rs_check(void) {
+    return -1;
+}
+#endif
+
+#ifndef EXTF_em2_rs_postprocess
+OT_WEAK ot_int em2_rs_postprocess(void) {
+    return -1;
 }
 #endif
 
@@ -177,6 +548,9 @@ OT_WEAK void em2_rs_encode(ot_int n_bytes) {
 }
 #endif
 
+#endif
+
+
 #ifndef EXTF_em2_rs_interleave
 OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
     while (numbytes < 0) {
@@ -214,27 +588,46 @@ OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
 
 #   if !defined(EXTF_em2_encode_data_HW)
     OT_WEAK void em2_encode_data_HW() {
-        while ( (em2.bytes > 0) && radio_txopen() ) {
-            em2.bytes--;
-            RS_ENCODE_1BYTE();
-            radio_putbyte( q_readbyte(&txq) );
+    /// Load as much of the frame as the radio can take, in one burst
+        ot_int n;
+        n = radio_txspan();
+        if (n > em2.bytes) {
+            n = em2.bytes;
+        }
+        if (n > 0) {
+            RS_ENCODE_NBYTES(n);
+            radio_putbytes(txq.getcursor, n);
+            txq.getcursor  += n;
+            em2.bytes      -= n;
         }
     }
 #   endif
 
 #   if !defined(EXTF_em2_decode_data_HW)
     OT_WEAK void em2_decode_data_HW() {
-        while ( (em2.bytes > 0) && radio_rxopen() ) {
-            em2.bytes--;
-            q_writebyte(&rxq, radio_getbyte() );
-            if (em2.state-- == 0) {
-                em2.bytes   = (ot_int)rxq.front[0];
-                em2.crc5    = em2_check_crc5();
-                em2.lctl    = rxq.front[1];
-                RS_DECODE_START();
+    /// Take all the bytes the radio has, in one burst.  While the header is
+    /// incomplete, only take up to the end of it.
+        ot_int n, limit;
+        while ( (em2.bytes > 0) && ((n = radio_rxspan()) > 0) ) {
+            limit = (em2.state >= 0) ? (em2.state + 1) : em2.bytes;
+            if (n > limit) {
+                n = limit;
+            }
+            radio_getbytes(rxq.putcursor, n);
+            rxq.putcursor  += n;
+            em2.bytes      -= n;
+
+            if (em2.state >= 0) {
+                em2.state -= n;
+                if (em2.state < 0) {
+                    em2.bytes   = (ot_int)rxq.front[0] - 1;         // Bytes remaining
+                    em2.crc5    = em2_check_crc5();
+                    em2.lctl    = rxq.front[1];
+                    RS_DECODE_START();
+                }
             }
             else {
-                RS_DECODE_1BYTE();
+                RS_DECODE_NBYTES(n);
             }
         }
     }
@@ -255,23 +648,44 @@ OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
 
 #   if !defined(EXTF_em2_encode_data_HWCRC)
     OT_WEAK void em2_encode_data_HWCRC() {
-        while ( (em2.bytes > 0) && radio_txopen() ) {
-            crc_calc_stream(&em2.crc);
-            RS_ENCODE_1BYTE();
-            radio_putbyte( q_readbyte(&txq) );
-            em2.bytes--;
+    /// Load as much of the frame as the radio can take, in one burst.  The
+    /// CRC is run ahead over the burst, so at the end of the frame it is
+    /// written into txq before it is loaded.
+        ot_int n, k;
+        n = radio_txspan();
+        if (n > em2.bytes) {
+            n = em2.bytes;
+        }
+        if (n > 0) {
+            k = (ot_int)((txq.getcursor + n) - em2.crc.cursor);
+            if (k > 0) {
+                crc_calc_nstream(&em2.crc, (ot_u16)k);
+            }
+            RS_ENCODE_NBYTES(n);
+            radio_putbytes(txq.getcursor, n);
+            txq.getcursor  += n;
+            em2.bytes      -= n;
         }
     }
 #   endif
 
 #   if !defined(EXTF_em2_decode_data_HWCRC)
     OT_WEAK void em2_decode_data_HWCRC() {
-        while ( (em2.bytes > 0) && radio_rxopen()) {
-            em2.bytes--;
-            q_writebyte(&rxq, radio_getbyte() );
+    /// Take all the bytes the radio has (only up to the end of the header while
+    /// the header is incomplete), and CRC them as a block.
+        ot_int n, limit;
+        while ( (em2.bytes > 0) && ((n = radio_rxspan()) > 0) ) {
+            limit = (em2.state >= 0) ? (em2.state + 1) : em2.bytes;
+            if (n > limit) {
+                n = limit;
+            }
+            radio_getbytes(rxq.putcursor, n);
+            rxq.putcursor  += n;
+            em2.bytes      -= n;
 
             if (em2.state >= 0) {
-                if (--em2.state < 0) {
+                em2.state -= n;
+                if (em2.state < 0) {
                     ot_int ext_bytes;
                     em2.bytes   = (ot_int)rxq.front[0] - 1;         // Bytes remaining
                     em2.crc5    = em2_check_crc5();
@@ -279,16 +693,16 @@ OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
                     ext_bytes   = 2;                                // CRC bytes
 
                     if (em2.lctl & 0x40) {
-                        ext_bytes -= rs_init_decode(&rxq);
-                        rs_decode(2);
+                        ext_bytes -= em2_rs_init_decode(&rxq);
+                        em2_rs_decode(2);
                     }
                     crc_init_stream(&em2.crc, False, em2.bytes + ext_bytes, rxq.front);    // Total bytes
                     crc_calc_nstream(&em2.crc, 2);
                 }
             }
             else {
-                RS_DECODE_1BYTE();
-                crc_calc_stream(&em2.crc);
+                RS_DECODE_NBYTES(n);
+                crc_calc_nstream(&em2.crc, (ot_u16)n);
             }
         }
     }
@@ -313,34 +727,96 @@ OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
   */
 
 #if ( (RF_FEATURE(PN9) != ENABLED) || (M2_FEATURE(FEC) && (RF_FEATURE_FEC != ENABLED)) )
-    void init_PN9() { em2.PN9_lfsr.ushort = 0x01FF; }
-    ot_u8 get_PN9() { return em2.PN9_lfsr.ubyte[LOWER]; }
-
-    void rotate_PN9() {
-    /// Nibble-wise PN9 implementation.  Runs pretty fast, no table.
-#       define PN9reg       em2.PN9_lfsr.ushort
-
-        ot_u16 x;
-        x           = (PN9reg << 5) ^ PN9reg;
-        x          &= 0x01E0;
-        PN9reg    >>= 4;
-        PN9reg     |= x;
-        x           = (PN9reg << 5) ^ PN9reg;
-        x          &= 0x01E0;
-        PN9reg    >>= 4;
-        PN9reg     |= x;
+/** PN9 keystream, starting from the 0x1FF seed
+  * A frame is at most 256 bytes, and every frame starts the sequence over, so
+  * 256 bytes of it are all that is ever used.  The union keeps it aligned for
+  * word-wide XOR.
+  */
+static const union {
+    ot_u8   byte[256];
+    ot_u32  word[256/sizeof(ot_u32)];
+} PN9table = { {
+    0xFF, 0xE1, 0x1D, 0x9A, 0xED, 0x85, 0x33, 0x24, 0xEA, 0x7A, 0xD2, 0x39, 0x70, 0x97, 0x57, 0x0A,
+    0x54, 0x7D, 0x2D, 0xD8, 0x6D, 0x0D, 0xBA, 0x8F, 0x67, 0x59, 0xC7, 0xA2, 0xBF, 0x34, 0xCA, 0x18,
+    0x30, 0x53, 0x93, 0xDF, 0x92, 0xEC, 0xA7, 0x15, 0x8A, 0xDC, 0xF4, 0x86, 0x55, 0x4E, 0x18, 0x21,
+    0x40, 0xC4, 0xC4, 0xD5, 0xC6, 0x91, 0x8A, 0xCD, 0xE7, 0xD1, 0x4E, 0x09, 0x32, 0x17, 0xDF, 0x83,
+    0xFF, 0xF0, 0x0E, 0xCD, 0xF6, 0xC2, 0x19, 0x12, 0x75, 0x3D, 0xE9, 0x1C, 0xB8, 0xCB, 0x2B, 0x05,
+    0xAA, 0xBE, 0x16, 0xEC, 0xB6, 0x06, 0xDD, 0xC7, 0xB3, 0xAC, 0x63, 0xD1, 0x5F, 0x1A, 0x65, 0x0C,
+    0x98, 0xA9, 0xC9, 0x6F, 0x49, 0xF6, 0xD3, 0x0A, 0x45, 0x6E, 0x7A, 0xC3, 0x2A, 0x27, 0x8C, 0x10,
+    0x20, 0x62, 0xE2, 0x6A, 0xE3, 0x48, 0xC5, 0xE6, 0xF3, 0x68, 0xA7, 0x04, 0x99, 0x8B, 0xEF, 0xC1,
+    0x7F, 0x78, 0x87, 0x66, 0x7B, 0xE1, 0x0C, 0x89, 0xBA, 0x9E, 0x74, 0x0E, 0xDC, 0xE5, 0x95, 0x02,
+    0x55, 0x5F, 0x0B, 0x76, 0x5B, 0x83, 0xEE, 0xE3, 0x59, 0xD6, 0xB1, 0xE8, 0x2F, 0x8D, 0x32, 0x06,
+    0xCC, 0xD4, 0xE4, 0xB7, 0x24, 0xFB, 0x69, 0x85, 0x22, 0x37, 0xBD, 0x61, 0x95, 0x13, 0x46, 0x08,
+    0x10, 0x31, 0x71, 0xB5, 0x71, 0xA4, 0x62, 0xF3, 0x79, 0xB4, 0x53, 0x82, 0xCC, 0xC5, 0xF7, 0xE0,
+    0x3F, 0xBC, 0x43, 0xB3, 0xBD, 0x70, 0x86, 0x44, 0x5D, 0x4F, 0x3A, 0x07, 0xEE, 0xF2, 0x4A, 0x81,
+    0xAA, 0xAF, 0x05, 0xBB, 0xAD, 0x41, 0xF7, 0xF1, 0x2C, 0xEB, 0x58, 0xF4, 0x97, 0x46, 0x19, 0x03,
+    0x66, 0x6A, 0xF2, 0x5B, 0x92, 0xFD, 0xB4, 0x42, 0x91, 0x9B, 0xDE, 0xB0, 0xCA, 0x09, 0x23, 0x04,
+    0x88, 0x98, 0xB8, 0xDA, 0x38, 0x52, 0xB1, 0xF9, 0x3C, 0xDA, 0x29, 0x41, 0xE6, 0xE2, 0x7B, 0xF0
+} };
+
+    void init_PN9() { em2.PN9_pos = 0; }
+    ot_u8 get_PN9() { return PN9table.byte[em2.PN9_pos]; }
+    void rotate_PN9() { em2.PN9_pos++; }
+
+    /// Low bits of an address.  unsigned long is pointer-sized on the MCUs and
+    /// on LP64 hosts, so this does not truncate the pointer first.
+#   define PN9_MISALIGN(PTR)    ((ot_uint)(unsigned long)(PTR) & (sizeof(ot_u32)-1))
+
+#   ifndef EXTF_em2_pn9_apply
+    OT_WEAK void em2_pn9_apply(ot_u8* dst, ot_u8* src, ot_int length) {
+        ot_u8 pos;
+        pos             = em2.PN9_pos;
+        em2.PN9_pos    += (ot_u8)length;
+
+        /// XOR a word at a time when dst, src and the keystream have the same
+        /// alignment, which they do when the frame starts on a word boundary.
+        if ((PN9_MISALIGN(dst) == PN9_MISALIGN(src)) && (PN9_MISALIGN(dst) == (pos & (sizeof(ot_u32)-1)))) {
+            for (; (PN9_MISALIGN(dst) != 0) && (length > 0); length--) {
+                *dst++ = *src++ ^ PN9table.byte[pos++];
+            }
+            for (; length >= (ot_int)sizeof(ot_u32); length -= sizeof(ot_u32)) {
+                *(ot_u32*)dst   = *(ot_u32*)src ^ PN9table.word[pos / sizeof(ot_u32)];
+                dst            += sizeof(ot_u32);
+                src            += sizeof(ot_u32);
+                pos            += sizeof(ot_u32);
+            }
+        }
+        for (; length > 0; length--) {
+            *dst++ = *src++ ^ PN9table.byte[pos++];
+        }
     }
+#   endif
 #endif
 
 #if (RF_FEATURE(PN9) != ENABLED)
 #   if !defined(EXTF_em2_encode_data_PN9)
     OT_WEAK void em2_encode_data_PN9() {
-        while ( (em2.bytes > 0) && (radio_txopen() == True) ) {
-            crc_calc_stream(&em2.crc);
-            RS_ENCODE_1BYTE();
-            radio_putbyte( q_readbyte(&txq) ^ get_PN9() );
-            rotate_PN9();
-            em2.bytes--;
+    /// Whiten up to 32 bytes at a time from txq into a staging chunk, running
+    /// the CRC in the same pass, and load each chunk in one burst until the
+    /// radio is full.  At the end of the CRC, it is written into txq ahead of
+    /// the cursor, so it is whitened and loaded like the rest.
+        ot_u8   chunk[32];
+        ot_int  space, n;
+
+        space = radio_txspan();
+        while ( (em2.bytes > 0) && (space > 0) ) {
+            n   = (em2.bytes < space) ? em2.bytes : space;
+            n   = (n < 32) ? n : 32;
+#           if (M2_FEATURE(RSCODE))
+            /// RS parity is written into txq when the message is done, so a
+            /// chunk stops there, and the next one whitens the parity.
+            if ((em2.lctl & 0x40) && (rs.count > 0) && (n > rs.count)) {
+                n = rs.count;
+            }
+#           endif
+            crc_calc_nstream_xor(&em2.crc, chunk, &PN9table.byte[em2.PN9_pos], (ot_u16)n, False);
+            em2.PN9_pos += (ot_u8)n;
+            radio_putbytes(chunk, n);
+
+            RS_ENCODE_NBYTES(n);
+            txq.getcursor  += n;
+            em2.bytes      -= n;
+            space          -= n;
         }
     }
 #   endif
@@ -349,13 +825,22 @@ OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
 #if (RF_FEATURE(PN9) != ENABLED)
 #   if !defined(EXTF_em2_decode_data_PN9)
     OT_WEAK void em2_decode_data_PN9() {
-        while ( (em2.bytes > 0) && (radio_rxopen() == True) ) {
-            em2.bytes--;
-            q_writebyte(&rxq, (radio_getbyte() ^ get_PN9()) );
-            rotate_PN9();
+    /// Take all the bytes the radio has (only up to the end of the header while
+    /// the header is incomplete), then dewhiten and CRC them as a block.
+        ot_int n, limit;
+        while ( (em2.bytes > 0) && ((n = radio_rxspan()) > 0) ) {
+            limit = (em2.state >= 0) ? (em2.state + 1) : em2.bytes;
+            if (n > limit) {
+                n = limit;
+            }
+            radio_getbytes(rxq.putcursor, n);
 
             if (em2.state >= 0) {
-                if (--em2.state < 0) {
+                em2_pn9_apply(rxq.putcursor, rxq.putcursor, n);
+                rxq.putcursor  += n;
+                em2.bytes      -= n;
+                em2.state      -= n;
+                if (em2.state < 0) {
                     ot_int ext_bytes;
                     em2.bytes   = (ot_int)rxq.front[0] - 1;         // Bytes remaining
                     em2.crc5    = em2_check_crc5();
@@ -371,8 +856,12 @@ OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
                 }
             }
             else {
-                RS_DECODE_1BYTE();
-                crc_calc_stream(&em2.crc);
+                /// Dewhiten and CRC in one pass: the stream cursor is putcursor
+                crc_calc_nstream_xor(&em2.crc, rxq.putcursor, &PN9table.byte[em2.PN9_pos], (ot_u16)n, True);
+                em2.PN9_pos    += (ot_u8)n;
+                rxq.putcursor  += n;
+                em2.bytes      -= n;
+                RS_DECODE_NBYTES(n);
             }
         }
     }
@@ -394,277 +883,229 @@ OT_WEAK void em2_rs_interleave(ot_u8* start, ot_int numbytes) {
   */
 
 #if ((M2_FEATURE(FECTX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
-static const ot_u8 FECtable[16] = {
-    0, 3,   1, 2,   3, 0,   2, 1,   3, 0,   2, 1,   0, 3,   1, 2
+/** FEC encoder output table, indexed by [state][input nibble]
+  * The encoder is K=4, rate 1/2, so its state is the last 3 input bits.  Each
+  * entry is the 8 output bits (4 symbols) for 4 input bits, and the next state
+  * is just the low 3 bits of the nibble.  A byte takes two lookups instead of
+  * eight trips through the trellis, and the table is only 128 bytes.
+  */
+static const ot_u8 FECtable[8][16] = {
+    { 0x00, 0x03, 0x0D, 0x0E, 0x37, 0x34, 0x3A, 0x39, 0xDF, 0xDC, 0xD2, 0xD1, 0xE8, 0xEB, 0xE5, 0xE6 },
+    { 0x7C, 0x7F, 0x71, 0x72, 0x4B, 0x48, 0x46, 0x45, 0xA3, 0xA0, 0xAE, 0xAD, 0x94, 0x97, 0x99, 0x9A },
+    { 0xF0, 0xF3, 0xFD, 0xFE, 0xC7, 0xC4, 0xCA, 0xC9, 0x2F, 0x2C, 0x22, 0x21, 0x18, 0x1B, 0x15, 0x16 },
+    { 0x8C, 0x8F, 0x81, 0x82, 0xBB, 0xB8, 0xB6, 0xB5, 0x53, 0x50, 0x5E, 0x5D, 0x64, 0x67, 0x69, 0x6A },
+    { 0xC0, 0xC3, 0xCD, 0xCE, 0xF7, 0xF4, 0xFA, 0xF9, 0x1F, 0x1C, 0x12, 0x11, 0x28, 0x2B, 0x25, 0x26 },
+    { 0xBC, 0xBF, 0xB1, 0xB2, 0x8B, 0x88, 0x86, 0x85, 0x63, 0x60, 0x6E, 0x6D, 0x54, 0x57, 0x59, 0x5A },
+    { 0x30, 0x33, 0x3D, 0x3E, 0x07, 0x04, 0x0A, 0x09, 0xEF, 0xEC, 0xE2, 0xE1, 0xD8, 0xDB, 0xD5, 0xD6 },
+    { 0x4C, 0x4F, 0x41, 0x42, 0x7B, 0x78, 0x76, 0x75, 0x93, 0x90, 0x9E, 0x9D, 0xA4, 0xA7, 0xA9, 0xAA }
 };
 
 #if !defined(EXTF_em2_encode_data_FEC)
 void OT_WEAK em2_encode_data_FEC() {
-    ot_int      i, j, k;
-    ot_u8       scratch;
+    ot_u8       state;
     ot_u8       input;
-    ot_u8       data_buffer[RADIO_BUFFER_TXMAX];
-    ot_uni16    FECoutput;
-    ot_uni16    FECreg;       //@todo adjust to allow multiframe packets
-    ot_uni32   INToutput;
+    ot_uni32    block;
 
-    k               = 0;
-    FECreg.ushort   = 0;      //@todo adjust to allow multiframe packets
+    /// The FEC state carries over from the last call, so a frame may be
+    /// encoded over several calls.  em2_encode_newframe() clears it.
+    state = em2.FEC_state;
 
     // Encode each input byte into two output bytes, and add the trellis
     // terminator to the end of the message (0x0B).  The number of
     // pre-encoded bytes plus the trellis terminator must be even, so one
     // or two trellis terminators are added (odd or even).  The number of
-    // post-encoded bytes is always a multiple of 4
+    // post-encoded bytes is always a multiple of 4, so two input bytes make
+    // a half-block (upper 16 bits) and the next two make the other half.
     while ( (em2.state != 0) && (radio_txopen_4() == True) ) {
+        ot_int i;
 
-        if (em2.bytes == 0) {
-            em2.state--;
-            input = 0x0B;                   //trellis terminator
-        }
-        else {
-            em2.bytes--;
-            crc_calc_stream(&em2.crc);
-            RS_ENCODE_1BYTE();
-            input   = q_readbyte(&txq);
-            input  ^= get_PN9();
-            rotate_PN9();
-        }
-
-        FECoutput.ushort     = 0;
-        FECreg.ubyte[UPPER] &= 0x07;
-        FECreg.ubyte[LOWER]  = input;
+        block.ulong = 0;
+        for (i=4; i>0; i-=2) {
+            if (em2.bytes == 0) {
+                em2.state--;
+                input = 0x0B;                   //trellis terminator
+            }
+            else {
+                em2.bytes--;
+                crc_calc_stream(&em2.crc);
+                RS_ENCODE_1BYTE();
+                input   = q_readbyte(&txq);
+                input  ^= get_PN9();
+                rotate_PN9();
+            }
 
-        for (j=8; j>0; j--) {
-            FECoutput.ushort = (FECoutput.ushort << 2) | FECtable[ (FECreg.ushort >> 7) ];
-            FECreg.ushort    = (FECreg.ushort << 1) & 0x7FF;
+            block.ulong = (block.ulong >> 8) | ((ot_u32)FECtable[state][input >> 4] << 24);
+            state       = (input >> 4) & 0x07;
+            block.ulong = (block.ulong >> 8) | ((ot_u32)FECtable[state][input & 0x0F] << 24);
+            state       = input & 0x07;
         }
-        data_buffer[k++] = FECoutput.ubyte[UPPER];
-        data_buffer[k++] = FECoutput.ubyte[LOWER];
-    }
-
-    // Interleave the buffer after it is encoded
-    // The interleaver operates on four bytes at a time
-    for (i=0; i<k; i+=4) {
-        INToutput.ulong = 0;
 
-        for (j=0; j<16; j++) {
-            scratch         = data_buffer[i + (~j & 0x03)];
-            //INToutput.ulong = (INToutput.ulong << 2) | ((scratch >> (2 * ((j & 0x0C) >> 2))) & 0x03);
-            INToutput.ulong = (INToutput.ulong << 2) | ((scratch >> (((j & 0x0C) >> 2) << 1)) & 0x03);
+        // Interleave the four encoded bytes: it is a transpose of the 4x4
+        // matrix of 2 bit symbols (the encoded bytes are the rows, first one
+        // in the low byte), followed by a byte reversal.
+        {
+            ot_u32 x, t;
+            x           = block.ulong;
+            t           = (x ^ (x >> 6)) & 0x00CC00CC;
+            x          ^= t ^ (t << 6);
+            t           = (x ^ (x >> 12)) & 0x0000F0F0;
+            x          ^= t ^ (t << 12);
+            block.ulong = (x << 24) | ((x & 0xFF00) << 8) | ((x >> 8) & 0xFF00) | (x >> 24);
         }
 
-        radio_putfourbytes(&INToutput.ubyte[0]);
+        radio_putfourbytes(&block.ubyte[0]);
     }
 
+    em2.FEC_state = state;
 }
 #endif
 #endif
 
 
 #if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
-static const ot_u8 TrellisSourceState[8][2] = {
-    {0, 4},         // State {0,4} -> State 0
-    {0, 4},         // State {0,4} -> State 1
-    {1, 5},         // State {1,5} -> State 2
-    {1, 5},         // State {1,5} -> State 3
-    {2, 6},         // State {2,6} -> State 4
-    {2, 6},         // State {2,6} -> State 5
-    {3, 7},         // State {3,7} -> State 6
-    {3, 7}          // State {3,7} -> State 7
-};
-
-static const ot_u8 TrellisTransitionOutput[8][2] = {
-    {0, 3},         // State {0,4} -> State 0 produces {"00", "11"}
-    {3, 0},         // State {0,4} -> State 1 produces {"11", "00"}
-    {1, 2},         // State {1,5} -> State 2 produces {"01", "10"}
-    {2, 1},         // State {1,5} -> State 3 produces {"10", "01"}
-    {3, 0},         // State {2,6} -> State 4 produces {"11", "00"}
-    {0, 3},         // State {2,6} -> State 5 produces {"00", "11"}
-    {2, 1},         // State {3,7} -> State 6 produces {"10", "01"}
-    {1, 2}          // State {3,7} -> State 7 produces {"01", "10"}
-};
-
-static const ot_u8 TrellisTransitionInput[8] = { 0, 1, 0, 1, 0, 1, 0, 1 };
-
-ot_u8 hamming_weight(ot_u8 a) {
-    a = ((a & 0xAA) >> 1) + (a & 0x55);
-    a = ((a & 0xCC) >> 2) + (a & 0x33);
-    a = ((a & 0xF0) >> 4) + (a & 0x0F);
-    return a;
-}
-
-/** @fn       min
-  * @brief    Returns the minimum of two byte values
-  * @param a  Value 1
-  * @param b  Value 2
-  * @return   Minimum of two values: Value 1 or Value 2
+/** Trellis of the K=4 encoder, in butterflies
+  * Destination states 2k and 2k+1 both come from source states k and k+4.
+  * The transition from k to 2k produces symbol "00", "01", "11", "10" for k =
+  * 0, 1, 2, 3, the one from k+4 to 2k produces its complement, and it is the
+  * other way around for 2k+1.  Complement symbols have complement Hamming
+  * distances (2-d), so a received symbol needs only two table lookups.
   */
-ot_u8 min(ot_u8 a, ot_u8 b) {
-    return (a <= b) ? a : b;
-}
+static const ot_u8 FECdistance[4]   = { 0, 1, 1, 2 };
+
+#ifndef EXTF_em2_fec_viterbi
+OT_WEAK ot_u8 em2_fec_viterbi(ot_u8* cost, ot_u32* path, ot_u8 symbols) {
+    ot_u8   ncost[8];
+    ot_u32  npath[8];
+    ot_u8   best;
+    ot_u8   floor;
+    ot_int  i, k;
+
+    for (i=6; i>=0; i-=2) {
+        ot_u8 dist[4];
+        dist[0] = FECdistance[(symbols >> i) & 3];          // to "00"
+        dist[1] = FECdistance[((symbols >> i) & 3) ^ 1];    // to "01"
+        dist[2] = 2 - dist[0];                              // to "11"
+        dist[3] = 2 - dist[1];                              // to "10"
+
+        /// Branch-free add-compare-select over the four butterflies.  On a
+        /// tie, the path from the lower source state wins.
+        for (k=0; k<4; k++) {
+            ot_u8   a, b, x, y;
+            ot_u32  mask;
+            a       = dist[k];
+            b       = 2 - a;
+
+            x       = cost[k] + a;
+            y       = cost[k+4] + b;
+            mask    = (ot_u32)0 - (ot_u32)(y < x);
+            ncost[k<<1]     = x ^ ((x ^ y) & (ot_u8)mask);
+            npath[k<<1]     = (path[k] ^ ((path[k] ^ path[k+4]) & mask)) << 1;
+
+            x       = cost[k] + b;
+            y       = cost[k+4] + a;
+            mask    = (ot_u32)0 - (ot_u32)(y < x);
+            ncost[(k<<1)+1] = x ^ ((x ^ y) & (ot_u8)mask);
+            npath[(k<<1)+1] = ((path[k] ^ ((path[k] ^ path[k+4]) & mask)) << 1) | 1;
+        }
+        for (k=0; k<8; k++) {
+            cost[k] = ncost[k];
+            path[k] = npath[k];
+        }
+    }
 
+    /// Normalize costs so that the minimum becomes 0
+    best = 0;
+    for (k=1; k<8; k++) {
+        best = (cost[k] < cost[best]) ? k : best;
+    }
+    floor = cost[best];
+    for (k=0; k<8; k++) {
+        cost[k] -= floor;
+    }
+    return best;
+}
+#endif
 
 
-#if !defined(EXTF_em2_decode_data_FEC)
-void OT_WEAK em2_decode_data_FEC() {
 
-    // Two sets of buffers (last, current) for each destination state for holding:
-    ot_u32  path_matrix[2][8];      // Encoder input data (32b window)
+static void sub_fec_putbyte(ot_u8 new_byte) {
+/// Descramble a decoded byte and run it through the frame decoding
+    q_writebyte(&rxq, (new_byte ^ get_PN9()));
+    rotate_PN9();
 
-    // Decoding
-    ot_u8   input;
-    ot_u8   min_cost;
+    if (em2.state >= 0) {
+        if (--em2.state < 0) {
+            ot_int fr_bytes;
+            fr_bytes    = (ot_int)rxq.front[0] + 1;             // Total bytes
+            em2.bytes   = (((fr_bytes >> 1) + 1) << 2) - 12;    // Encoded bytes remaining
+            em2.databytes = fr_bytes - 2;                       // Decoded bytes remaining
+            em2.crc5    = em2_check_crc5();
+            em2.lctl    = rxq.front[1];
 
-    // Deinterleaving
-    ot_u8*  data_in;
-    ot_u8   deint_data[4];
+            if (em2.lctl & 0x40) {
+                fr_bytes -= em2_rs_init_decode(&rxq);
+                em2_rs_decode(2);
+            }
+            crc_init_stream(&em2.crc, False, fr_bytes, rxq.front);
+            crc_calc_nstream(&em2.crc, 2);
+        }
+    }
+    else {
+        RS_DECODE_1BYTE();
+        crc_calc_stream(&em2.crc);
+        em2.databytes--;
+    }
+}
 
-    // Variables used to hold # Viterbi iterations to run, # bytes output,
-    // minimum cost for any destination state, bit index of input symbol
-    ot_int  i, j;
-    ot_int  bit_shift = 6;
 
+#if !defined(EXTF_em2_decode_data_FEC)
+void OT_WEAK em2_decode_data_FEC() {
     while ( (em2.bytes > 0) && (radio_rxopen_4() == True) ) {
-
-        /// De-interleave a 4 byte block
+        ot_u8   int_data[4];
+        ot_u32  block;
+        ot_int  i;
+
+        /// De-interleave a 4 byte block.  The interleaver is a transpose of
+        /// 2 bit symbols, and the radio sends its high byte first, so the
+        /// received bytes are put into the block in reverse and transposed
+        /// back.  The de-interleaved bytes end up first one in the low byte.
+        radio_getfourbytes(int_data);
+        em2.bytes -= 4;
         {
-            ot_u8   int_data[4];
-            radio_getfourbytes(int_data);
-            em2.bytes -= 4;
-
-            for (i=0; i<4; i++) {
-                input = 0;
-                for (j=3; j>=0; j--) {
-                    input  <<= 2;
-                    input   |= (int_data[j] >> (i<<1)) & 0x03;
-                }
-                deint_data[i] = input;
-            }
-            data_in = deint_data;
+            ot_u32 t;
+            block   = ((ot_u32)int_data[3] << 24) | ((ot_u32)int_data[2] << 16) \
+                    | ((ot_u32)int_data[1] << 8)  | (ot_u32)int_data[0];
+            t       = (block ^ (block >> 6)) & 0x00CC00CC;
+            block  ^= t ^ (t << 6);
+            t       = (block ^ (block >> 12)) & 0x0000F0F0;
+            block  ^= t ^ (t << 12);
         }
 
-
-        // DECODE the deinterleaved data
-        // Process up to 4 bytes of de-interleaved input data,
-        // processing one encoder symbol (2b) at a time
-        for (i=16; i>0; i--) {
-            ot_u8   symbol;
-
-            min_cost    = 0xFF;
-            symbol      = ((*data_in) >> bit_shift) & 0x03;
-            bit_shift  -= 2;
-
-            if (bit_shift < 0) {       // if bit shifting is all done (byte finished)
-                bit_shift = 6;              // reset bit_shift
-                data_in++;                  // Update pointer to the next byte of received data
-            }
-
-
-            // For each destination state in the trellis,
-            // calculate hamming costs for both possible paths into state,
-            // and select the one with lowest cost.
-            for (j=0; j<8; j++) {
-                ot_u8   state0;
-                ot_u8   state1;
-                ot_u8   cost0;
-                ot_u8   cost1;
-
-                input = TrellisTransitionInput[j];
-
-                // Calculate cost of transition from each of the 2 source states
-                //    (cost is Hamming difference between received 2b symbol
-                //     and expected symbol for transition)
-                state0  = TrellisSourceState[j][0];
-                cost0   = em2.cost_matrix[em2.last_buffer][state0];
-                cost0  += hamming_weight(symbol ^ TrellisTransitionOutput[j][0]);
-
-                state1  = TrellisSourceState[j][1];
-                cost1   = em2.cost_matrix[em2.last_buffer][state1];
-                cost1  += hamming_weight(symbol ^ TrellisTransitionOutput[j][1]);
-
-                // Select transition that gives lowest cost in destination state,
-                // copy that source state's path and add new decoded bit
-                if (cost0 <= cost1) {
-                    em2.cost_matrix[em2.current_buffer][j]  = cost0;
-                    path_matrix[em2.current_buffer][j]      = path_matrix[em2.last_buffer][state0] << 1;
-                    path_matrix[em2.current_buffer][j]     |= input;
-                    min_cost                                = min(min_cost, cost0);
-                }
-                else {
-                    em2.cost_matrix[em2.current_buffer][j]  = cost1;
-                    path_matrix[em2.current_buffer][j]      = path_matrix[em2.last_buffer][state1] << 1;
-                    path_matrix[em2.current_buffer][j]     |= input;
-                    min_cost                                = min(min_cost, cost1);
-                }
-            }
-            em2.path_bits++;
-
-            // If trellis history is sufficiently long,
-            // output a byte of decoded data
-            if (em2.path_bits == 32) {
-                ot_u8 new_byte;
-                em2.path_bits  -= 8;
-                new_byte        = (ot_u8)(path_matrix[em2.current_buffer][0] >> 24);
-                new_byte       ^= get_PN9();
-                rotate_PN9();
-                q_writebyte(&rxq, new_byte);
-
-                if (em2.state < 0) {
-                    ot_int fr_bytes;
-                    em2.state  -= 1;
-                    fr_bytes    = rxq.front[0] + 1;
-                    em2.bytes   = ((fr_bytes >> 1) + 1) << 2;
-                    em2.bytes  -= 4;
-                    em2.crc5    = em2_check_crc5();
-                    em2.lctl    = rxq.front[1];
-                    fr_bytes    = 0;
-
-                    if (em2.lctl & 0x40) {
-                        fr_bytes -= em2_rs_init_decode(&rxq);
-                        em2_rs_decode(2);
-                    }
-                    em2.databytes   = fr_bytes - 2;     // subtract this block
-
-                    crc_init_stream(&em2.crc, False, fr_bytes, rxq.front);
-                    crc_calc_nstream(&em2.crc, 2);
-                }
-                else {
-                    RS_DECODE_1BYTE();
-                    crc_calc_stream(&em2.crc);
-                    em2.databytes--;
-                }
-            }
-
-
-            // After having processed 3-symbol trellis terminator,
-            // flush out remaining data (always end-of-frame)
-            if ( (em2.databytes <= 3)  && (em2.path_bits == ((em2.databytes<<3) + 3)) ) {
-                while (em2.path_bits >= 8) {
-                    ot_u8 new_byte;
-
-                    em2.databytes--;
-                    new_byte        = (ot_u8)(path_matrix[em2.current_buffer][0] >> em2.path_bits);
-                    em2.path_bits  -= 8;
-                    new_byte       ^= get_PN9();
-                    rotate_PN9();
-                    q_writebyte(&rxq, new_byte);
-                    crc_calc_stream(&em2.crc);
+        /// Each de-interleaved byte is 4 symbols, which decode to 4 bits.
+        /// A byte is output once it is 24 bits deep in the survivor path.
+        for (i=0; i<4; i++) {
+            ot_u8 best;
+            best            = em2_fec_viterbi(em2.FEC_cost, em2.FEC_path, (ot_u8)block);
+            block         >>= 8;
+            em2.path_bits  += 4;
+
+            /// After the last data bit, the first 3 bits of the trellis
+            /// terminator put the encoder in state 0, so the rest of the
+            /// frame is flushed out of the state 0 path.
+            if ((em2.state < 0) && (em2.path_bits >= ((em2.databytes << 3) + 3))) {
+                while (em2.databytes > 0) {
+                    em2.path_bits -= 8;
+                    sub_fec_putbyte( (ot_u8)(em2.FEC_path[0] >> em2.path_bits) );
                 }
+                em2.bytes = 0;
                 return;
             }
-
-            // Swap current and last buffers for next iteration
-            em2.last_buffer      = (em2.last_buffer+1) & 1;
-            em2.current_buffer   = (em2.current_buffer+1) & 1;
-        }
-
-        // Normalize costs so that minimum cost becomes 0
-        for (j=0; j<8; j++) {
-            em2.cost_matrix[em2.last_buffer][j] -= min_cost;
+            if (em2.path_bits >= 32) {
+                em2.path_bits -= 8;
+                sub_fec_putbyte( (ot_u8)(em2.FEC_path[best] >> 24) );
+            }
         }
     }
-
 }
 #endif
 #endif
@@ -782,37 +1223,50 @@ OT_WEAK void em2_decode_newpacket() {
 #if !defined(EXTF_em2_encode_newframe)
 OT_WEAK void em2_encode_newframe() {
 
-    ///1. CRC management variants:
+    /// 1. Get the link control flags.  Kill the RS Coding flag if RS Coding
+    ///    is not supported.
+#   if (M2_FEATURE(RSCODE) != ENABLED)
+    txq.front[1]   &= ~0x40;
+#   endif
+    em2.lctl        = txq.front[1];
+
+    /// 2. CRC and RS Coding are appended to the frame while it is encoded,
+    ///    so add them to the frame length.  This is only done on the first
+    ///    TX of the frame: on retransmission, they are already in the queue.
+    ///    CRC5 goes last, because it covers the length.  Variants:
     /// <LI> software CRC5 and software CRC16 </LI>
     /// <LI> software CRC5 and hardware CRC16 </LI>
     /// <LI> hardware CRC5 and software CRC16 </LI>
     /// <LI> hardware CRC5 and hardware CRC16 </LI>
-#   if ((RF_FEATURE(CRC16) | RF_FEATURE(CRC)) != ENABLED)
     if (txq.options.ubyte[UPPER] != 0) {
+#       if ((RF_FEATURE(CRC16) | RF_FEATURE(CRC)) != ENABLED)
+        crc_init_stream(&em2.crc, True, q_span(&txq), txq.getcursor);
+        txq.putcursor  += 2;
+        txq.front[0]   += 2;
+#       endif
+#       if (M2_FEATURE(RSCODE))
+        if (em2.lctl & 0x40) {
+            ot_int parity_bytes;
+            parity_bytes    = em2_rs_init_encode(&txq);
+            txq.front[0]   += parity_bytes;
+            txq.putcursor  += parity_bytes;
+        }
+#       endif
 #       if (RF_FEATURE(CRC5) != ENABLED)
         em2_add_crc5();
 #       endif
+    }
+    else {
+        /// The CRC and RS parity are already in the queue: the CRC stream just
+        /// follows the cursor, and RS encoding has nothing to do.
 #       if ((RF_FEATURE(CRC16) | RF_FEATURE(CRC)) != ENABLED)
-        crc_init_stream(&em2.crc, True, q_span(&txq), txq.getcursor);
-        txq.putcursor += 2;
+        crc_init_stream(&em2.crc, False, 0, txq.getcursor);
+#       endif
+#       if (M2_FEATURE(RSCODE))
+        rs.count    = 0;
+        rs.writeout = False;
 #       endif
     }
-#   endif
-
-    /// 2. Handle RS Coding and other link control flags, and initialize
-    ///    RS Encoder if it is supported.  Otherwise, kill the flag
-#   if (M2_FEATURE(RSCODE))
-    em2.lctl = txq.front[1];
-    if (em2.lctl & 0x40) {
-        ot_int parity_bytes;
-        parity_bytes    = em2_rs_init_encode(&txq);
-        txq.front[0]   += parity_bytes;
-        txq.putcursor  += parity_bytes;
-    }
-#   else
-    em2.lctl        = txq.front[1] & ~0x40;
-    txq.front[1]    = em2.lctl;
-#   endif
 
     /// 3. Set encoder total bytes now that all are in the queue
     em2.bytes = q_span(&txq);
@@ -832,6 +1286,7 @@ OT_WEAK void em2_encode_newframe() {
 
         em2.state   = ((em2.bytes & 1) == 0);
         em2.state  += 1;
+        em2.FEC_state = 0;
 #       if (RF_FEATURE(PN9) == ENABLED)
         init_PN9();
 #       endif
@@ -854,18 +1309,14 @@ OT_WEAK void em2_decode_newframe() {
     /// Prepare SW FEC Decoders, and if necessary PN9 decoder
 #   if ((M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED))
         if (rxq.options.ubyte[LOWER]) {
-#           ifdef __BIG_ENDIAN__
-                ///@todo: make endian agnostic
-#           else
-                *((ot_u32*)(&em2.cost_matrix[0][0])) = 0x64646400;
-                *((ot_u32*)(&em2.cost_matrix[0][4])) = 0x64646464;
-                *((ot_u32*)(&em2.cost_matrix[1][0])) = 0x00000000;
-                *((ot_u32*)(&em2.cost_matrix[1][4])) = 0x00000000;
-                ///@todo Verify: seemed like an error on the last line ([0][4]), which I corrected to [1][4]
-#           endif
+            ot_int i;
+            for (i=0; i<8; i++) {
+                em2.FEC_cost[i] = 100;
+                em2.FEC_path[i] = 0;
+            }
+            em2.FEC_cost[0]     = 0;        // encoder starts in state 0
             em2.path_bits       = 0;
-            em2.last_buffer     = 0;
-            em2.current_buffer  = 1;
+            em2.bytes           = 12;       // 3 blocks to decode the header
 #           if (RF_FEATURE(PN9) == ENABLED)
                 init_PN9();
 #           endif
@@ -899,7 +1350,7 @@ OT_WEAK ot_u16 em2_decode_endframe() {
     ///     errors, to verify that indeed all errors were corrected.
     corrections = 0;
     if (em2.lctl & 0x40) {
-        framebytes -= em2_rs_paritylength( framebytes );
+        framebytes -= sub_rs_framepar(framebytes);
 #       if (M2_FEATURE(RSCODE))
         if (crc_invalid) {
             corrections = em2_rs_postprocess();
@@ -921,7 +1372,14 @@ OT_WEAK ot_u16 em2_decode_endframe() {
     ///   (RS and CRC are actually both types of block codes)
     rxq.front[0] = (ot_u8)framebytes;
 
-    ///5. If CRC is still invalid, report the packet is uncorrectably broken
+    ///5. On the last frame of a multiframe packet, go back to the first one
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+    if ((em2.lctl & 0x80) == 0) {
+        em2_decode_endpacket();
+    }
+#   endif
+
+    ///6. If CRC is still invalid, report the packet is uncorrectably broken
     return crc_invalid;
 }
 #endif
@@ -943,6 +1401,83 @@ OT_WEAK ot_u8 em2_remaining_frames() {
 #endif
 
 
+#if !defined(EXTF_em2_frame_overhead)
+OT_WEAK ot_int em2_frame_overhead(ot_u8* frame) {
+/// The same bytes that em2_encode_newframe() adds to the frame: CRC16, unless
+/// the radio does it in HW, and RS parity, which depends on the length of the
+/// message (the frame plus its CRC16).
+    ot_int overhead = 0;
+#   if ((RF_FEATURE(CRC16) | RF_FEATURE(CRC)) != ENABLED)
+    overhead = 2;
+#   endif
+#   if (M2_FEATURE(RSCODE))
+    if (frame[1] & 0x40) {
+        overhead += em2_rs_paritylength(frame[0] + 1 + overhead);
+    }
+#   endif
+    return overhead;
+}
+#endif
+
+
+#if (M2_FEATURE(MULTIFRAME) == ENABLED)
+#if !defined(EXTF_em2_encode_nextframe)
+OT_WEAK void em2_encode_nextframe() {
+/// The encoder stops at the end of each frame, so txq.getcursor is now on the
+/// next one.  The frame setup works on txq.front, so txq.front is moved onto
+/// the frame for the setup and put back afterwards.
+    ot_u8* pkt_front;
+
+    pkt_front       = txq.front;
+    txq.front       = txq.getcursor;
+    txq.putcursor   = txq.getcursor + txq.getcursor[0] + 1;
+    em2_encode_newframe();
+    txq.front       = pkt_front;
+}
+#endif
+
+
+#if !defined(EXTF_em2_decode_nextframe)
+OT_WEAK void em2_decode_nextframe() {
+/// The decoder stops at the end of each frame, so the next frame will be put
+/// at rxq.putcursor.  The decoder parses the frame header at rxq.front, so
+/// rxq.front stays on this frame until the packet is done.
+    if (em2.pkt_front == NULL) {
+        em2.pkt_front = rxq.front;
+    }
+    rxq.front       = rxq.putcursor;
+    rxq.getcursor   = rxq.putcursor;
+    em2_decode_newframe();
+}
+#endif
+
+
+#if !defined(EXTF_em2_decode_endpacket)
+OT_WEAK void em2_decode_endpacket() {
+    if (em2.pkt_front != NULL) {
+        rxq.front       = em2.pkt_front;
+        em2.pkt_front   = NULL;
+    }
+}
+#endif
+
+
+#if !defined(EXTF_em2_decode_framebytes)
+OT_WEAK ot_int em2_decode_framebytes(ot_u8* frame) {
+/// em2_decode_endframe() leaves the frame bytes, without CRC16 and RS parity,
+/// in the length byte, but they stay in rxq after the frame.  The parity goes
+/// by the message, which is the frame with its CRC16, as in the encoder.
+    ot_int msg_bytes;
+    msg_bytes = (ot_int)frame[0] + 2;
+    if (frame[1] & 0x40) {
+        msg_bytes += em2_rs_paritylength(msg_bytes);
+    }
+    return msg_bytes;
+}
+#endif
+#endif
+
+
 #if !defined(EXTF_em2_remaining_bytes)
 OT_WEAK ot_int em2_remaining_bytes() {
     return em2.bytes;
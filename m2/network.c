@@ -35,10 +35,12 @@
 #include <m2/network.h>
 #include <m2/transport.h>
 #include <m2/dll.h>
+#include <m2/encode.h>
 #include <m2/tmpl.h>
 
 #include <otlib/auth.h>
 #include <otlib/buffers.h>
+#include <otlib/memcpy.h>
 #include <otlib/utils.h>
 #include <otsys/veelite.h>
 
@@ -54,7 +56,39 @@
   */
 m2np_struct m2np;
 
+#ifndef EXTF_network_route_ff
 static const ot_int _idlen[2] = { 8, 2 };
+#endif
+
+#if ((M2_FEATURE(MULTIFRAME) == ENABLED) && !defined(EXTF_network_route_ff))
+static ot_bool sub_m2dp_join(ot_u8* pkt_end);
+#endif
+
+
+#if ((M2_FEATURE(HDRCACHE) == ENABLED) && !defined(EXTF_m2np_header))
+/** Header templates, one per addressing mode (Frame Info bits 1:0).  Each one
+  * is the front of the last header built in that mode, from the Length byte
+  * to the end of the source ID, and it is tagged with the session parameters
+  * it was built from: Link Control, Subnet, Frame Info and Extra.  When the
+  * next header has the same ones, it is a copy of the template with the Length,
+  * TX EIRP, Dialog ID and DLLS nonce patched.  The target ID and routing are
+  * written after it, as they change with each requester.  The source ID is not
+  * compared, so the templates are flushed with m2np_flush() when dll.netconf
+  * is reloaded.
+  */
+#define M2NP_TMPL_MAX   21      // 4 + FrInfo + Ext + DialogID + Nonce + UID
+
+typedef struct {
+    ot_u8   length;             // bytes in data[], 0 when empty
+    ot_u8   fr_info;
+    ot_u8   data[M2NP_TMPL_MAX];
+} m2np_tmpl;
+
+static m2np_tmpl m2np_tmpls[4];
+
+static ot_bool sub_tmpl_load(m2session* active, ot_u8 lctl);
+static void sub_tmpl_save(void);
+#endif
 
 
 
@@ -74,6 +108,8 @@ OT_WEAK void network_init() {
     // Hop code should be explicitly set when producing an anycast or unicast 
     // transmission.  OTAPI will do this for you.
     //m2np.rt.hop_code  = 0;
+    
+    m2np_flush();
 }
 #endif
   
@@ -172,10 +208,14 @@ ot_int network_route_ff(m2session* active) {
 #   if (OT_FEATURE(DLL_SECURITY))
     ot_u8   dlls_key_index;
 #   endif
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+    ot_u8*  pkt_end = rxq.putcursor;
+#   endif
 
-    // Strip CRC bytes from the end of the message.  RS bytes are stripped by
-    // the decoder, if RS is enabled/used.
-    //rxq.front[0]       -= 2;  //done in encoder now
+    /// The decoder leaves the frame bytes, without CRC and RS, in the length
+    /// byte.  CRC and RS are still in rxq, so the frame data ends here, and
+    /// the frames of a multiframe packet come after it.
+    rxq.putcursor       = &rxq.front[rxq.front[0]];
     
     /// Acquire RSCODE flag from LC byte (0x40) and transpose to its position
     /// for session flags (0x08)
@@ -248,6 +288,16 @@ ot_int network_route_ff(m2session* active) {
 #   endif
     }
     
+    /// Multiframe packet: the payloads of the M2DP frames after this one are
+    /// appended to its payload, so the upper layers get them as one.
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+    if (rxq.front[1] & M2LC_FRCONT) {
+        if (sub_m2dp_join(pkt_end) == False) {
+            return -1;
+        }
+    }
+#   endif
+    
     /// Handle rest of M2NP header fields
     if (use_m2np) {
         /// Grab Source Address from this packet (dialog address), which is 
@@ -319,10 +369,12 @@ ot_int network_route_ff(m2session* active) {
         }
     }
     
-    /// M2DP is merely a continuation of the last frame
+    /// M2DP is merely a continuation of the last frame.  In a multiframe
+    /// packet, it was appended to the M2NP payload above.
     else {
-        ///@todo m2dp_parse_frame()
+        ///@todo m2dp_parse_frame() for an M2DP packet on its own
         //route_val = m2dp_parse_frame(active);
+        route_val = -1;
     }
     
     /// Attach footer to response, if necessary
@@ -332,6 +384,75 @@ ot_int network_route_ff(m2session* active) {
 
     return route_val;
 }
+
+
+#if (M2_FEATURE(MULTIFRAME) == ENABLED)
+static ot_bool sub_m2dp_join(ot_u8* pkt_end) {
+/// The frames of the packet are back-to-back in rxq, from rxq.front, each one
+/// followed by its CRC16 and RS parity.  Each M2DP frame is checked against
+/// the M2NP frame, its DLLS payload is decrypted in place, and its payload is
+/// moved down to rxq.putcursor, over the CRC, parity and header before it.  A
+/// damaged frame, or one that is not part of the dialog, drops the packet.
+    ot_u8*  frame;
+    ot_u8*  next;
+    ot_u8*  data;
+    ot_u8*  end;
+    ot_u8   lctl;
+    ot_u8   dialog_id;
+
+    lctl        = rxq.front[1];
+    dialog_id   = rxq.front[5 + ((rxq.front[4] & M2FI_EXT) != 0)];
+    next        = rxq.front + em2_decode_framebytes(rxq.front);
+
+    /// The LC byte and the next frame are taken before the payload is moved,
+    /// because it goes over the header of the frame.
+    while (lctl & M2LC_FRCONT) {
+        frame   = next;
+        if ((frame + 6) > pkt_end) {
+            return False;
+        }
+        next    = frame + em2_decode_framebytes(frame);
+        data    = &frame[5];
+        end     = &frame[frame[0]];
+        if (end > pkt_end) {
+            return False;
+        }
+
+        /// M2DP header: same subnet, no addressing, same Dialog ID
+        lctl    = frame[1];
+        if ((lctl & M2LC_DMGMARK) || (frame[3] != rxq.front[3]) \
+         || (frame[4] & M2FI_ADDRMASK)) {
+            return False;
+        }
+        data += ((frame[4] & M2FI_EXT) != 0);
+        if (*data++ != dialog_id) {
+            return False;
+        }
+
+        /// DLLS uses the key of the M2NP frame, which is now key 0, and the
+        /// nonce starts at the Dialog ID, as in M2NP.
+        if (frame[4] & M2FI_DLLS) {
+#       if (OT_FEATURE(DLL_SECURITY))
+            ot_int lendiff;
+            lendiff = auth_decrypt(data-1, data+6, (ot_uint)(end - (data+6)), 0, 0);
+            if (lendiff < 0) {
+                return False;
+            }
+            data   += 6;
+            end    -= lendiff;
+#       else
+            return False;
+#       endif
+        }
+
+        /// The payload only moves down, so a forward copy is safe
+        while (data < end) {
+            *rxq.putcursor++ = *data++;
+        }
+    }
+    return True;
+}
+#endif
 #endif
 
 
@@ -351,6 +472,8 @@ void m2np_header(m2session* active, ot_u8 addressing, ot_u8 nack) {
 /// Build an M2NP header, which gets forwarded in all cases to M2QP at the 
 /// transport layer, and which has NM2=0, Frame_Type={0,1}
 
+    ot_u16 lctl;
+
     /// Prep txq 
     q_empty(&txq);
     //q_start(&txq, 0, 0);
@@ -367,13 +490,9 @@ void m2np_header(m2session* active, ot_u8 addressing, ot_u8 nack) {
         txq.back        = txq.getcursor + maxframe;
     }
     
-    /// Write early header bytes:
-    /// <LI> Null Length (Actual length is deposited after frame done) </LI>
-    /// <LI> Null LC bits (FR-Cont, Blockcode, CRC5 deposited in encoder)
-    /// <LI> Null TX EIRP (Actual value deposited in PHY) </LI>
-    /// <LI> Subnet Value </LI>
-    q_writeshort(&txq, (ot_u16)((active->flags & M2_FLAG_RSCODE) << 3) );
-    q_writeshort(&txq, (ot_u16)active->subnet);
+    /// Link Control has only the Blockcode bit here (FR-Cont and CRC5 are
+    /// deposited in the encoder).  It is taken before the flags change below.
+    lctl = (ot_u16)((active->flags & M2_FLAG_RSCODE) << 3);
     
 #   if (M2_FEATURE(MULTIHOP) != ENABLED)    
     active->flags &= M2_FLAG_ROUTE;
@@ -401,6 +520,24 @@ void m2np_header(m2session* active, ot_u8 addressing, ot_u8 nack) {
     /// Save & Write Frame Info Byte
     m2np.header.fr_info     = addressing;
     m2np.header.fr_info    |= ((active->extra & 0x0F) != 0) << 3;   //M2FI_EXT
+    
+    /// If the template of this addressing mode has the same session parameters,
+    /// the header up to the target address is a copy of it.  Else build it and
+    /// save it.
+#   if (M2_FEATURE(HDRCACHE) == ENABLED)
+    if (sub_tmpl_load(active, (ot_u8)lctl)) {
+        goto m2np_header_TARGET;
+    }
+#   endif
+    
+    /// Write early header bytes:
+    /// <LI> Null Length (Actual length is deposited after frame done) </LI>
+    /// <LI> Null LC bits (FR-Cont, Blockcode, CRC5 deposited in encoder)
+    /// <LI> Null TX EIRP (Actual value deposited in PHY) </LI>
+    /// <LI> Subnet Value </LI>
+    /// <LI> Frame Info </LI>
+    q_writeshort(&txq, lctl);
+    q_writeshort(&txq, (ot_u16)active->subnet);
     q_writebyte(&txq, m2np.header.fr_info);
     
     /// Write Extra Flags Byte, if set
@@ -426,6 +563,11 @@ void m2np_header(m2session* active, ot_u8 addressing, ot_u8 nack) {
     /// Write This Source Device ID (always present in M2NP)
     m2np_put_deviceid( (ot_bool)(m2np.header.fr_info & M2FI_VID) );
 
+#   if (M2_FEATURE(HDRCACHE) == ENABLED)
+    sub_tmpl_save();
+    m2np_header_TARGET:
+#   endif
+
     /// If required, enabled NLS.  The rules are basically the same as DLLS.
     /// @todo Experimental!
 #   if (OT_FEATURE(NL_SECURITY))
@@ -467,6 +609,61 @@ void m2np_header(m2session* active, ot_u8 addressing, ot_u8 nack) {
 
 
 
+#if ((M2_FEATURE(HDRCACHE) == ENABLED) && !defined(EXTF_m2np_header))
+static ot_bool sub_tmpl_load(m2session* active, ot_u8 lctl) {
+    m2np_tmpl*  tmpl;
+    ot_u8*      front;
+    ot_int      dialog;
+    ot_u8       check;
+    
+    tmpl    = &m2np_tmpls[m2np.header.fr_info & M2FI_ADDRMASK];
+    dialog  = 5 + ((m2np.header.fr_info & M2FI_EXT) != 0);
+    
+    check   = (tmpl->length == 0);
+    check  |= tmpl->fr_info ^ m2np.header.fr_info;
+    check  |= tmpl->data[1] ^ lctl;
+    check  |= tmpl->data[3] ^ active->subnet;
+    if (dialog == 6) {
+        check |= tmpl->data[5] ^ active->extra;
+    }
+    if (check != 0) {
+        return False;
+    }
+    
+    /// Copy the template, then patch the bytes that change with each frame:
+    /// Length and TX EIRP go back to null (m2np_footer() and the PHY deposit
+    /// them), and the Dialog ID and DLLS nonce are this frame's.
+    front = txq.getcursor;
+    ot_memcpy(front, tmpl->data, tmpl->length);
+    front[0]        = 0;
+    front[2]        = 0;
+    front[dialog]   = active->dialog_id;
+    
+#   if (OT_FEATURE(DLL_SECURITY))
+    if (m2np.header.fr_info & M2FI_DLLS) {
+        auth_putnonce(&front[dialog+1], 6);
+    }
+#   endif
+    
+    txq.putcursor = front + tmpl->length;
+    return True;
+}
+
+
+static void sub_tmpl_save(void) {
+    m2np_tmpl*  tmpl;
+    ot_int      length;
+    
+    tmpl            = &m2np_tmpls[m2np.header.fr_info & M2FI_ADDRMASK];
+    length          = q_span(&txq);
+    tmpl->length    = (ot_u8)length;
+    tmpl->fr_info   = m2np.header.fr_info;
+    ot_memcpy(tmpl->data, txq.getcursor, length);
+}
+#endif
+
+
+
 void m2np_put_deviceid(ot_bool use_vid) {
     if (use_vid) q_writeshort_be(&txq, *(ot_u16*)dll.netconf.vid);
     else         q_writestring(&txq, dll.netconf.uid, 8);
@@ -505,6 +702,19 @@ ot_bool m2np_idcmp(ot_int length, ot_u8* id) {
 
 
 
+#ifndef EXTF_m2np_flush
+OT_WEAK void m2np_flush(void) {
+#   if ((M2_FEATURE(HDRCACHE) == ENABLED) && !defined(EXTF_m2np_header))
+    m2np_tmpls[0].length = 0;
+    m2np_tmpls[1].length = 0;
+    m2np_tmpls[2].length = 0;
+    m2np_tmpls[3].length = 0;
+#   endif
+}
+#endif
+
+
+
 #ifndef EXTF_m2np_footer
 OT_WEAK void m2np_footer() {
     ot_int block_bytes;
@@ -660,7 +870,47 @@ OT_WEAK void m2advp_close() {
 OT_WEAK void m2dp_append() {
 ///@note M2DP usage is being replaced, not as as an idependent frame type but
 ///      simply as a continuation frame for M2NP
+    ot_u8*  last;
+    ot_u8*  next;
+    ot_u8*  limit;
+
+    /// Find the last frame of the packet and mark it as continued.  Frames are
+    /// queued back-to-back, each with room after it for CRC & RS parity.
+    last = txq.front;
+    while (last[1] & M2LC_FRCONT) {
+        last += last[0] + 1 + em2_frame_overhead(last);
+    }
+    last[1]    |= M2LC_FRCONT;
+    next        = last + last[0] + 1 + em2_frame_overhead(last);
+
+    /// The new frame is open for writing, up to the max frame size or to the
+    /// end of the buffer.
+    limit           = txq.front + txq.alloc;
+    txq.getcursor   = next;
+    txq.putcursor   = next;
+    txq.back        = next + ((last[1] & M2LC_RSCODE) ? 221 : 254);
+    if (txq.back > limit) {
+        txq.back = limit;
+    }
+
+    /// Write the header.  Length is deposited in m2dp_footer(), LC bits and
+    /// TX EIRP like M2NP.  Subnet and Dialog ID are the same as the frame
+    /// before, and Frame Info keeps the listen and security flags, with no
+    /// addressing (that is what makes it M2DP).
+    q_writeshort(&txq, (ot_u16)(last[1] & M2LC_RSCODE));
+    q_writeshort(&txq, (ot_u16)last[3]);
+    m2np.header.fr_info &= (M2FI_LISTEN | M2FI_CRYPTO);
+    q_writebyte(&txq, m2np.header.fr_info);
+    q_writebyte(&txq, last[5 + ((last[4] & M2FI_EXT) != 0)]);
 
+    /// DLLS Nonce, as in M2NP.  The key is the one used by the M2NP frame.
+#   if (OT_FEATURE(DLL_SECURITY))
+    if (m2np.header.fr_info & M2FI_DLLS) {
+        ot_u8* nonce    = txq.putcursor;
+        txq.putcursor  += 6;
+        auth_putnonce(nonce, 6);
+    }
+#   endif
 }
 #endif
 
@@ -669,7 +919,13 @@ OT_WEAK void m2dp_append() {
 #ifndef EXTF_m2dp_footer
 OT_WEAK void m2dp_footer() {
 /// M2DP is similar enough to M2NP that the same footer function may be used.
+/// Afterwards, txq.back marks the end of the packet, and the TX window goes
+/// back to the first frame, which is where the encoder starts.
     m2np_footer();
+    txq.back        = txq.getcursor + txq.getcursor[0] + 1;
+    txq.back       += em2_frame_overhead(txq.getcursor);
+    txq.getcursor   = txq.front;
+    txq.putcursor   = txq.front + txq.front[0] + 1;
 }
 #endif
 
@@ -33,6 +33,7 @@
 #include <m2/dll.h>
 
 #include <otlib/buffers.h>
+#include <otlib/memcpy.h>
 #include <otsys/veelite.h>
 
 
@@ -55,10 +56,6 @@
 #define _PREDATA_US_01          (_PREDATA_BYTES*_8SYMBOLS_US_01)
 #define _PREDATA_US_10          (_PREDATA_BYTES*_8SYMBOLS_US_10)
 
-#define _8SYMBOLS_MITI_00       (634)       //8 symbols @ 13.24 kHz
-#define _8SYMBOLS_MITI_01       (159)       //8 symbols @ 53 kHz
-#define _8SYMBOLS_MITI_10       (80)        //8 symbols @ 106 kHz
-
 #define _BGPKT_TICKS_00         (((_OVERHEAD_US_00+_PREDATA_US_00+(7*_8SYMBOLS_US_00))+976) / 977)
 #define _BGPKT_TICKS_01         (((_OVERHEAD_US_01+_PREDATA_US_01+(7*_8SYMBOLS_US_01))+976) / 977)
 #define _BGPKT_TICKS_10         (((_OVERHEAD_US_10+_PREDATA_US_10+(7*_8SYMBOLS_US_10))+976) / 977)
@@ -95,17 +92,21 @@ radio_struct    radio;
   * transceiver preferences, and encoding.
   */
 
-static const ot_u8 preheader_ti[4] = {
-    ((_OVERHEAD_US_00+_PREDATA_US_00+976)/977),    // xx00
-    ((_OVERHEAD_US_01+_PREDATA_US_01+976)/977),    // xx01
-    ((_OVERHEAD_US_10+_PREDATA_US_10+976)/977),    // xx10
-    0                                           // xx11 (RFU)
+/// Airtime constants are in 1/16 miti (2^-24 sec) so that the error of the
+/// per-byte figure does not add up over a long frame.  us * 16.777 = 1/16 miti
+#define _US2SMITI(US)           (((ot_u32)(US)*16777 + 500) / 1000)
+
+static const ot_u32 preheader_smiti[4] = {
+    _US2SMITI(_OVERHEAD_US_00+_PREDATA_US_00),      // xx00
+    _US2SMITI(_OVERHEAD_US_01+_PREDATA_US_01),      // xx01
+    _US2SMITI(_OVERHEAD_US_10+_PREDATA_US_10),      // xx10
+    0                                               // xx11 (RFU)
 };
 
-static const ot_u16 byte_miti[4] = {
-    _8SYMBOLS_MITI_00,
-    _8SYMBOLS_MITI_01,
-    _8SYMBOLS_MITI_10,
+static const ot_u16 byte_smiti[4] = {
+    _US2SMITI(_8SYMBOLS_US_00),
+    _US2SMITI(_8SYMBOLS_US_01),
+    _US2SMITI(_8SYMBOLS_US_10),
     0
 };
 
@@ -151,6 +152,60 @@ static const ot_u8 tgd_ti[16] = {
 
 
 
+/** Compiled Channel Table
+  * The channel configuration ISF is compiled into RAM the first time it is
+  * needed, and again after it gets written (its Veelite generation changes).
+  * Entries are in file order, up to M2_PARAM_CHANTABLE of them, and each one
+  * has the TX EIRP already clipped and the CCA threshold already in native
+  * encoding.  The CS threshold is kept in DASH7 encoding, because the adaptive
+  * offset (radio.link.offset_thr) is added to it when the channel is entered.
+  */
+#define _CHANTABLE_GEN()        vl_generation(VL_ISF_BLOCKID, ISF_ID(channel_configuration))
+
+#if defined(ISF_MAX_channel_configuration)
+#   if (M2_PARAM(CHANTABLE) < ((ISF_MAX_channel_configuration-6)/6))
+#       warning "M2_PARAM_CHANTABLE is smaller than the channel configuration ISF: channels at the end are ignored"
+#   endif
+#endif
+
+typedef struct {
+    ot_u8   id;
+    ot_u8   tx_eirp;
+    ot_u8   link_qual;
+    ot_u8   raw_thr;
+    ot_u8   cca_thr;
+} rm2_chanentry;
+
+typedef struct {
+    ot_bool         valid;
+    ot_u8           flags;
+    ot_u16          gen;
+    ot_u8           count;
+    rm2_chanentry   entry[M2_PARAM_CHANTABLE];
+} rm2_chantable_struct;
+
+static rm2_chantable_struct rm2_chantable;
+
+
+
+/** Airtime Model
+  * Airtime parameters of the active channel (phymac[0].channel).  It is built
+  * by rm2_airtime_refresh() when the channel changes, so the airtime of a
+  * frame is one multiply-add.
+  */
+typedef struct {
+    ot_u8   channel;
+    ot_u8   fec;
+    ot_u16  byte_smiti;
+    ot_u32  pre_smiti;
+} rm2_airtime_struct;
+
+static rm2_airtime_struct rm2_air = { 0xF0, 0, 0, 0 };
+
+
+
+
+
 /** Radio-Agnostic Mode 2 Library Functions    <BR>
   * ========================================================================<BR>
   * Mode 2 specific virtual PHYMAC functionality, implemented in radio_task.c 
@@ -185,6 +240,7 @@ OT_WEAK void rm2_init(void) {
     /// necessary settings and calibration will always occur. 
     phymac[0].channel   = 0xF0;
     phymac[0].tx_eirp   = 0x7F;
+    rm2_chantable.valid = False;
     fp                  = ISF_open_su( ISF_ID(channel_configuration) );
     rm2_channel_lookup(0x18, fp);
     vl_close(fp);
@@ -251,37 +307,79 @@ OT_WEAK ot_uint rm2_rxtimeout_floor(ot_u8 chan_id) {
 
 
 
-#ifndef EXTF_rm2_pkt_duration
-/*
-OT_WEAK ot_uint rm2_pkt_duration(ot_queue* pkt_q) {
-/// Wrapper function for rm2_scale_codec that adds some slop overhead
-/// Slop = preamble bytes + sync bytes + ramp-up + ramp-down + padding
-    ot_uint pkt_bytes;
-    
-    pkt_bytes   = q_length(pkt_q);
-    pkt_bytes  += RF_PARAM_PKT_OVERHEAD;
-    
-    // If packet is using RS coding, adjust by the nominal rate (4/5).
-    if (pkt_q->front[1] & 0x40) {
-        pkt_bytes += (pkt_bytes+3)>>2;
+#ifndef EXTF_rm2_airtime_refresh
+OT_WEAK void rm2_airtime_refresh(void) {
+    ot_u8 encoding;
+    encoding            = phymac[0].channel >> 4;
+    rm2_air.channel     = phymac[0].channel;
+    rm2_air.fec         = (encoding & 0x08);
+    rm2_air.byte_smiti  = byte_smiti[encoding & 3];
+    rm2_air.pre_smiti   = preheader_smiti[encoding & 3];
+}
+#endif
+
+
+
+static ot_u32 sub_payload_smiti(ot_uint buf_bytes) {
+/// Payload airtime on the active channel, in 1/16 miti
+    if (rm2_air.channel != phymac[0].channel) {
+        rm2_airtime_refresh();
     }
-    
-    return rm2_scale_codec(pkt_bytes);
+
+    // If channel is FEC'ed
+    if (rm2_air.fec) {
+        buf_bytes  &= ~1;   // make even
+        buf_bytes  += 2;    // add trellis terminator with interleaving
+        buf_bytes <<= 1;    // make half rate
+    }
+
+    // If channel is spread (presently unused)
+    //if (encoding & 0x04) {
+    //    buf_bytes *= 7;
+    //}
+
+    return (ot_u32)buf_bytes * rm2_air.byte_smiti;
 }
-*/
-OT_WEAK ot_uint rm2_pkt_duration(ot_queue* pkt_q) {
+
+
+
+#ifndef EXTF_rm2_airtime
+OT_WEAK ot_u32 rm2_airtime(ot_uint frame_bytes) {
+    ot_u32 smiti;
+    smiti   = sub_payload_smiti(frame_bytes);
+    smiti  += rm2_air.pre_smiti;
+    return (smiti + 15) >> 4;
+}
+#endif
+
+
+
+#ifndef EXTF_rm2_pkt_airtime
+OT_WEAK ot_u32 rm2_pkt_airtime(ot_queue* pkt_q) {
     ot_uint pkt_bytes;
-    ot_uint pkt_duration;
 
     pkt_bytes = q_length(pkt_q);
+#   if (M2_FEATURE(MULTIFRAME) == ENABLED)
+    if (pkt_q->front[1] & 0x80) {
+        // Multiframe packet: the last frame ends at the queue back
+        pkt_bytes = (ot_uint)(pkt_q->back - pkt_q->front);
+    }
+#   endif
     if (pkt_q->front[1] & 0x40) {
         // If packet is using RS coding, adjust by the nominal rate (+25%).
         pkt_bytes += (pkt_bytes+3)>>2;
     }
 
-    pkt_duration    = rm2_scale_codec(pkt_bytes);
-    pkt_duration   += preheader_ti[(phymac[0].channel>>4) & 3];
-    return pkt_duration;
+    return rm2_airtime(pkt_bytes);
+}
+#endif
+
+
+
+#ifndef EXTF_rm2_pkt_duration
+OT_WEAK ot_uint rm2_pkt_duration(ot_queue* pkt_q) {
+/// Preheader and payload are added before rounding up to ticks
+    return (ot_uint)((rm2_pkt_airtime(pkt_q) + 1023) >> 10);
 }
 #endif
 
@@ -309,33 +407,6 @@ OT_WEAK ot_uint rm2_bgpkt_duration() {
 
 
 #ifndef EXTF_rm2_scale_codec
-/*
-OT_WEAK ot_uint rm2_scale_codec(ot_uint buf_bytes) {
-/// Turns a number of bytes (buf_bytes) into a number of ti units.
-/// To refresh your memory: 
-/// 1 ti    = ((1sec/32768) * 2^5) = 2^-10 sec = ~0.977 ms
-/// 1 miti   = 1/1024 ti = 2^-20 sec = ~0.954us
-///
-/// Implementation follows derivation below:
-/// pkt_duration(ti) = ( (buf_bytes*bit_us[X]/(1024/8) )
-///
-/// Supported Data rates below:
-/// Low-Speed + Non-FEC = 18.88 miti/bit (55.55 kbps)
-/// Low-Speed + FEC     = 37.75 miti/bit (27.77 kbps)
-/// Hi-Speed + Non-FEC  = 5.24 miti/bit  (200 kbps)
-/// Hi-Speed + FEC      = 10.49 miti/bit (100 kbps)
-    
-    static const ot_u8 bit_us[4] = { 19, 38, 6, 11 };   
-    
-    ot_u8 index = ((phymac[0].channel & 0x20)>>4) + (phymac[0].channel >> 7);
-    buf_bytes  *= bit_us[index];
-    //buf_bytes >>= 7;              ///@note revert this
-    //buf_bytes >>= 2;
-    buf_bytes >>= 4;
-
-    return buf_bytes;
-}
-*/
 OT_WEAK ot_uint rm2_scale_codec(ot_uint buf_bytes) {
 /// Turns a number of bytes (buf_bytes) into a number of ti units.
 /// To refresh your memory:
@@ -350,28 +421,10 @@ OT_WEAK ot_uint rm2_scale_codec(ot_uint buf_bytes) {
 /// Low-Speed + FEC     = 37.75 miti/bit (27.77 kbps)
 /// Hi-Speed + Non-FEC  = 5.24 miti/bit  (200 kbps)
 /// Hi-Speed + FEC      = 10.49 miti/bit (100 kbps)
+    ot_u32 smiti;
+    smiti = sub_payload_smiti(buf_bytes);
 
-    ot_ulong bytes_miti;
-    ot_u8 encoding;
-
-    encoding = (phymac[0].channel >> 4);
-
-    // If channel is FEC'ed
-    if (encoding & 0x08) {
-        buf_bytes  &= ~1;   // make even
-        buf_bytes  += 2;    // add trellis terminator with interleaving
-        buf_bytes <<= 1;    // make half rate
-    }
-
-    // If channel is spread (presently unused)
-    //if (encoding & 0x04) {
-    //    buf_bytes *= 7;
-    //}
-
-    bytes_miti  = buf_bytes * byte_miti[encoding & 3];
-    bytes_miti += 1023;
-
-    return (ot_uint)(bytes_miti >> 10);
+    return (ot_uint)((smiti + 16383) >> 14);
 }
 #endif
 
@@ -403,17 +456,13 @@ OT_WEAK ot_bool rm2_mac_filter() {
 
 #ifndef EXTF_rm2_test_channel
 OT_WEAK ot_bool rm2_test_channel(ot_u8 channel) {
+/// The channel table is in RAM, so the file is only opened if the table must
+/// be compiled (rm2_channel_lookup() does that when fp is NULL).
     ot_bool test;
 
     test = rm2_channel_fastcheck(channel);
     if (test == False) {
-        vlFILE* fp;
-        /// Open the Mode 2 FS Config register that contains the channel list
-        /// for this host, and make sure the channel we want to use is available
-        /// @todo assert fp
-        fp      = ISF_open_su( ISF_ID(channel_configuration) );
-        test    = rm2_channel_lookup(channel, fp);
-        vl_close(fp);
+        test = rm2_channel_lookup(channel, NULL);
     }
 
     return test;
@@ -423,12 +472,8 @@ OT_WEAK ot_bool rm2_test_channel(ot_u8 channel) {
 
 #ifndef EXTF_rm2_test_chanlist
 OT_WEAK ot_bool rm2_test_chanlist() {
-    vlFILE* fp;
     ot_int  i;
 
-    fp = ISF_open_su( ISF_ID(channel_configuration) );
-    ///@todo assert fp
-
     /// Go through the list of tx channels
     /// <LI> Make sure the channel ID is valid. </LI>
     /// <LI> Make sure the transmission can fit within the contention period. </LI>
@@ -436,10 +481,9 @@ OT_WEAK ot_bool rm2_test_chanlist() {
     for (i=0; i<dll.comm.tx_channels; i++) {
         ot_u8 next_channel = dll.comm.tx_chanlist[i];
         if (rm2_channel_fastcheck(next_channel))        break;
-        if (rm2_channel_lookup(next_channel, fp))       break;
+        if (rm2_channel_lookup(next_channel, NULL))     break;
     }
 
-    vl_close(fp);
     return (ot_bool)(i < dll.comm.tx_channels);
 }
 #endif
@@ -456,61 +500,104 @@ OT_WEAK ot_bool rm2_channel_fastcheck(ot_u8 chan_id) {
 #endif
 
 
+static void sub_compile_chantable(vlFILE* fp) {
+/// Entries are 6 bytes, starting at offset 6 of the file.  The channel list is
+/// not necessarily sorted, so the table keeps the file order, and lookup uses
+/// the first entry that matches.  Spectrum IDs are 6 bits, so entries with
+/// higher IDs can never match, and they are not compiled.
+    ot_uni16        scratch;
+    ot_int          i;
+    rm2_chanentry*  entry;
+
+    rm2_chantable.count = 0;
+    rm2_chantable.gen   = _CHANTABLE_GEN();
+
+    /// Populate the phymac flags: these are not frequently used
+    scratch.ushort      = vl_read(fp, 2);
+    rm2_chantable.flags = scratch.ubyte[UPPER];
+
+    for (i=6; (i<fp->length) && (rm2_chantable.count<M2_PARAM_CHANTABLE); i+=6) {
+        entry           = &rm2_chantable.entry[rm2_chantable.count];
+        scratch.ushort  = vl_read(fp, i);
+        entry->id       = scratch.ubyte[0];
+        if (entry->id > 0x3F) {
+            continue;
+        }
+
+        scratch.ushort      = vl_read(fp, i+2);
+        entry->tx_eirp      = (scratch.ubyte[0] & 0x80) | rm2_clip_txeirp(scratch.ubyte[0]);
+        entry->link_qual    = scratch.ubyte[1];
+
+        /// Convert CCA threshold from DASH7 numeric encoding to native encoding
+        scratch.ushort      = vl_read(fp, i+4);
+        entry->raw_thr      = scratch.ubyte[0];
+        entry->cca_thr      = rm2_calc_rssithr( scratch.ubyte[1] );
+        rm2_chantable.count++;
+    }
+
+    rm2_chantable.valid = True;
+}
+
+
+
 #ifndef EXTF_rm2_channel_lookup
 OT_WEAK ot_bool rm2_channel_lookup(ot_u8 chan_id, vlFILE* fp) {
 /// Called during channel scans.
 /// Duty: (a) See if the supplied channel is supported on this device & config.
 ///       If yes, return true.  (b) Determine if recalibration is required
 ///       before changing to the new channel, and recalibrate if so.
-    ot_u8       spectrum_id;
-    ot_int      i;
-    ot_uni16    scratch;
+    ot_u8           spectrum_id;
+    ot_u8           old_chan_id;
+    ot_u8           old_tx_eirp;
+    ot_u8           i;
+    rm2_chanentry*  entry;
+
+    /// Compile the channel table if the file has been written since the last
+    /// time it was compiled
+    if ((rm2_chantable.valid == False) || (rm2_chantable.gen != _CHANTABLE_GEN())) {
+        if (fp != NULL) {
+            sub_compile_chantable(fp);
+        }
+        else {
+            fp = ISF_open_su( ISF_ID(channel_configuration) );
+            if (fp == NULL) {
+                return False;
+            }
+            sub_compile_chantable(fp);
+            vl_close(fp);
+        }
+    }
 
     // Strip the FEC & Spread bits
-    spectrum_id = chan_id & 0x3F;
-
-    /// Populate the phymac flags: these are not frequently used
-    /// @todo I might want to do this in radio_init() instead
-    scratch.ushort  = vl_read(fp, 2);
-    phymac[0].flags = scratch.ubyte[UPPER];
-
-    /// Look through the channel list to find the one with matching spectrum id.
-    /// The channel list is not necessarily sorted.
-    /// @todo might do this with vl_get() in the future
-    for (i=6; i<fp->length; i+=6) {
-        scratch.ushort = vl_read(fp, i);
-
-        if ((spectrum_id == scratch.ubyte[0]) \
-        || ((spectrum_id & 0xF0) == scratch.ubyte[0])) {
-            ot_u8 old_chan_id   = phymac[0].channel;
-            ot_u8 old_tx_eirp   = (phymac[0].tx_eirp & 0x7f);
-
-            phymac[0].tg        = rm2_default_tgd(chan_id);
-            phymac[0].channel   = chan_id;
-          //phymac[0].autoscale = scratch.ubyte[1];
-
-            scratch.ushort      = vl_read(fp, i+2);
-            phymac[0].tx_eirp   = scratch.ubyte[0] & 0x80;
-            phymac[0].tx_eirp  |= rm2_clip_txeirp(scratch.ubyte[0]);
-            phymac[0].link_qual = scratch.ubyte[1];
-
-            ///@todo Try this: *(ot_u16*)&phymac[0].cs_thr = vl_read(fp, i+4);  
-            ///it will need some rearrangement in phymac struct
-            /// Convert thresholds from DASH7 numeric encoding to native encoding
-            scratch.ushort      = vl_read(fp, i+4);
-            //phymac[0].cs_thr    = __THR(scratch.ubyte[0]);
-            //phymac[0].cca_thr   = scratch.ubyte[1];
-            //phymac[0].cs_thr    = rm2_calc_rssithr(phymac[0].cs_thr);
-            //phymac[0].cca_thr   = rm2_calc_rssithr(phymac[0].cca_thr);
-            radio.link.raw_thr  = scratch.ubyte[0];
-            phymac[0].cs_thr    = rm2_calc_rssithr( (ot_u8)(radio.link.raw_thr + radio.link.offset_thr) );
-            phymac[0].cca_thr   = rm2_calc_rssithr( scratch.ubyte[1] );
-            
-            rm2_enter_channel(old_chan_id, old_tx_eirp);
-            return True;
+    phymac[0].flags = rm2_chantable.flags;
+    spectrum_id     = chan_id & 0x3F;
+
+    /// Find the first entry with the spectrum ID, or with its upper nibble
+    /// (entries with lower nibble 0 are wildcards)
+    for (i=0; i<rm2_chantable.count; i++) {
+        if ((rm2_chantable.entry[i].id == spectrum_id) \
+        ||  (rm2_chantable.entry[i].id == (spectrum_id & 0xF0))) {
+            break;
         }
     }
-    return False;
+    if (i == rm2_chantable.count) {
+        return False;
+    }
+
+    entry               = &rm2_chantable.entry[i];
+    old_chan_id         = phymac[0].channel;
+    old_tx_eirp         = (phymac[0].tx_eirp & 0x7f);
+
+    phymac[0].tg        = rm2_default_tgd(chan_id);
+    phymac[0].channel   = chan_id;
+    phymac[0].tx_eirp   = entry->tx_eirp;
+    phymac[0].link_qual = entry->link_qual;
+    radio.link.raw_thr  = entry->raw_thr;
+    phymac[0].cs_thr    = rm2_calc_rssithr( (ot_u8)(radio.link.raw_thr + radio.link.offset_thr) );
+    phymac[0].cca_thr   = entry->cca_thr;
+
+    rm2_enter_channel(old_chan_id, old_tx_eirp);
+    return True;
 }
 #endif
 
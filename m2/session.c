@@ -16,18 +16,16 @@
 /**
   * @file       /otlib/session.c
   * @author     JP Norair
-  * @version    R102
-  * @date       20 Mar 2014
+  * @version    R103
+  * @date       18 Oct 2014
   * @brief      DASH7 M2 (ISO 18000-7.4) Session Framework
   * @ingroup    Session
   *
   * The session stack is not exposed, because it may be implemented in a lot of
-  * different ways.  The way it is implemented here is not very efficient for
-  * stacks any larger than a small few elements (maybe 4).  Many devices only
-  * need one session, and even more can do fine with just two, so it is not a
-  * big deal, yet.  For a complex device with large functionality, you would
-  * probably want to do change the data-copying method used here to some sort
-  * of pointer shifting method.
+  * different ways.  The way it is implemented here is an index-linked list
+  * over a static heap of sessions, with a free list.  Sessions never move, so
+  * push, pop, extend, and continue are all O(1), regardless of the depth of
+  * the stack.  This matters for gateways that run dozens of dialogs at once.
   *
   ******************************************************************************
   */
@@ -38,9 +36,10 @@
 #include <otlib/rand.h>
 
 #define _1ST    0
-#define _2ND    1
 #define _LAST   (OT_PARAM(SESSION_DEPTH)-1)
-#define _END    (OT_PARAM(SESSION_DEPTH))
+#define _END    (OT_PARAM(SESSION_DEPTH))       // Null index & empty session
+
+#define _TOP    session.link[_END]
 
 
 session_struct session;
@@ -51,26 +50,43 @@ void session_applet_null(m2session* a) { }
 
 
 
-#ifndef EXTF_session_init
-void session_init() {
-    session.top = &session.heap[_END];
-}
-#endif
 
+/** Subroutines
+  * ============================================================================
+  * The stack is a singly-linked list of heap indices.  link[_END] is the top of
+  * the stack and link[i] is the session after session i.  Free sessions are
+  * kept on a second list, starting at session.free.
+  *
+  * A joined session sequence starts at a session that was stored with
+  * M2_NETSTATE_INIT (or at the top), and seqend[] of its first session is the
+  * index of its last session.  Only the top session's netstate is altered by
+  * the layers above, so the sequence boundaries remain valid.
+  */
 
+static void sub_settop(ot_u8 i) {
+    _TOP        = i;
+    session.top = &session.heap[i];
+}
 
-#ifndef EXTF_session_getnext
-OT_WEAK ot_uint session_getnext() {
-/// Not idiot proof.  Do not call this unless you have already checked
-/// session_notempty().
-    ot_uint wait;
-    wait                    = session.top->counter;
-    session.top->counter    = 0;
-    return wait;
+
+static ot_u8 sub_alloc(void) {
+    ot_u8 i;
+    i               = session.free;
+    session.free    = session.link[i];
+    session.count++;
+    return i;
 }
-#endif
 
 
+static void sub_insert(ot_u8 prev, ot_u8 i) {
+/// Link session i after session prev, which may be _END for the top.
+    session.link[i]     = session.link[prev];
+    session.link[prev]  = i;
+    session.seqend[i]   = i;
+    if (session.link[i] == _END) {
+        session.last    = i;
+    }
+}
 
 
 m2session* sub_store_session(m2session* store, ot_app applet, ot_u16 wait, ot_u8 netstate, ot_u8 channel) {
@@ -86,28 +102,66 @@ m2session* sub_store_session(m2session* store, ot_app applet, ot_u16 wait, ot_u8
 
 
 
+
+/** Session Public Functions
+  * ============================================================================
+  */
+
+#ifndef EXTF_session_init
+void session_init() {
+    ot_u8 i;
+
+    for (i=_1ST; i<_LAST; i++) {
+        session.link[i] = i+1;
+    }
+    session.link[_LAST] = _END;
+    session.free        = _1ST;
+    session.count       = 0;
+    session.last        = _END;
+    session.lasthead    = _END;
+    sub_settop(_END);
+}
+#endif
+
+
+
+#ifndef EXTF_session_getnext
+OT_WEAK ot_uint session_getnext() {
+/// Not idiot proof.  Do not call this unless you have already checked
+/// session_notempty().
+    ot_uint wait;
+    wait                    = session.top->counter;
+    session.top->counter    = 0;
+    return wait;
+}
+#endif
+
+
+
 #ifndef EXTF_session_new
 OT_WEAK m2session* session_new(ot_app applet, ot_u16 wait, ot_u8 channel, ot_u8 netstate) {
-    ot_u8* src;
-    ot_uint length;
+    ot_u8 i;
 
     // Always reserve an extra session for extension.
     // i.e. There must be two or more free sessions to do session_new()
-    if (session.top <= &session.heap[_2ND] ) {
+    if (session.count >= (OT_PARAM(SESSION_DEPTH)-1)) {
         return NULL;
     }
 
-    // We're adding a new session to the bottom of the heap/stack/queue...
-    src         = (ot_u8*)session.top;
-    session.top--;
-    length      = (ot_uint)((ot_u8*)&session.heap[_END] - src);
+    // We're adding a new session to the bottom of the stack.  It starts a new
+    // sequence if it is INIT or the only session, else it joins the last one.
+    i = sub_alloc();
+    sub_insert(session.last, i);
 
-    // Only do the copy if the size is not zero
-    if (length != 0) {
-        memcpy( (ot_u8*)session.top, src, length);
+    if ((_TOP == i) || (netstate & M2_NETSTATE_INIT)) {
+        session.lasthead = i;
+    }
+    else {
+        session.seqend[session.lasthead] = i;
     }
 
-    return sub_store_session(&session.heap[_LAST], applet, wait, netstate, channel);
+    sub_settop(_TOP);
+    return sub_store_session(&session.heap[i], applet, wait, netstate, channel);
 }
 #endif
 
@@ -115,51 +169,46 @@ OT_WEAK m2session* session_new(ot_app applet, ot_u16 wait, ot_u8 channel, ot_u8
 
 #ifndef EXTF_session_extend
 OT_WEAK m2session* session_extend(ot_app applet, ot_u16 wait, ot_u8 channel, ot_u8 netstate) {
-    m2session* extend;
+    ot_u8 i;
+    ot_u8 end;
 
     // If not one free session, there's no room!
-    if (session.top <= &session.heap[_1ST]) {
+    if (session.count >= OT_PARAM(SESSION_DEPTH)) {
         return NULL;
     }
 
-    // We're adding a new session...
-    session.top--;
-    extend = session.top;
-
-    // If the new session is on the last spot, it means the heap is actually
-    // empty, so no movement is necessary.  If heap is not empty and not full
-    // (we know this by condition above and condition below), go through the
-    // session heap to see where to put this extended session, and move all
-    // higher data one spot up.
-    if (extend < &session.heap[_LAST]) {
-        do {
-            // Increment session, noting that first increment simply counters
-            // "session.top--" above.
-            extend++;
-
-            // Inspect following session. If it is INIT, then we extend the
-            // session sequence below this point.  Else, following session is
-            // still part of the current session sequence, so keep looking.
-            if (extend[1].netstate & M2_NETSTATE_INIT) {
-                break;
-            }
-
-            // The above "if (session.top <= &session.heap[_1ST])" make it OK
-            // if we are at the 1st place in the session heap
-        } while (extend < &session.heap[_LAST]);
+    // If the stack is empty, the new session is the top.  Else, it is put
+    // after the end of the sequence that is at the top.
+    i = sub_alloc();
 
-        // Shift the stack down one notch, from top to extension point.
-        memcpy( (ot_u8*)session.top,
-                (ot_u8*)&session.top[1],
-                (ot_uint)((ot_u8*)extend - (ot_u8*)session.top) );
+    if (_TOP == _END) {
+        sub_insert(_END, i);
+        session.lasthead = i;
+    }
+    else {
+        end = session.seqend[_TOP];
+        sub_insert(end, i);
+
+        // An INIT session starts a sequence of its own, so later extensions
+        // still go ahead of it.
+        if (netstate & M2_NETSTATE_INIT) {
+            if (session.last == i) {
+                session.lasthead = i;
+            }
+        }
+        else {
+            session.seqend[_TOP] = i;
+        }
     }
 
-    return sub_store_session(extend, applet, wait, channel, netstate);
+    sub_settop(_TOP);
+    return sub_store_session(&session.heap[i], applet, wait, netstate, channel);
 }
 #endif
 
 
 
+
 #ifndef EXTF_session_continue
 OT_WEAK m2session* session_continue(ot_app applet, ot_u8 next_state, ot_uint wait) {
 ///@todo preliminary testing shows dll.comm.tc should not be the initial offset
@@ -197,23 +246,56 @@ OT_WEAK m2session* session_continue(ot_app applet, ot_u8 next_state, ot_uint wai
 #ifndef EXTF_session_occupied
 //DEPRECATED
 OT_WEAK ot_bool session_occupied(ot_u8 chan_id) {
-    m2session* next;
-    next = session.top;
+    ot_u8 i;
+    for (i=_TOP; i!=_END; i=session.link[i]) {
+        if (session.heap[i].channel == chan_id) {
+            return True;
+        }
+    }
+    return False;
+}
+#endif
+
+
+#ifndef EXTF_session_pop
+OT_WEAK void session_pop() {
+/// The follower inherits the sequence of the old top, unless the old top was
+/// the end of its sequence.  Popping an empty stack does nothing.
+    ot_u8 old;
+    ot_u8 next;
+
+    old = _TOP;
+    if (old != _END) {
+        next = session.link[old];
+        if (next == _END) {
+            session.last        = _END;
+            session.lasthead    = _END;
+        }
+        else if (session.seqend[old] != old) {
+            session.seqend[next] = session.seqend[old];
+            if (session.lasthead == old) {
+                session.lasthead = next;
+            }
+        }
 
-    while (next < &session.heap[_END]) {
-        next++;
+        sub_settop(next);
+        session.link[old]   = session.free;
+        session.free        = old;
+        session.count--;
     }
-    return (ot_bool)(next < &session.heap[_END]);
 }
 #endif
 
 
 #ifndef EXTF_session_scrap
 OT_WEAK void session_scrap() {
-    if (session.top != &session.heap[_END]) {
+    if (_TOP != _END) {
         m2session* old_top;
-        old_top = session.top++;
+        old_top = session.top;
+        session_pop();
 
+        // The popped session is free, but its data is intact until the next
+        // session_new() or session_extend().
         if (old_top->applet != NULL) {
             old_top->netstate = M2_NETSTATE_SCRAP;
             old_top->applet(old_top);
@@ -223,26 +305,13 @@ OT_WEAK void session_scrap() {
 #endif
 
 
-
-#ifndef EXTF_session_pop
-OT_WEAK void session_pop() {
-/// session.top++ will pop a session, but this routine includes protection
-/// against less-than-perfect API usage by assuring that session.top is
-/// only incremented when in bounds.
-    if (session.top != &session.heap[_END])
-        session.top++;
-}
-#endif
-
-
-
 #ifndef EXTF_session_flush
 OT_WEAK void session_flush() {
     while (session_notempty()) {
         if (session.top->netstate & M2_NETSTATE_INIT) {
             break;
         }
-        session.top++;      //session_pop();
+        session_pop();
     }
 }
 #endif
@@ -257,19 +326,15 @@ OT_WEAK m2session* session_top() {
 
 #ifndef EXTF_session_numfree
 OT_WEAK ot_int session_numfree() {
-    ot_uint block;
-    block   = (ot_uint)((ot_u8*)session.top - (ot_u8*)&session.heap[_1ST]);
-    block  /= sizeof(m2session);
-    block  -= 1;            //because we always keep one free for extensions
-
-    return (ot_int)block;
+    // -1 because we always keep one free for extensions
+    return (ot_int)(OT_PARAM(SESSION_DEPTH) - 1) - (ot_int)session.count;
 }
 #endif
 
 
 #ifndef EXTF_session_notempty
 OT_WEAK ot_bool session_notempty() {
-    return (session.top < &session.heap[_END]);
+    return (ot_bool)(_TOP != _END);
 }
 #endif
 
@@ -277,8 +342,8 @@ OT_WEAK ot_bool session_notempty() {
 
 #ifndef EXTF_session_follower
 OT_WEAK m2session* session_follower() {
-    if (session.top < &session.heap[_LAST]) {
-        return &session.top[1];
+    if (session.count > 1) {
+        return &session.heap[session.link[_TOP]];
     }
     return NULL;
 }
@@ -287,8 +352,8 @@ OT_WEAK m2session* session_follower() {
 
 #ifndef EXTF_session_follower_wait
 OT_WEAK ot_u16 session_follower_wait() {
-    if (session.top < &session.heap[_LAST]) {
-        return session.top[1].counter;
+    if (session.count > 1) {
+        return session.heap[session.link[_TOP]].counter;
     }
     return 65535;
 }
@@ -297,9 +362,20 @@ OT_WEAK ot_u16 session_follower_wait() {
 
 #ifndef EXTF_session_invite_follower
 OT_WEAK void session_invite_follower() {
-    if (session.top < &session.heap[_LAST]) {
-        session.top[1].counter      = 0;
-        session.top[1].netstate    &= ~M2_NETSTATE_INIT;
+/// Clearing INIT on the follower joins it (and its sequence) to the top one.
+    ot_u8 next;
+
+    if (session.count > 1) {
+        next = session.link[_TOP];
+        if ((session.seqend[_TOP] == _TOP) && \
+            (session.heap[next].netstate & M2_NETSTATE_INIT)) {
+            session.seqend[_TOP] = session.seqend[next];
+            if (session.lasthead == next) {
+                session.lasthead = _TOP;
+            }
+        }
+        session.heap[next].counter     = 0;
+        session.heap[next].netstate   &= ~M2_NETSTATE_INIT;
     }
 }
 #endif
@@ -308,17 +384,18 @@ OT_WEAK void session_invite_follower() {
 
 #ifndef EXTF_session_postpone_inactives
 OT_WEAK void session_postpone_inactives(ot_u16 postponement) {
-    m2session* next;
-    next = session.top;
-
-    while (next < &session.heap[_END]) {
-        if (next->netstate & M2_NETSTATE_INIT) {
-            ot_long scratch;
-            scratch         = next->counter + postponement;
-            next->counter   = (scratch < 65535) ? (ot_u16)scratch : 65535;
-            break;
-        }
-        next++;
+/// The first INIT session is either the top or the one that starts the next
+/// sequence.
+    ot_u8 i;
+
+    i = _TOP;
+    if ((i != _END) && ((session.heap[i].netstate & M2_NETSTATE_INIT) == 0)) {
+        i = session.link[session.seqend[i]];
+    }
+    if (i != _END) {
+        ot_long scratch;
+        scratch                 = session.heap[i].counter + postponement;
+        session.heap[i].counter = (scratch < 65535) ? (ot_u16)scratch : 65535;
     }
 }
 #endif
@@ -339,27 +416,24 @@ OT_WEAK ot_u8 session_netstate() {
 
 OT_WEAK void session_print() {
     ot_int i;
-    m2session* test;
+    ot_u8 test;
 
-    i   = (ot_int)((ot_u8*)&session.heap[_END] - (ot_u8*)session.top);
-    printf("Number of Sessions: %lu\n", i/sizeof(m2session));
+    printf("Number of Sessions: %d\n", session.count);
 
-    if (i > 0) {
+    if (session.count > 0) {
         printf("===  SCHED CHAN N.ST D.ID SNET EXTR FLAG\n");
-        test = session.top;
-        do {
-            printf("%02lu: 0x%04X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\n",
-                (test - session.top),
-                test->counter,
-                test->channel,
-                test->netstate,
-                test->dialog_id,
-                test->subnet,
-                test->extra,
-                test->flags);
-
-            test++;
-        } while (test < &session.heap[_END]);
+        i = 0;
+        for (test=_TOP; test!=_END; test=session.link[test]) {
+            printf("%02d: 0x%04X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X 0x%02X\n",
+                i++,
+                session.heap[test].counter,
+                session.heap[test].channel,
+                session.heap[test].netstate,
+                session.heap[test].dialog_id,
+                session.heap[test].subnet,
+                session.heap[test].extra,
+                session.heap[test].flags);
+        }
     }
 
     printf("\n");
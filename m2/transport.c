@@ -151,6 +151,28 @@ OT_WEAK ot_bool m2qp_sig_a2p(ot_u8 type, ot_u8 opcode, id_tmpl* user_id) { retur
 //m2dp_struct m2dp;
 m2qp_struct m2qp;
 
+/** Masked token correlator state, set up by sub_init_charcorrelation().
+  * hi[] and lo[] are match vectors by nibble: bit i of hi[b>>4] & lo[b&15]
+  * is set when byte b matches token byte i under its mask.  Bit i of plane[]
+  * is the alignment that started i bytes ago.  For an exact search, plane[0]
+  * is the Shift-And state.  Else plane[0..planes-1] are bit-sliced counters of
+  * the matching bytes.  They start at bias, which is the passing number below
+  * a power of two, so the top plane shows a passing window.  Tokens of up to
+  * M2QP_COR_DIRECT bytes are correlated directly: plane[0] holds the last
+  * bytes of the datastream, and plane[1] and plane[2] the token value and
+  * mask, packed the same way.
+  */
+#define M2QP_COR_MAXTOKEN   32
+#define M2QP_COR_DIRECT     4
+
+static struct {
+    ot_u32  hi[16];
+    ot_u32  lo[16];
+    ot_u32  plane[6];
+    ot_u8   bias;
+    ot_u8   planes;         // 0 for an exact search
+} m2qp_cor;
+
 
 
 /** @brief Subroutine for use with m2qp_load_isf(): Loads arithmetic comparison.
@@ -160,6 +182,11 @@ m2qp_struct m2qp;
   */
 ot_int sub_load_comparison(ot_int* cursor, ot_u8 data_byte);
 
+/** @brief Sets up sub_load_charcorrelation() for the query template (m2qp.qtmpl)
+  * @retval ot_int      0 on success, -1 if the token is longer than 32 bytes
+  */
+ot_int sub_init_charcorrelation(void);
+
 /** @brief Subroutine for use with m2qp_load_isf(): Performs string token search.
   * @param cursor       (ot_int*)   Used by m2qp_load_isf()
   * @param data_byte    (ot_u8)     One byte of data to load (and process)
@@ -674,8 +701,14 @@ OT_WEAK ot_int m2qp_isf_comp(ot_u8 is_series, id_tmpl* user_id) {
         // Assure length is 0 when Non-Null search is used, and set the load
         // function accordingly, depending on the query method
         m2qp.qtmpl.length   = (m2qp.qtmpl.code) ? m2qp.qtmpl.length : 0;
-        load_function       = ((m2qp.qtmpl.code & M2QC_COR_SEARCH) != 0) ? \
-                               &sub_load_charcorrelation : &sub_load_comparison;
+        load_function       = &sub_load_comparison;
+        
+        if (m2qp.qtmpl.code & M2QC_COR_SEARCH) {
+            if (sub_init_charcorrelation() != 0) {
+                return -1;
+            }
+            load_function   = &sub_load_charcorrelation;
+        }
 
         // Get ISF information from queue, and load data
         m2qp.qdata.comp_id  = q_readbyte(&rxq);
@@ -845,6 +878,7 @@ OT_WEAK ot_int m2qp_load_isf(   ot_u8       is_series,
     ot_int  n_files = 1;
     ot_int  j       = 0;
     ot_int  output  = 0;
+    ot_uni16 ldata;
 
     /// 1. Open the ISF Series, if enabled
     ///    Do not respond if the series is not accessible (return negative)
@@ -889,10 +923,12 @@ OT_WEAK ot_int m2qp_load_isf(   ot_u8       is_series,
         if (offset < 0) {
             offset += fp_f->length;
 
-            // Load the window and process it, using the open file
+            // Load the window and process it, using the open file.  Reads
+            // are 16 bit aligned, so an odd start needs the halfword below.
+            if (offset & 1) {
+                ldata.ushort = vl_read(fp_f, offset-1);
+            }
             while ( (j < window_bytes) && (offset < fp_f->length) ) {
-                ot_uni16 ldata;
-
                 align = offset & 1;
                 if (align == 0) {
                     ldata.ushort = vl_read(fp_f, offset);
@@ -937,54 +973,152 @@ OT_WEAK ot_int m2qp_load_isf(   ot_u8       is_series,
   * - Used as the load_function() argument to sub_load_isf()
   */
 
+ot_int sub_init_charcorrelation(void) {
+/// The token is compared by nibbles: byte b matches token byte i when both of
+/// its nibbles match under the mask, so the 32 bit match vector of b is
+/// hi[b>>4] & lo[b&15].  It takes 32 table entries instead of 256.
+    ot_int  i, j;
+    ot_int  passing;
+    ot_u8   mask;
+    ot_u8   value;
+
+    if (m2qp.qtmpl.length > M2QP_COR_MAXTOKEN) {
+        return -1;
+    }
+
+    /// Short tokens (and the empty one) are correlated directly, because the
+    /// vectors cost more to set up than they save.  The last token byte goes
+    /// in the low byte, where the newest byte of the datastream will be.
+    if (m2qp.qtmpl.length <= M2QP_COR_DIRECT) {
+        m2qp_cor.plane[1] = 0;
+        m2qp_cor.plane[2] = 0;
+        for (i=0; i<m2qp.qtmpl.length; i++) {
+            j                   = (m2qp.qtmpl.length - 1 - i) << 3;
+            mask                = m2qp.qtmpl.mask[i];
+            m2qp_cor.plane[1]  |= (ot_u32)(m2qp.qtmpl.value[i] & mask) << j;
+            m2qp_cor.plane[2]  |= (ot_u32)mask << j;
+        }
+        return 0;
+    }
+
+    for (j=0; j<16; j++) {
+        m2qp_cor.hi[j] = 0;
+        m2qp_cor.lo[j] = 0;
+    }
+    for (i=0; i<m2qp.qtmpl.length; i++) {
+        mask    = m2qp.qtmpl.mask[i];
+        value   = m2qp.qtmpl.value[i] & mask;
+
+        /// Unmasked bytes are the usual case, and they match one entry of each
+        if (mask == 0xFF) {
+            m2qp_cor.hi[value >> 4] |= (ot_u32)1 << i;
+            m2qp_cor.lo[value & 15] |= (ot_u32)1 << i;
+            continue;
+        }
+        for (j=0; j<16; j++) {
+            m2qp_cor.hi[j] |= (ot_u32)(((j<<4) & mask) == (value & 0xF0)) << i;
+            m2qp_cor.lo[j] |= (ot_u32)(( j     & mask) == (value & 0x0F)) << i;
+        }
+    }
+
+    /// The score of a window is (matches - mismatches), and it passes when it
+    /// is at least the threshold, so the passing number of matching bytes is
+    /// (length + threshold) / 2, rounded up.  When that is the whole token,
+    /// the search is exact and Shift-And is enough.  Else the counters get
+    /// planes enough that the top one is reached at the passing number, and
+    /// that a full count does not overflow.
+    passing         = (m2qp.qtmpl.length + (m2qp.qtmpl.code & M2QC_COR_THRMASK) + 1) >> 1;
+    m2qp_cor.planes = 0;
+    if (passing != m2qp.qtmpl.length) {
+        for (j=1; (j < passing) || (j <= (m2qp.qtmpl.length - passing)); j<<=1) {
+            m2qp_cor.planes++;
+        }
+        m2qp_cor.bias   = (ot_u8)(j - passing);
+        m2qp_cor.planes++;
+    }
+
+    for (j=0; j<6; j++) {
+        m2qp_cor.plane[j] = 0;
+    }
+    return 0;
+}
+
+
 ot_int sub_load_charcorrelation(ot_int* cursor, ot_u8 data_byte) {
-/// This is a pure character-by-character correlation, which is not as efficient
-/// for comparing strings as more specialized methods (The Boyer-Moore-Horspool
-/// method might fit nicely here) but it gives the ability to report partial
-/// matches, which the BM or BMH methods do not.
+/// This is a bit-parallel correlation of the masked token over the datastream:
+/// each byte from the datastream advances all alignments of the token at once,
+/// so the work per byte does not depend on the token length.  Like a direct
+/// correlation (and unlike Boyer-Moore-Horspool), it reports partial matches.
 ///
 /// A correlation is a mathematic process for comparing two sequences, so check
 /// Wikipedia for more info (http://en.wikipedia.org/wiki/Cross-correlation).
-/// This function performs a correlation of a byte-wise token onto a byte-wise
-/// datastream.  The token is usually supplied in the command data (stored in
-/// shared memory), and the datastream is fed into this function byte-by-byte
-/// (usually referenced from file data).
-
-    ot_int i;
-    ot_int c;
-    ot_u8* local_buf;
-
-    /// The datastream is buffered in an unused part of the data-queue.
-    /// The LOCAL_U8() macro behaves similar to array nomenclature
-    local_buf = &LOCAL_U8(0);
-    local_buf[*cursor] = data_byte;
-
-    /// If the datastream is *not* fully pre-buffered, return to the caller.
-    /// If the datastream is fully pre-buffered, then proceed to correlation.
-    if ( *cursor < (m2qp.qtmpl.length-1) ) {
-        (*cursor)++;
-        return 0;
+/// The token is usually supplied in the command data (stored in shared
+/// memory), and the datastream is fed into this function byte-by-byte
+/// (usually referenced from file data).  sub_init_charcorrelation() must be
+/// called before the first byte.
+    ot_u32  match;
+    ot_u32  carry;
+    ot_u32  plane;
+    ot_int  planes;
+    ot_int  top;
+    ot_int  i;
+
+    top = m2qp.qtmpl.length - 1;
+
+    /// Short tokens: direct correlation of the last bytes, all at once.  Each
+    /// byte of match is nonzero where a token byte differs, and the score is
+    /// +1 for each equal byte and -1 for each other one.  An empty token
+    /// scores 0, as it always did.
+    if (top < M2QP_COR_DIRECT) {
+        m2qp_cor.plane[0] = (m2qp_cor.plane[0] << 8) | data_byte;
+        if ( *cursor < top ) {
+            (*cursor)++;
+            return 0;
+        }
+        match   = (m2qp_cor.plane[0] ^ m2qp_cor.plane[1]) & m2qp_cor.plane[2];
+        match  |= match >> 4;
+        match  |= match >> 2;
+        match  |= match >> 1;
+        match  &= 0x01010101;
+        match   = (match * 0x01010101) >> 24;
+        return ((top + 1 - (ot_int)(match << 1)) >= (ot_int)(m2qp.qtmpl.code & M2QC_COR_THRMASK));
     }
 
-    /// Equality Correlation with data shifting of the buffer after each
-    /// comparison operation.  The value c is the comparison score.  It is a
-    /// bipolar accumulator, so a non-equality alters the score by -1 and an
-    /// equality by +1.  It is implemented as c += (0 or 2) - 1
-    else {
-        for (i=0, c=0; i<m2qp.qtmpl.length; i++) {
-            c += ( (local_buf[i] & m2qp.qtmpl.mask[i]) == \
-                   (m2qp.qtmpl.value[i] & m2qp.qtmpl.mask[i]) ) << 1;
-            c -= 1;
+    match   = m2qp_cor.hi[data_byte >> 4] & m2qp_cor.lo[data_byte & 15];
+    planes  = m2qp_cor.planes;
+
+    /// Exact search: Shift-And.  Bit i stays set while the alignment that
+    /// started i bytes ago has matched every byte.
+    if (planes == 0) {
+        m2qp_cor.plane[0] = ((m2qp_cor.plane[0] << 1) | 1) & match;
+    }
 
-            local_buf[i-1] = local_buf[i];
+    /// Correlation: Shift-Add with bit-sliced counters.  Each alignment moves
+    /// up one bit and a new one starts with the bias, then the match vector is
+    /// added to all counters with a ripple carry through the planes.
+    else {
+        carry = match;
+        for (i=0; i<planes; i++) {
+            plane               = (m2qp_cor.plane[i] << 1) | ((m2qp_cor.bias >> i) & 1);
+            m2qp_cor.plane[i]   = plane ^ carry;
+            carry              &= plane;
         }
+        planes--;
+    }
+
+    /// If the datastream has not yet filled the first window, return to the
+    /// caller.  The window that ends with this byte is the one that started
+    /// (length - 1) bytes ago.
+    if ( *cursor < top ) {
+        (*cursor)++;
+        return 0;
     }
 
     /// One parameter of the correlation query is a correlation threshold.  It
     /// occupies the lower 5 bits of the query code.  It is an integer value.
-    /// Scores higher than the threshold are passing scores.  The query score
+    /// Scores at or above the threshold are passing scores.  The query score
     /// indicates the number of hits the query made on the file data.
-    return (c >= (ot_int)(m2qp.qtmpl.code & 0x1F));
+    return (m2qp_cor.plane[planes] >> top) & 1;
 }
 
 
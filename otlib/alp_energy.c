@@ -0,0 +1,148 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /otlib/alp_energy.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      ALP to Energy accounting processor
+  * @ingroup    ALP
+  *
+  * Reports the records of the Energy module (otsys/energy.h), so a client can
+  * compare device configurations by projected battery life.  Returned values
+  * are big endian.  Times are 32 bit seconds and 16 bit ticks (1/1024 s) below
+  * that, and charges are 32 bit mC and 16 bit uC (0-999) below that, so the
+  * records do not wrap over the life of a node (see otsys/energy.h).  A
+  * client that is not root cannot reset the records, so it should poll them
+  * and take the differences.
+  *
+  * ALP Command Field:
+  * b7:     Respond Bit     0 don't respond
+  *                         1 Respond with return template
+  *
+  * b3-0:   Operand         0000: Read Summary
+  *                         0001: Return Summary
+  *                         0010: Read CPU States
+  *                         0011: Return CPU States
+  *                         0100: Read Radio States
+  *                         0101: Return Radio States
+  *                         0110: Reset Records (root only)
+  *
+  * Summary:        uptime (s, ticks), charge (mC, uC), avg current (uA, 32 bit),
+  *                 life (hours, 32 bit)
+  *                 Life is projected from the 2 byte battery capacity (mAh)
+  *                 in the payload of the Read command, or from the default
+  *                 OT_PARAM_ENERGY_CAPACITY if the payload is empty.
+  * CPU States:     time (s, ticks) & charge (mC, uC) of each ENERGY_cpu_...
+  * Radio States:   time (s, ticks) & charge (mC, uC) of each ENERGY_rf_...
+  *
+  ******************************************************************************
+  */
+
+
+#include <otlib/alp.h>
+
+#if (   (OT_FEATURE(SERVER) == ENABLED) \
+     && (OT_FEATURE(ALP) == ENABLED) \
+     && (OT_FEATURE(ENERGY) == ENABLED) )
+
+#include <otlib/auth.h>
+#include <otlib/queue.h>
+#include <otsys/energy.h>
+
+
+
+static void sub_put_value(ot_queue* q, ot_u32 whole, ot_u16 part) {
+/// Times are seconds & ticks, charges are mC & uC
+    q_writelong(q, whole);
+    q_writeshort(q, part);
+}
+
+
+OT_WEAK ot_bool alp_proc_energy(alp_tmpl* alp, id_tmpl* user_id) {
+    static const ot_u8 out_len[8] = {
+        20, 0, (12*ENERGY_CPU_STATES), 0, (12*ENERGY_RF_STATES), 0, 0, 0
+    };
+    ot_u32  capacity;
+    ot_u32  value;
+    ot_u16  part;
+    ot_u8   cmd_in;
+    ot_u8   data_in;
+    ot_u8   i;
+    ot_int  out_bytes;
+
+    data_in             = alp->inq->getcursor[1];
+    cmd_in              = alp->inq->getcursor[3];
+    alp->inq->getcursor+= 4;
+
+    // Read commands are only answered if there is room for the whole answer
+    out_bytes = out_len[cmd_in & 7] * ((cmd_in & 0x08) == 0);
+    if (q_space(alp->outq) < out_bytes) {
+        out_bytes = 0;
+    }
+
+    switch (out_bytes ? (cmd_in & 0x0F) : 0x0F) {
+        case 0: capacity = OT_PARAM_ENERGY_CAPACITY;
+                if (data_in >= 2) {
+                    capacity = q_readshort(alp->inq);
+                    data_in -= 2;
+                }
+                value = energy_uptime(&part);
+                sub_put_value(alp->outq, value, part);
+                value = energy_charge(&part);
+                sub_put_value(alp->outq, value, part);
+                q_writelong(alp->outq, energy_avgcurrent());
+                q_writelong(alp->outq, energy_lifetime(capacity));
+                break;
+
+        case 2: for (i=0; i<ENERGY_CPU_STATES; i++) {
+                    value = energy_cpu_time(i, &part);
+                    sub_put_value(alp->outq, value, part);
+                    value = energy_cpu_charge(i, &part);
+                    sub_put_value(alp->outq, value, part);
+                }
+                break;
+
+        case 4: for (i=0; i<ENERGY_RF_STATES; i++) {
+                    value = energy_rf_time(i, &part);
+                    sub_put_value(alp->outq, value, part);
+                    value = energy_rf_charge(i, &part);
+                    sub_put_value(alp->outq, value, part);
+                }
+                break;
+
+        default: if (((cmd_in & 0x0F) == 6) && auth_isroot(user_id)) {
+                    energy_reset();
+                }
+                break;
+    }
+
+    // Skip any unread input payload
+    alp->inq->getcursor += data_in;
+
+    if (cmd_in & 0x80) {
+        alp->OUTREC(CMD)    = (cmd_in & 0x7F) | 0x01;
+        alp->OUTREC(PLEN)   = (ot_u8)out_bytes;
+    }
+    else {
+        alp->outq->putcursor -= out_bytes;
+    }
+
+    return True;
+}
+
+
+#endif
@@ -47,16 +47,20 @@
 #ifndef ALP_DASHFORTH
 #   define ALP_DASHFORTH   (OT_FEATURE(DASHFORTH) == ENABLED)
 #endif
+#ifndef ALP_ENERGY
+#   define ALP_ENERGY   (OT_FEATURE(ENERGY) == ENABLED)
+#endif
 #define ALP_API         ((OT_FEATURE(ALPAPI) == ENABLED) * ((OT_FEATURE(M2) == ENABLED) *3))
 #define ALP_EXT         (OT_FEATURE(ALPEXT) == ENABLED)
 
 
-#define ALP_MAX         9
+#define ALP_MAX         10
 #define ALP_FUNCTIONS   (   ALP_FILESYSTEM \
                           + ALP_SENSORS \
                           + ALP_SECURITY \
                           + ALP_LOGGER \
                           + ALP_DASHFORTH \
+                          + ALP_ENERGY \
                           + ALP_API )
 
 
@@ -596,6 +600,9 @@ OT_WEAK ot_bool alp_proc(alp_tmpl* alp, id_tmpl* user_id) {
 #   if (ALP_DASHFORTH)
         &alp_proc_null,         //Not implemented yet
 #   endif
+#   if (ALP_ENERGY)
+        &alp_proc_energy,
+#   endif
 #   if (ALP_API)
         &alp_proc_api_session,
         &alp_proc_api_system,
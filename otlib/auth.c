@@ -31,8 +31,9 @@
 #include <otlib/memcpy.h>
 #include <otlib/rand.h>
 #include <otsys/veelite.h>
+#include <otsys/time.h>
 
-#define _SEC_NL     OT_FEATURE(NLSECURITY)
+#define _SEC_NL     OT_FEATURE(NL_SECURITY)
 #define _SEC_DLL    OT_FEATURE(DLL_SECURITY)
 #define _SEC_ALL    (_SEC_NL && _SEC_DLL)
 #define _SEC_ANY    (_SEC_NL || _SEC_DLL)
@@ -55,15 +56,11 @@ const id_tmpl*   auth_guest;
 #endif
 
 #ifndef AES_EXPKEYS
-#   define AES_EXPKEYS  0
+#   define AES_EXPKEYS  OT_FEATURE(CRYPTO_KEYCACHE)
 #endif
 
-#if AES_EXPKEYS
-#   define _SEC_TWINKEYS    1
-#   define _SEC_CACHESIZE   (_SEC_KEYSIZE*2)
-#else
-#   define _SEC_CACHESIZE   16
-#endif
+#define _SEC_CACHESIZE   16
+#define _SEC_BATCH       8
 
 
 
@@ -73,6 +70,11 @@ ot_u8 _nonce[8];
 typedef struct {
     auth_info   info;
     ot_u32      cache[_SEC_CACHESIZE];
+    ot_u16      gen;        // Veelite generation of the key file
+#   if (AES_EXPKEYS)
+    ot_bool     keyed;      // context below is valid for this key
+    EAXdrv_t    context;    // AES schedule & OMAC subkeys, built on key load
+#   endif
 } auth_dlls_struct;
 
 
@@ -85,36 +87,50 @@ typedef struct {
 
 
 
-// Maybe in the future, but probably some type of malloc will get implemented
-// instead of this special-purpose heap
-#if 0
+#if (_SEC_NL)
+/** NLS user & key store
+  * The table has one entry per user.  Entries are found through a hash on
+  * the user ID, and kept in a binary min-heap by expiry time so that the
+  * next to expire (or to evict) is always at the top.  The key data lives
+  * in a separate heap, where each item has a 4 byte header with the owner
+  * entry and the key length.  Deleted items leave holes, which
+  * crypto_clean() compacts.
+  */
+#   define _SEC_TABLESIZE   OT_PARAM(NLS_USERS)
+#   define _SEC_HEAPSIZE    OT_PARAM(NLS_HEAPSIZE)
+#   define _SEC_NULL        0xFFFF
+#   define _SEC_ITEMSIZE(LEN)   (4 + (((LEN)+3) & ~3))
+#   define _SEC_RECSIZE(LEN)    (18 + (((LEN)+1) & ~1))
+
+#   if (_SEC_TABLESIZE > 32767)
+#       error "OT_PARAM_NLS_USERS must be 32767 or less"
+#   endif
+#   if !defined(OT_PARAM_NLS_GFB_ID)
+#       error "OT_PARAM_NLS_GFB_ID must be set to the first GFB file reserved for NLS users"
+#   elif defined(GFB_NUM_FILES) && ((OT_PARAM(NLS_GFB_ID) + OT_PARAM(NLS_GFB_FILES)) > GFB_NUM_FILES)
+#       error "The NLS user files (OT_PARAM_NLS_GFB_ID, OT_PARAM_NLS_GFB_FILES) must be within GFB_NUM_FILES"
+#   endif
 
-    /** @typedef crypto_Heap_Type
-      * Struct used for the Key Heap Data Type
-      *
-      * ot_uint end:            byte offset to end of heap where there is free space
-      * ot_u8   heapdata[]:     heap data storage.  Stores crypto_Entries mixed with
-      *                         key data.
-      */
     typedef struct {
-        ot_u8   alloc;
-        id_tmpl id;
-    } heap_item;
+        auth_info   info;       // info.lifetime is the expiry, UTC s (0 = never)
+        auth_id     id;         // id.length is 0 when the entry is free
+        ot_u16      next;       // next entry in hash bucket, or in free list
+        ot_u16      rank;       // position in auth_nls.order[]
+        ot_u32      key;        // offset of key data in auth_nls.heap[]
+    } auth_entry;
 
     typedef struct {
-        ot_int  free_space;
-        ot_int  end;
-        ot_u8   data[_SEC_HEAPSIZE];
-    } auth_heap_struct;
-
-#   define _SEC_HEAPSIZE   ((16+sizeof(heap_item))*2)  //OT_PARAM(AUTH_HEAP_SIZE)
-#   define _SEC_TABLESIZE  2   //OT_PARAM(AUTH_TABLE_SIZE)
-
-#   if (_SEC_NLS)
-        auth_ctl          auth_table[_SEC_TABLESIZE];
-        auth_heap_struct    auth_heap;
-#   endif
-
+        ot_u16      count;
+        ot_u16      free;                       // head of the free list
+        ot_u32      end;                        // first unused heap byte
+        ot_u32      holes;                      // freed heap bytes below end
+        ot_u16      bucket[_SEC_TABLESIZE];
+        ot_u16      order[_SEC_TABLESIZE];      // min-heap by expiry
+        auth_entry  entry[_SEC_TABLESIZE];
+        ot_u8       heap[_SEC_HEAPSIZE];
+    } auth_nls_struct;
+
+    auth_nls_struct auth_nls;
 #endif
 
 
@@ -127,76 +143,242 @@ typedef struct {
 
 
 
-// internal stuff
-
-/** @brief Sorts key table based in order of which key is closest to expiration.
-  * @param none
-  * @retval none
+/** Subroutines <BR>
+  * ========================================================================<BR>
   */
-void crypto_sort();
+#if (_SEC_DLL || _SEC_NL)
+void sub_expand_key(auth_dlls_struct* key) {
+/// EAX only runs AES in the forward direction, so the keyed context (the
+/// expanded schedule plus the OMAC subkeys) serves encrypt and decrypt.  It
+/// is built here, once per key load, instead of once per frame.
+#if (AES_EXPKEYS)
+    if (key->keyed) {
+        EAXdrv_clear(&key->context);
+    }
+    key->keyed = (ot_bool)(EAXdrv_init((ot_u8*)key->cache, &key->context) == 0);
+#endif
+}
 
-/** @brief Wipes out expired keys
-  * @param none
-  * @retval none
-  */
-void crypto_cull();
 
-/** @brief Reorganizes (cleans) the Key Heap & table
-  * @param none
-  * @retval none
-  */
-void crypto_clean();
 
+#if (_SEC_DLL)
+void sub_load_key(ot_uint index) {
+    vlFILE* fp;
+    auth_key[index].gen = vl_generation(VL_ISF_BLOCKID, index+ISF_ID(root_authentication_key));
+    fp = ISF_open_su(index+ISF_ID(root_authentication_key));
+    vl_load(fp, 18, &(auth_key[index].info.length));
+    vl_close(fp);
 
+    sub_expand_key(&auth_key[index]);
+}
 
 
+ot_u32* sub_get_key(ot_uint index) {
+/// The key cache is reloaded if the key file was written since it was loaded
+    if (auth_key[index].gen != vl_generation(VL_ISF_BLOCKID, index+ISF_ID(root_authentication_key))) {
+        sub_load_key(index);
+    }
+    return auth_key[index].cache;
+}
 
-/** Subroutines <BR>
-  * ========================================================================<BR>
-  */
-#if (_SEC_DLL || _SEC_NL)
-void sub_expand_key(auth_dlls_struct* key) {
-/// Storing expanded keys is not presently supported
-#if (0 && (AES_EXPKEYS))
-#   if (_SEC_TWINKEYS == 0)
-        key->info.options = 0;
-        key->info.length  = 44;
-        AES_expand_enckey(key->cache, key->cache);
-#   else
-        ot_u32* enckey;
-        key->info.options = 1;
-        key->info.length  = 44;
-        enckey = key->cache + 44;
-        AES_expand_enckey(key->cache, enckey);
-        AES_expand_deckey(key->cache, key->cache);
-#   endif
-#endif
+
+#if (AES_EXPKEYS)
+EAXdrv_t* sub_get_context(ot_uint index) {
+/// Same reload rule as sub_get_key(), plus a retry if the last keying failed
+    if ((auth_key[index].keyed == False) \
+    || (auth_key[index].gen != vl_generation(VL_ISF_BLOCKID, index+ISF_ID(root_authentication_key)))) {
+        sub_load_key(index);
+    }
+    return auth_key[index].keyed ? &auth_key[index].context : NULL;
 }
+#endif
+#endif
 
 
 
 ///@todo Bring this into OT Utils?
 ot_bool sub_idcmp(id_tmpl* user_id, auth_id* auth_id) {
-    ot_bool id_check;
+/// Bytewise, because auth_id->value is not word aligned
+    ot_int i;
 
     if (user_id->length != auth_id->length) {
         return False;
     }
-    if (user_id->length == 2) {
-        return (((ot_u16*)user_id->value)[0] == ((ot_u16*)auth_id->value)[0]);
-    }
-
-    id_check    = (((ot_u32*)user_id->value)[0] == ((ot_u32*)auth_id->value)[0]);
-    id_check   &= (((ot_u32*)user_id->value)[1] == ((ot_u32*)auth_id->value)[1]);
-    return id_check;
+    for (i=0; (i<user_id->length) && (user_id->value[i] == auth_id->value[i]); i++);
+    return (ot_bool)(i == user_id->length);
 }
 
 
-ot_bool sub_authcmp(id_tmpl* user_id, id_tmpl* comp_id, ot_u8 mod_flags) {
+ot_bool sub_authcmp(id_tmpl* user_id, const id_tmpl* comp_id, ot_u8 mod_flags) {
     if ((user_id == NULL) || (user_id == comp_id))
         return True;
 
-    return (ot_bool)auth_search_user(user_id, mod_flags);
+    return (ot_bool)(auth_search_user(NULL, user_id, mod_flags) == 0);
+}
+#endif
+
+
+
+#if (_SEC_NL)
+ot_u32 sub_expiry(ot_u16 index) {
+/// Lifetime 0 is "never expires", so it sorts after everything else
+    ot_u32 lifetime = auth_nls.entry[index].info.lifetime;
+    return (lifetime == 0) ? (ot_u32)~0 : lifetime;
+}
+
+
+ot_u16 sub_hash(ot_u8* value, ot_int length) {
+/// FNV-1a over the ID bytes, folded into the table size
+    ot_u32 hash = 2166136261UL;
+    while (--length >= 0) {
+        hash = (hash ^ *value++) * 16777619UL;
+    }
+    return (ot_u16)((hash ^ (hash >> 16)) % _SEC_TABLESIZE);
+}
+
+
+void sub_setrank(ot_u16 rank, ot_u16 index) {
+    auth_nls.order[rank]        = index;
+    auth_nls.entry[index].rank  = rank;
+}
+
+
+void sub_siftup(ot_u16 rank) {
+    ot_u16 index    = auth_nls.order[rank];
+    ot_u32 expiry   = sub_expiry(index);
+
+    while (rank > 0) {
+        ot_u16 parent = (rank-1) >> 1;
+        if (sub_expiry(auth_nls.order[parent]) <= expiry) {
+            break;
+        }
+        sub_setrank(rank, auth_nls.order[parent]);
+        rank = parent;
+    }
+    sub_setrank(rank, index);
+}
+
+
+void sub_siftdown(ot_u16 rank) {
+    ot_u16 index    = auth_nls.order[rank];
+    ot_u32 expiry   = sub_expiry(index);
+    ot_u16 child;
+
+    while ((child = (rank << 1) + 1) < auth_nls.count) {
+        if (((child+1) < auth_nls.count) \
+        && (sub_expiry(auth_nls.order[child+1]) < sub_expiry(auth_nls.order[child]))) {
+            child++;
+        }
+        if (expiry <= sub_expiry(auth_nls.order[child])) {
+            break;
+        }
+        sub_setrank(rank, auth_nls.order[child]);
+        rank = child;
+    }
+    sub_setrank(rank, index);
+}
+
+
+ot_u16 sub_find(id_tmpl* user_id) {
+    ot_u16 index;
+
+    if ((user_id == NULL) || (user_id->length == 0) || (user_id->length > 8)) {
+        return _SEC_NULL;
+    }
+    index = auth_nls.bucket[sub_hash(user_id->value, user_id->length)];
+    while ((index != _SEC_NULL) && !sub_idcmp(user_id, &auth_nls.entry[index].id)) {
+        index = auth_nls.entry[index].next;
+    }
+    return index;
+}
+
+
+void sub_delete(ot_u16 index) {
+    auth_entry* entry = &auth_nls.entry[index];
+    ot_u16*     link;
+    ot_u16      last;
+
+    /// Unlink from the hash bucket
+    link = &auth_nls.bucket[sub_hash(entry->id.value, entry->id.length)];
+    while (*link != index) {
+        link = &auth_nls.entry[*link].next;
+    }
+    *link = entry->next;
+
+    /// Take it out of the expiry heap: the last entry fills the hole
+    last = auth_nls.order[--auth_nls.count];
+    if (last != index) {
+        ot_u16 rank = entry->rank;
+        sub_setrank(rank, last);
+        sub_siftdown(rank);
+        sub_siftup(auth_nls.entry[last].rank);
+    }
+
+    /// Release the key data and the entry
+    auth_nls.heap[entry->key-4] = (_SEC_NULL & 0xFF);
+    auth_nls.heap[entry->key-3] = (_SEC_NULL >> 8);
+    auth_nls.holes     += _SEC_ITEMSIZE(entry->info.length);
+    entry->id.length    = 0;
+    entry->next         = auth_nls.free;
+    auth_nls.free       = index;
+}
+
+
+void sub_sethandle(auth_handle* handle, ot_u16 index) {
+    if (handle != NULL) {
+        handle->info    = &auth_nls.entry[index].info;
+        handle->id      = &auth_nls.entry[index].id;
+        handle->keydata = &auth_nls.heap[auth_nls.entry[index].key];
+    }
+}
+
+
+void sub_nls_init() {
+    ot_u16 i;
+
+    auth_nls.count  = 0;
+    auth_nls.free   = 0;
+    auth_nls.end    = 0;
+    auth_nls.holes  = 0;
+    for (i=0; i<_SEC_TABLESIZE; i++) {
+        auth_nls.bucket[i]          = _SEC_NULL;
+        auth_nls.entry[i].id.length = 0;
+        auth_nls.entry[i].next      = i+1;
+    }
+    auth_nls.entry[_SEC_TABLESIZE-1].next = _SEC_NULL;
+}
+
+
+ot_uint sub_putrecord(ot_u8* rec, auth_entry* entry) {
+/// GFB record: ID length, protocol, options, key length, lifetime (LE),
+/// ID (8 bytes), index, 0, key data padded to an even length
+    ot_u32 lifetime = entry->info.lifetime;
+
+    rec[0]  = (ot_u8)entry->id.length;
+    rec[1]  = entry->info.protocol;
+    rec[2]  = entry->info.options;
+    rec[3]  = entry->info.length;
+    rec[4]  = (ot_u8)lifetime;
+    rec[5]  = (ot_u8)(lifetime >> 8);
+    rec[6]  = (ot_u8)(lifetime >> 16);
+    rec[7]  = (ot_u8)(lifetime >> 24);
+    memcpy(&rec[8], entry->id.value, 8);
+    rec[16] = entry->info.index;
+    rec[17] = 0;
+    memcpy(&rec[18], &auth_nls.heap[entry->key], entry->info.length);
+    rec[18+entry->info.length] = 0;
+
+    return _SEC_RECSIZE(entry->info.length);
+}
+
+
+void sub_vlread(vlFILE* fp, ot_uint offset, ot_u8* dst, ot_uint length) {
+    ot_uni16 scratch;
+    for (; length>0; length-=2, offset+=2) {
+        scratch.ushort  = vl_read(fp, offset);
+        *dst++          = scratch.ubyte[0];
+        *dst++          = scratch.ubyte[1];
+    }
 }
 #endif
 
@@ -223,17 +405,13 @@ void auth_init() {
     /// Load key files into cache for faster access.  We assume that there is
     /// only one type of crypto, which is AES128
     for (i=0; i<2; i++) {
-        vlFILE* fp;
-        fp = ISF_open_su(i+ISF_ID(root_authentication_key));
-        vl_load(fp, 18, &(auth_key[i].info.length));
-        vl_close(fp);
-
-        /// @note This will do nothing until it is legal to store expanded keys
-        sub_expand_key(&auth_key[i]);
+        sub_load_key(i);
     }
 #endif
-#if (_SEC_NLS)
-    ///@todo
+#if (_SEC_NL)
+    /// Bring back the NLS users that were saved with auth_save_nlsusers()
+    sub_nls_init();
+    auth_load_nlsusers();
 #endif
 }
 #endif
@@ -278,6 +456,18 @@ void auth_putnonce(ot_u8* dst, ot_uint limit) {
 // EAX has a symmetric cipher (Yay!)
 ot_int __eaxcrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index, ot_u8 options,
                      ot_int (*__crypt)(ot_u8*, ot_u8*, ot_uint, EAXdrv_t*) )   {
+#if (_SEC_DLL && AES_EXPKEYS)
+    EAXdrv_t* context;
+
+    /// The cached context is keyed already: only the per-message state is set
+    /// up by the driver, so no key expansion happens on this path.
+    context = sub_get_context(key_index);
+    if (context == NULL) {
+        return -1;
+    }
+    return __crypt(nonce, data, datalen, context) ? -2 : 4;
+
+#else
     EAXdrv_t context;
     ot_int  retval;
 
@@ -287,6 +477,7 @@ ot_int __eaxcrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index, o
         retval = retval ? -2 : 4;
     }
     return retval;
+#endif
 }
 
 
@@ -295,6 +486,8 @@ ot_int auth_encrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index,
 /// "options" not presently used.
 #if (_SEC_DLL)
     return __eaxcrypt(nonce, data, datalen, key_index, options, &EAXdrv_encrypt);
+#else
+    return -1;
 #endif
 }
 #endif
@@ -305,6 +498,50 @@ ot_int auth_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index,
 /// "options" not presently used.
 #if (_SEC_DLL)
     return __eaxcrypt(nonce, data, datalen, key_index, options, &EAXdrv_decrypt);
+#else
+    return -1;
+#endif
+}
+#endif
+
+
+#ifndef EXTF_auth_decrypt_batch
+ot_int auth_decrypt_batch(auth_frame* frame, ot_int count, ot_u8 options) {
+/// "options" not presently used.  Frames are handed to the driver in groups
+/// of _SEC_BATCH, using the cached context of each frame's key.
+#if (_SEC_DLL && AES_EXPKEYS)
+    EAXdrv_frame    drv[_SEC_BATCH];
+    auth_frame*     src[_SEC_BATCH];
+    ot_int          i, n;
+    ot_int          good = 0;
+
+    while (count > 0) {
+        for (n=0; (n<_SEC_BATCH) && (count>0); count--, frame++) {
+            drv[n].context = sub_get_context(frame->key_index);
+            if (drv[n].context == NULL) {
+                frame->retval = -1;
+                continue;
+            }
+            drv[n].nonce    = frame->nonce;
+            drv[n].data     = frame->data;
+            drv[n].datalen  = frame->datalen;
+            src[n++]        = frame;
+        }
+        EAXdrv_decrypt_batch(drv, n);
+        for (i=0; i<n; i++) {
+            src[i]->retval  = drv[i].retval ? -2 : 4;
+            good           += (drv[i].retval == 0);
+        }
+    }
+    return good;
+
+#else
+    ot_int good = 0;
+    for (; count > 0; count--, frame++) {
+        frame->retval   = auth_decrypt(frame->nonce, frame->data, frame->datalen, frame->key_index, options);
+        good           += (frame->retval >= 0);
+    }
+    return good;
 #endif
 }
 #endif
@@ -313,7 +550,7 @@ ot_int auth_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, ot_u8 key_index,
 #ifndef EXTF_auth_get_deckey
 ot_u8* auth_get_deckey(ot_u8 index) {
 #if (_SEC_DLL)
-    return (ot_u8*)auth_key[index].cache;
+    return (ot_u8*)sub_get_key(index);
 #else
     return NULL;
 #endif
@@ -325,7 +562,7 @@ ot_u8* auth_get_deckey(ot_u8 index) {
 ot_u8* auth_get_enckey(ot_u8 index) {
 #if (_SEC_TWINKEYS)
     ot_u32* enckey;
-    enckey  = auth_key[index].cache;
+    enckey  = sub_get_key(index);
     enckey += (auth_key[index].info.options) ? auth_key[index].info.length : 0;
     return (ot_u8*)enckey;
 #else
@@ -352,7 +589,7 @@ ot_u8* auth_get_enckey(ot_u8 index) {
   */
 ot_bool auth_isroot(id_tmpl* user_id) {
 /// NULL is how root is implemented in internal calls
-#if (_SEC_NLS)
+#if (_SEC_NL)
     return sub_authcmp(user_id, auth_root, AUTH_FLAG_ISROOT);
 #elif (_SEC_DLL)
     return (ot_bool)((user_id == NULL) || (user_id == auth_root));
@@ -364,7 +601,7 @@ ot_bool auth_isroot(id_tmpl* user_id) {
 
 ot_bool auth_isuser(id_tmpl* user_id) {
 /// NULL is how root is implemented in internal calls
-#if (_SEC_NLS)
+#if (_SEC_NL)
     return sub_authcmp(user_id, auth_user, AUTH_FLAG_ISUSER);
 #elif (_SEC_DLL)
     return (ot_bool)((user_id == NULL) || (user_id == auth_user));
@@ -380,8 +617,12 @@ ot_u8 auth_check(ot_u8 data_mod, ot_u8 req_mod, id_tmpl* user_id) {
 /// Find the ID in the table, then mask the user's mod with the file's mod
 /// and the mod from the request (i.e. read, write).
 
-    ///@todo need to write auth_search_user()
-    //return (ot_u8)auth_search_user(user_id, (data_mod & req_mod));
+#   if (_SEC_NL)
+    /// Known NLS users get user access, everyone else gets guest access
+    if (auth_search_user(NULL, user_id, AUTH_FLAG_ISUSER) == 0) {
+        return (0x3F & data_mod & req_mod);
+    }
+#   endif
     return (0x07 & data_mod & req_mod);
 
 #else
@@ -475,33 +716,267 @@ ot_u8 auth_store_keydata(auth_info* info, ot_u8* keydata) {
 
 
 
-/** @todo NLS is not supported any time soon, but refactor according to new prototypes
+/** NLS User & Key Store <BR>
+  * ========================================================================<BR>
+  */
+
+#ifndef EXTF_auth_new_nlsuser
+ot_u8 auth_new_nlsuser(auth_handle* handle, id_tmpl* new_user, auth_info* new_info, ot_u8* new_key) {
+#if (_SEC_NL)
+    auth_entry* entry;
+    ot_u16      index;
+    ot_u16      bucket;
+    ot_u32      size;
+
+    if ((new_user == NULL) || (new_user->length == 0) || (new_user->length > 8)) {
+        return 1;
+    }
+    size = _SEC_ITEMSIZE(new_info->length);
+    if (size > _SEC_HEAPSIZE) {
+        return 2;
+    }
+
+    /// A user that is already in the table is replaced
+    index = sub_find(new_user);
+    if (index != _SEC_NULL) {
+        sub_delete(index);
+    }
+
+    /// Make room: compact the key heap if that is enough, otherwise evict
+    /// the user that is nearest to expiry.
+    while ((auth_nls.free == _SEC_NULL) || ((_SEC_HEAPSIZE - auth_nls.end) < size)) {
+        if ((auth_nls.free != _SEC_NULL) && ((_SEC_HEAPSIZE - auth_nls.end + auth_nls.holes) >= size)) {
+            crypto_clean();
+        }
+        else {
+            sub_delete(auth_nls.order[0]);
+        }
+    }
 
-ot_u8 auth_new_nlsuser(auth_handle* handle, id_tmpl* new_user, auth_info* new_info, ot_u8* new_key);
-auth_ctl* auth_new_nlsuser(auth_ctl* new_user, ot_u8* new_data) {
-#if (_SEC_NLS)
+    index               = auth_nls.free;
+    entry               = &auth_nls.entry[index];
+    auth_nls.free       = entry->next;
+    entry->info         = *new_info;
+    entry->id.length    = new_user->length;
+    memcpy(entry->id.value, new_user->value, new_user->length);
+
+    /// Key data goes at the end of the key heap, after its item header
+    auth_nls.heap[auth_nls.end+0]   = (ot_u8)index;
+    auth_nls.heap[auth_nls.end+1]   = (ot_u8)(index >> 8);
+    auth_nls.heap[auth_nls.end+2]   = new_info->length;
+    auth_nls.heap[auth_nls.end+3]   = 0;
+    entry->key                      = auth_nls.end + 4;
+    auth_nls.end                   += size;
+    memcpy(&auth_nls.heap[entry->key], new_key, new_info->length);
+
+    bucket                  = sub_hash(entry->id.value, entry->id.length);
+    entry->next             = auth_nls.bucket[bucket];
+    auth_nls.bucket[bucket] = index;
+
+    sub_setrank(auth_nls.count, index);
+    auth_nls.count++;
+    sub_siftup(entry->rank);
+
+    sub_sethandle(handle, index);
+    return 0;
+
+#else
+    return 255;
 #endif
-    return NULL;
 }
+#endif
 
 
 
-ot_u8 auth_search_user(auth_handle* handle, id_tmpl* user_id, ot_u8 mod_flags
-auth_ctl* auth_search_user(id_tmpl* user_id, ot_u8 mod_flags) {
-#if (_SEC_ANY)
-    ot_int i;
+#ifndef EXTF_auth_search_user
+ot_u8 auth_search_user(auth_handle* handle, id_tmpl* user_id, ot_u8 mod_flags) {
+#if (_SEC_NL)
+    ot_u16 index;
+
+    index = sub_find(user_id);
+    if (index == _SEC_NULL) {
+        return 1;
+    }
+#   if (OT_FEATURE(TIME) == ENABLED)
+    if (sub_expiry(index) <= time_get_utc()) {
+        sub_delete(index);
+        return 1;
+    }
+#   endif
+    if ((auth_nls.entry[index].info.protocol & mod_flags) != mod_flags) {
+        return 4;
+    }
+    sub_sethandle(handle, index);
+    return 0;
+
+#else
+    return 1;
+#endif
+}
+#endif
+
+
+
+#ifndef EXTF_auth_del_nlsuser
+ot_u8 auth_del_nlsuser(id_tmpl* user_id) {
+#if (_SEC_NL)
+    ot_u16 index = sub_find(user_id);
+    if (index == _SEC_NULL) {
+        return 1;
+    }
+    sub_delete(index);
+    return 0;
+#else
+    return 1;
+#endif
+}
+#endif
+
 
-    for (i=0; (i<_SEC_TABLESIZE) && (auth_table[i]!=NULL); i++) {
-        if (auth_table[i]->mod & mod_flags) {
-            if (sub_idcmp(user_id, auth_table[i])) {
-                return auth_table[i];
+
+#ifndef EXTF_auth_save_nlsusers
+ot_int auth_save_nlsusers() {
+#if (_SEC_NL)
+    vlFILE* fp      = NULL;
+    ot_u8   file    = 0;
+    ot_int  saved   = 0;
+    ot_u16  i;
+    ot_uint length;
+    ot_u8   rec[_SEC_RECSIZE(255)];
+
+    /// Records are appended to the GFB files in turn.  When one is full, the
+    /// next is started.
+    for (i=0; i<auth_nls.count; i++) {
+        length = sub_putrecord(rec, &auth_nls.entry[auth_nls.order[i]]);
+        while ((fp == NULL) || (vl_append(fp, length, rec) != 0)) {
+            if (fp != NULL) {
+                vl_close(fp);
+            }
+            fp = (file < OT_PARAM(NLS_GFB_FILES)) ? GFB_open_su(OT_PARAM(NLS_GFB_ID) + file++) : NULL;
+            if (fp == NULL) {
+                return saved;
             }
+            vl_store(fp, 0, NULL);
         }
+        saved++;
     }
+
+    /// Empty the files that are left, so an older and longer save is gone
+    while (1) {
+        if (fp != NULL) {
+            vl_close(fp);
+        }
+        fp = (file < OT_PARAM(NLS_GFB_FILES)) ? GFB_open_su(OT_PARAM(NLS_GFB_ID) + file++) : NULL;
+        if (fp == NULL) {
+            break;
+        }
+        vl_store(fp, 0, NULL);
+    }
+    return saved;
+
+#else
+    return 0;
 #endif
-    return NULL;
 }
-*/
+#endif
+
+
+
+#ifndef EXTF_auth_load_nlsusers
+ot_int auth_load_nlsusers() {
+#if (_SEC_NL)
+    vlFILE*     fp;
+    ot_u8       file;
+    ot_uint     offset;
+    ot_uint     length;
+    ot_int      loaded = 0;
+    auth_info   info;
+    id_tmpl     user;
+    ot_u8       rec[_SEC_RECSIZE(255)];
+
+    for (file=0; file<OT_PARAM(NLS_GFB_FILES); file++) {
+        fp = GFB_open_su(OT_PARAM(NLS_GFB_ID) + file);
+        if (fp == NULL) {
+            break;
+        }
+        for (offset=0; (offset+18) <= fp->length; offset+=length) {
+            sub_vlread(fp, offset, rec, 18);
+            length = _SEC_RECSIZE(rec[3]);
+            if ((rec[0] == 0) || (rec[0] > 8) || ((offset+length) > fp->length)) {
+                break;
+            }
+            sub_vlread(fp, offset+18, &rec[18], length-18);
+
+            user.length     = rec[0];
+            user.value      = &rec[8];
+            info.protocol   = rec[1];
+            info.options    = rec[2];
+            info.length     = rec[3];
+            info.lifetime   = (ot_u32)rec[4] | ((ot_u32)rec[5] << 8) \
+                            | ((ot_u32)rec[6] << 16) | ((ot_u32)rec[7] << 24);
+            info.index      = rec[16];
+            loaded         += (auth_new_nlsuser(NULL, &user, &info, &rec[18]) == 0);
+        }
+        vl_close(fp);
+    }
+
+    crypto_cull();
+    return loaded;
+
+#else
+    return 0;
+#endif
+}
+#endif
+
+
+
+#if (_SEC_NL)
+void crypto_sort() {
+/// Rebuild the expiry heap, bottom-up
+    ot_int rank;
+    for (rank=(auth_nls.count >> 1)-1; rank>=0; rank--) {
+        sub_siftdown((ot_u16)rank);
+    }
+}
+
+
+void crypto_cull() {
+#if (OT_FEATURE(TIME) == ENABLED)
+    ot_u32 now = time_get_utc();
+    while ((auth_nls.count != 0) && (sub_expiry(auth_nls.order[0]) <= now)) {
+        sub_delete(auth_nls.order[0]);
+    }
+#endif
+}
+
+
+void crypto_clean() {
+/// Slide the live key items down over the holes, in heap order
+    ot_u32  src;
+    ot_u32  dst     = 0;
+    ot_u32  size;
+
+    for (src=0; src<auth_nls.end; src+=size) {
+        ot_u8*  item    = &auth_nls.heap[src];
+        ot_u16  owner   = item[0] | (item[1] << 8);
+        size            = _SEC_ITEMSIZE(item[2]);
+
+        if (owner != _SEC_NULL) {
+            if (dst != src) {
+                ot_u32 i;
+                for (i=0; i<size; i++) {
+                    auth_nls.heap[dst+i] = item[i];
+                }
+                auth_nls.entry[owner].key = dst + 4;
+            }
+            dst += size;
+        }
+    }
+    auth_nls.end    = dst;
+    auth_nls.holes  = 0;
+}
+#endif
 
 
 
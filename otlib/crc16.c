@@ -78,6 +78,54 @@ void crc_calc_nstream(crcstream_t* stream, ot_u16 n) {
 
 
 
+void crc_calc_nstream_xor(crcstream_t* stream, ot_u8* dst, const ot_u8* key,
+                          ot_u16 n, ot_bool crc_dst) {
+    ot_u8*  src;
+    ot_int  k;
+
+    src             = stream->cursor;
+    stream->cursor += n;
+    k               = ((ot_int)n < stream->count) ? (ot_int)n : stream->count;
+    if (k > 0) {
+        stream->count  -= k;
+        stream->val     = crc16drv_block_xor(dst, src, key, k, stream->val, crc_dst);
+    }
+
+    /// The CRC goes into the stream ahead of the bytes still to be copied, so
+    /// it gets copied (and whitened) with them.
+    if ((stream->count == 0) && (stream->writeout)) {
+        stream->writeout    = False;
+        src[k]              = (ot_u8)(stream->val >> 8);
+        src[k+1]            = (ot_u8)(stream->val);
+    }
+    for (; k<(ot_int)n; k++) {
+        dst[k] = src[k] ^ key[k];
+    }
+}
+
+
+#if ((MCU_FEATURE(CRC16) == ENABLED) && !defined(EXTF_crc16drv_block_xor))
+OT_WEAK ot_u16 crc16drv_block_xor(ot_u8* dst, ot_u8* src, const ot_u8* key,
+                                  ot_int size, ot_u16 init, ot_bool crc_dst) {
+/// A CRC peripheral reads its input from memory, so this takes two passes
+/// unless the platform has something better.
+    ot_int i;
+
+    if (crc_dst == False) {
+        init = crc16drv_block_manual(src, size, init);
+    }
+    for (i=0; i<size; i++) {
+        dst[i] = src[i] ^ key[i];
+    }
+    if (crc_dst) {
+        init = crc16drv_block_manual(dst, size, init);
+    }
+    return init;
+}
+#endif
+
+
+
 ot_bool crc_check(crcstream_t* stream) {
 ///@todo deprecate this function in OT, in favor of crc_get(), and checking with 0.
     return (stream->val == 0);
@@ -150,6 +198,59 @@ static const ot_u16 crc16_table[256] = {
 };
 
 
+/** Slicing tables for the multi-byte loop (OT_PARAM_CRC16_SLICES = 4 or 8)
+  * crc16_slice[k-1][i] is the CRC of byte i followed by k zero bytes.  They are
+  * built from crc16_table the first time they are needed, so they always match
+  * it, and they stay out of flash.
+  */
+#if (OT_PARAM(CRC16_SLICES) > 1)
+static ot_u16   crc16_slice[OT_PARAM(CRC16_SLICES)-1][256];
+static ot_bool  crc16_sliced = False;
+
+static void sub_build_slices() {
+    ot_int i, k;
+    ot_u16 crc;
+
+    for (i=0; i<256; i++) {
+        crc = crc16_table[i];
+        for (k=0; k<(OT_PARAM(CRC16_SLICES)-1); k++) {
+            crc                 = (crc << 8) ^ crc16_table[crc >> 8];
+            crc16_slice[k][i]   = crc;
+        }
+    }
+    crc16_sliced = True;
+}
+#endif
+
+/** One multi-byte step: the CRC goes into the first two bytes of the step, and
+  * each byte is looked-up in the slice for its distance from the end.
+  */
+#if (OT_PARAM(CRC16_SLICES) == 8)
+#   define CRC16_STEP   8
+static OT_INLINE ot_u16 sub_slicestep(ot_u16 crc, const ot_u8* data) {
+    return  crc16_slice[6][(crc >> 8) ^ data[0]]
+          ^ crc16_slice[5][(crc & 0xFF) ^ data[1]]
+          ^ crc16_slice[4][data[2]]
+          ^ crc16_slice[3][data[3]]
+          ^ crc16_slice[2][data[4]]
+          ^ crc16_slice[1][data[5]]
+          ^ crc16_slice[0][data[6]]
+          ^ crc16_table[data[7]];
+}
+#elif (OT_PARAM(CRC16_SLICES) == 4)
+#   define CRC16_STEP   4
+static OT_INLINE ot_u16 sub_slicestep(ot_u16 crc, const ot_u8* data) {
+    return  crc16_slice[2][(crc >> 8) ^ data[0]]
+          ^ crc16_slice[1][(crc & 0xFF) ^ data[1]]
+          ^ crc16_slice[0][data[2]]
+          ^ crc16_table[data[3]];
+}
+#endif
+
+/// Blocks shorter than this are not offered to crc16drv_fold()
+#define CRC16_FOLD_MIN  64
+
+
 #ifndef EXTF_crc16drv_init
 OT_INLINE ot_u16 crc16drv_init() {
     //crc16_dr = 0xFFFF;
@@ -165,6 +266,23 @@ ot_u16 crc16drv_block_manual(ot_u8* block_addr, ot_int block_size, ot_u16 init)
 /// by CRC isn't much of an issue, but if you are getting weird CRC errors
 /// when using streams, try comparing against this software implemetation.
 
+    if (block_size >= CRC16_FOLD_MIN) {
+        ot_int folded;
+        folded      = crc16drv_fold(block_addr, block_size, &init);
+        block_addr += folded;
+        block_size -= folded;
+    }
+
+#   ifdef CRC16_STEP
+    if (crc16_sliced == False) {
+        sub_build_slices();
+    }
+    for (; block_size >= CRC16_STEP; block_size -= CRC16_STEP) {
+        init        = sub_slicestep(init, block_addr);
+        block_addr += CRC16_STEP;
+    }
+#   endif
+
     while (--block_size >= 0) {
         ot_u8 index = ((ot_u8*)&init)[UPPER] ^ *block_addr++;       //((crc_val>>8) & 0xff) ^ *block_addr++;
         init        = (init<<8) ^ crc16_table[index];
@@ -174,6 +292,63 @@ ot_u16 crc16drv_block_manual(ot_u8* block_addr, ot_int block_size, ot_u16 init)
 #endif
 
 
+#ifndef EXTF_crc16drv_block_xor
+OT_WEAK ot_u16 crc16drv_block_xor(ot_u8* dst, ot_u8* src, const ot_u8* key,
+                                  ot_int size, ot_u16 init, ot_bool crc_dst) {
+/// Each byte is read, XOR'ed and written once, and the clear one of the two
+/// (src when whitening, dst when dewhitening) goes into the CRC.  A whole step
+/// is loaded before it is stored, because dst may alias src or key.
+    ot_u8 in, out;
+#   ifdef CRC16_STEP
+    ot_u8 clear[CRC16_STEP];
+    ot_u8 k[CRC16_STEP];
+    ot_int i;
+
+    if (crc16_sliced == False) {
+        sub_build_slices();
+    }
+    for (; size >= CRC16_STEP; size -= CRC16_STEP) {
+        for (i=0; i<CRC16_STEP; i++) {
+            clear[i]    = src[i];
+            k[i]        = key[i];
+        }
+        if (crc_dst) {
+            for (i=0; i<CRC16_STEP; i++) {
+                clear[i]   ^= k[i];
+                dst[i]      = clear[i];
+            }
+        }
+        else {
+            for (i=0; i<CRC16_STEP; i++) {
+                dst[i]      = clear[i] ^ k[i];
+            }
+        }
+        init    = sub_slicestep(init, clear);
+        src    += CRC16_STEP;
+        dst    += CRC16_STEP;
+        key    += CRC16_STEP;
+    }
+#   endif
+
+    while (--size >= 0) {
+        in      = *src++;
+        out     = in ^ *key++;
+        *dst++  = out;
+        in      = crc_dst ? out : in;
+        init    = (init<<8) ^ crc16_table[(init>>8) ^ in];
+    }
+    return init;
+}
+#endif
+
+
+#ifndef EXTF_crc16drv_fold
+OT_WEAK ot_int crc16drv_fold(ot_u8* block_addr, ot_int block_size, ot_u16* crc) {
+    return 0;
+}
+#endif
+
+
 #ifndef EXTF_crc16drv_block
 OT_INLINE ot_u16 crc16drv_block(ot_u8* block_addr, ot_int block_size) {
     return crc16drv_block_manual(block_addr, block_size, 0xFFFF);
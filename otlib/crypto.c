@@ -36,20 +36,49 @@
 // One of the great things about EAX is that the cryptography process is
 // largely symmetric.
 
+#if (OT_FEATURE(CRYPTO_KEYCACHE) == ENABLED)
+/// The last context is kept keyed, along with the key it was built from.
+/// Callers usually pass the same key many times over, and then the AES key
+/// expansion and OMAC subkey setup in EAXdrv_init() can be skipped.
+static EAXdrv_t eax_context;
+static ot_u8    eax_key[16];
+static ot_bool  eax_keyed = False;
+
+static ot_int sub_get_context(ot_u8* key) {
+    ot_int i;
+
+    if (eax_keyed) {
+        for (i=0; (i<16) && (key[i] == eax_key[i]); i++);
+        if (i == 16) {
+            return 0;
+        }
+        EAXdrv_clear(&eax_context);
+    }
+    memcpy(eax_key, key, 16);
+    i           = EAXdrv_init(key, &eax_context);
+    eax_keyed   = (ot_bool)(i == 0);
+    return i;
+}
+#endif
+
+
 ot_int __EAX_crypt( ot_u8* dst, ot_u8* src, ot_uint srclen, ot_u8* nonce, ot_u8* key,
                     ot_int (*__crypt)(ot_u8*, ot_u8*, ot_uint, EAXdrv_t*)  ) {
     
-    EAXdrv_t    context;        // Might benefit by putting this outside the stack
-    ot_int      retval;
-    
-    ///@todo could add option parameter to prevent initialization of context
-    retval = EAXdrv_init(key, &context);
+#if (OT_FEATURE(CRYPTO_KEYCACHE) == ENABLED)
+    EAXdrv_t*   context = &eax_context;
+    ot_int      retval  = sub_get_context(key);
+#else
+    EAXdrv_t    context_stack;
+    EAXdrv_t*   context = &context_stack;
+    ot_int      retval  = EAXdrv_init(key, context);
+#endif
     
     if (retval == 0) {
         if ((dst != src) && (dst != NULL) && (srclen != 0)) {
             memcpy(dst, src, srclen);
         }
-        if (__crypt(nonce, dst, srclen, &context) == 0) {
+        if (__crypt(nonce, dst, srclen, context) == 0) {
             return 4;
         }
         retval--;
@@ -68,6 +97,18 @@ OT_INLINE ot_int EAX_decrypt(ot_u8* dst, ot_u8* src, ot_uint srclen, ot_u8* nonc
 }
 
 
+#ifndef EXTF_EAXdrv_decrypt_batch
+OT_WEAK ot_int EAXdrv_decrypt_batch(EAXdrv_frame* frame, ot_int count) {
+    ot_int good = 0;
+    for (; count > 0; count--, frame++) {
+        frame->retval   = EAXdrv_decrypt(frame->nonce, frame->data, frame->datalen, frame->context);
+        good           += (frame->retval == 0);
+    }
+    return good;
+}
+#endif
+
+
 
 
 
@@ -49,6 +49,7 @@
 #include <otlib/alp.h>
 #include <otlib/queue.h>
 #include <otsys/mpipe.h>
+#include <otsys/time.h>
 
 
 
@@ -58,12 +59,24 @@ ot_bool logger_header(ot_u8 id_subcode, ot_int payload_length) {
 /// by all logging functions.  If there is not enough space in the MPipe queue
 /// to hold the log data, it will return False, and nothing will be added to
 /// the MPipe queue.
+///
+/// With LOG_FEATURE_TIMESTAMP, the payload is prefixed by the monotonic time
+/// of the log (32 bit sec, 32 bit nsec, big endian).
+#   if (LOG_FEATURE(TIMESTAMP) && OT_FEATURE(TIME))
+    ot_timespec stamp;
+    time_get_monotonic(&stamp);
+    payload_length += 8;
+#   endif
 
     mpipe.alp.outrec.id     = 4;                //Logger ID
     mpipe.alp.outrec.cmd    = id_subcode;       //Format Type
 
     if ((mpipe.alp.outq->putcursor+payload_length) < mpipe.alp.outq->back) {
         alp_new_record(&mpipe.alp, (ALP_FLAG_MB+5), 255, payload_length);
+#       if (LOG_FEATURE(TIMESTAMP) && OT_FEATURE(TIME))
+        q_writelong(mpipe.alp.outq, stamp.sec);
+        q_writelong(mpipe.alp.outq, stamp.nsec);
+#       endif
         return True;
     }
     //mpipe_kill();
@@ -47,6 +47,11 @@
 vlFILE vl_file[OT_PARAM(VLFPS)];
 
 
+// File generation counters: one per stock ISF, plus one shared by all others
+#define VL_GEN_SHARED       ISF_NUM_STOCK_FILES
+static ot_u16 vl_gen[ISF_NUM_STOCK_FILES+1];
+
+
 #define FP_ISVALID(fp_VAL)  (fp_VAL != NULL)
 
 //Slower but more robust version of above
@@ -184,6 +189,20 @@ ot_u8 sub_defragment_heap(vaddr base, ot_uint window);
   */
 vaddr sub_header_search(vaddr header, ot_u8 search_id, ot_int num_headers);
 
+/** @brief Returns the index of the generation counter for a file header
+  * @param header       (vaddr) header address of the file, or NULL_vaddr
+  * @retval ot_uint     Index into vl_gen[]
+  * @ingroup Veelite
+  */
+static ot_uint sub_gen_index(vaddr header);
+
+/** @brief Increments the generation counter of the file at the header
+  * @param header       (vaddr) header address of the file
+  * @retval None
+  * @ingroup Veelite
+  */
+static void sub_touch(vaddr header);
+
 
 
 
@@ -304,6 +323,7 @@ ot_u8 vl_new(vlFILE** fp_new, vlBLOCK block_id, ot_u8 data_id, ot_u8 mod, ot_uin
         return 0x06;
     }
 
+    sub_touch((*fp_new)->header);
     return 0;
 #else
     return 255;
@@ -357,6 +377,7 @@ ot_u8 vl_delete(vlBLOCK block_id, ot_u8 data_id, id_tmpl* user_id) {
         }
     }
 
+    sub_touch(header);
     sub_delete_file(header);
     return 0;
 #else
@@ -490,6 +511,8 @@ ot_u16 vl_read( vlFILE* fp, ot_uint offset ) {
 
 #ifndef EXTF_vl_write
 ot_u8 vl_write( vlFILE* fp, ot_uint offset, ot_u16 data ) {
+    ot_u8 test;
+
     if (offset >= fp->alloc) {
         return 255;
     }
@@ -497,7 +520,10 @@ ot_u8 vl_write( vlFILE* fp, ot_uint offset, ot_u16 data ) {
         fp->length = offset+2;
     }
 
-    return fp->write( (offset+fp->start), data);
+    test = fp->write( (offset+fp->start), data);
+    sub_touch(fp->header);
+    vl_written(fp);
+    return test;
 }
 #endif
 
@@ -548,6 +574,8 @@ ot_u8 vl_store( vlFILE* fp, ot_uint length, ot_u8* data ) {
         test               |= fp->write(cursor, scratch.ushort);
     }
 
+    sub_touch(fp->header);
+    vl_written(fp);
     return test;
 }
 #endif
@@ -570,6 +598,8 @@ ot_u8 vl_append( vlFILE* fp, ot_uint length, ot_u8* data ) {
             scratch.ubyte[1]    = *data++;
             test               |= fp->write(cursor, scratch.ushort);
         }
+        sub_touch(fp->header);
+        vl_written(fp);
     }
     return test;
 }
@@ -577,6 +607,23 @@ ot_u8 vl_append( vlFILE* fp, ot_uint length, ot_u8* data ) {
 
 
 
+#ifndef EXTF_vl_written
+OT_WEAK void vl_written( vlFILE* fp ) {
+}
+#endif
+
+
+
+#ifndef EXTF_vl_generation
+ot_u16 vl_generation( vlBLOCK block_id, ot_u8 data_id ) {
+    vaddr header;
+    header = (block_id == VL_ISF_BLOCKID) ? sub_isf_search(data_id) : NULL_vaddr;
+    return vl_gen[sub_gen_index(header)];
+}
+#endif
+
+
+
 
 #ifndef EXTF_vl_close
 ot_u8 vl_close( vlFILE* fp ) {
@@ -929,6 +976,20 @@ ot_u8 sub_isf_mirror(ot_u8 direction) {
 
 /// Generic Subroutines
 
+static ot_uint sub_gen_index(vaddr header) {
+/// Stock ISF headers are at fixed addresses, in order of ID
+    if ((header >= ISF_Header_START) && (header < ISF_Header_START_USER)) {
+        return (ot_uint)(header - ISF_Header_START) / sizeof(vl_header);
+    }
+    return VL_GEN_SHARED;
+}
+
+
+static void sub_touch(vaddr header) {
+    vl_gen[sub_gen_index(header)]++;
+}
+
+
 vlFILE* sub_new_fp() {
 #if (OT_PARAM(VLFPS) < 8)
     ot_int fd;
@@ -0,0 +1,318 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /otsys/energy.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Energy Accounting Model
+  * @ingroup    Energy
+  *
+  ******************************************************************************
+  */
+
+#include <otstd.h>
+#include <board.h>
+#include <otsys/energy.h>
+
+#if (OT_FEATURE(ENERGY) == ENABLED)
+
+#include <otplatform.h>
+#include <otsys/syskern.h>
+#include <otlib/memcpy.h>
+
+
+/// Time is accumulated in whole seconds plus a remainder of kernel clocks, so
+/// the records do not wrap for 136 years of time in any one state.
+#define ENERGY_SECSHIFT     (OT_GPTIM_SHIFT + 10)
+#define ENERGY_CLKMASK      (((ot_u32)1 << ENERGY_SECSHIFT) - 1)
+
+
+typedef struct {
+    ot_u32  seconds;
+    ot_u32  clocks;
+} energy_time;
+
+typedef struct {
+    ot_u8       cpu_state;
+    ot_u8       rf_state;
+    ot_uint     cpu_mark;
+    ot_uint     rf_mark;
+    energy_time cpu[ENERGY_CPU_STATES];
+    energy_time rf[ENERGY_RF_STATES];
+} energy_struct;
+
+static energy_struct energy;
+
+
+static const ot_u16 cpu_uA[ENERGY_cpu_task+1] = {
+    MCU_PARAM_ENERGY_SLEEP,
+    MCU_PARAM_ENERGY_SLEEP_IO,
+    MCU_PARAM_ENERGY_SLEEP_RF,
+    MCU_PARAM_ENERGY_STOP,
+    MCU_PARAM_ENERGY_RUN,       // kernel
+    MCU_PARAM_ENERGY_RUN        // all tasks
+};
+
+static const ot_u16 rf_uA[ENERGY_RF_STATES] = {
+    RF_PARAM_ENERGY_OFF,
+    RF_PARAM_ENERGY_IDLE,
+    RF_PARAM_ENERGY_RX,
+    RF_PARAM_ENERGY_TX
+};
+
+
+
+
+/** Subroutines
+  * ============================================================================
+  */
+
+static void sub_account(energy_time* record, ot_uint mark, ot_uint now) {
+/// The kernel timer only counts up between flushes, but an ISR may log a state
+/// change between the flush and the update of the mark: ignore that interval.
+    if (now > mark) {
+        record->clocks  += (now - mark);
+        record->seconds += (record->clocks >> ENERGY_SECSHIFT);
+        record->clocks  &= ENERGY_CLKMASK;
+    }
+}
+
+
+static ot_u32 sub_time(energy_time* record, ot_u16* ticks) {
+    if (ticks != NULL) {
+        *ticks = (ot_u16)(record->clocks >> OT_GPTIM_SHIFT);
+    }
+    return record->seconds;
+}
+
+
+static ot_u32 sub_charge(energy_time* record, ot_u16 uA, ot_u16* uC) {
+/// mC = seconds * uA / 1000, plus the ticks below a second.  It is split so
+/// that no product goes over 32 bits, and the remainder is kept in uC.
+    ot_u32 mC;
+    ot_u32 rem;
+
+    mC  = (record->seconds / 1000) * uA;
+    rem = (record->seconds % 1000) * uA;
+    mC += rem / 1000;
+    rem = (rem % 1000) + (((record->clocks >> OT_GPTIM_SHIFT) * uA) >> 10);
+    mC += rem / 1000;
+
+    if (uC != NULL) {
+        *uC = (ot_u16)(rem % 1000);
+    }
+    return mC;
+}
+
+
+static energy_time* sub_cpu_record(ot_u8 state) {
+/// States out of range have an empty record
+    static energy_time none;
+    none.seconds    = 0;
+    none.clocks     = 0;
+    return (state < ENERGY_CPU_STATES) ? &energy.cpu[state] : &none;
+}
+
+
+static ot_u16 sub_cpu_uA(ot_u8 state) {
+    return cpu_uA[(state > ENERGY_cpu_task) ? ENERGY_cpu_task : state];
+}
+
+
+
+
+/** Energy Public Functions
+  * ============================================================================
+  */
+
+#ifndef EXTF_energy_init
+void energy_init(void) {
+    energy.cpu_state    = ENERGY_cpu_kernel;
+    energy.rf_state     = ENERGY_rf_off;
+    energy_reset();
+}
+#endif
+
+
+#ifndef EXTF_energy_reset
+void energy_reset(void) {
+    ot_uint now;
+    now = systim_get();
+
+    memset((ot_u8*)energy.cpu, 0, sizeof(energy.cpu));
+    memset((ot_u8*)energy.rf, 0, sizeof(energy.rf));
+    energy.cpu_mark = now;
+    energy.rf_mark  = now;
+}
+#endif
+
+
+#ifndef EXTF_energy_cpu
+void energy_cpu(ot_u8 state) {
+    ot_uint now;
+    now = systim_get();
+
+    sub_account(&energy.cpu[energy.cpu_state], energy.cpu_mark, now);
+    energy.cpu_mark     = now;
+    energy.cpu_state    = (state < ENERGY_CPU_STATES) ? state : ENERGY_cpu_kernel;
+}
+#endif
+
+
+#ifndef EXTF_energy_radio
+void energy_radio(ot_u8 state) {
+    ot_uint now;
+
+    if (state != energy.rf_state) {
+        now = systim_get();
+        sub_account(&energy.rf[energy.rf_state], energy.rf_mark, now);
+        energy.rf_mark  = now;
+        energy.rf_state = state & 3;
+    }
+}
+#endif
+
+
+#ifndef EXTF_energy_flush
+void energy_flush(ot_uint elapsed) {
+/// The event manager is kernel runtime.  If a task was killed, its exit hook
+/// never ran, so this is also where the CPU state gets put back to kernel.
+    sub_account(&energy.cpu[energy.cpu_state], energy.cpu_mark, elapsed);
+    sub_account(&energy.rf[energy.rf_state], energy.rf_mark, elapsed);
+    energy.cpu_state    = ENERGY_cpu_kernel;
+    energy.cpu_mark     = 0;
+    energy.rf_mark      = 0;
+}
+#endif
+
+
+#ifndef EXTF_energy_cpu_time
+ot_u32 energy_cpu_time(ot_u8 state, ot_u16* ticks) {
+    return sub_time(sub_cpu_record(state), ticks);
+}
+#endif
+
+
+#ifndef EXTF_energy_rf_time
+ot_u32 energy_rf_time(ot_u8 state, ot_u16* ticks) {
+/// Radio states are only ever stored as (state & 3)
+    return sub_time(&energy.rf[state & 3], ticks);
+}
+#endif
+
+
+#ifndef EXTF_energy_cpu_charge
+ot_u32 energy_cpu_charge(ot_u8 state, ot_u16* uC) {
+    return sub_charge(sub_cpu_record(state), sub_cpu_uA(state), uC);
+}
+#endif
+
+
+#ifndef EXTF_energy_rf_charge
+ot_u32 energy_rf_charge(ot_u8 state, ot_u16* uC) {
+    return sub_charge(&energy.rf[state & 3], rf_uA[state & 3], uC);
+}
+#endif
+
+
+#ifndef EXTF_energy_uptime
+ot_u32 energy_uptime(ot_u16* ticks) {
+/// The CPU is always in exactly one state, so its records add up to uptime
+    ot_u32  seconds;
+    ot_u32  sub;
+    ot_u16  part;
+    ot_u8   i;
+
+    seconds = 0;
+    sub     = 0;
+    for (i=0; i<ENERGY_CPU_STATES; i++) {
+        seconds += sub_time(&energy.cpu[i], &part);
+        sub     += part;
+    }
+    if (ticks != NULL) {
+        *ticks = (ot_u16)(sub & 1023);
+    }
+    return seconds + (sub >> 10);
+}
+#endif
+
+
+#ifndef EXTF_energy_charge
+ot_u32 energy_charge(ot_u16* uC) {
+    ot_u32  mC;
+    ot_u32  sub;
+    ot_u16  part;
+    ot_u8   i;
+
+    mC  = 0;
+    sub = 0;
+    for (i=0; i<ENERGY_CPU_STATES; i++) {
+        mC  += energy_cpu_charge(i, &part);
+        sub += part;
+    }
+    for (i=0; i<ENERGY_RF_STATES; i++) {
+        mC  += energy_rf_charge(i, &part);
+        sub += part;
+    }
+    if (uC != NULL) {
+        *uC = (ot_u16)(sub % 1000);
+    }
+    return mC + (sub / 1000);
+}
+#endif
+
+
+#ifndef EXTF_energy_avgcurrent
+ot_u32 energy_avgcurrent(void) {
+/// uA = (mC * 1000 + uC) / seconds.  The division is done a decimal digit at
+/// a time, so that it stays in 32 bits for up to 13 years of uptime.
+    ot_u32  seconds;
+    ot_u32  mC;
+    ot_u32  uA;
+    ot_u32  rem;
+    ot_u16  uC;
+    ot_u8   i;
+
+    seconds = energy_uptime(NULL);
+    if (seconds == 0) {
+        return 0;
+    }
+
+    mC  = energy_charge(&uC);
+    uA  = mC / seconds;
+    rem = mC % seconds;
+    for (i=0; i<3; i++) {
+        rem    *= 10;
+        uA      = (uA * 10) + (rem / seconds);
+        rem    %= seconds;
+    }
+    return uA + ((rem + uC) / seconds);
+}
+#endif
+
+
+#ifndef EXTF_energy_lifetime
+ot_u32 energy_lifetime(ot_u32 capacity_mAh) {
+/// hours = (mAh * 1000) / uA
+    ot_u32 uA;
+    uA = energy_avgcurrent();
+    return (uA == 0) ? 0xFFFFFFFF : ((capacity_mAh * 1000) / uA);
+}
+#endif
+
+
+#endif
@@ -0,0 +1,351 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /otsys/otcron.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      OTcron Real-Time Scheduler
+  * @ingroup    OTcron
+  *
+  ******************************************************************************
+  */
+
+#include <otstd.h>
+#include <otsys/otcron.h>
+
+#if (OT_FEATURE(CRON) == ENABLED)
+
+#include <otplatform.h>
+#include <otsys/syskern.h>
+#include <otsys/time.h>
+
+
+#if (OT_PARAM_CRON_BUCKETS & (OT_PARAM_CRON_BUCKETS-1))
+#   error "OT_PARAM_CRON_BUCKETS must be a power of 2"
+#endif
+
+#define CRON_NULL       0xFFFF
+#define CRON_BMASK      (OT_PARAM_CRON_BUCKETS-1)
+#define CRON_WIDTH      ((ot_u32)1 << OT_PARAM_CRON_SHIFT)
+#define CRON_BUCKET(T)  (((T) >> OT_PARAM_CRON_SHIFT) & CRON_BMASK)
+
+/// Kernel timeout limit for the OTcron task, in seconds, used when the
+/// platform has no RTC alarm.  It must fit into ot_long ticks.
+#define CRON_TIMEOUT_MAX    2000000
+
+
+typedef struct {
+    ot_task task;
+    ot_u32  value;
+    ot_u32  mask;
+    ot_u32  next;       // UTC of next occurrence
+    ot_u16  link;       // next event in bucket, or in free-list
+} otcron_event;
+
+typedef struct {
+    ot_u32          last;       // no event is earlier than this time
+    ot_u16          free;
+    ot_u16          bucket[OT_PARAM_CRON_BUCKETS];
+    otcron_event    event[OT_PARAM_CRON_EVENTS];
+} otcron_struct;
+
+static otcron_struct otcron;
+
+
+
+
+/** Subroutines
+  * ============================================================================
+  */
+
+static ot_bool sub_nextmatch(ot_u32* next, ot_u32 start, ot_u32 value, ot_u32 mask) {
+/// Puts the smallest time >= start for which (time & mask) == value into next,
+/// or returns False if there is no such time in the 32 bit range.  0 is a valid
+/// time, when UTC has not been set.  Mask bits are scanned from
+/// the top.  Free bits follow "start" until a masked bit differs, at which
+/// point the result is known to be above start (take free bits as 0) or below
+/// it (round-up at the lowest free bit that is still 0 in start).
+    ot_u32 bit;
+    ot_u32 bump;
+
+    value  &= mask;
+    bump    = 0;
+
+    for (bit=0x80000000; bit!=0; bit>>=1) {
+        if (mask & bit) {
+            if ((value ^ start) & bit) {
+                if (value & bit) {
+                    *next = (start & ~(bit|(bit-1))) | bit | (value & (bit-1));
+                    return True;
+                }
+                if (bump == 0) {
+                    return False;
+                }
+                *next = (start & ~mask & ~(bump|(bump-1))) | bump | value;
+                return True;
+            }
+        }
+        else if ((start & bit) == 0) {
+            bump = bit;
+        }
+    }
+
+    *next = start;
+    return True;
+}
+
+
+
+static void sub_insert(ot_u16 i) {
+/// Insert the event into its bucket, keeping the bucket sorted by time
+    ot_u16* link;
+    ot_u32  next;
+
+    next = otcron.event[i].next;
+    link = &otcron.bucket[CRON_BUCKET(next)];
+
+    while ((*link != CRON_NULL) && (otcron.event[*link].next <= next)) {
+        link = &otcron.event[*link].link;
+    }
+    otcron.event[i].link    = *link;
+    *link                   = i;
+}
+
+
+
+static void sub_unlink(ot_u16 i) {
+    ot_u16* link;
+    link = &otcron.bucket[CRON_BUCKET(otcron.event[i].next)];
+
+    while (*link != CRON_NULL) {
+        if (*link == i) {
+            *link = otcron.event[i].link;
+            break;
+        }
+        link = &otcron.event[*link].link;
+    }
+}
+
+
+
+static void sub_free(ot_u16 i) {
+    otcron.event[i].task    = NULL;
+    otcron.event[i].link    = otcron.free;
+    otcron.free             = i;
+}
+
+
+
+static ot_u16 sub_earliest(void) {
+/// Calendar queue search: starting at the bucket of otcron.last, take the
+/// first bucket whose head falls inside that bucket's window for the current
+/// lap.  No event is earlier than otcron.last, so an event that is overdue is
+/// still found first.  If a whole lap has no such event, all events are more
+/// than a lap away, so fall back to a direct search over the bucket heads.
+    ot_u16  b, i, best;
+    ot_u32  top;
+
+    b   = CRON_BUCKET(otcron.last);
+    top = (otcron.last | (CRON_WIDTH-1));
+
+    for (i=0; i<OT_PARAM_CRON_BUCKETS; i++) {
+        ot_u16 head = otcron.bucket[b];
+        if ((head != CRON_NULL) && (otcron.event[head].next <= top)) {
+            return head;
+        }
+        b   = (b+1) & CRON_BMASK;
+        top+= CRON_WIDTH;
+    }
+
+    best = CRON_NULL;
+    for (b=0; b<OT_PARAM_CRON_BUCKETS; b++) {
+        i = otcron.bucket[b];
+        if ((i != CRON_NULL) && \
+            ((best == CRON_NULL) || (otcron.event[i].next < otcron.event[best].next))) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+
+
+static void sub_schedule(ot_task task, ot_u32 now) {
+/// Program the kernel for the earliest event.  The RTC alarm wakes the OTcron
+/// task exactly on time.  The task timeout is also set, as a backup, and it is
+/// the only wakeup on platforms without RTC alarms.
+    ot_u16 i;
+    ot_u32 wait;
+
+    i = sub_earliest();
+    if (i == CRON_NULL) {
+        task->event = 0;
+        return;
+    }
+
+    wait        = otcron.event[i].next - now;
+    task->event = 1;
+
+#   if defined(RTC_ALARMS) && (RTC_ALARMS > 0)
+    platform_set_rtc_alarm(0, TASK_otcron, (wait > 65535) ? 65535 : (ot_u16)wait);
+#   endif
+
+    wait = (wait > CRON_TIMEOUT_MAX) ? CRON_TIMEOUT_MAX : wait;
+    sys_task_setnext_clocks(task, TI2CLK((ot_long)wait << 10));
+}
+
+
+
+
+/** OTcron Public Functions
+  * ============================================================================
+  */
+
+#ifndef EXTF_otcron_init
+void otcron_init(void) {
+    ot_u16 i;
+
+    for (i=0; i<OT_PARAM_CRON_BUCKETS; i++) {
+        otcron.bucket[i] = CRON_NULL;
+    }
+
+    otcron.last = 0xFFFFFFFF;
+    otcron.free = CRON_NULL;
+    i           = OT_PARAM_CRON_EVENTS;
+    while (i != 0) {
+        sub_free(--i);
+    }
+
+    sys.task[TASK_otcron].event = 0;
+}
+#endif
+
+
+
+#ifndef EXTF_otcron_add
+ot_int otcron_add(ot_task task, CRONTIME_Type type, ot_u32 time, ot_u32 mask) {
+    ot_u16 i;
+    ot_u32 now;
+
+    i = otcron.free;
+    if ((i == CRON_NULL) || (task == NULL)) {
+        return -1;
+    }
+
+    now = time_get_utc();
+    if (type == CRONTIME_relative) {
+        time   += now;
+        mask    = 0xFFFFFFFF;
+    }
+
+    // An event already in the past is dropped unless it recurs
+    if (sub_nextmatch(&otcron.event[i].next, now, time, mask) == False) {
+        return -1;
+    }
+
+    otcron.free             = otcron.event[i].link;
+    otcron.event[i].task    = task;
+    otcron.event[i].value   = time;
+    otcron.event[i].mask    = mask;
+    sub_insert(i);
+
+    // If UTC has been set back, the new event can be earlier than the rest
+    if (otcron.event[i].next < otcron.last) {
+        otcron.last = otcron.event[i].next;
+    }
+
+    // The new event may be the earliest: let the OTcron task reprogram
+    sys.task[TASK_otcron].event = 1;
+    sys_preempt(&sys.task[TASK_otcron], 0);
+
+    return (ot_int)i;
+}
+#endif
+
+
+
+#ifndef EXTF_otcron_del
+void otcron_del(ot_int handle) {
+    if ((handle >= 0) && (handle < OT_PARAM_CRON_EVENTS)) {
+        if (otcron.event[handle].task != NULL) {
+            sub_unlink((ot_u16)handle);
+            sub_free((ot_u16)handle);
+        }
+    }
+}
+#endif
+
+
+
+#ifndef EXTF_otcron_deltask
+void otcron_deltask(ot_task task) {
+    ot_int i;
+    for (i=0; i<OT_PARAM_CRON_EVENTS; i++) {
+        if (otcron.event[i].task == task) {
+            otcron_del(i);
+        }
+    }
+}
+#endif
+
+
+
+#ifndef EXTF_otcron_systask
+void otcron_systask(ot_task task) {
+    ot_u32  now;
+    ot_u16  i;
+
+    /// event = 0 is the kill/init state.  The event list is not touched, so
+    /// the task can be restarted by the next otcron_add().
+    if (task->event == 0) {
+        return;
+    }
+
+    /// Synchronize the tasks of all the events that are due, including any
+    /// that were due before the last run.  Recurring events are reinserted at
+    /// their next occurrence, which is after "now," so afterwards no event is
+    /// earlier than "now."
+    now = time_get_utc();
+    while (1) {
+        i = sub_earliest();
+        if ((i == CRON_NULL) || (otcron.event[i].next > now)) {
+            break;
+        }
+
+        sub_unlink(i);
+        otcron.event[i].task->cursor = 0;
+        sys_preempt(otcron.event[i].task, 0);
+
+        // At the last second of the 32 bit range, there is no next time
+        if ((now == 0xFFFFFFFF) || \
+            (sub_nextmatch(&otcron.event[i].next, now+1, otcron.event[i].value, otcron.event[i].mask) == False)) {
+            sub_free(i);
+        }
+        else {
+            sub_insert(i);
+        }
+    }
+    if (now > otcron.last) {
+        otcron.last = now;
+    }
+
+    sub_schedule(task, now);
+}
+#endif
+
+
+#endif
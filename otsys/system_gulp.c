@@ -34,13 +34,19 @@
 
 #include <otsys/syskern.h>
 #include "system_gulp.h"
+#include <otsys/energy.h>
 #include <otsys/mpipe.h>
 #include <otsys/sysext.h>
+#include <otsys/time.h>
 
 #include <m2/dll.h>
 #include <m2/radio.h>
 #include <m2/session.h>
 
+#if (OT_FEATURE(CRON))
+#   include <otsys/otcron.h>
+#endif
+
 
 
 
@@ -49,6 +55,9 @@
   */
 sys_struct  sys;
 
+/// Yield request for the active task, set by sys_task_manager()
+static volatile ot_bool sys_yield_req;
+
 typedef void (*fnvv)(void);
 
 
@@ -99,6 +108,9 @@ static const systask_fn systask_call[]   = {
 #if (M2_FEATURE(ENDPOINT))
     &dll_systask_sleepscan,
 #endif
+#if (OT_FEATURE(CRON))
+    &otcron_systask,
+#endif
 #if (OT_FEATURE(EXT_TASK))
     &ext_systask,
 #endif
@@ -144,6 +156,16 @@ void sys_init() {
 
     sys.active = TASK_MAX;
 
+    /// Start energy accounting before anything else draws power
+#   if (OT_FEATURE(ENERGY) == ENABLED)
+        energy_init();
+#   endif
+
+    /// Initialize OTcron before DLL, which adds its real-time schedules
+#   if (OT_FEATURE(CRON) == ENABLED)
+        otcron_init();
+#   endif
+
     /// Initialize External module if enabled
 #   if (OT_FEATURE(EXT_TASK) == ENABLED)
         ext_init();
@@ -198,6 +220,8 @@ void sys_powerdown() {
     code    = (mpipe_status() <= 0) ? 1 : code;
 #   endif
 
+    ENERGY_CPU(ENERGY_cpu_sleep + code);
+
 #   if defined(EXTF_sys_sig_powerdown)
         sys_sig_powerdown(code);
 #   elif (OT_FEATURE(SYSKERN_CALLBACKS))
@@ -212,6 +236,8 @@ void sys_powerdown() {
         powerdown[code]();
     }
 #   endif
+
+    ENERGY_CPU(ENERGY_cpu_kernel);
 }
 #endif
 
@@ -395,8 +421,11 @@ ot_uint sys_event_manager() {
 
     /// 1. On entry, we need to know the time that has passed since the last
     ///    run of this function, and then we can flush the timer and begin a
-    ///    new loop of tasking.
+    ///    new loop of tasking.  The time is also updated, which does nothing
+    ///    unless time is enabled.
     elapsed = systim_get();
+    time_add_ti(elapsed);
+    ENERGY_FLUSH(elapsed);
     systim_flush();
 
     /// 2. Clock all the tasks, to find out which one to do next.
@@ -481,7 +510,42 @@ ot_uint sys_event_manager() {
 
 #ifndef EXTF_sys_task_manager
 void sys_task_manager() {
-/// Not implemented in GULP... will be implemented in "Big GULP"
+/// "Big GULP" task manager.  GULP has only one context, so tasks cannot be
+/// switched-out by force.  Instead, the platform calls this function (usually
+/// from the kernel timer ISR) when the active task has overrun, and the task
+/// will yield to the scheduler at its next pre-emption point.
+    sys_yield_req = True;
+}
+#endif
+
+
+
+#ifndef EXTF_sys_task_yield
+ot_bool sys_task_yield(ot_task task) {
+/// The GULP kernel timer is flushed on each run of the scheduler, so
+/// systim_get() is the runtime of the task so far and task nextevent values
+/// are relative to the same base.  Tasks with lower index than the caller are
+/// higher priority, and the caller must yield if any of them are pending.
+    ot_long      elapsed;
+    task_marker* task_i;
+
+    elapsed = (ot_long)systim_get();
+
+    if ((sys_yield_req == False) && (elapsed <= TI2CLK(task->reserve))) {
+        for (task_i=&sys.task[0]; task_i<task; task_i++) {
+            if ((task_i->event != 0) && (task_i->nextevent <= elapsed)) {
+                goto sys_task_yield_NOW;
+            }
+        }
+        return False;
+    }
+
+    // Reschedule the caller for immediate re-entry.  sys_event_manager() will
+    // run any pending higher priority task ahead of it.
+    sys_task_yield_NOW:
+    sys_yield_req   = False;
+    task->nextevent = elapsed;
+    return True;
 }
 #endif
 
@@ -490,7 +554,10 @@ void sys_task_manager() {
 #ifndef EXTF_sys_run_task
 OT_INLINE void sys_run_task() {
 /// Must be inline
+    sys_yield_req = False;
+    ENERGY_CPU(ENERGY_cpu_task + (TASK(sys.active) - &sys.task[0]));
 	TASK_CALL(sys.active);
+    ENERGY_CPU(ENERGY_cpu_kernel);
 }
 #endif
 
@@ -523,23 +590,10 @@ void sys_synchronize(Task_Index task_id) {
 
 
 void sys_refresh_scheduler() {
+/// The Real Time Scheduler ISF is applied by OTcron, in dll_refresh_rts().
+/// OTcron programs the RTC alarm for its own earliest event.
 #if (M2_FEATURE(RTC_SCHEDULER))
-    ot_u16  sched_ctrl;
-    ot_u16  offset;
-    ot_int  i, j;
-
-    platform_clear_rtc_alarms();
-
-    sched_ctrl = dll.netconf.active;
-
-    for (i=TASK_hold, j=0, offset=0;
-        i<TASK_external;
-        i++, sched_ctrl<<=1, offset+=4) {
-
-        if (sched_ctrl & M2_SET_HOLDSCHED)
-            platform_set_rtc_alarm(j++, i, offset);
-    }
-
+    dll_refresh_rts();
 #endif
 }
 
@@ -31,8 +31,10 @@
 #include <otplatform.h>
 
 #include <otsys/syskern.h>
+#include <otsys/energy.h>
 #include <otsys/mpipe.h>
 #include <otsys/sysext.h>
+#include <otsys/time.h>
 
 #include <otlib/memcpy.h>
 #include <otlib/utils.h>
@@ -47,7 +49,7 @@
 /// Really what needs to happen is that app_config must be put into build_config
 /// and then app_config will become about tasks/threads only.
 #if OT_FEATURE(CRON)
-#   include <hbsys/otcron.h>
+#   include <otsys/otcron.h>
 #endif
 #if OT_FEATURE(IAP2)
 #   include <hbsys/iap2.h>
@@ -116,9 +118,9 @@ static const systask_fn systask_call[]   = {
 #if (OT_FEATURE(M2))
     &dll_systask_sleepscan,
 #endif
-//#if (OT_FEATURE(CRON))
-//    &otcron_systask,
-//#endif
+#if (OT_FEATURE(CRON))
+    &otcron_systask,
+#endif
 #if (OT_PARAM(KERNELTASKS) > 0)
     OT_PARAM_KERNELTASK_HANDLES,
 #elif (OT_FEATURE(EXT_TASK))
@@ -168,6 +170,9 @@ OT_WEAK void sys_init() {
 
     ///@todo change these manual calls into normal task calls using event=0,
     ///      which is the initialization/kill state.
+#   if (OT_FEATURE(ENERGY) == ENABLED)
+        energy_init();
+#   endif
 #   if (OT_FEATURE(CRON) == ENABLED)
         otcron_init();
 #   endif
@@ -233,6 +238,8 @@ OT_WEAK void sys_powerdown() {
 #   if defined(OT_PARAM_USER_EXOTASKS)
 #   endif
 
+    ENERGY_CPU(ENERGY_cpu_sleep + code);
+
 #   if defined(EXTF_sys_sig_powerdown)
         sys_sig_powerdown(code);
 #   elif (OT_FEATURE(SYSKERN_CALLBACKS))
@@ -240,6 +247,8 @@ OT_WEAK void sys_powerdown() {
 #   else
 #       error "powerdown applet (sys_sig_powerdown) is not available."
 #   endif
+
+    ENERGY_CPU(ENERGY_cpu_kernel);
 }
 #endif
 
@@ -449,6 +458,7 @@ OT_WEAK ot_uint sys_event_manager() {
     ///    the time, which does nothing unless time is enabled.
     elapsed = systim_get();
     time_add_ti(elapsed);
+    ENERGY_FLUSH(elapsed);
     systim_flush();
 
 
@@ -590,7 +600,9 @@ OT_INLINE void sys_run_task() {
     systim_disable();
 
     sys_run_task_CALL:
+    ENERGY_CPU(ENERGY_cpu_task + (TASK(sys.active) - &sys.task[0]));
     TASK_CALL(sys.active);
+    ENERGY_CPU(ENERGY_cpu_kernel);
 }
 #endif
 
@@ -622,26 +634,11 @@ OT_WEAK void sys_synchronize(Task_Index task_id) {
 }
 
 
-///@todo this is replaced by OTcron
 OT_WEAK void sys_refresh_scheduler() {
-#if (0)
-//#if (M2_FEATURE(RTC_SCHEDULER))
-    ot_u16  sched_ctrl;
-    ot_u16  offset;
-    ot_int  i, j;
-
-    platform_clear_rtc_alarms();
-
-    sched_ctrl = dll.netconf.active;
-
-    for (i=TASK_hold, j=0, offset=0;
-        i<TASK_external;
-        i++, sched_ctrl<<=1, offset+=4) {
-
-        if (sched_ctrl & M2_SET_HOLDSCHED)
-            platform_set_rtc_alarm(j++, i, offset);
-    }
-
+/// The Real Time Scheduler ISF is applied by OTcron, in dll_refresh_rts().
+/// OTcron programs the RTC alarm for its own earliest event.
+#if (M2_FEATURE(RTC_SCHEDULER))
+    dll_refresh_rts();
 #endif
 }
 
@@ -25,26 +25,76 @@
   */
 
 #include <otstd.h>
+#include <otsys/syskern.h>
 #include <otsys/time.h>
 #include <platform/timers.h>
 
 
 
+#ifndef EXTF_systim_get_subtick
+OT_WEAK ot_u32 systim_get_subtick(ot_u32* subtick_ns) {
+/// Default for platforms without a clock finer than the kernel timer.  The
+/// remainder of a tick is whatever kernel clocks there are below a tick.
+/// 1 tick = 1953125/2 ns.
+    ot_u32 clocks;
+    clocks = systim_get();
+    if (subtick_ns != NULL) {
+        *subtick_ns = ((clocks & ((1 << OT_GPTIM_SHIFT) - 1)) * 1953125) >> (1 + OT_GPTIM_SHIFT);
+    }
+    return (clocks >> OT_GPTIM_SHIFT);
+}
+#endif
+
+
+
 
 #if OT_FEATURE(TIME)
 
+#define NS_PER_SEC      1000000000
+
 static ot_time  systime;
 static ot_time  starttime;
+static ot_time  monotime;
+static ot_s32   realtime_ns;        // sub-tick phase of realtime vs. systim
 
 
-void sub_load_now(ot_time* now) {
-    ot_u32 ticks;
+static void sub_add_ti(ot_time* time, ot_u32 ticks) {
     ot_u32 scratch;
-    *now        = systime;
-    ticks       = systim_get();
-    scratch     = ticks + now->ticks;
-    now->upper  = (scratch < ticks);
-    now->ticks  = scratch;
+    scratch         = ticks + time->ticks;
+    time->upper    += (scratch < ticks);
+    time->ticks     = scratch;
+}
+
+
+void sub_load_now(ot_time* now) {
+    *now = systime;
+    sub_add_ti(now, systim_get_subtick(NULL));
+}
+
+
+static void sub_time2spec(ot_timespec* ts, ot_time* time, ot_s32 ns) {
+/// ns is a correction in [-1 tick, +2 ticks], so the sum stays in ot_s32
+    ts->sec = (time->upper << 22) | (time->ticks >> 10);
+    ns     += ((time->ticks & 1023) * 1953125) >> 1;
+    if (ns < 0) {
+        ns += NS_PER_SEC;
+        ts->sec--;
+    }
+    else if (ns >= NS_PER_SEC) {
+        ns -= NS_PER_SEC;
+        ts->sec++;
+    }
+    ts->nsec = (ot_u32)ns;
+}
+
+
+static ot_u32 sub_spec2time(ot_time* time, ot_timespec* ts) {
+/// Returns the nanoseconds that remain below one tick
+    ot_u32 frac_ti;
+    frac_ti     = (ts->nsec << 1) / 1953125;
+    time->upper = (ts->sec >> 22);
+    time->ticks = (ts->sec << 10) | frac_ti;
+    return ts->nsec - ((frac_ti * 1953125) >> 1);
 }
 
 
@@ -58,43 +108,84 @@ void time_init_utc(ot_u32 utc) {
 void time_set_utc(ot_u32 utc) {
     systime.upper   = (utc >> 22);
     systime.ticks   = (utc << 10);
+    realtime_ns     = 0;
+}
+
+
+void time_set_realtime(ot_timespec* ts) {
+/// The new time is the time "now," but systime is the time at the last kernel
+/// flush, so the ticks since the flush are taken back off.  The sub-tick
+/// phase difference is kept in realtime_ns.
+    ot_u32 ticks;
+    ot_u32 ns;
+    ot_u32 rem_ns;
+
+    ticks           = systim_get_subtick(&ns);
+    rem_ns          = sub_spec2time(&systime, ts);
+    systime.upper  -= (systime.ticks < ticks);
+    systime.ticks  -= ticks;
+    realtime_ns     = (ot_s32)rem_ns - (ot_s32)ns;
 }
 
 
 void time_add_ti(ot_u32 ticks) {
-    ot_u32 scratch;
-    scratch         = ticks + systime.ticks;
-    systime.upper  += (scratch < ticks);
-    systime.ticks   = scratch;
+    sub_add_ti(&systime, ticks);
+    sub_add_ti(&monotime, ticks);
 }
 
 
 ot_u32 time_get_utc(void) {
     ot_time now;
     sub_load_now(&now);
-    now->upper  <<= 22;
-    now->ticks  >>= 10;
-    return (now->upper | now->ticks);
+    now.upper <<= 22;
+    now.ticks >>= 10;
+    return (now.upper | now.ticks);
 }
 
 
 ot_u32 time_uptime(void) {
     ot_time now;
-    sub_load_now(&now);
-    
-    now->upper<<= 22;
-    now->upper += (now->ticks >> 10);
-    now->ticks  = (starttime.upper << 22);
-    now->ticks += (starttime.ticks >> 10);
-
-    return (now->upper - now->ticks);
+    now = monotime;
+    sub_add_ti(&now, systim_get_subtick(NULL));
+    return (now.upper << 22) | (now.ticks >> 10);
 }
 
 
 ot_u32 time_uptime_ti(void) {
+    return monotime.ticks + systim_get_subtick(NULL);
+}
+
+
+void time_get_realtime(ot_timespec* ts) {
     ot_time now;
-    sub_load_now(&now);
-    return (now->ticks - starttime.ticks);
+    ot_u32  ns;
+    now = systime;
+    sub_add_ti(&now, systim_get_subtick(&ns));
+    sub_time2spec(ts, &now, (ot_s32)ns + realtime_ns);
+}
+
+
+void time_get_monotonic(ot_timespec* ts) {
+    ot_time now;
+    ot_u32  ns;
+    now = monotime;
+    sub_add_ti(&now, systim_get_subtick(&ns));
+    sub_time2spec(ts, &now, (ot_s32)ns);
+}
+
+
+void time_mono2real(ot_timespec* ts) {
+/// realtime = monotonic + (systime - monotime), with 64 bit borrow
+    ot_time time;
+    ot_u32  ns;
+    ot_u32  scratch;
+
+    ns              = sub_spec2time(&time, ts);
+    scratch         = time.ticks + systime.ticks;
+    time.upper     += systime.upper + (scratch < time.ticks);
+    time.upper     -= monotime.upper + (scratch < monotime.ticks);
+    time.ticks      = scratch - monotime.ticks;
+    sub_time2spec(ts, &time, (ot_s32)ns + realtime_ns);
 }
 
 
@@ -116,6 +207,10 @@ void time_add_ti(ot_u32 ticks)          { }
 ot_u32 time_get_utc(void)               { return 0; }
 ot_u32 time_uptime(void)                { return 0; }
 ot_u32 time_uptime_ti(void)             { return 0; }
+void time_set_realtime(ot_timespec* ts) { }
+void time_get_realtime(ot_timespec* ts) { ts->sec = 0; ts->nsec = 0; }
+void time_get_monotonic(ot_timespec* ts){ ts->sec = 0; ts->nsec = 0; }
+void time_mono2real(ot_timespec* ts)    { }
 
 #endif
 
@@ -0,0 +1,161 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /otplatform/stdc/crc16_stdc.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      Carry-less multiply CRC16 folding for x86-64 hosts
+  * @ingroup    CRC16
+  *
+  * POSIX gateways check the CRC of every frame and every MPipe packet.  This
+  * file replaces the weak crc16drv_fold() from /otlib/crc16.c with one that
+  * folds 64 bytes per step using PCLMULQDQ.  The CPU is checked at runtime,
+  * and without PCLMULQDQ (or on other hosts) the table driver does all of it.
+  *
+  * The fold works on the byte-reversed block, so the first byte is the most
+  * significant.  Each 128 bit lane is moved forward by multiplying its halves
+  * by x^(N+64) mod P and x^N mod P, which keeps the remainder the same, and a
+  * Barrett step reduces the final lane to the 16 bit CRC.  The polynomial is
+  * taken from crc16_table.h, so it always matches the table driver.
+  *
+  ******************************************************************************
+  */
+
+#include <otstd.h>
+#include <platform/config.h>
+#include <otlib/crc16.h>
+#include <otlib/crc16_table.h>
+
+#if ( (MCU_FEATURE(CRC16) != ENABLED) && !defined(EXTF_crc16drv_fold) \
+    && defined(__GNUC__) && defined(__x86_64__) )
+
+#include <stdint.h>
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+
+#define CRC16_POLY      (0x10000 | CRCx01)
+
+static ot_int   pclmul_ok = -1;     // -1 = not yet checked
+static uint64_t k_fold4[2];         // x^576, x^512 mod P
+static uint64_t k_fold1[2];         // x^192, x^128 mod P
+static uint64_t k_x64;              // x^64 mod P
+static uint64_t k_mu;               // floor(x^80 / P), without the x^64 bit
+
+
+
+static uint64_t sub_xmod(ot_int n, uint64_t* quotient) {
+/// x^n mod P, and the low 64 bits of floor(x^n / P)
+    ot_u32      r = 1;
+    uint64_t    q = 0;
+    while (--n >= 0) {
+        r <<= 1;
+        q <<= 1;
+        if (r & 0x10000) {
+            r  ^= CRC16_POLY;
+            q  |= 1;
+        }
+    }
+    if (quotient != NULL) {
+        *quotient = q;
+    }
+    return r;
+}
+
+
+static void sub_init() {
+    unsigned int eax, ebx, ecx, edx;
+
+    pclmul_ok = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) \
+    && (ecx & bit_PCLMUL) && (ecx & bit_SSSE3)) {
+        k_fold4[0]  = sub_xmod(576, NULL);
+        k_fold4[1]  = sub_xmod(512, NULL);
+        k_fold1[0]  = sub_xmod(192, NULL);
+        k_fold1[1]  = sub_xmod(128, NULL);
+        k_x64       = sub_xmod(64, NULL);
+        sub_xmod(80, &k_mu);
+        pclmul_ok   = 1;
+    }
+}
+
+
+__attribute__((target("pclmul,ssse3")))
+static ot_int sub_fold(ot_u8* data, ot_int size, ot_u16* crc) {
+    __m128i rev, k4, k1, a0, a1, a2, a3, v, w;
+    ot_int  n;
+
+    rev = _mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+    k4  = _mm_set_epi64x((long long)k_fold4[0], (long long)k_fold4[1]);
+    k1  = _mm_set_epi64x((long long)k_fold1[0], (long long)k_fold1[1]);
+
+#   define LOAD(P)      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(P)), rev)
+#   define FOLD(A, K)   _mm_xor_si128(_mm_clmulepi64_si128(A, K, 0x11), \
+                                      _mm_clmulepi64_si128(A, K, 0x00))
+
+    /// The running CRC goes into the first two bytes, like the table driver
+    a0  = _mm_xor_si128(LOAD(data), _mm_slli_si128(_mm_cvtsi32_si128(*crc), 14));
+    a1  = LOAD(data+16);
+    a2  = LOAD(data+32);
+    a3  = LOAD(data+48);
+
+    for (n=64; (size-n) >= 64; n+=64) {
+        a0  = _mm_xor_si128(FOLD(a0, k4), LOAD(data+n));
+        a1  = _mm_xor_si128(FOLD(a1, k4), LOAD(data+n+16));
+        a2  = _mm_xor_si128(FOLD(a2, k4), LOAD(data+n+32));
+        a3  = _mm_xor_si128(FOLD(a3, k4), LOAD(data+n+48));
+    }
+
+    a0  = _mm_xor_si128(FOLD(a0, k1), a1);
+    a0  = _mm_xor_si128(FOLD(a0, k1), a2);
+    a0  = _mm_xor_si128(FOLD(a0, k1), a3);
+    for (; (size-n) >= 16; n+=16) {
+        a0  = _mm_xor_si128(FOLD(a0, k1), LOAD(data+n));
+    }
+
+    /// 128 -> 64 bits, in two steps, because the first product is 79 bits
+    w   = _mm_clmulepi64_si128(a0, _mm_cvtsi64_si128((long long)k_x64), 0x01);
+    v   = _mm_xor_si128(a0, w);
+    w   = _mm_clmulepi64_si128(w, _mm_cvtsi64_si128((long long)k_x64), 0x01);
+    v   = _mm_move_epi64(_mm_xor_si128(v, w));
+
+    /// Barrett: q = floor(v * x^16 / P), and the CRC is the low 16 bits of q*P
+    w   = _mm_clmulepi64_si128(v, _mm_cvtsi64_si128((long long)k_mu), 0x00);
+    v   = _mm_xor_si128(v, _mm_srli_si128(w, 8));
+    w   = _mm_clmulepi64_si128(v, _mm_cvtsi32_si128(CRCx01), 0x00);
+    *crc = (ot_u16)_mm_cvtsi128_si32(w);
+
+#   undef LOAD
+#   undef FOLD
+    return n;
+}
+
+
+
+ot_int crc16drv_fold(ot_u8* block_addr, ot_int block_size, ot_u16* crc) {
+    if (pclmul_ok < 0) {
+        sub_init();
+    }
+    if ((pclmul_ok == 0) || (block_size < 64)) {
+        return 0;
+    }
+    return sub_fold(block_addr, block_size, crc);
+}
+
+
+#endif
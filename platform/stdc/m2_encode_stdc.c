@@ -0,0 +1,231 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /otplatform/stdc/m2_encode_stdc.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      SIMD kernels for the SW FEC and RS decoders
+  * @ingroup    Encode
+  *
+  * POSIX gateways decode every FEC frame they hear in software.  This file
+  * replaces the weak em2_fec_viterbi() from /m2/encode.c with an SSE2 one,
+  * which does the add-compare-select of all 8 encoder states in one vector
+  * per symbol.  Without SSE2, the portable one from /m2/encode.c is used.
+  *
+  * It also replaces em2_rs_syndrome(), which updates the RS syndromes of
+  * every received byte, with one that updates 16 syndromes per vector.
+  *
+  ******************************************************************************
+  */
+
+#include <otstd.h>
+#include <m2/encode.h>
+
+#if ( (M2_FEATURE(FECRX) == ENABLED) && (RF_FEATURE(FEC) != ENABLED) \
+    && defined(__SSE2__) && !defined(EXTF_em2_fec_viterbi) )
+
+#include <emmintrin.h>
+
+
+/** Branch metrics for each received symbol, per destination state
+  * Destination 2k gets a from source k and b from source k+4, destination
+  * 2k+1 gets b from source k and a from source k+4.  a is the distance from
+  * the received symbol to "00", "01", "11", "10" for k = 0, 1, 2, 3, and b is
+  * 2-a.  Bytes are in destination state order.
+  */
+static const ot_u8 bm_lo[4][8] = {
+    { 0, 2, 1, 1, 2, 0, 1, 1 },     // "00" received
+    { 1, 1, 0, 2, 1, 1, 2, 0 },     // "01" received
+    { 1, 1, 2, 0, 1, 1, 0, 2 },     // "10" received
+    { 2, 0, 1, 1, 0, 2, 1, 1 }      // "11" received
+};
+
+static const ot_u8 bm_hi[4][8] = {
+    { 2, 0, 1, 1, 0, 2, 1, 1 },
+    { 1, 1, 2, 0, 1, 1, 0, 2 },
+    { 1, 1, 0, 2, 1, 1, 2, 0 },
+    { 0, 2, 1, 1, 2, 0, 1, 1 }
+};
+
+
+
+ot_u8 em2_fec_viterbi(ot_u8* cost, ot_u32* path, ot_u8 symbols) {
+    __m128i C, P0, P1, ones;
+    ot_int  i;
+    ot_u8   floor;
+    ot_u8   best;
+
+    /// ot_u32 is a long, which is 64 bits on LP64 hosts, so the paths are
+    /// moved in and out of the vectors one at a time.
+    C       = _mm_loadl_epi64((const __m128i*)cost);
+    P0      = _mm_set_epi32((int)path[3], (int)path[2], (int)path[1], (int)path[0]);
+    P1      = _mm_set_epi32((int)path[7], (int)path[6], (int)path[5], (int)path[4]);
+    ones    = _mm_set_epi32(1, 0, 1, 0);
+
+    for (i=6; i>=0; i-=2) {
+        __m128i lo, hi, x, y, sel, m16, m32;
+        __m128i src0, src1;
+        ot_int  s = (symbols >> i) & 3;
+
+        /// Add-compare-select on the path metrics, 8 states at once.
+        /// y < x picks the source k+4, so a tie picks source k.
+        lo  = _mm_unpacklo_epi8(C, C);              // c0 c0 c1 c1 .. c7 c7
+        hi  = _mm_srli_si128(lo, 8);                // c4 c4 .. c7 c7
+        x   = _mm_adds_epu8(lo, _mm_loadl_epi64((const __m128i*)bm_lo[s]));
+        y   = _mm_adds_epu8(hi, _mm_loadl_epi64((const __m128i*)bm_hi[s]));
+        C   = _mm_min_epu8(x, y);
+        sel = _mm_andnot_si128(_mm_cmpeq_epi8(C, x), _mm_set1_epi8(-1));
+        m16 = _mm_unpacklo_epi8(sel, sel);
+
+        /// Survivor paths: register exchange, selected with the masks
+        m32     = _mm_unpacklo_epi16(m16, m16);     // states 0-3
+        src0    = _mm_shuffle_epi32(P0, _MM_SHUFFLE(1,1,0,0));
+        src1    = _mm_shuffle_epi32(P1, _MM_SHUFFLE(1,1,0,0));
+        src0    = _mm_or_si128(_mm_andnot_si128(m32, src0), _mm_and_si128(m32, src1));
+
+        m32     = _mm_unpackhi_epi16(m16, m16);     // states 4-7
+        hi      = _mm_shuffle_epi32(P0, _MM_SHUFFLE(3,3,2,2));
+        src1    = _mm_shuffle_epi32(P1, _MM_SHUFFLE(3,3,2,2));
+        src1    = _mm_or_si128(_mm_andnot_si128(m32, hi), _mm_and_si128(m32, src1));
+
+        P0      = _mm_or_si128(_mm_slli_epi32(src0, 1), ones);
+        P1      = _mm_or_si128(_mm_slli_epi32(src1, 1), ones);
+    }
+
+    /// Normalize costs so that the minimum becomes 0.  The best state is the
+    /// lowest one with the minimum, like the portable version.
+    {
+        __m128i m;
+        m       = _mm_min_epu8(C, _mm_srli_si128(C, 4));
+        m       = _mm_min_epu8(m, _mm_srli_si128(m, 2));
+        m       = _mm_min_epu8(m, _mm_srli_si128(m, 1));
+        floor   = (ot_u8)_mm_cvtsi128_si32(m);
+        m       = _mm_set1_epi8((char)floor);
+        best    = (ot_u8)__builtin_ctz(_mm_movemask_epi8(_mm_cmpeq_epi8(C, m)) | 0x100);
+        C       = _mm_subs_epu8(C, m);
+    }
+
+    _mm_storel_epi64((__m128i*)cost, C);
+    {
+        unsigned int scratch[8];                    // 32 bits on any SSE2 host
+        ot_int  k;
+        _mm_storeu_si128((__m128i*)&scratch[0], P0);
+        _mm_storeu_si128((__m128i*)&scratch[4], P1);
+        for (k=0; k<8; k++) {
+            path[k] = scratch[k];
+        }
+    }
+    return best;
+}
+
+
+#endif
+
+
+
+
+
+#if ( (M2_FEATURE(RSCODE) == ENABLED) && defined(__SSE2__) \
+    && !defined(EXTF_em2_rs_syndrome) )
+
+#include <emmintrin.h>
+
+/** Multipliers for the syndrome update, S[j] = S[j]*a^j + byte
+  * Multiplying by a constant is linear over the bits of S[j], so lane j of
+  * rs_k[v][b] is a^j * x^b, for syndrome j = 16v + lane, and the product is
+  * the XOR of the ones for the bits that are set in S[j].
+  */
+static ot_bool  rs_k_ready = False;
+static __m128i  rs_k[RS_MAXPARITY/16][8];
+
+
+static ot_u8 sub_gf_xtime(ot_u8 a) {
+    return (ot_u8)((a << 1) ^ ((a & 0x80) ? (RS_GFPOLY & 0xFF) : 0));
+}
+
+
+static void sub_rs_init() {
+    ot_u8   k[RS_MAXPARITY][8];
+    ot_u8   alpha_j;
+    ot_int  j, b;
+
+    alpha_j = 1;
+    for (j=0; j<RS_MAXPARITY; j++) {
+        k[j][0] = alpha_j;
+        for (b=1; b<8; b++) {
+            k[j][b] = sub_gf_xtime(k[j][b-1]);
+        }
+        alpha_j = sub_gf_xtime(alpha_j);
+    }
+    for (j=0; j<RS_MAXPARITY; j+=16) {
+        for (b=0; b<8; b++) {
+            ot_u8 lane[16];
+            ot_int i;
+            for (i=0; i<16; i++) {
+                lane[i] = k[j+i][b];
+            }
+            rs_k[j/16][b] = _mm_loadu_si128((const __m128i*)lane);
+        }
+    }
+    rs_k_ready = True;
+}
+
+
+static __m128i sub_rs_mulk(__m128i s, const __m128i* k) {
+/// The sign of each byte is its top bit, so it becomes a mask for k[7], and
+/// adding s to itself brings the next bit up.
+    __m128i acc, zero;
+    ot_int  b;
+    zero    = _mm_setzero_si128();
+    acc     = zero;
+    for (b=7; b>=0; b--) {
+        acc = _mm_xor_si128(acc, _mm_and_si128(_mm_cmplt_epi8(s, zero), k[b]));
+        s   = _mm_add_epi8(s, s);
+    }
+    return acc;
+}
+
+
+void em2_rs_syndrome(ot_u8* syndrome, ot_int parity, ot_u8* data, ot_int length) {
+    __m128i s0, s1, r;
+
+    if (rs_k_ready == False) {
+        sub_rs_init();
+    }
+    s0 = _mm_loadu_si128((const __m128i*)&syndrome[0]);
+    s1 = _mm_loadu_si128((const __m128i*)&syndrome[16]);
+
+    if (parity <= 16) {
+        while (--length >= 0) {
+            r   = _mm_set1_epi8((char)*data++);
+            s0  = _mm_xor_si128(sub_rs_mulk(s0, rs_k[0]), r);
+        }
+    }
+    else {
+        while (--length >= 0) {
+            r   = _mm_set1_epi8((char)*data++);
+            s0  = _mm_xor_si128(sub_rs_mulk(s0, rs_k[0]), r);
+            s1  = _mm_xor_si128(sub_rs_mulk(s1, rs_k[1]), r);
+        }
+    }
+
+    _mm_storeu_si128((__m128i*)&syndrome[0], s0);
+    _mm_storeu_si128((__m128i*)&syndrome[16], s1);
+}
+
+
+#endif
@@ -0,0 +1,564 @@
+/* Copyright 2014 JP Norair
+  *
+  * Licensed under the OpenTag License, Version 1.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  * http://www.indigresso.com/wiki/doku.php?id=opentag:license_1_0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  *
+  */
+/**
+  * @file       /otplatform/stdc/otlib_eax_stdc.c
+  * @author     JP Norair
+  * @version    R100
+  * @date       18 Oct 2014
+  * @brief      EAX Cryptographic Driver for POSIX hosts
+  * @defgroup   EAX Driver
+  * @ingroup    EAX Driver
+  *
+  * A gateway has to decrypt the DLLS frames of every endpoint it hears, so
+  * this driver is built for throughput.  AES-128 uses AES-NI when the CPU has
+  * it (checked at runtime), and a bitsliced AES otherwise, which is constant
+  * time: it has no tables, so the cache cannot leak the key.  Build with
+  * EAX_NOAESNI defined to use the bitsliced AES on any CPU.
+  *
+  * The EAX profile is the one used by M2NP DLLS: 7 byte nonce, no header,
+  * and a 4 byte tag after the data.  EAXdrv_decrypt() takes the length with
+  * the tag, as auth_decrypt() gets it from the queue.
+  *
+  * All frames go through one engine, which runs up to EAX_LANES frames side
+  * by side.  At each step it takes the next CTR block and the next OMAC block
+  * of every frame and encrypts them together, so the AES pipeline always has
+  * independent blocks in flight.  EAXdrv_decrypt_batch() gives the engine
+  * several frames at once.  The frames may use different keys.
+  *
+  ******************************************************************************
+  */
+
+#include <otstd.h>
+#if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY)) \
+ && (OT_FEATURE(CRYPTO_RFAES) != ENABLED)
+
+#include <otlib/crypto.h>
+
+#if (defined(__GNUC__) && defined(__x86_64__) && !defined(EAX_NOAESNI))
+#   define EAX_AESNI
+#   include <cpuid.h>
+#   include <emmintrin.h>
+#   include <wmmintrin.h>
+#endif
+
+#define EAX_NONCELEN    7               // M2NP DLLS nonce field
+#define EAX_TAGLEN      4
+#define EAX_LANES       8               // frames interleaved by the engine
+
+#define ROTL32(X, N)    (((X) << (N)) | ((X) >> (32-(N))))
+#define XTIME(X)        (ot_u8)(((X) << 1) ^ (((X) & 0x80) ? 0x1B : 0))
+#define XTIME32(X)      ((((X) & 0x7F7F7F7F) << 1) ^ ((((X) >> 7) & 0x01010101) * 0x1B))
+
+typedef void (*ecb_fn)(const EAXdrv_t** key, ot_u8 (*block)[16], ot_int count);
+
+typedef struct {
+    EAXdrv_frame*   frame;
+    const EAXdrv_t* key;
+    ot_int          length;             // message bytes, without the tag
+    ot_int          blocks;
+    uint64_t        ctr_hi;             // CTR start (the nonce OMAC), host order
+    uint64_t        ctr_lo;
+    ot_u8           nonce[16];
+    ot_u8           mac[16];
+} eax_lane;
+
+static ot_int   aesni_ok = -1;          // -1 = not yet checked
+static ecb_fn   sub_ecb;                // AES-NI or bitsliced, set by sub_init()
+
+
+
+/** AES-128 block cipher
+  * ============================================================================
+  * The state and the schedule are little-endian words, one per column, so on
+  * x86 the schedule in memory is also the byte schedule that AES-NI loads.
+  *
+  * Without AES-NI, nothing indexes memory with key or data: SubBytes is the
+  * Boyar-Peralta circuit (113 gates), run on 64 bytes at once with each byte
+  * spread over 8 bit-planes, and the other steps are shifts and masks.
+  */
+
+static void sub_transpose_bits(uint64_t* w) {
+/// 8x8 bit transpose of each word: bit B of byte J goes to bit J of byte B
+    uint64_t    t;
+    ot_int      i;
+
+    for (i=0; i<8; i++) {
+        t       = (w[i] ^ (w[i] >> 7)) & 0x00AA00AA00AA00AAULL;
+        w[i]   ^= t ^ (t << 7);
+        t       = (w[i] ^ (w[i] >> 14)) & 0x0000CCCC0000CCCCULL;
+        w[i]   ^= t ^ (t << 14);
+        t       = (w[i] ^ (w[i] >> 28)) & 0x00000000F0F0F0F0ULL;
+        w[i]   ^= t ^ (t << 28);
+    }
+}
+
+
+static void sub_transpose_bytes(uint64_t* w) {
+/// 8x8 byte transpose across the words: byte J of w[K] goes to byte K of w[J]
+    uint64_t    t;
+    ot_int      i;
+
+    for (i=0; i<4; i++) {
+        t       = ((w[i] >> 32) ^ w[i+4]) & 0x00000000FFFFFFFFULL;
+        w[i]   ^= t << 32;
+        w[i+4] ^= t;
+    }
+    for (i=0; i<6; i++) {
+        if ((i & 2) == 0) {
+            t       = ((w[i] >> 16) ^ w[i+2]) & 0x0000FFFF0000FFFFULL;
+            w[i]   ^= t << 16;
+            w[i+2] ^= t;
+        }
+    }
+    for (i=0; i<8; i+=2) {
+        t       = ((w[i] >> 8) ^ w[i+1]) & 0x00FF00FF00FF00FFULL;
+        w[i]   ^= t << 8;
+        w[i+1] ^= t;
+    }
+}
+
+
+static void sub_sbox(uint64_t* q) {
+/// Boyar & Peralta, "A depth-16 circuit for the AES S-box" (2011), on 64
+/// bytes in bit-planes: bit I of q[B] is bit B of byte I.
+    uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11, y12, y13, y14;
+    uint64_t y15, y16, y17, y18, y19, y20, y21;
+    uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11, z12, z13;
+    uint64_t z14, z15, z16, z17;
+    uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13;
+    uint64_t t14, t15, t16, t17, t18, t19, t20, t21, t22, t23, t24, t25;
+    uint64_t t26, t27, t28, t29, t30, t31, t32, t33, t34, t35, t36, t37;
+    uint64_t t38, t39, t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59, t60, t61;
+    uint64_t t62, t63, t64, t65, t66, t67;
+    uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];  x1 = q[6];  x2 = q[5];  x3 = q[4];
+    x4 = q[3];  x5 = q[2];  x6 = q[1];  x7 = q[0];
+
+    /// Top linear transform
+    y14 = x3 ^ x5;      y13 = x0 ^ x6;      y9  = x0 ^ x3;      y8  = x0 ^ x5;
+    t0  = x1 ^ x2;      y1  = t0 ^ x7;      y4  = y1 ^ x3;      y12 = y13 ^ y14;
+    y2  = y1 ^ x0;      y5  = y1 ^ x6;      y3  = y5 ^ y8;      t1  = x4 ^ y12;
+    y15 = t1 ^ x5;      y20 = t1 ^ x1;      y6  = y15 ^ x7;     y10 = y15 ^ t0;
+    y11 = y20 ^ y9;     y7  = x7 ^ y11;     y17 = y10 ^ y11;    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;     y21 = y13 ^ y16;    y18 = x0 ^ y16;
+
+    /// Non-linear middle: inversion in GF(2^4)^2
+    t2  = y12 & y15;    t3  = y3 & y6;      t4  = t3 ^ t2;      t5  = y4 & x7;
+    t6  = t5 ^ t2;      t7  = y13 & y16;    t8  = y5 & y1;      t9  = t8 ^ t7;
+    t10 = y2 & y7;      t11 = t10 ^ t7;     t12 = y9 & y11;     t13 = y14 & y17;
+    t14 = t13 ^ t12;    t15 = y8 & y10;     t16 = t15 ^ t12;    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;     t19 = t9 ^ t14;     t20 = t11 ^ t16;    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;    t23 = t19 ^ y21;    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;    t26 = t21 & t23;    t27 = t24 ^ t26;    t28 = t25 & t27;
+    t29 = t28 ^ t22;    t30 = t23 ^ t24;    t31 = t22 ^ t26;    t32 = t31 & t30;
+    t33 = t32 ^ t24;    t34 = t23 ^ t33;    t35 = t27 ^ t33;    t36 = t24 & t35;
+    t37 = t36 ^ t34;    t38 = t27 ^ t36;    t39 = t29 & t38;    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;    t42 = t29 ^ t33;    t43 = t29 ^ t40;    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0  = t44 & y15;    z1  = t37 & y6;     z2  = t33 & x7;     z3  = t43 & y16;
+    z4  = t40 & y1;     z5  = t29 & y7;     z6  = t42 & y11;    z7  = t45 & y17;
+    z8  = t41 & y10;    z9  = t44 & y12;    z10 = t37 & y3;     z11 = t33 & y4;
+    z12 = t43 & y13;    z13 = t40 & y5;     z14 = t29 & y2;     z15 = t42 & y9;
+    z16 = t45 & y14;    z17 = t41 & y8;
+
+    /// Bottom linear transform, with the 0x63 of the affine map
+    t46 = z15 ^ z16;    t47 = z10 ^ z11;    t48 = z5 ^ z13;     t49 = z9 ^ z10;
+    t50 = z2 ^ z12;     t51 = z2 ^ z5;      t52 = z7 ^ z8;      t53 = z0 ^ z3;
+    t54 = z6 ^ z7;      t55 = z16 ^ z17;    t56 = z12 ^ t48;    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;     t59 = z3 ^ t54;     t60 = t46 ^ t57;    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;    t63 = t49 ^ t58;    t64 = z4 ^ t59;     t65 = t61 ^ t62;
+    t66 = z1 ^ t63;     s0  = t59 ^ t63;    s6  = t56 ^ ~t62;   s7  = t48 ^ ~t60;
+    t67 = t64 ^ t65;    s3  = t53 ^ t66;    s4  = t51 ^ t66;    s5  = t47 ^ t65;
+    s1  = t64 ^ ~s3;    s2  = t55 ^ ~t67;
+
+    q[7] = s0;  q[6] = s1;  q[5] = s2;  q[4] = s3;
+    q[3] = s4;  q[2] = s5;  q[1] = s6;  q[0] = s7;
+}
+
+
+static void sub_subbytes(ot_u8* data, ot_int length) {
+/// SubBytes on any number of bytes, 64 at a time.  The tail of the last
+/// group is padding: its output is computed the same way and dropped.
+    uint64_t    q[8];
+    ot_int      n;
+
+    for (; length > 0; length -= 64, data += 64) {
+        n = (length < 64) ? length : 64;
+        memset(q, 0, sizeof(q));
+        memcpy(q, data, n);
+        sub_transpose_bits(q);
+        sub_transpose_bytes(q);
+        sub_sbox(q);
+        sub_transpose_bytes(q);
+        sub_transpose_bits(q);
+        memcpy(data, q, n);
+    }
+}
+
+
+static void sub_expand(const ot_u8* key, uint32_t* rk) {
+    uint32_t    t;
+    ot_u8       rcon = 1;
+    ot_int      i;
+
+    memcpy(rk, key, 16);
+    for (i=4; i<44; i++) {
+        t = rk[i-1];
+        if ((i & 3) == 0) {
+            t   = ROTL32(t, 24);
+            sub_subbytes((ot_u8*)&t, 4);
+            t  ^= rcon;
+            rcon = XTIME(rcon);
+        }
+        rk[i] = rk[i-4] ^ t;
+    }
+}
+
+
+static void sub_ecb_bitslice(const EAXdrv_t** key, ot_u8 (*block)[16], ot_int count) {
+/// Round by round over all blocks, so that SubBytes gets them all in one go
+    uint32_t    s[4], t[4];
+    ot_int      i, c, r;
+
+    for (i=0; i<count; i++) {
+        memcpy(s, block[i], 16);
+        for (c=0; c<4; c++) {
+            s[c] ^= key[i]->rk[c];
+        }
+        memcpy(block[i], s, 16);
+    }
+
+    for (r=1; r<=10; r++) {
+        sub_subbytes(block[0], count << 4);
+
+        for (i=0; i<count; i++) {
+            const uint32_t* rk = &key[i]->rk[r*4];
+
+            /// ShiftRows: row R of column C comes from column C+R
+            memcpy(s, block[i], 16);
+            for (c=0; c<4; c++) {
+                t[c] = (s[c] & 0x000000FF)         | (s[(c+1)&3] & 0x0000FF00)
+                     | (s[(c+2)&3] & 0x00FF0000)   | (s[(c+3)&3] & 0xFF000000);
+            }
+
+            /// MixColumns, except in the last round: with a[R] the rows and
+            /// a[R+1] under ROTL32(a, 24), b = 2(a ^ a[R+1]) ^ a[R+1] ^ a[R+2] ^ a[R+3]
+            for (c=0; c<4; c++) {
+                if (r < 10) {
+                    uint32_t a1 = ROTL32(t[c], 24);
+                    t[c] = XTIME32(t[c] ^ a1) ^ a1 ^ ROTL32(t[c], 16) ^ ROTL32(t[c], 8);
+                }
+                t[c] ^= rk[c];
+            }
+            memcpy(block[i], t, 16);
+        }
+    }
+}
+
+
+#ifdef EAX_AESNI
+__attribute__((target("aes,sse2")))
+static void sub_ecb_aesni(const EAXdrv_t** key, ot_u8 (*block)[16], ot_int count) {
+/// Round by round over all blocks, so consecutive AESENCs are independent
+    __m128i s[EAX_LANES*2];
+    ot_int  i, r;
+
+#   define RK(I, R)     _mm_loadu_si128((const __m128i*)&key[I]->rk[(R)*4])
+
+    for (i=0; i<count; i++) {
+        s[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)block[i]), RK(i, 0));
+    }
+    for (r=1; r<10; r++) {
+        for (i=0; i<count; i++) {
+            s[i] = _mm_aesenc_si128(s[i], RK(i, r));
+        }
+    }
+    for (i=0; i<count; i++) {
+        _mm_storeu_si128((__m128i*)block[i], _mm_aesenclast_si128(s[i], RK(i, 10)));
+    }
+
+#   undef RK
+}
+#endif
+
+
+
+static void sub_init() {
+    aesni_ok    = 0;
+    sub_ecb     = &sub_ecb_bitslice;
+#   ifdef EAX_AESNI
+    {   unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES)) {
+            aesni_ok    = 1;
+            sub_ecb     = &sub_ecb_aesni;
+        }
+    }
+#   endif
+}
+
+
+
+
+/** EAX engine
+  * ============================================================================
+  */
+
+static OT_INLINE void sub_xor16(ot_u8* dst, const ot_u8* src) {
+    uint64_t a[2], b[2];
+    memcpy(a, dst, 16);
+    memcpy(b, src, 16);
+    a[0] ^= b[0];
+    a[1] ^= b[1];
+    memcpy(dst, a, 16);
+}
+
+
+static void sub_double(ot_u8* dst, const ot_u8* src) {
+/// Multiply by x in GF(2^128), big-endian, as OMAC needs for its subkeys
+    ot_u8   carry = (src[0] & 0x80) ? 0x87 : 0;
+    ot_int  i;
+    for (i=0; i<15; i++) {
+        dst[i] = (ot_u8)((src[i] << 1) | (src[i+1] >> 7));
+    }
+    dst[15] = (ot_u8)(src[15] << 1) ^ carry;
+}
+
+
+static void sub_ctrblock(eax_lane* lane, ot_int j, ot_u8* block) {
+    uint64_t lo = lane->ctr_lo + (uint64_t)j;
+    uint64_t hi = lane->ctr_hi + (lo < lane->ctr_lo);
+    hi = __builtin_bswap64(hi);
+    lo = __builtin_bswap64(lo);
+    memcpy(block, &hi, 8);
+    memcpy(block+8, &lo, 8);
+}
+
+
+static void sub_macblock(eax_lane* lane, ot_int j, ot_u8* block) {
+/// OMAC^2 input for message block j.  The last block gets 2L if it is full,
+/// or the 10* pad and 4L if it is not.
+    ot_u8*  data    = lane->frame->data + (j << 4);
+    ot_int  rem     = lane->length - (j << 4);
+
+    memcpy(block, lane->mac, 16);
+    if (rem > 16) {
+        sub_xor16(block, data);
+    }
+    else if (rem == 16) {
+        sub_xor16(block, data);
+        sub_xor16(block, lane->key->l2);
+    }
+    else {
+        ot_int i;
+        for (i=0; i<rem; i++) {
+            block[i] ^= data[i];
+        }
+        block[rem] ^= 0x80;
+        sub_xor16(block, lane->key->l4);
+    }
+}
+
+
+static void sub_eax(EAXdrv_frame* frame, ot_int count, ot_bool encrypt) {
+/// count <= EAX_LANES.  When encrypting, the OMAC of block j can only start
+/// after block j is encrypted, so it runs one step behind the CTR.
+    eax_lane        lane[EAX_LANES];
+    const EAXdrv_t* key[EAX_LANES*2];
+    ot_u8           block[EAX_LANES*2][16];
+    ot_int          i, j, k, m, lanes, steps;
+    ot_int          lag = (encrypt != False);
+
+    /// Set up the lanes, and OMAC^0 the nonces: [0] then one padded block
+    lanes = 0;
+    for (i=0; i<count; i++) {
+        eax_lane* ln = &lane[lanes];
+
+        ln->length = (ot_int)frame[i].datalen - (encrypt ? 0 : EAX_TAGLEN);
+        if (ln->length < 0) {
+            frame[i].retval = -1;
+            continue;
+        }
+        ln->frame   = &frame[i];
+        ln->key     = frame[i].context;
+        ln->blocks  = (ln->length + 15) >> 4;
+
+        memset(block[lanes], 0, 16);
+        memcpy(block[lanes], frame[i].nonce, EAX_NONCELEN);
+        block[lanes][EAX_NONCELEN] = 0x80;
+        sub_xor16(block[lanes], ln->key->e0);
+        sub_xor16(block[lanes], ln->key->l4);
+        key[lanes++] = ln->key;
+    }
+    sub_ecb(key, block, lanes);
+
+    steps = 0;
+    for (i=0; i<lanes; i++) {
+        uint64_t w;
+        memcpy(lane[i].nonce, block[i], 16);
+        memcpy(lane[i].mac, lane[i].key->e2, 16);
+        memcpy(&w, block[i], 8);
+        lane[i].ctr_hi = __builtin_bswap64(w);
+        memcpy(&w, block[i]+8, 8);
+        lane[i].ctr_lo = __builtin_bswap64(w);
+        if ((lane[i].blocks + lag) > steps) {
+            steps = lane[i].blocks + lag;
+        }
+    }
+
+    /// Each step: CTR block j and OMAC block j-lag of every lane, in one call
+    for (j=0; j<steps; j++) {
+        k = 0;
+        for (i=0; i<lanes; i++) {
+            m = j - lag;
+            if (j < lane[i].blocks) {
+                sub_ctrblock(&lane[i], j, block[k]);
+                key[k++] = lane[i].key;
+            }
+            if ((m >= 0) && (m < lane[i].blocks)) {
+                sub_macblock(&lane[i], m, block[k]);
+                key[k++] = lane[i].key;
+            }
+        }
+        sub_ecb(key, block, k);
+
+        k = 0;
+        for (i=0; i<lanes; i++) {
+            m = j - lag;
+            if (j < lane[i].blocks) {
+                ot_u8*  data    = lane[i].frame->data + (j << 4);
+                ot_int  rem     = lane[i].length - (j << 4);
+                if (rem >= 16) {
+                    sub_xor16(data, block[k]);
+                }
+                else {
+                    ot_int b;
+                    for (b=0; b<rem; b++) {
+                        data[b] ^= block[k][b];
+                    }
+                }
+                k++;
+            }
+            if ((m >= 0) && (m < lane[i].blocks)) {
+                memcpy(lane[i].mac, block[k++], 16);
+            }
+        }
+    }
+
+    /// Tag = N ^ H ^ C, truncated.  An empty message has a fixed OMAC^2.
+    for (i=0; i<lanes; i++) {
+        ot_u8*  tag = lane[i].frame->data + lane[i].length;
+        ot_u8   diff = 0;
+
+        sub_xor16(lane[i].nonce, lane[i].key->h);
+        sub_xor16(lane[i].nonce, (lane[i].blocks == 0) ? lane[i].key->c0 : lane[i].mac);
+        if (encrypt) {
+            memcpy(tag, lane[i].nonce, EAX_TAGLEN);
+        }
+        else {
+            for (k=0; k<EAX_TAGLEN; k++) {
+                diff |= tag[k] ^ lane[i].nonce[k];
+            }
+        }
+        lane[i].frame->retval = (diff != 0);
+    }
+}
+
+
+
+
+/** Driver functions
+  * ============================================================================
+  */
+
+ot_int EAXdrv_init(ot_u8* key, EAXdrv_t* context) {
+/// Everything that depends only on the key is done here: the schedule, the
+/// OMAC subkeys, and the OMAC values that do not depend on the message.
+    const EAXdrv_t* ctx[4];
+    ot_u8           block[4][16];
+
+    if (aesni_ok < 0) {
+        sub_init();
+    }
+    sub_expand(key, context->rk);
+    ctx[0] = ctx[1] = ctx[2] = ctx[3] = context;
+
+    /// L = E([0]), which is also the first OMAC^0 chain value
+    memset(block, 0, 32);
+    block[1][15] = 2;
+    sub_ecb(ctx, block, 2);
+    memcpy(context->e0, block[0], 16);
+    memcpy(context->e2, block[1], 16);
+    sub_double(context->l2, context->e0);
+    sub_double(context->l4, context->l2);
+
+    /// H = OMAC^1 of the empty header, and OMAC^2 of the empty message
+    memcpy(block[0], context->l2, 16);
+    memcpy(block[1], context->l2, 16);
+    block[0][15] ^= 1;
+    block[1][15] ^= 2;
+    sub_ecb(ctx, block, 2);
+    memcpy(context->h, block[0], 16);
+    memcpy(context->c0, block[1], 16);
+
+    return 0;
+}
+
+
+ot_int EAXdrv_clear(EAXdrv_t* context) {
+    volatile ot_u8* wipe = (volatile ot_u8*)context;
+    ot_uint         i;
+    for (i=0; i<sizeof(EAXdrv_t); i++) {
+        wipe[i] = 0;
+    }
+    return 0;
+}
+
+
+ot_int EAXdrv_encrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, EAXdrv_t* context) {
+    EAXdrv_frame frame = { nonce, data, datalen, context, 0 };
+    sub_eax(&frame, 1, True);
+    return frame.retval;
+}
+
+
+ot_int EAXdrv_decrypt(ot_u8* nonce, ot_u8* data, ot_uint datalen, EAXdrv_t* context) {
+    EAXdrv_frame frame = { nonce, data, datalen, context, 0 };
+    sub_eax(&frame, 1, False);
+    return frame.retval;
+}
+
+
+ot_int EAXdrv_decrypt_batch(EAXdrv_frame* frame, ot_int count) {
+    ot_int i, n;
+    ot_int good = 0;
+
+    for (; count > 0; count -= n, frame += n) {
+        n = (count < EAX_LANES) ? count : EAX_LANES;
+        sub_eax(frame, n, False);
+        for (i=0; i<n; i++) {
+            good += (frame[i].retval == 0);
+        }
+    }
+    return good;
+}
+
+
+#endif
@@ -70,6 +70,9 @@
 #if (OT_FEATURE(SERVER) == ENABLED)
 #   include <m2/radio.h>
 #endif
+#if (OT_FEATURE(ENERGY) == ENABLED)
+#   include <otsys/energy.h>
+#endif
 
 //#include <otlib/auth.h>         //should be initialized via system (sys_init())
 //#include <m2/session.h>      //should be initialized via system (sys_init())
@@ -88,6 +91,7 @@
 
 
 // Platform-specific crc table (same as normal CRC table)
+#include <otlib/crc16.h>
 #include <otlib/crc16_table.h>
 ot_u16 p_crcval;
 static const ot_u16 p_crctable[256] = {
@@ -356,13 +360,58 @@ void platform_poweron() {
 }
 
 
+#if (OT_FEATURE(ENERGY) == ENABLED)
+static void sub_energy_report(FILE* out) {
+/// Print the Energy records of the simulation run, so that configurations can
+/// be compared by projected battery life.
+    static const char* rf_name[ENERGY_RF_STATES] = { "off", "idle", "rx", "tx" };
+    ot_u32  seconds, mC;
+    ot_u16  ticks, uC;
+    ot_u8   i;
+
+    seconds = energy_uptime(&ticks);
+    mC      = energy_charge(&uC);
+    fprintf(out, "Energy: %lu.%03u s, %lu.%03u mC, %lu uA avg, %lu h on %u mAh\n",
+            (unsigned long)seconds, (ticks * 1000) >> 10, (unsigned long)mC, uC,
+            (unsigned long)energy_avgcurrent(),
+            (unsigned long)energy_lifetime(OT_PARAM_ENERGY_CAPACITY), OT_PARAM_ENERGY_CAPACITY);
+
+    for (i=0; i<ENERGY_CPU_STATES; i++) {
+        if (i < ENERGY_cpu_kernel) {
+            fprintf(out, "  cpu sleep%u", i);
+        }
+        else if (i == ENERGY_cpu_kernel) {
+            fprintf(out, "  cpu kernel");
+        }
+        else {
+            fprintf(out, "  cpu task%-2u", i-ENERGY_cpu_task);
+        }
+        seconds = energy_cpu_time(i, &ticks);
+        mC      = energy_cpu_charge(i, &uC);
+        fprintf(out, " %10lu.%03u s %10lu.%03u mC\n",
+                (unsigned long)seconds, (ticks * 1000) >> 10, (unsigned long)mC, uC);
+    }
+    for (i=0; i<ENERGY_RF_STATES; i++) {
+        seconds = energy_rf_time(i, &ticks);
+        mC      = energy_rf_charge(i, &uC);
+        fprintf(out, "  rf  %-6s %10lu.%03u s %10lu.%03u mC\n",
+                rf_name[i], (unsigned long)seconds, (ticks * 1000) >> 10, (unsigned long)mC, uC);
+    }
+}
+#endif
+
+
 void platform_poweroff() {
 /// - Put any mirror data into the flash
 /// - Save the vworm mapping table
+/// - Report the Energy records of the simulation run
 #if (OT_FEATURE(VEELITE) == ENABLED)
     ISF_syncmirror();
     vworm_save();
 #endif
+#if (OT_FEATURE(ENERGY) == ENABLED)
+    sub_energy_report(stderr);
+#endif
 }
 
 
@@ -461,6 +510,18 @@ void platform_init_systick(ot_uint period) {
 
 
 void platform_init_rtc(ot_u32 value) {
+/// POSIX has a real RTC: the system realtime clock.  The default value is
+/// ignored and the Time module is loaded from CLOCK_REALTIME, to the ns.
+#if (OT_FEATURE(TIME) == ENABLED)
+    struct timespec now;
+    ot_timespec     ts;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    ts.sec  = (ot_u32)now.tv_sec;
+    ts.nsec = (ot_u32)now.tv_nsec;
+    time_init_utc(ts.sec);
+    time_set_realtime(&ts);
+#endif
 }
 
 
@@ -477,26 +538,39 @@ void platform_init_memcpy() { }
   * ========================================================================<BR>
   */
 
-ot_u32 systim_get() {
-/// Have to do a lot of hackery, because unix itimer is a downcounter with a
-/// highly annoying setup
+/// The kernel timer is measured with the POSIX monotonic clock, relative to
+/// the time of the last flush.  The itimer is still used to deliver the
+/// kernel interrupt, but it is never read back.
+static struct timespec  systim_base;
+static ot_u32           systim_last;
 
-    struct itimerval gettime;
-    int time1, time0;
-
-    if (getitimer(ITIMER_REAL, &gettime) != 0) {
-        fprintf(stderr, "ERROR: itimer cannot be get\n");
+static void sub_systim_init(void) {
+    if ((systim_base.tv_sec == 0) && (systim_base.tv_nsec == 0)) {
+        clock_gettime(CLOCK_MONOTONIC, &systim_base);
     }
+}
+
+ot_u32 systim_get_subtick(ot_u32* subtick_ns) {
+/// 1 tick = 1/1024 s.  The ns remainder is what is left below a whole tick.
+    struct timespec now;
+    uint64_t        ns;
+    ot_u32          ticks;
 
-    time0   = tconfig.it_value.tv_sec * 1024;
-    time0  += tconfig.it_value.tv_usec / 976;
-    time1   = gettime.it_value.tv_sec * 1024;
-    time1  += gettime.it_value.tv_usec / 976;
+    sub_systim_init();
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ns  = (uint64_t)(now.tv_sec - systim_base.tv_sec) * 1000000000;
+    ns += (now.tv_nsec - systim_base.tv_nsec);
 
-    time1   = time0 - time1;
-    time1  *= (time1 >= 0);
+    ticks       = (ot_u32)((ns << 10) / 1000000000);
+    systim_last = ticks;
+    if (subtick_ns != NULL) {
+        *subtick_ns = (ot_u32)(ns - (((uint64_t)ticks * 1000000000) >> 10));
+    }
+    return ticks;
+}
 
-    return time1;
+ot_u32 systim_get() {
+    return systim_get_subtick(NULL);
 }
 
 void platform_set_ktim(ot_u16 value) {
@@ -514,6 +588,16 @@ void platform_set_ktim(ot_u16 value) {
 }
 
 void systim_flush() {
+/// The base advances by the whole ticks that were last read out, which the
+/// kernel has just accounted.  The sub-tick remainder carries over, so the
+/// kernel time does not drift from the monotonic clock.
+    uint64_t ns;
+    sub_systim_init();
+    ns                      = ((uint64_t)systim_last * 1000000000) >> 10;
+    ns                     += systim_base.tv_nsec;
+    systim_base.tv_sec     += (time_t)(ns / 1000000000);
+    systim_base.tv_nsec     = (long)(ns % 1000000000);
+    systim_last             = 0;
     platform_set_ktim(65535);
 }
 
@@ -535,11 +619,9 @@ void platform_disable_rtc() {
 
 ot_u32 platform_get_time() {
 #if (OT_FEATURE(TIME) == ENABLED)
-#   if (RTC_OVERSAMPLE == 0)
-        return ///@todo find time register, if it exists
-#   else
-        return otrtc.utc;
-#   endif
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (ot_u32)now.tv_sec;
 #else
     return 0;
 #endif
@@ -608,14 +690,9 @@ ot_u16 crc16drv_init() {
 }
 
 ot_u16 crc16drv_block(ot_u8* block_addr, ot_int block_size) {
-    ot_u8* data     = block_addr;
-    ot_u16 crc16    = 0xFFFF;
-
-    while (block_size > 0) {
-        crc16 = (crc16 << 8) ^ p_crctable[((crc16 >> 8) & 0xff) ^ *data++];
-        block_size--;
-    }
-    return crc16;
+/// The block driver from /otlib/crc16.c slices and folds long blocks, which
+/// is what MPipe packets are.
+    return crc16drv_block_manual(block_addr, block_size, 0xFFFF);
 }
 
 void crc16drv_byte(ot_u8 databyte) {
@@ -129,6 +129,30 @@
 #define MCU_SLEEP_WHILE_RF() SLEEP_WHILE_UHF()
 
 
+/** Energy Accounting Current Table (uA)
+  * ========================================================================<BR>
+  * Typical datasheet supply currents for the sys_powerdown() modes, used by
+  * the Energy module (OT_FEATURE_ENERGY).  The emulated MCU is an
+  * STM32L, so its values are used.
+  * Board or app config may override these with measured values.
+  */
+#ifndef MCU_PARAM_ENERGY_RUN
+#   define MCU_PARAM_ENERGY_RUN         3700
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP
+#   define MCU_PARAM_ENERGY_SLEEP       1000
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP_IO
+#   define MCU_PARAM_ENERGY_SLEEP_IO    1000
+#endif
+#ifndef MCU_PARAM_ENERGY_SLEEP_RF
+#   define MCU_PARAM_ENERGY_SLEEP_RF    1000
+#endif
+#ifndef MCU_PARAM_ENERGY_STOP
+#   define MCU_PARAM_ENERGY_STOP        2
+#endif
+
+
 
 /** Data section Nomenclature  <BR>
   * ========================================================================<BR>
@@ -147,6 +171,33 @@
 
 
 
+/** Cryptography  <BR>
+  * ========================================================================<BR>
+  * Context for the EAX driver in otlib_eax_stdc.c.  Everything in it depends
+  * only on the key, so EAXdrv_init() builds it once and it is reused.
+  * With CRYPTO_RFAES, the driver is the SPIRIT1 one (e.g. against a model).
+  */
+#if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY)) \
+ && (OT_FEATURE(CRYPTO_RFAES) == ENABLED)
+#   include <io/spirit1/eax.h>
+    typedef spirit1_eaxctx EAXdrv_t;
+#elif (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY))
+    typedef struct {
+        uint32_t    rk[44];         // AES-128 encryption schedule
+        ot_u8       l2[16];         // OMAC subkey 2L, for a full last block
+        ot_u8       l4[16];         // OMAC subkey 4L, for a padded last block
+        ot_u8       e0[16];         // E([0]), first OMAC^0 chain value (= L)
+        ot_u8       e2[16];         // E([2]), first OMAC^2 chain value
+        ot_u8       h[16];          // OMAC^1 of the empty header
+        ot_u8       c0[16];         // OMAC^2 of an empty message
+    } EAXdrv_t;
+#else
+    typedef ot_uint EAXdrv_t;
+#endif
+
+
+
+
 /** Flash Emulation  <BR>
   * ========================================================================<BR>
   * Emulate a 4KB block for Veelite.
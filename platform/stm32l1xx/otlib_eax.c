@@ -29,7 +29,8 @@
   */
 
 #include <otstd.h>
-#if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY))
+#if (OT_FEATURE(DLL_SECURITY) || OT_FEATURE(NL_SECURITY) || OT_FEATURE(VL_SECURITY)) \
+ && (OT_FEATURE(CRYPTO_RFAES) != ENABLED)
 
 // This is the OTlib crypto header that defines the driver functions
 #include <otlib/crypto.h>